@@ -3507,7 +3507,8 @@ bool CBotInstrMethode::ExecuteVar(CBotVar* &pVar, CBotStack* &pj, CBotToken* pre
     }
     CBotVar*    pRes = pResult;
 
-    if ( !pClass->ExecuteMethode(m_MethodeIdent, m_NomMethod, 
+    long nIdent = m_MethodeIdent;
+    if ( !pClass->ExecuteMethode(nIdent, m_NomMethod, 
                                  pThis, ppVars, 
                                  pResult, pile2, GetToken())) return false;
     if (pRes != pResult) delete pRes;
@@ -3558,7 +3559,8 @@ void CBotInstrMethode::RestoreStateVar(CBotStack* &pile, bool bMain)
 
 //    CBotVar*    pRes = pResult;
 
-    pClass->RestoreMethode(m_MethodeIdent, m_NomMethod, 
+    long nIdent = m_MethodeIdent;
+    pClass->RestoreMethode(nIdent, m_NomMethod, 
                                  pThis, ppVars, pile2);
 }
 
@@ -3612,7 +3614,8 @@ bool CBotInstrMethode::Execute(CBotStack* &pj)
     }
     CBotVar*    pRes = pResult;
 
-    if ( !pClass->ExecuteMethode(m_MethodeIdent, m_NomMethod, 
+    long nIdent = m_MethodeIdent;
+    if ( !pClass->ExecuteMethode(nIdent, m_NomMethod, 
                                  pThis, ppVars, 
                                  pResult, pile2, GetToken())) return false;    // interupted
 
@@ -3773,7 +3776,8 @@ bool CBotNew::Execute(CBotStack* &pj)
         // create a variable for the result
         CBotVar*    pResult = NULL;     // constructos still void
 
-        if ( !pClass->ExecuteMethode(m_nMethodeIdent, pClass->GetName(), 
+        long nIdent = m_nMethodeIdent;
+        if ( !pClass->ExecuteMethode(nIdent, pClass->GetName(), 
                                      pThis, ppVars, 
                                      pResult, pile2, GetToken())) return false;    // interrupt
 
@@ -3836,7 +3840,8 @@ void CBotNew::RestoreState(CBotStack* &pj, bool bMain)
         }
         ppVars[i] = NULL;
 
-        pClass->RestoreMethode(m_nMethodeIdent, m_vartoken.GetString(), pThis,
+        long nIdent = m_nMethodeIdent;
+        pClass->RestoreMethode(nIdent, m_vartoken.GetString(), pThis,
                                ppVars, pile2)    ;        // interrupt here!
     }
 }
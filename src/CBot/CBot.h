@@ -25,9 +25,15 @@
 #include "CBotDll.h"                    // public definitions
 #include "CBotToken.h"                  // token management
 
+#include <atomic>
+#include <vector>
+
 #define    STACKRUN    true             /// \def return execution directly on a suspended routine
 #define    STACKMEM    true             /// \def preserve memory for the execution stack
 #define    MAXSTACK    990              /// \def stack size reserved
+#define    MAXSLOTS    2000             /// \def limit of variables resolved by slot in a function
+#define    POOLMAXFREE 1024             /// \def free blocks kept for each type of variable and thread
+#define    POOLSLOTS   32               /// \def local variables of the functions taking their slots from the pool
 
 #define    EOX         (reinterpret_cast<CBotStack*>(-1))   /// \def tag special condition
 
@@ -58,6 +64,7 @@ class CBotWhile;    // while (...) {...};
 class CBotIf;       // if (...) {...} else {...}
 class CBotDefParam; // paramerer list of a function
 class CBotRepeat;   // repeat (nb) {...}
+class CBotByteCode; // compiled form of a loop
 
 
 
@@ -247,11 +254,25 @@ public:
     bool            RestoreState(FILE* pf, CBotStack* &pStack);
 
     static
-    void            SetTimer(int n);
+    void            SetTimer(int n);                                    // default number of steps for a run
+    void            StartTimer(int n);                                  // number of steps for this run
+    int             GetTimerUsed();                                     // number of steps done in this run
+    int             GetTimerLeft();                                     // number of steps left in this run
+    void            SetTimerLeft(int n);
+    bool            IsStepMode();                                       // is the program run step by step?
+
+    static
+    void            SetWorkerThread(bool bWorker);                      // does the current thread run programs in parallel?
+    static
+    bool            IsWorkerThread();
+    bool            IfDefer();                                          // must the current call wait for the main thread?
+    bool            IsDeferred();                                       // did the run stop on such a call?
 
     void            GetRunPos(const char* &FunctionName, int &start, int &end);
     CBotVar*        GetStackVars(const char* &FunctionName, int level);
 
+    void            SetFrame(long firstIdent, int nSlots);              // this level runs a function
+
     int                m_temp;
 
 private:
@@ -265,10 +286,14 @@ private:
 #endif
     int                m_state;
     int                m_step;
-    static int        m_error;
-    static int        m_start;
-    static int        m_end;
-    static
+    // state of the run in progress, kept per thread (see SetWorkerThread)
+    static thread_local
+    int                m_error;
+    static thread_local
+    int                m_start;
+    static thread_local
+    int                m_end;
+    static thread_local
     CBotVar*        m_retvar;                    // result of a return
 
     CBotVar*        m_var;                        // result of the operations
@@ -280,18 +305,34 @@ private:
     CBotProgram*    m_prog;                        // user-defined functions
 
     static
-    int                m_initimer;
-    static
-    int                m_timer;
-    static
+    int                m_defaultTimer;                // steps for a run, if not given by the program
+    CBotStack*        m_root;                        // first stack of the program, holding the timer
+    int                m_initimer;                    // steps given to the run (used in m_root only)
+    int                m_timer;                    // steps remaining in the run (used in m_root only)
+    bool            m_bDeferred;                // run stopped on a call for the main thread (used in m_root only)
+    static thread_local
+    bool            m_bWorker;                    // current thread is a worker thread
+    static thread_local
     CBotString        m_labelBreak;
-    static
+    static thread_local
     void*            m_pUser;
 
     CBotInstr*        m_instr;                    // the corresponding instruction
     bool            m_bFunc;                    // an input of a function?
     CBotCall*        m_call;                        // recovery point in a extern call
     friend class    CBotTry;
+
+    // local variables of the running function, by their unique number
+    CBotStack*        m_frame;                    // level of the function, NULL outside of one
+    CBotVar**        m_slots;                    // variable (ident - m_firstIdent), NULL if unknown (used in m_frame only)
+    long            m_firstIdent;
+    int                m_nSlots;
+
+    CBotVar*        GetSlotVar(long ident);
+    void            SetSlotVar(long ident, CBotVar* pVar);
+    void            ReleaseSlots();
+    void            FreeSlots();
+    void            SetFrameAbove(CBotStack* frame);
 };
 
 // inline routinees must be declared in file.h
@@ -453,6 +494,9 @@ public:
     virtual
     bool        CompCase(CBotStack* &pj, int val);
 
+    virtual
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
+
     void        SetToken(CBotToken* p);
     int            GetTokenType();
     CBotToken*    GetToken();
@@ -482,6 +526,7 @@ private:
     CBotInstr*    m_Condition;        // condition
     CBotInstr*    m_Block;            // instructions
     CBotString    m_label;            // a label if there is 
+    CBotByteCode* m_code;             // compiled form of the loop, NULL if not possible
 
 public:
                 CBotWhile();
@@ -490,6 +535,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 class CBotRepeat : public CBotInstr
@@ -524,6 +570,7 @@ private:
     CBotInstr*    m_Block;            // instruction
     CBotInstr*    m_Condition;        // conditions
     CBotString    m_label;            // a label if there is 
+    CBotByteCode* m_code;             // compiled form of the loop, NULL if not possible
 
 public:
                 CBotDo();
@@ -532,6 +579,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 class CBotFor : public CBotInstr
@@ -542,6 +590,7 @@ private:
     CBotInstr*    m_Incr;                // instruction for increment
     CBotInstr*    m_Block;            // instructions
     CBotString    m_label;            // a label if there is 
+    CBotByteCode* m_code;             // compiled form of the loop, NULL if not possible
 
 public:
                 CBotFor();
@@ -550,6 +599,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 class CBotBreak : public CBotInstr
@@ -564,6 +614,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 class CBotReturn : public CBotInstr
@@ -689,6 +740,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 
@@ -708,6 +760,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack, bool cont = false, bool noskip = false);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 // definition of an array
@@ -753,6 +806,7 @@ class CBotEmpty : public CBotInstr
 {
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 // defininition of a boolean
@@ -770,6 +824,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack, bool cont = false, bool noskip=false);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 
@@ -788,6 +843,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack, bool cont = false, bool noskip=false);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 // definition of an element string
@@ -857,6 +913,7 @@ public:
     bool        ExecuteVar(CBotVar* &pVar, CBotCStack* &pile);
     bool        ExecuteVar(CBotVar* &pVar, CBotStack* &pile, CBotToken* prevToken, bool bStep);
     void        RestoreStateVar(CBotStack* &pile, bool bMain);
+    bool        GenVar(CBotByteCode* pCode, bool bRead, int& slot, int& index, int& type);
 };
 
 
@@ -887,6 +944,7 @@ private:
     CBotInstr*     m_expr;                    // expression for calculating the index
     friend class CBotLeftExpr;
     friend class CBotExprVar;
+    friend class CBotByteCode;
 
 public:
                 CBotIndexExpr();
@@ -915,6 +973,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pStack);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 class CBotListExpression : public CBotInstr
@@ -929,6 +988,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pStack);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 class CBotLogicExpr : public CBotInstr
@@ -946,6 +1006,7 @@ public:
 //    CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pStack);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 
@@ -985,6 +1046,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pStack);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 // all operations with two operands
@@ -1001,6 +1063,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack, int* pOperations = NULL);
     bool        Execute(CBotStack* &pStack);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 
@@ -1033,6 +1096,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack, bool bLocal = true);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 
@@ -1100,9 +1164,11 @@ public:
 
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
     bool        ExecuteVar(CBotVar* &pVar, CBotStack* &pile, CBotToken* prevToken, bool bStep);
     bool        Execute2Var(CBotVar* &pVar, CBotStack* &pj, CBotToken* prevToken, bool bStep);
     void        RestoreStateVar(CBotStack* &pj, bool bMain);
+    bool        GenVar(CBotByteCode* pCode, bool bRead, bool bWrite, int& slot, int& index, int& type);
 };
 
 class CBotPostIncExpr : public CBotInstr
@@ -1118,6 +1184,7 @@ public:
 //    CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 class CBotPreIncExpr : public CBotInstr
@@ -1133,6 +1200,7 @@ public:
 //    CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 
@@ -1166,6 +1234,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 
@@ -1227,6 +1296,7 @@ public:
     CBotInstr*    Compile(CBotToken* &p, CBotCStack* pStack);
     bool        Execute(CBotStack* &pj);
     void        RestoreState(CBotStack* &pj, bool bMain);
+    bool        GenCode(CBotByteCode* pCode, int& reg, int& type);
 };
 
 
@@ -1251,6 +1321,42 @@ public:
 
 
 // class for the management of integer numbers (int)
+// free lists for the variables of simple types and the slots of the functions
+// (see CBotPool.cpp)
+
+class CBotPool
+{
+public:
+    enum
+    {
+        PoolInt,
+        PoolFloat,
+        PoolBoolean,
+        PoolString,
+        PoolSlots,
+        PoolMax
+    };
+
+    static
+    void*           Alloc(int list, size_t size);
+    static
+    void            Free(int list, void* p, size_t size);
+    static
+    void            Count();                        // an allocation without the heap (stack level)
+
+    static
+    long            GetAllocCount();                // allocations done by the current thread
+    static
+    long            GetHeapCount();                 // those which needed the heap
+
+private:
+    static thread_local
+    long            m_nAlloc;
+    static thread_local
+    long            m_nHeap;
+};
+
+
 class CBotVarInt : public CBotVar
 {
 private:
@@ -1262,6 +1368,11 @@ public:
                 CBotVarInt( const CBotToken* name );
 //                ~CBotVarInt();
 
+    static
+    void*       operator new(size_t size);
+    static
+    void        operator delete(void* p, size_t size);
+
     void        SetValInt(int val, const char* s = NULL);
     void        SetValFloat(float val);
     int            GetValInt();
@@ -1313,6 +1424,11 @@ public:
                 CBotVarFloat( const CBotToken* name );
 //                ~CBotVarFloat();
 
+    static
+    void*       operator new(size_t size);
+    static
+    void        operator delete(void* p, size_t size);
+
     void        SetValInt(int val, const char* s = NULL);
     void        SetValFloat(float val);
     int            GetValInt();
@@ -1354,6 +1470,11 @@ public:
                 CBotVarString( const CBotToken* name );
 //                ~CBotVarString();
 
+    static
+    void*       operator new(size_t size);
+    static
+    void        operator delete(void* p, size_t size);
+
     void        SetValString(const char* p);
     CBotString    GetValString();
 
@@ -1381,6 +1502,11 @@ public:
                 CBotVarBoolean( const CBotToken* name );
 //                ~CBotVarBoolean();
 
+    static
+    void*       operator new(size_t size);
+    static
+    void        operator delete(void* p, size_t size);
+
     void        SetValInt(int val, const char* s = NULL);
     void        SetValFloat(float val);
     int            GetValInt();
@@ -1408,6 +1534,9 @@ private:
     CBotVarClass*    m_ExClass;        // list of existing instances at some point
     CBotVarClass*    m_ExNext;        // for this general list
     CBotVarClass*    m_ExPrev;        // for this general list
+    static
+    CBotVarClass*    m_ExDestroy;    // instances whose destructor waits for the main thread
+    CBotVarClass*    m_DestroyNext;    // for this list
 
 private:
     CBotClass*        m_pClass;        // the class definition
@@ -1415,7 +1544,7 @@ private:
     CBotVar*        m_pVar;            // contents
     friend class    CBotVar;        // my daddy is a buddy WHAT? :D(\TODO mon papa est un copain )
     friend class    CBotVarPointer;    // and also the pointer
-    int                m_CptUse;        // counter usage
+    std::atomic<int>    m_CptUse;    // counter usage, may be changed by several worker threads
     long            m_ItemIdent;    // identifier (unique) of an instance
     bool            m_bConstructor;    // set if a constructor has been called
 
@@ -1441,6 +1570,8 @@ public:
 
     void        IncrementUse();                // a reference to incrementation
     void        DecrementUse();                // a reference to decrementation
+    static
+    void        DestroyDeferred();            // runs the destructors left by worker threads
 
     CBotVarClass* 
                 GetPointer();
@@ -1569,17 +1700,20 @@ private:
     CBotTypResult
                 (*m_rComp) (CBotVar* &pVar, void* pUser)    ;
     CBotCall*    m_next;
+    bool        m_bThreadSafe;    // can be called from a worker thread
 
 public:
                 CBotCall(const char* name, 
                          bool rExec (CBotVar* pVar, CBotVar* pResult, int& Exception, void* pUser), 
-                         CBotTypResult rCompile (CBotVar* &pVar, void* pUser));
+                         CBotTypResult rCompile (CBotVar* &pVar, void* pUser),
+                         bool bThreadSafe = false);
                 ~CBotCall();
 
     static
     bool        AddFunction(const char* name, 
                             bool rExec (CBotVar* pVar, CBotVar* pResult, int& Exception, void* pUser), 
-                            CBotTypResult rCompile (CBotVar* &pVar, void* pUser));
+                            CBotTypResult rCompile (CBotVar* &pVar, void* pUser),
+                            bool bThreadSafe = false);
 
     static
     CBotTypResult
@@ -1678,6 +1812,8 @@ private:
 //    long            m_nThisIdent;
     long            m_nFuncIdent;
     bool            m_bSynchro;        // synchronized method?
+    long            m_nFirstIdent;     // unique numbers of the local variables follow this one
+    int             m_nSlots;          // and there are less than m_nSlots of them
 
 private:
     CBotDefParam*    m_Param;        // parameter list
@@ -1725,9 +1861,192 @@ public:
     CBotString        GetParams();
     bool            IsPublic();
     bool            IsExtern();
+    bool            IsSynchro();
     CBotFunction*    Next();
+    CBotProgram*    GetProgram(CBotStack* pStack);
 
     bool            GetPosition(int& start, int& stop, CBotGet modestart, CBotGet modestop);
 };
 
 
+// functions compiled from a text, shared by all the programs compiled
+// from the same text (e.g. a script given to many robots) : the instructions
+// are not changed by the execution, each program keeps its own stack and instance
+// only programs without classes and public functions are shared, these
+// being known by all the programs
+// a code is found again only while the public functions and classes it was
+// compiled with are unchanged; the execution never writes the identifiers
+// of the called functions found by name in the shared instructions
+
+class CBotProgramCode
+{
+private:
+    static
+    CBotProgramCode* m_list;        // all the shared codes
+    static
+    long            m_generation;   // changed with the public functions and the classes
+    CBotProgramCode* m_next;
+    CBotProgramCode* m_prev;
+
+    unsigned long   m_hash;         // of the text, to compare it quickly
+    CBotString      m_text;         // the compiled text
+    CBotString      m_class;        // class of the instance of the programs
+    int             m_nUse;         // number of programs using the code
+    long            m_gener;        // generation of the public functions and classes at compilation
+
+public:
+    CBotFunction*   m_Prog;         // the functions
+    CBotStringArray m_extern;       // names of the extern functions
+
+                    CBotProgramCode(const char* text, const CBotString& className, CBotFunction* pProg);
+                    ~CBotProgramCode();
+
+    static
+    CBotProgramCode* Find(const char* text, const CBotString& className);
+    static
+    unsigned long   Hash(const char* text);
+    static
+    void            NewGeneration();    // public functions or classes changed, the codes are no more found
+
+    void            AddUse();
+    void            Release();      // deletes the code when no program uses it anymore
+};
+
+/////////////////////////////////////////////////////////////////////
+// bytecode for innermost loops (see CBotByteCode.cpp)
+
+#define CODEMAXVAR  64                  // registers for the variables
+#define CODEMAXREG  256                 // all registers, temporary ones follow the variables
+
+// operations of the bytecode
+enum CBotOpCode
+{
+    OP_END,                             // leaves the loop
+    OP_STEP,                            // only counts its steps
+    OP_LOOP,                            // returns to the start of the loop, unless the timer is over
+    OP_JMP,                             // jumps to b
+    OP_JZ,                              // jumps to b if a is false
+    OP_JNZ,                             // jumps to b if a is true
+
+    OP_LDI,                             // dst = integer b
+    OP_LDF,                             // dst = float f
+    OP_MOV,                             // dst = a
+    OP_ITOF,                            // dst = float(a)
+    OP_FTOI,                            // dst = int(a)
+
+    OP_ADDI, OP_SUBI, OP_MULI, OP_DIVI, OP_MODI,
+    OP_ANDI, OP_ORI, OP_XORI, OP_SLI, OP_SRI, OP_ASRI,
+    OP_NEGI, OP_NOTI, OP_NOTB, OP_INCI, OP_DECI,
+    OP_LOI, OP_LSI, OP_HII, OP_HSI, OP_EQI, OP_NEI,
+
+    OP_ADDF, OP_SUBF, OP_MULF, OP_DIVF, OP_MODF,
+    OP_NEGF, OP_INCF, OP_DECF,
+    OP_LOF, OP_LSF, OP_HIF, OP_HSF, OP_EQF, OP_NEF,
+
+    OP_LDAI,                            // dst = element b of the array in variable a
+    OP_LDAF,
+    OP_STAI,                            // element b of the array in variable dst = a
+    OP_STAF
+};
+
+// an operation of the bytecode
+struct CBotOp
+{
+    int             code;               // CBotOpCode
+    int             dst;                // register written, -1 if none
+    int             a;                  // first operand
+    int             b;                  // second operand, integer constant or jump target
+    float           f;                  // float constant
+    CBotToken*      token;              // position of the possible error
+    int             steps;              // steps of the timer counted before the operation
+};
+
+// content of a register
+union CBotReg
+{
+    int             i;                  // int and boolean
+    float           f;
+};
+
+// variable used by a compiled loop, its register is its index
+struct CBotCodeVar
+{
+    long            ident;              // unique number of the variable
+    int             type;               // CBotTypInt, CBotTypFloat, CBotTypBoolean or CBotTypArrayPointer
+    int             elem;               // type of the elements of an array
+    bool            bLocal;             // declared inside the loop
+    bool            bRead;              // value used by the loop
+    bool            bWrite;             // value changed by the loop
+};
+
+// Innermost loops using only numbers, booleans and arrays of them are lowered
+// at compile time to a register bytecode; nothing else is. The loop runs it from
+// its first state, with the variables of the stack loaded in registers and stored
+// back when it leaves. It may only stop where the loop would also check the timer,
+// so the state of the stack is exactly the one of CBotWhile, CBotDo or CBotFor
+// (and SaveState / RestoreState are unchanged). The code counts the same steps
+// as the instructions would, each path of an iteration.
+
+class CBotByteCode
+{
+public:
+    enum
+    {
+        RunFallback,                    // the code can't be used, executes the instructions
+        RunEnd,                         // the loop is done (or in error)
+        RunSuspend                      // the timer is over, continues at the next Run
+    };
+
+                    CBotByteCode();
+                    ~CBotByteCode();
+
+    static
+    CBotByteCode*   Compile(CBotInstr* loop, CBotCStack* pStack);
+    int             Run(CBotStack* pile);
+
+    // used by CBotInstr::GenCode()
+    int             GetPos();
+    int             AddOp(int code, int dst = -1, int a = 0, int b = 0, CBotToken* token = NULL);
+    void            AddOpFloat(int dst, float f);
+    void            AddSteps(int n);
+    void            SetJump(int pos, int target);
+
+    int             NewTemp();
+    int             GetTemps();
+    void            FreeTemps(int mark);
+    bool            IsTemp(int reg);
+    int             GetWrites();
+
+    bool            GenVar(CBotToken* token, long ident, CBotInstr* index, bool bRead, bool bWrite,
+                           int& slot, int& reg, int& type);
+    bool            GenLoad(int slot, int index, int type, int& reg, CBotToken* token);
+    bool            GenStore(int slot, int index, int type, int reg, CBotToken* token);
+    bool            GenDecl(CBotInstr* var, CBotInstr* expr, int type);
+    bool            Convert(int& reg, int& type, int newtype);
+
+    bool            StartLoop(const CBotString& label);
+    bool            AddBreak(bool bContinue, const CBotString& label);
+    int             EndLoop(int head, int cont);
+
+private:
+    bool            FindVar(CBotToken* token, long ident, int& slot);
+
+    std::vector<CBotOp>         m_ops;
+    std::vector<CBotCodeVar>    m_vars;
+    std::vector<int>            m_breaks;       // jumps to the end of the loop
+    std::vector<int>            m_continues;    // jumps to the next iteration
+
+    CBotCStack*     m_stack;                    // for the types of the variables, during Compile()
+    CBotString      m_label;                    // label of the loop
+    bool            m_bLoop;                    // loop already started?
+    bool            m_bOver;                    // too many registers
+    int             m_temps;                    // temporary registers in use
+    int             m_writes;                   // number of writes to variable registers
+    int             m_steps;                    // steps counted by the next operation
+
+    // registers of the running loop, a loop contains no call so Run() is never nested
+    static thread_local
+    CBotReg         m_reg[CODEMAXREG];
+    static thread_local
+    CBotVar*        m_var[CODEMAXVAR];
+};
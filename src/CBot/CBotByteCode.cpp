@@ -0,0 +1,1052 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+///////////////////////////////////////////////////////////////////////
+// This file defines the bytecode back end:
+//      CBotByteCode        the compiled form of an innermost loop and its VM
+//      GenCode()           lowering of the instructions it accepts
+//
+// Only innermost loops are lowered. Each GenCode() adds the steps its
+// instruction counts with SetState() and IncState(), where they are
+// counted, so that an iteration costs the same on each path. Anything
+// else (calls, strings, classes, nested loops, return...) makes GenCode()
+// fail and the loop is executed by the instructions as before.
+
+
+#include "CBot.h"
+
+#include <math.h>
+
+
+thread_local CBotReg    CBotByteCode::m_reg[CODEMAXREG];
+thread_local CBotVar*   CBotByteCode::m_var[CODEMAXVAR];
+
+
+///////////////////////////////////////////////////////////////////////////
+// code generation
+
+CBotByteCode::CBotByteCode()
+{
+    m_stack     = NULL;
+    m_bLoop     = false;
+    m_bOver     = false;
+    m_temps     = 0;
+    m_writes    = 0;
+    m_steps     = 0;
+}
+
+CBotByteCode::~CBotByteCode()
+{
+}
+
+// lowers a loop, returns NULL if it is not possible
+
+CBotByteCode* CBotByteCode::Compile(CBotInstr* loop, CBotCStack* pStack)
+{
+    CBotByteCode*   code = new CBotByteCode();
+    int             reg, type;
+
+    code->m_stack = pStack;
+    bool ok = loop->GenCode(code, reg, type) && !code->m_bOver;
+    code->m_stack = NULL;
+
+    if ( ok ) return code;
+
+    delete code;
+    return NULL;
+}
+
+// the position may be the target of a jump,
+// the steps counted before it must not be counted by the jump
+
+int CBotByteCode::GetPos()
+{
+    if ( m_steps > 0 ) AddOp(OP_STEP);
+    return static_cast<int>( m_ops.size() );
+}
+
+int CBotByteCode::AddOp(int code, int dst, int a, int b, CBotToken* token)
+{
+    CBotOp  op;
+    op.code     = code;
+    op.dst      = dst;
+    op.a        = a;
+    op.b        = b;
+    op.f        = 0.0f;
+    op.token    = token;
+    op.steps    = m_steps;
+    m_ops.push_back(op);
+    m_steps = 0;
+
+    if ( dst >= 0 && dst < CODEMAXVAR ) m_writes++;     // a variable is changed
+    return static_cast<int>( m_ops.size() ) - 1;
+}
+
+void CBotByteCode::AddOpFloat(int dst, float f)
+{
+    m_ops[AddOp(OP_LDF, dst)].f = f;
+}
+
+// steps counted by the instructions, at the next operation
+
+void CBotByteCode::AddSteps(int n)
+{
+    m_steps += n;
+}
+
+void CBotByteCode::SetJump(int pos, int target)
+{
+    m_ops[pos].b = target;
+}
+
+int CBotByteCode::NewTemp()
+{
+    if ( CODEMAXVAR + m_temps >= CODEMAXREG )
+    {
+        m_bOver = true;
+        return CODEMAXVAR;
+    }
+    return CODEMAXVAR + m_temps++;
+}
+
+int CBotByteCode::GetTemps()
+{
+    return m_temps;
+}
+
+void CBotByteCode::FreeTemps(int mark)
+{
+    m_temps = mark;
+}
+
+bool CBotByteCode::IsTemp(int reg)
+{
+    return reg >= CODEMAXVAR;
+}
+
+int CBotByteCode::GetWrites()
+{
+    return m_writes;
+}
+
+// finds the slot of a variable of the loop or of the stack
+
+bool CBotByteCode::FindVar(CBotToken* token, long ident, int& slot)
+{
+    for ( slot = 0; slot < static_cast<int>( m_vars.size() ); slot++ )
+    {
+        if ( m_vars[slot].ident == ident ) return true;
+    }
+
+    // not seen yet, must be a variable declared before the loop
+    CBotToken*  pt  = token;
+    CBotVar*    var = m_stack->FindVar(pt);
+    if ( var == NULL || var->GetUniqNum() != ident ) return false;
+    if ( slot >= CODEMAXVAR ) return false;
+
+    CBotCodeVar v;
+    v.ident     = ident;
+    v.type      = var->GetType();
+    v.elem      = CBotTypVoid;
+    v.bLocal    = false;
+    v.bRead     = false;
+    v.bWrite    = false;
+
+    if ( v.type == CBotTypArrayPointer )
+    {
+        CBotTypResult elem = var->GetTypResult().GetTypElem();
+        v.elem = elem.GetType();
+        if ( v.elem != CBotTypInt && v.elem != CBotTypFloat && v.elem != CBotTypBoolean ) return false;
+    }
+    else if ( v.type != CBotTypInt && v.type != CBotTypFloat && v.type != CBotTypBoolean )
+    {
+        return false;
+    }
+
+    m_vars.push_back(v);
+    return true;
+}
+
+// a variable, or an element of an array (index is then the register of the position)
+
+bool CBotByteCode::GenVar(CBotToken* token, long ident, CBotInstr* index, bool bRead, bool bWrite,
+                          int& slot, int& reg, int& type)
+{
+    if ( !FindVar(token, ident, slot) ) return false;
+
+    CBotCodeVar& v = m_vars[slot];
+
+    if ( index == NULL )
+    {
+        if ( v.type == CBotTypArrayPointer ) return false;
+        v.bRead  = v.bRead  || bRead;
+        v.bWrite = v.bWrite || bWrite;
+        reg  = -1;
+        type = v.type;
+        return true;
+    }
+
+    // only one dimension
+    if ( v.type != CBotTypArrayPointer ||
+         !index->IsOfClass("CBotIndexExpr") ||
+         index->GetNext3() != NULL ) return false;
+
+    int elem = v.elem;
+    int t;
+    if ( !(static_cast<CBotIndexExpr*>(index))->m_expr->GenCode(this, reg, t) ) return false;
+    if ( t == CBotTypFloat && !Convert(reg, t, CBotTypInt) ) return false;
+    if ( t != CBotTypInt ) return false;
+    AddSteps(1);                            // as CBotIndexExpr
+
+    type = elem;
+    return true;
+}
+
+bool CBotByteCode::GenLoad(int slot, int index, int type, int& reg, CBotToken* token)
+{
+    if ( index < 0 )
+    {
+        reg = slot;                         // the register of the variable
+        return true;
+    }
+
+    reg = NewTemp();
+    AddOp( type == CBotTypFloat ? OP_LDAF : OP_LDAI, reg, slot, index, token );
+    return true;
+}
+
+bool CBotByteCode::GenStore(int slot, int index, int type, int reg, CBotToken* token)
+{
+    if ( index < 0 )
+    {
+        if ( reg != slot ) AddOp(OP_MOV, slot, reg);
+        return true;
+    }
+
+    AddOp( type == CBotTypFloat ? OP_STAF : OP_STAI, slot, reg, index, token );
+    return true;
+}
+
+// declaration of a local variable of the loop
+
+bool CBotByteCode::GenDecl(CBotInstr* var, CBotInstr* expr, int type)
+{
+    // without a value, reading the variable must give an error
+    // a named constant keeps its name in the variable
+    if ( expr == NULL || expr->GetTokenType() == TokenTypDef ) return false;
+
+    int     reg, t;
+    if ( !expr->GenCode(this, reg, t) || !Convert(reg, t, type) ) return false;
+
+    int     slot = static_cast<int>( m_vars.size() );
+    if ( slot >= CODEMAXVAR ) return false;
+
+    CBotCodeVar v;
+    v.ident     = (static_cast<CBotLeftExprVar*>(var))->m_nIdent;
+    v.type      = type;
+    v.elem      = CBotTypVoid;
+    v.bLocal    = true;
+    v.bRead     = false;
+    v.bWrite    = true;
+    m_vars.push_back(v);
+
+    AddOp(OP_MOV, slot, reg);
+    AddSteps(1);                            // SetState(1)
+    return true;
+}
+
+// conversion for an assignment
+
+bool CBotByteCode::Convert(int& reg, int& type, int newtype)
+{
+    if ( type == newtype ) return true;
+
+    if ( type == CBotTypInt && newtype == CBotTypFloat )
+    {
+        int r = NewTemp();
+        AddOp(OP_ITOF, r, reg);
+        reg = r;
+        type = newtype;
+        return true;
+    }
+    if ( type == CBotTypFloat && newtype == CBotTypInt )
+    {
+        int r = NewTemp();
+        AddOp(OP_FTOI, r, reg);
+        reg = r;
+        type = newtype;
+        return true;
+    }
+    return false;
+}
+
+bool CBotByteCode::StartLoop(const CBotString& label)
+{
+    if ( m_bLoop ) return false;            // the loop contains another one
+    m_bLoop = true;
+    m_label = label;
+    return true;
+}
+
+bool CBotByteCode::AddBreak(bool bContinue, const CBotString& label)
+{
+    if ( !label.IsEmpty() && label != m_label ) return false;      // leaves an outer loop
+
+    int pos = AddOp(OP_JMP);
+    if ( bContinue ) m_continues.push_back(pos);
+    else             m_breaks.push_back(pos);
+    return true;
+}
+
+// closes the loop, returns the position of its end
+
+int CBotByteCode::EndLoop(int head, int cont)
+{
+    AddOp(OP_LOOP, -1, 0, head);
+    int exit = AddOp(OP_END);
+
+    for ( int i = 0; i < static_cast<int>( m_breaks.size() ); i++ )
+        SetJump(m_breaks[i], exit);
+    for ( int i = 0; i < static_cast<int>( m_continues.size() ); i++ )
+        SetJump(m_continues[i], cont);
+
+    return exit;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+// execution
+
+int CBotByteCode::Run(CBotStack* pile)
+{
+    if ( pile->IsStepMode() ) return RunFallback;       // shows each instruction
+
+    CBotReg*    reg = m_reg;
+    CBotVar**   var = m_var;
+    int         nbvar = static_cast<int>( m_vars.size() );
+
+    // loads the variables from the stack
+    for ( int i = 0; i < nbvar; i++ )
+    {
+        const CBotCodeVar& v = m_vars[i];
+
+        var[i] = NULL;
+        if ( v.bLocal ) continue;
+
+        CBotVar* p = pile->FindVar(v.ident);
+        if ( p == NULL || p->GetType() != v.type ) return RunFallback;
+        var[i] = p;
+
+        if ( v.type == CBotTypArrayPointer ) continue;
+        if ( !v.bRead && !v.bWrite ) continue;
+
+        // the instructions give the errors for undefined values,
+        // and a variable not changed by the loop must keep its value
+        if ( p->GetInit() != IS_DEF ) return RunFallback;
+
+        if ( v.type == CBotTypFloat ) reg[i].f = p->GetValFloat();
+        else                          reg[i].i = p->GetValInt();
+    }
+
+    const CBotOp*   ops     = &m_ops[0];
+    int             timer   = pile->GetTimerLeft();
+    int             result  = RunEnd;
+    int             pc      = 0;
+    CBotVar*        item;
+
+    while ( true )
+    {
+        const CBotOp& op = ops[pc++];
+        timer -= op.steps;
+
+        switch ( op.code )
+        {
+        case OP_END:
+            goto end;
+        case OP_STEP:
+            break;
+        case OP_LOOP:
+            if ( timer <= 0 )
+            {
+                result = RunSuspend;            // as SetState(0, 0) of the loop
+                goto end;
+            }
+            pc = op.b;
+            break;
+        case OP_JMP:
+            pc = op.b;
+            break;
+        case OP_JZ:
+            if ( reg[op.a].i == 0 ) pc = op.b;
+            break;
+        case OP_JNZ:
+            if ( reg[op.a].i != 0 ) pc = op.b;
+            break;
+
+        case OP_LDI:
+            reg[op.dst].i = op.b;
+            break;
+        case OP_LDF:
+            reg[op.dst].f = op.f;
+            break;
+        case OP_MOV:
+            reg[op.dst] = reg[op.a];
+            break;
+        case OP_ITOF:
+            reg[op.dst].f = static_cast<float>(reg[op.a].i);
+            break;
+        case OP_FTOI:
+            reg[op.dst].i = static_cast<int>(reg[op.a].f);
+            break;
+
+        case OP_ADDI:
+            reg[op.dst].i = reg[op.a].i + reg[op.b].i;
+            break;
+        case OP_SUBI:
+            reg[op.dst].i = reg[op.a].i - reg[op.b].i;
+            break;
+        case OP_MULI:
+            reg[op.dst].i = reg[op.a].i * reg[op.b].i;
+            break;
+        case OP_DIVI:
+            if ( reg[op.b].i == 0 )
+            {
+                pile->SetError(TX_DIVZERO, op.token);
+                goto end;
+            }
+            reg[op.dst].i = reg[op.a].i / reg[op.b].i;
+            break;
+        case OP_MODI:
+            if ( reg[op.b].i == 0 )
+            {
+                pile->SetError(TX_DIVZERO, op.token);
+                goto end;
+            }
+            reg[op.dst].i = reg[op.a].i % reg[op.b].i;
+            break;
+        case OP_ANDI:
+            reg[op.dst].i = reg[op.a].i & reg[op.b].i;
+            break;
+        case OP_ORI:
+            reg[op.dst].i = reg[op.a].i | reg[op.b].i;
+            break;
+        case OP_XORI:
+            reg[op.dst].i = reg[op.a].i ^ reg[op.b].i;
+            break;
+        case OP_SLI:
+            reg[op.dst].i = reg[op.a].i << reg[op.b].i;
+            break;
+        case OP_SRI:
+            {
+                int source = reg[op.a].i;                // as CBotVarInt::SR
+                if ( reg[op.b].i >= 1 ) source &= 0x7fffffff;
+                reg[op.dst].i = source >> reg[op.b].i;
+            }
+            break;
+        case OP_ASRI:
+            reg[op.dst].i = reg[op.a].i >> reg[op.b].i;
+            break;
+        case OP_NEGI:
+            reg[op.dst].i = -reg[op.a].i;
+            break;
+        case OP_NOTI:
+            reg[op.dst].i = ~reg[op.a].i;
+            break;
+        case OP_NOTB:
+            reg[op.dst].i = !reg[op.a].i;
+            break;
+        case OP_INCI:
+            reg[op.dst].i++;
+            break;
+        case OP_DECI:
+            reg[op.dst].i--;
+            break;
+        case OP_LOI:
+            reg[op.dst].i = reg[op.a].i < reg[op.b].i;
+            break;
+        case OP_LSI:
+            reg[op.dst].i = reg[op.a].i <= reg[op.b].i;
+            break;
+        case OP_HII:
+            reg[op.dst].i = reg[op.a].i > reg[op.b].i;
+            break;
+        case OP_HSI:
+            reg[op.dst].i = reg[op.a].i >= reg[op.b].i;
+            break;
+        case OP_EQI:
+            reg[op.dst].i = reg[op.a].i == reg[op.b].i;
+            break;
+        case OP_NEI:
+            reg[op.dst].i = reg[op.a].i != reg[op.b].i;
+            break;
+
+        case OP_ADDF:
+            reg[op.dst].f = reg[op.a].f + reg[op.b].f;
+            break;
+        case OP_SUBF:
+            reg[op.dst].f = reg[op.a].f - reg[op.b].f;
+            break;
+        case OP_MULF:
+            reg[op.dst].f = reg[op.a].f * reg[op.b].f;
+            break;
+        case OP_DIVF:
+            if ( reg[op.b].f == 0 )
+            {
+                pile->SetError(TX_DIVZERO, op.token);
+                goto end;
+            }
+            reg[op.dst].f = reg[op.a].f / reg[op.b].f;
+            break;
+        case OP_MODF:
+            if ( reg[op.b].f == 0 )
+            {
+                pile->SetError(TX_DIVZERO, op.token);
+                goto end;
+            }
+            reg[op.dst].f = static_cast<float>(fmod( reg[op.a].f, reg[op.b].f ));
+            break;
+        case OP_NEGF:
+            reg[op.dst].f = -reg[op.a].f;
+            break;
+        case OP_INCF:
+            reg[op.dst].f++;
+            break;
+        case OP_DECF:
+            reg[op.dst].f--;
+            break;
+        case OP_LOF:
+            reg[op.dst].i = reg[op.a].f < reg[op.b].f;
+            break;
+        case OP_LSF:
+            reg[op.dst].i = reg[op.a].f <= reg[op.b].f;
+            break;
+        case OP_HIF:
+            reg[op.dst].i = reg[op.a].f > reg[op.b].f;
+            break;
+        case OP_HSF:
+            reg[op.dst].i = reg[op.a].f >= reg[op.b].f;
+            break;
+        case OP_EQF:
+            reg[op.dst].i = reg[op.a].f == reg[op.b].f;
+            break;
+        case OP_NEF:
+            reg[op.dst].i = reg[op.a].f != reg[op.b].f;
+            break;
+
+        case OP_LDAI:
+        case OP_LDAF:
+            item = (static_cast<CBotVarArray*>(var[op.a]))->GetItem(reg[op.b].i, false);
+            if ( item == NULL )
+            {
+                pile->SetError(TX_OUTARRAY, op.token);
+                goto end;
+            }
+            // a nan element can only be copied by the instructions, it is refused here
+            if ( item->GetInit() != IS_DEF )
+            {
+                pile->SetError(item->GetInit() == IS_NAN ? TX_OPNAN : TX_NOTINIT, op.token);
+                goto end;
+            }
+            if ( op.code == OP_LDAF ) reg[op.dst].f = item->GetValFloat();
+            else                      reg[op.dst].i = item->GetValInt();
+            break;
+        case OP_STAI:
+        case OP_STAF:
+            item = (static_cast<CBotVarArray*>(var[op.dst]))->GetItem(reg[op.b].i, true);
+            if ( item == NULL )
+            {
+                pile->SetError(TX_OUTARRAY, op.token);
+                goto end;
+            }
+            if ( op.code == OP_STAF ) item->SetValFloat(reg[op.a].f);
+            else                      item->SetValInt(reg[op.a].i);
+            break;
+        }
+    }
+
+end:
+    pile->SetTimerLeft(timer);
+
+    // stores the variables changed by the loop
+    for ( int i = 0; i < nbvar; i++ )
+    {
+        const CBotCodeVar& v = m_vars[i];
+        if ( v.bLocal || !v.bWrite ) continue;
+
+        if ( v.type == CBotTypFloat ) var[i]->SetValFloat(reg[i].f);
+        else                          var[i]->SetValInt(reg[i].i);
+    }
+
+    return result;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+// lowering of the instructions
+
+bool CBotInstr::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    return false;                               // not possible by default
+}
+
+bool CBotWhile::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    if ( !pCode->StartLoop(m_label) ) return false;
+
+    int head = pCode->GetPos();
+
+    int cond, t;
+    if ( !m_Condition->GenCode(pCode, cond, t) || t != CBotTypBoolean ) return false;
+    int test = pCode->AddOp(OP_JZ, -1, cond);
+    pCode->AddSteps(1);                                 // SetState(1)
+
+    if ( m_Block != NULL &&
+         !m_Block->GenCode(pCode, reg, type) ) return false;
+    pCode->AddSteps(1);                                 // SetState(0, 0), not counted by continue
+
+    pCode->SetJump(test, pCode->EndLoop(head, pCode->GetPos()));
+    return true;
+}
+
+bool CBotDo::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    if ( !pCode->StartLoop(m_label) ) return false;
+
+    int head = pCode->GetPos();
+
+    if ( m_Block != NULL &&
+         !m_Block->GenCode(pCode, reg, type) ) return false;
+    pCode->AddSteps(1);                                 // SetState(1), not counted by continue
+
+    int cont = pCode->GetPos();
+    int cond, t;
+    if ( !m_Condition->GenCode(pCode, cond, t) || t != CBotTypBoolean ) return false;
+    int test = pCode->AddOp(OP_JZ, -1, cond);
+    pCode->AddSteps(1);                                 // SetState(0, 0)
+
+    pCode->SetJump(test, pCode->EndLoop(head, cont));
+    return true;
+}
+
+// the initialization is done by the instructions, the code starts at the test
+
+bool CBotFor::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    if ( !pCode->StartLoop(m_label) ) return false;
+
+    int head = pCode->GetPos();
+    int test = -1;
+
+    if ( m_Test != NULL )
+    {
+        int cond, t;
+        if ( !m_Test->GenCode(pCode, cond, t) || t != CBotTypBoolean ) return false;
+        test = pCode->AddOp(OP_JZ, -1, cond);
+    }
+    pCode->AddSteps(1);                                 // SetState(2)
+
+    if ( m_Block != NULL &&
+         !m_Block->GenCode(pCode, reg, type) ) return false;
+    pCode->AddSteps(1);                                 // SetState(3), not counted by continue
+
+    int cont = pCode->GetPos();
+    if ( m_Incr != NULL &&
+         !m_Incr->GenCode(pCode, reg, type) ) return false;
+    pCode->AddSteps(1);                                 // SetState(1, 0)
+
+    int exit = pCode->EndLoop(head, cont);
+    if ( test >= 0 ) pCode->SetJump(test, exit);
+    return true;
+}
+
+bool CBotBreak::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    return pCode->AddBreak(GetTokenType() == ID_CONTINUE, m_label);
+}
+
+bool CBotIf::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    int cond, t;
+    if ( !m_Condition->GenCode(pCode, cond, t) || t != CBotTypBoolean ) return false;
+    pCode->AddSteps(1);                                 // SetState(1)
+    int test = pCode->AddOp(OP_JZ, -1, cond);
+
+    if ( m_Block != NULL &&
+         !m_Block->GenCode(pCode, reg, type) ) return false;
+
+    if ( m_BlockElse != NULL )
+    {
+        int jump = pCode->AddOp(OP_JMP);
+        pCode->SetJump(test, pCode->GetPos());
+        if ( !m_BlockElse->GenCode(pCode, reg, type) ) return false;
+        pCode->SetJump(jump, pCode->GetPos());
+    }
+    else
+    {
+        pCode->SetJump(test, pCode->GetPos());
+    }
+    return true;
+}
+
+// each instruction releases its temporary registers,
+// a step is counted between two of them
+
+bool CBotListInstr::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    for ( CBotInstr* p = m_Instr; p != NULL; p = p->GetNext() )
+    {
+        int mark = pCode->GetTemps();
+        if ( p != m_Instr ) pCode->AddSteps(1);
+        if ( !p->GenCode(pCode, reg, type) ) return false;
+        pCode->FreeTemps(mark);
+    }
+    return true;
+}
+
+bool CBotListExpression::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    for ( CBotInstr* p = m_Expr; p != NULL; p = p->GetNext() )
+    {
+        int mark = pCode->GetTemps();
+        if ( p != m_Expr ) pCode->AddSteps(1);
+        if ( !p->GenCode(pCode, reg, type) ) return false;
+        pCode->FreeTemps(mark);
+    }
+    return true;
+}
+
+bool CBotEmpty::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    return true;
+}
+
+bool CBotInt::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    if ( !pCode->GenDecl(m_var, m_expr, CBotTypInt) ) return false;
+    return m_next2b == NULL || m_next2b->GenCode(pCode, reg, type);
+}
+
+bool CBotFloat::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    if ( !pCode->GenDecl(m_var, m_expr, CBotTypFloat) ) return false;
+    return m_next2b == NULL || m_next2b->GenCode(pCode, reg, type);
+}
+
+bool CBotBoolean::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    if ( !pCode->GenDecl(m_var, m_expr, CBotTypBoolean) ) return false;
+    return m_next2b == NULL || m_next2b->GenCode(pCode, reg, type);
+}
+
+// assignments, the value of the variable is read before the right operand
+
+bool CBotExpression::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    int op = GetTokenType();
+
+    // a named constant keeps its name in the variable
+    if ( op == ID_ASS && m_rightop->GetTokenType() == TokenTypDef ) return false;
+
+    int slot, index, value = -1;
+    if ( !m_leftop->GenVar(pCode, op != ID_ASS, slot, index, type) ) return false;
+    if ( op != ID_ASS &&
+         !pCode->GenLoad(slot, index, type, value, m_leftop->GetToken()) ) return false;
+
+    int writes = pCode->GetWrites();
+    int right, t;
+    if ( !m_rightop->GenCode(pCode, right, t) ) return false;
+    pCode->AddSteps(3);                                 // IncState() of both stacks and the result
+
+    // the right operand changes a register already read
+    if ( pCode->GetWrites() != writes &&
+         ((index >= 0 && !pCode->IsTemp(index)) || (value >= 0 && !pCode->IsTemp(value))) ) return false;
+
+    if ( op == ID_ASS )
+    {
+        if ( !pCode->Convert(right, t, type) ) return false;
+        if ( !pCode->GenStore(slot, index, type, right, m_leftop->GetToken()) ) return false;
+        reg = index < 0 ? slot : right;
+        return true;
+    }
+
+    // the operation is done in the type of the variable
+    if ( !pCode->Convert(right, t, type) ) return false;
+
+    int code = -1;
+    if ( type == CBotTypInt )
+    {
+        switch ( op )
+        {
+        case ID_ASSADD:     code = OP_ADDI; break;
+        case ID_ASSSUB:     code = OP_SUBI; break;
+        case ID_ASSMUL:     code = OP_MULI; break;
+        case ID_ASSDIV:     code = OP_DIVI; break;
+        case ID_ASSMODULO:  code = OP_MODI; break;
+        case ID_ASSAND:     code = OP_ANDI; break;
+        case ID_ASSOR:      code = OP_ORI;  break;
+        case ID_ASSXOR:     code = OP_XORI; break;
+        case ID_ASSSL:      code = OP_SLI;  break;
+        case ID_ASSSR:      code = OP_SRI;  break;
+        case ID_ASSASR:     code = OP_ASRI; break;
+        }
+    }
+    if ( type == CBotTypFloat )
+    {
+        switch ( op )
+        {
+        case ID_ASSADD:     code = OP_ADDF; break;
+        case ID_ASSSUB:     code = OP_SUBF; break;
+        case ID_ASSMUL:     code = OP_MULF; break;
+        case ID_ASSDIV:     code = OP_DIVF; break;
+        case ID_ASSMODULO:  code = OP_MODF; break;
+        }
+    }
+    if ( type == CBotTypBoolean )
+    {
+        switch ( op )
+        {
+        case ID_ASSAND:     code = OP_ANDI; break;
+        case ID_ASSOR:      code = OP_ORI;  break;
+        case ID_ASSXOR:     code = OP_XORI; break;
+        }
+    }
+    if ( code < 0 ) return false;
+
+    reg = pCode->NewTemp();
+    pCode->AddOp(code, reg, value, right, &m_token);
+    if ( !pCode->GenStore(slot, index, type, reg, m_leftop->GetToken()) ) return false;
+    if ( index < 0 ) reg = slot;
+    return true;
+}
+
+bool CBotLeftExpr::GenVar(CBotByteCode* pCode, bool bRead, int& slot, int& index, int& type)
+{
+    return pCode->GenVar(&m_token, m_nIdent, m_next3, bRead, true, slot, index, type);
+}
+
+bool CBotExprVar::GenVar(CBotByteCode* pCode, bool bRead, bool bWrite, int& slot, int& index, int& type)
+{
+    return pCode->GenVar(&m_token, m_nIdent, m_next3, bRead, bWrite, slot, index, type);
+}
+
+bool CBotExprVar::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    int slot, index;
+    if ( !GenVar(pCode, true, false, slot, index, type) ) return false;
+    pCode->AddSteps(1);                                 // IncState()
+    return pCode->GenLoad(slot, index, type, reg, &m_token);
+}
+
+bool CBotExprNum::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    reg = pCode->NewTemp();
+
+    switch ( m_numtype )
+    {
+    case CBotTypShort:
+    case CBotTypInt:
+        pCode->AddOp(OP_LDI, reg, 0, m_valint);
+        type = CBotTypInt;
+        return true;
+    case CBotTypFloat:
+        pCode->AddOpFloat(reg, m_valfloat);
+        type = CBotTypFloat;
+        return true;
+    }
+    return false;
+}
+
+bool CBotExprBool::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    reg = pCode->NewTemp();
+    pCode->AddOp(OP_LDI, reg, 0, GetTokenType() == ID_TRUE ? 1 : 0);
+    type = CBotTypBoolean;
+    return true;
+}
+
+bool CBotExprUnaire::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    int value;
+    if ( !m_Expr->GenCode(pCode, value, type) ) return false;
+    pCode->AddSteps(1);                                 // IncState()
+
+    int code = -1;
+    switch ( GetTokenType() )
+    {
+    case ID_ADD:
+        reg = value;
+        return type != CBotTypBoolean;
+    case ID_SUB:
+        if ( type == CBotTypInt )   code = OP_NEGI;
+        if ( type == CBotTypFloat ) code = OP_NEGF;
+        break;
+    case ID_NOT:
+        if ( type == CBotTypInt )   code = OP_NOTI;
+        break;
+    case ID_LOG_NOT:
+    case ID_TXT_NOT:
+        if ( type == CBotTypBoolean ) code = OP_NOTB;
+        break;
+    }
+    if ( code < 0 ) return false;
+
+    reg = pCode->NewTemp();
+    pCode->AddOp(code, reg, value);
+    return true;
+}
+
+// the increment and decrement keep the value of the variable in a temporary register
+
+bool CBotPostIncExpr::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    int slot, index, value;
+    if ( !(static_cast<CBotExprVar*>(m_Instr))->GenVar(pCode, true, true, slot, index, type) ) return false;
+    if ( type != CBotTypInt && type != CBotTypFloat ) return false;
+    if ( !pCode->GenLoad(slot, index, type, value, &m_token) ) return false;
+    pCode->AddSteps(1);                                 // SetState(1)
+
+    reg = pCode->NewTemp();
+    pCode->AddOp(OP_MOV, reg, value);                   // value before incrementation
+
+    int code;
+    if ( type == CBotTypInt ) code = GetTokenType() == ID_INC ? OP_INCI : OP_DECI;
+    else                      code = GetTokenType() == ID_INC ? OP_INCF : OP_DECF;
+
+    if ( index < 0 )
+    {
+        pCode->AddOp(code, slot);
+        return true;
+    }
+
+    pCode->AddOp(code, value);
+    return pCode->GenStore(slot, index, type, value, &m_token);
+}
+
+bool CBotPreIncExpr::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    int slot, index;
+    if ( !(static_cast<CBotExprVar*>(m_Instr))->GenVar(pCode, true, true, slot, index, type) ) return false;
+    if ( type != CBotTypInt && type != CBotTypFloat ) return false;
+    if ( index >= 0 ) return false;                     // the instructions evaluate the index twice
+    if ( !pCode->GenLoad(slot, index, type, reg, &m_token) ) return false;
+    pCode->AddSteps(2);                                 // IncState() of the instruction and of the variable
+
+    int code;
+    if ( type == CBotTypInt ) code = GetTokenType() == ID_INC ? OP_INCI : OP_DECI;
+    else                      code = GetTokenType() == ID_INC ? OP_INCF : OP_DECF;
+
+    pCode->AddOp(code, reg);
+    return pCode->GenStore(slot, index, type, reg, &m_token);
+}
+
+bool CBotLogicExpr::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    int cond, t;
+    if ( !m_condition->GenCode(pCode, cond, t) || t != CBotTypBoolean ) return false;
+    pCode->AddSteps(1);                                 // SetState(1)
+    int test = pCode->AddOp(OP_JZ, -1, cond);
+
+    int value;
+    reg = pCode->NewTemp();
+    if ( !m_op1->GenCode(pCode, value, type) ) return false;
+    pCode->AddOp(OP_MOV, reg, value);
+    int jump = pCode->AddOp(OP_JMP);
+
+    // both values must be of the same type, as the result of the instruction
+    pCode->SetJump(test, pCode->GetPos());
+    if ( !m_op2->GenCode(pCode, value, t) || t != type ) return false;
+    pCode->AddOp(OP_MOV, reg, value);
+    pCode->SetJump(jump, pCode->GetPos());
+    return true;
+}
+
+bool CBotTwoOpExpr::GenCode(CBotByteCode* pCode, int& reg, int& type)
+{
+    int op = GetTokenType();
+    int left, right, type1, type2;
+
+    if ( op == ID_LOG_AND || op == ID_TXT_AND || op == ID_LOG_OR || op == ID_TXT_OR )
+    {
+        // does not evaluate the second operand if not necessary
+        reg = pCode->NewTemp();
+        if ( !m_leftop->GenCode(pCode, left, type1) || type1 != CBotTypBoolean ) return false;
+        pCode->AddOp(OP_MOV, reg, left);
+        int test = pCode->AddOp( (op == ID_LOG_AND || op == ID_TXT_AND) ? OP_JZ : OP_JNZ, -1, reg );
+        pCode->AddSteps(1);                             // SetState(1)
+        if ( !m_rightop->GenCode(pCode, right, type2) || type2 != CBotTypBoolean ) return false;
+        pCode->AddSteps(1);                             // IncState()
+        pCode->AddOp(OP_MOV, reg, right);
+        pCode->SetJump(test, pCode->GetPos());
+        type = CBotTypBoolean;
+        return true;
+    }
+
+    if ( !m_leftop->GenCode(pCode, left, type1) ) return false;
+    int writes = pCode->GetWrites();
+    if ( !m_rightop->GenCode(pCode, right, type2) ) return false;
+    pCode->AddSteps(2);                                 // SetState(1) and IncState()
+
+    // the right operand changes the variable of the left one
+    if ( !pCode->IsTemp(left) && pCode->GetWrites() != writes ) return false;
+
+    bool    bNum  = type1 != CBotTypBoolean && type2 != CBotTypBoolean;
+    bool    bBool = type1 == CBotTypBoolean && type2 == CBotTypBoolean;
+    bool    bInt  = type1 == CBotTypInt     && type2 == CBotTypInt;
+
+    // the operation is done in the greatest type, as with the variables
+    type = (type1 == CBotTypFloat || type2 == CBotTypFloat) ? CBotTypFloat : type1;
+    if ( op == ID_DIV ) type = CBotTypFloat;
+    if ( bNum && (!pCode->Convert(left, type1, type) || !pCode->Convert(right, type2, type)) ) return false;
+    bool    bFloat = bNum && type == CBotTypFloat;
+
+    int code = -1;
+    switch ( op )
+    {
+    case ID_ADD:    if ( bNum ) code = bFloat ? OP_ADDF : OP_ADDI; break;
+    case ID_SUB:    if ( bNum ) code = bFloat ? OP_SUBF : OP_SUBI; break;
+    case ID_MUL:    if ( bNum ) code = bFloat ? OP_MULF : OP_MULI; break;
+    case ID_DIV:    if ( bNum ) code = OP_DIVF; break;
+    case ID_MODULO: if ( bNum ) code = bFloat ? OP_MODF : OP_MODI; break;
+    case ID_AND:    if ( bInt || bBool ) code = OP_ANDI; break;
+    case ID_OR:     if ( bInt || bBool ) code = OP_ORI;  break;
+    case ID_XOR:    if ( bInt || bBool ) code = OP_XORI; break;
+    case ID_SL:     if ( bInt ) code = OP_SLI;  break;
+    case ID_SR:     if ( bInt ) code = OP_SRI;  break;
+    case ID_ASR:    if ( bInt ) code = OP_ASRI; break;
+    case ID_LO:     if ( bNum ) code = bFloat ? OP_LOF : OP_LOI; break;
+    case ID_LS:     if ( bNum ) code = bFloat ? OP_LSF : OP_LSI; break;
+    case ID_HI:     if ( bNum ) code = bFloat ? OP_HIF : OP_HII; break;
+    case ID_HS:     if ( bNum ) code = bFloat ? OP_HSF : OP_HSI; break;
+    case ID_EQ:     if ( bNum || bBool ) code = bFloat ? OP_EQF : OP_EQI; break;
+    case ID_NE:     if ( bNum || bBool ) code = bFloat ? OP_NEF : OP_NEI; break;
+    }
+    if ( code < 0 ) return false;
+
+    switch ( op )
+    {
+    case ID_LO:
+    case ID_LS:
+    case ID_HI:
+    case ID_HS:
+    case ID_EQ:
+    case ID_NE:
+        type = CBotTypBoolean;
+    }
+
+    reg = pCode->NewTemp();
+    pCode->AddOp(code, reg, left, right, &m_token);
+    return true;
+}
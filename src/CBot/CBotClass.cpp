@@ -50,6 +50,7 @@ CBotClass::CBotClass(const char* name, CBotClass* pPapa, bool bIntrinsic)
     m_ExPrev  = NULL;
     m_ExClass = this;
 
+    CBotProgramCode::NewGeneration();
 }
 
 CBotClass::~CBotClass()
@@ -62,6 +63,8 @@ CBotClass::~CBotClass()
     m_ExPrev = NULL;
     m_ExNext = NULL;
 
+    CBotProgramCode::NewGeneration();
+
     delete  m_pVar;
     delete  m_pCalls;
     delete  m_pMethod;
@@ -82,6 +85,8 @@ void CBotClass::Purge()
 {
     if ( this == NULL ) return;
 
+    CBotProgramCode::NewGeneration();
+
     delete      m_pVar;
     m_pVar      = NULL;
     delete      m_pCalls;
@@ -326,6 +331,31 @@ bool CBotClass::AddUpdateFunc( void rMaj ( CBotVar* pThis, void* pUser ) )
     return true;
 }
 
+bool CBotClass::HasSharedData()
+{
+    CBotClass*  p = m_ExClass;
+
+    while ( p != NULL )
+    {
+        CBotVar*    pv = p->m_pVar;
+        while ( pv != NULL )
+        {
+            if ( pv->IsStatic() ) return true;
+            pv = pv->GetNext();
+        }
+
+        CBotFunction*   pf = p->m_pMethod;
+        while ( pf != NULL )
+        {
+            if ( pf->IsSynchro() ) return true;
+            pf = pf->Next();
+        }
+
+        p = p->m_ExNext;
+    }
+    return false;
+}
+
 // compiles a method associated with an instance of class
 // the method can be declared by the user or AddFunction
 
@@ -750,7 +780,8 @@ bool CBotClassInst::Execute(CBotStack* &pj)
             // creates a variable for the result
             CBotVar*    pResult = NULL;     // constructor still void
 
-            if ( !pClass->ExecuteMethode(m_nMethodeIdent, pClass->GetName(), 
+            long nIdent = m_nMethodeIdent;
+            if ( !pClass->ExecuteMethode(nIdent, pClass->GetName(), 
                                          pThis, ppVars, 
                                          pResult, pile2, GetToken())) return false; // interrupt
 
@@ -847,7 +878,8 @@ void CBotClassInst::RestoreState(CBotStack* &pj, bool bMain)
             // creates a variable for the result
 //            CBotVar*    pResult = NULL;     // constructor still void
 
-            pClass->RestoreMethode(m_nMethodeIdent, pClass->GetName(), pThis, ppVars, pile2);
+            long nIdent = m_nMethodeIdent;
+            pClass->RestoreMethode(nIdent, pClass->GetName(), pThis, ppVars, pile2);
             return;
         }
     }
@@ -46,6 +46,7 @@ class CBotCall;         // functions
 class CBotCallMethode;  // methods
 class CBotDefParam;     // parameter list
 class CBotCStack;       // stack
+class CBotProgramCode;  // functions shared by identical programs
 
 
 ////////////////////////////////////////////////////////////////////////
@@ -367,6 +368,7 @@ private:
     CBotClass*        m_pClass;        // classes defined in this part
     CBotStack*        m_pStack;        // execution stack
     CBotVar*        m_pInstance;    // instance of the parent class
+    CBotProgramCode* m_pCode;       // shared code of m_Prog, or NULL if m_Prog is only ours
     friend class    CBotFunction;
 
     int                m_ErrorCode;
@@ -375,6 +377,15 @@ private:
 
     long            m_Ident;        // associated identifier
 
+    int             m_quota;        // steps for each Run(), -1 for the default given to SetTimer()
+    int             m_stepsUsed;    // steps done in the last Run()
+    long            m_allocUsed;    // variables and stack levels created by the last Run()
+    long            m_heapUsed;     // those which were not taken from a free list
+    bool            m_bDeferred;    // last Run() stopped on a call for the main thread
+
+    void            FreeFunctions();
+    void            ShareFunctions(const char* program, CBotStringArray& ListFonctions);
+
 public:
     static CBotString        m_DebugVarStr;    // end of a debug
     bool m_bDebugDD;        // idem déclanchable par robot \TODO ???
@@ -431,6 +442,7 @@ public:
     //                returns false if the program was suspended
     //                returns true if the program ended with or without error
     //                timer = 0 allows to advance step by step
+    //                timer < 0 uses the quota of this program (see SetQuota)
 
     bool            GetRunPos(const char* &FunctionName, int &start, int &end);
     //                gives the position in the executing program
@@ -454,13 +466,46 @@ public:
     void            SetTimer(int n);
     //                defines the number of steps (parts of instructions) to done  
     //                in Run() before rendering hand "false" \TODO avant de rendre la main "false"
+    //                this is the default for all programs without their own quota
+
+    void            SetQuota(int n);
+    int             GetQuota();
+    //                defines the number of steps done in each Run() of this program only
+    //                n < 0 uses the default given to SetTimer()
+
+    int             GetStepsUsed();
+    //                gives the number of steps done in the last Run()
+
+    void            GetAllocUsed(long& nAlloc, long& nHeap);
+    //                gives the number of variables of simple types and stack levels
+    //                created in the last Run(), and how many of them needed the heap
+
+    static
+    void            SetWorkerThread(bool bWorker);
+    //                declares the current thread as running programs in parallel with others
+    //                there Run() stops before any function not added as thread safe
+    //                and before any method of a class defined by AddFunction;
+    //                the host then resumes the program with Run() on the main thread
+    //                the routines given to AddUpdateFunc are not called there,
+    //                so the host must update these instances before
+
+    bool            IsDeferred();
+    //                returns true if the last Run() stopped on a call for the main thread
+
+    static
+    void            RunDeferred();
+    //                runs on the main thread the destructors of the instances
+    //                released by programs in worker threads
 
     static
     bool            AddFunction(const char* name, 
                                 bool rExec (CBotVar* pVar, CBotVar* pResult, int& Exception, void* pUser), 
-                                CBotTypResult rCompile (CBotVar* &pVar, void* pUser));
+                                CBotTypResult rCompile (CBotVar* &pVar, void* pUser),
+                                bool bThreadSafe = false);
     //                call this to add externally (**)
     //                a new function used by the program CBoT
+    //                bThreadSafe declares that rExec only reads data
+    //                and may be called by several worker threads at once
 
     static
     bool            DefineNum(const char* name, long val);
@@ -812,6 +857,11 @@ public:
     bool            AddUpdateFunc( void rMaj ( CBotVar* pThis, void* pUser ) );
     //                defines routine to be called to update the elements of the class
 
+    static
+    bool            HasSharedData();
+    //                returns true if a class has static elements or synchronized methods,
+    //                by which programs running in parallel could interact
+
     bool            AddItem(CBotString name, CBotTypResult type, int mPrivate = PR_PUBLIC);
     //                adds an element to the class
 //    bool            AddItem(CBotString name, CBotClass* pClass);
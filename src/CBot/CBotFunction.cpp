@@ -36,6 +36,8 @@ CBotFunction::CBotFunction()
 //  m_nThisIdent = 0;
     m_nFuncIdent = 0;
     m_bSynchro    = false;
+    m_nFirstIdent = 0;
+    m_nSlots     = 0;
 }
 
 CBotFunction* CBotFunction::m_listPublic = NULL;
@@ -49,6 +51,8 @@ CBotFunction::~CBotFunction()
     // remove public list if there is
     if ( m_bPublic )
     {
+        CBotProgramCode::NewGeneration();
+
         if ( m_nextpublic != NULL )
         {
             m_nextpublic->m_prevpublic = m_prevpublic;
@@ -75,6 +79,20 @@ bool CBotFunction::IsExtern()
     return m_bExtern;
 }
 
+// program of the function; the functions shared by several programs
+// (see CBotProgramCode) belong to the program running them
+
+CBotProgram* CBotFunction::GetProgram(CBotStack* pStack)
+{
+    if ( m_pProg != NULL ) return m_pProg;
+    return pStack->GetBotCall();
+}
+
+bool CBotFunction::IsSynchro()
+{
+    return m_bSynchro;
+}
+
 bool CBotFunction::GetPosition(int& start, int& stop, CBotGet modestart, CBotGet modestop)
 {
     start = m_extern.GetStart();
@@ -228,6 +246,9 @@ CBotFunction* CBotFunction::Compile(CBotToken* &p, CBotCStack* pStack, CBotFunct
                 if (!IsOfType(p, TokenTypVar)) goto bad;
 
             }
+            // the parameters and local variables get the following unique numbers
+            func->m_nFirstIdent = CBotVar::NextUniqNum();
+
             func->m_openpar = p;
             func->m_Param = CBotDefParam::Compile( p, pStk );
             func->m_closepar = p->GetPrev();
@@ -267,6 +288,10 @@ CBotFunction* CBotFunction::Compile(CBotToken* &p, CBotCStack* pStack, CBotFunct
                 func->m_closeblk = p->GetPrev();
                 if ( pStk->IsOk() )
                 {
+                    func->m_nSlots = CBotVar::NextUniqNum() - func->m_nFirstIdent;
+                    if ( func->m_nSlots > MAXSLOTS ) func->m_nSlots = 0;    // found by name only
+
+
                     if ( func->m_bPublic )  // public function, return known for all
                     {
                         CBotFunction::AddPublic(func);
@@ -375,7 +400,8 @@ bool CBotFunction::Execute(CBotVar** ppVars, CBotStack* &pj, CBotVar* pInstance)
     CBotStack*  pile = pj->AddStack(this, 2);               // one end of stack local to this function
 //  if ( pile == EOX ) return true;
 
-    pile->SetBotCall(m_pProg);                              // bases for routines
+    pile->SetBotCall(GetProgram(pj));                       // bases for routines
+    pile->SetFrame(m_nFirstIdent, m_nSlots);                // room for the local variables
 
     if ( pile->GetState() == 0 )
     {
@@ -426,7 +452,8 @@ void CBotFunction::RestoreState(CBotVar** ppVars, CBotStack* &pj, CBotVar* pInst
     if ( pile == NULL ) return;
     CBotStack*  pile2 = pile;
 
-    pile->SetBotCall(m_pProg);                          // bases for routines
+    pile->SetBotCall(GetProgram(pj));                   // bases for routines
+    pile->SetFrame(m_nFirstIdent, m_nSlots);
 
     if ( pile->GetBlock() < 2 )
     {
@@ -638,7 +665,8 @@ int CBotFunction::DoCall(long& nIdent, const char* name, CBotVar** ppVars, CBotS
         CBotStack*  pStk1 = pStack->AddStack(pt, 2);    // to put "this"
 //      if ( pStk1 == EOX ) return true;
 
-        pStk1->SetBotCall(pt->m_pProg);                 // it may have changed module
+        pStk1->SetBotCall(pt->GetProgram(pStack));      // it may have changed module
+        pStk1->SetFrame(pt->m_nFirstIdent, pt->m_nSlots);
 
         if ( pStk1->IfStep() ) return false;
 
@@ -650,7 +678,7 @@ int CBotFunction::DoCall(long& nIdent, const char* name, CBotVar** ppVars, CBotS
         {
             if ( !pt->m_MasterClass.IsEmpty() )
             {
-                CBotVar* pInstance = m_pProg->m_pInstance;
+                CBotVar* pInstance = GetProgram(pStack)->m_pInstance;
                 // make "this" known
                 CBotVar* pThis ;
                 if ( pInstance == NULL )
@@ -681,10 +709,10 @@ int CBotFunction::DoCall(long& nIdent, const char* name, CBotVar** ppVars, CBotS
         if ( !pStk3->GetRetVar(                     // puts the result on the stack
             pt->m_Block->Execute(pStk3) ))          // GetRetVar said if it is interrupted
         {
-            if ( !pStk3->IsOk() && pt->m_pProg != m_pProg )
+            if ( !pStk3->IsOk() && pt->GetProgram(pStack) != GetProgram(pStack) )
             {
 #ifdef _DEBUG
-                if ( m_pProg->GetFunctions()->GetName() == "LaCommande" ) return false;
+                if ( GetProgram(pStack)->GetFunctions()->GetName() == "LaCommande" ) return false;
 #endif
                 pStk3->SetPosError(pToken);         // indicates the error on the procedure call
             }
@@ -712,7 +740,8 @@ void CBotFunction::RestoreCall(long& nIdent, const char* name, CBotVar** ppVars,
         pStk1 = pStack->RestoreStack(pt);
         if ( pStk1 == NULL ) return;
 
-        pStk1->SetBotCall(pt->m_pProg);                 // it may have changed module
+        pStk1->SetBotCall(pt->GetProgram(pStack));      // it may have changed module
+        pStk1->SetFrame(pt->m_nFirstIdent, pt->m_nSlots);
 
         if ( pStk1->GetBlock() < 2 )
         {
@@ -772,6 +801,7 @@ int CBotFunction::DoCall(long& nIdent, const char* name, CBotVar* pThis, CBotVar
 //      if ( pStk == EOX ) return true;
 
         pStk->SetBotCall(pt->m_pProg);                  // it may have changed module
+        pStk->SetFrame(pt->m_nFirstIdent, pt->m_nSlots);
         CBotStack*  pStk3 = pStk->AddStack(NULL, true); // to set parameters passed
 
         // preparing parameters on the stack
@@ -847,6 +877,7 @@ void CBotFunction::RestoreCall(long& nIdent, const char* name, CBotVar* pThis, C
         CBotStack*  pStk = pStack->RestoreStack(pt);
         if ( pStk == NULL ) return;
         pStk->SetBotCall(pt->m_pProg);                  // it may have changed module
+        pStk->SetFrame(pt->m_nFirstIdent, pt->m_nSlots);
 
         CBotVar*    pthis = pStk->FindVar("this");
         pthis->SetUniqNum(-2);
@@ -914,6 +945,7 @@ CBotFunction* CBotFunction::Next()
 
 void CBotFunction::AddPublic(CBotFunction* func)
 {
+    CBotProgramCode::NewGeneration();
     if ( m_listPublic != NULL )
     {
         func->m_nextpublic = m_listPublic;
@@ -1313,7 +1345,8 @@ bool CBotInstrCall::Execute(CBotStack* &pj)
     CBotStack* pile2 = pile->AddStack();
     if ( pile2->IfStep() ) return false;
 
-    if ( !pile2->ExecuteCall(m_nFuncIdent, GetToken(), ppVars, m_typRes)) return false; // interrupt
+    long nIdent = m_nFuncIdent;         // not updated, the instruction can be shared (see CBotProgramCode)
+    if ( !pile2->ExecuteCall(nIdent, GetToken(), ppVars, m_typRes)) return false; // interrupt
 
     return pj->Return(pile2);   // release the entire stack
 }
@@ -1351,7 +1384,8 @@ void CBotInstrCall::RestoreState(CBotStack* &pj, bool bMain)
     CBotStack* pile2 = pile->RestoreStack();
     if ( pile2 == NULL ) return;
 
-    pile2->RestoreCall(m_nFuncIdent, GetToken(), ppVars);
+    long nIdent = m_nFuncIdent;
+    pile2->RestoreCall(nIdent, GetToken(), ppVars);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1641,6 +1675,7 @@ CBotClass* CBotClass::Compile(CBotToken* &p, CBotCStack* pStack)
         }
 
         pOld->m_IsDef = true;           // complete definition
+        CBotProgramCode::NewGeneration();
         if (pStack->IsOk()) return pOld;
     }
     pStack->SetError(TX_ENDOF, p);
@@ -0,0 +1,121 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+///////////////////////////////////////////////////////////////////////
+// This file defines the free lists of CBotPool
+//
+// Blocks given back are kept for the next allocations of the same list,
+// instead of returning them to the heap. The lists are kept per thread,
+// so programs running in worker threads never share them; a block freed
+// by another thread than the one which allocated it simply changes list.
+
+
+#include "CBot.h"
+
+#include <new>
+
+
+// the lists of a thread, released with the thread
+struct CBotFreeList
+{
+    void*   first[CBotPool::PoolMax];           // first free block, the next one is stored in it
+    int     count[CBotPool::PoolMax];           // number of free blocks
+    size_t  size[CBotPool::PoolMax];            // size of the blocks, given by the first allocation
+
+    CBotFreeList()
+    {
+        for ( int i = 0; i < CBotPool::PoolMax; i++ )
+        {
+            first[i] = NULL;
+            count[i] = 0;
+            size[i]  = 0;
+        }
+    }
+
+    ~CBotFreeList()
+    {
+        for ( int i = 0; i < CBotPool::PoolMax; i++ )
+        {
+            while ( first[i] != NULL )
+            {
+                void*   p = first[i];
+                first[i] = *static_cast<void**>(p);
+                ::operator delete(p);
+            }
+        }
+    }
+};
+
+static thread_local CBotFreeList m_freeList;
+
+thread_local long CBotPool::m_nAlloc = 0;
+thread_local long CBotPool::m_nHeap  = 0;
+
+
+void* CBotPool::Alloc(int list, size_t size)
+{
+    CBotFreeList&   fl = m_freeList;
+
+    m_nAlloc++;
+
+    if ( fl.size[list] == 0 ) fl.size[list] = size;
+
+    if ( fl.first[list] != NULL && size == fl.size[list] )
+    {
+        void*   p = fl.first[list];
+        fl.first[list] = *static_cast<void**>(p);
+        fl.count[list]--;
+        return p;
+    }
+
+    m_nHeap++;
+    return ::operator new(size);
+}
+
+void CBotPool::Free(int list, void* p, size_t size)
+{
+    if ( p == NULL ) return;
+
+    CBotFreeList&   fl = m_freeList;
+
+    if ( fl.size[list] == 0 ) fl.size[list] = size;
+
+    // a derived class, or enough blocks kept already
+    if ( size != fl.size[list] || fl.count[list] >= POOLMAXFREE )
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    *static_cast<void**>(p) = fl.first[list];
+    fl.first[list] = p;
+    fl.count[list]++;
+}
+
+void CBotPool::Count()
+{
+    m_nAlloc++;
+}
+
+long CBotPool::GetAllocCount()
+{
+    return m_nAlloc;
+}
+
+long CBotPool::GetHeapCount()
+{
+    return m_nHeap;
+}
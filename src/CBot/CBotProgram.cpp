@@ -27,10 +27,17 @@ CBotProgram::CBotProgram()
     m_pClass    = NULL;
     m_pStack    = NULL;
     m_pInstance = NULL;
+    m_pCode     = NULL;
 
     m_ErrorCode = 0;
     m_Ident     = 0;
     m_bDebugDD  = 0;
+
+    m_quota     = -1;
+    m_stepsUsed = 0;
+    m_allocUsed = 0;
+    m_heapUsed  = 0;
+    m_bDeferred = false;
 }
 
 CBotProgram::CBotProgram(CBotVar* pInstance)
@@ -40,10 +47,17 @@ CBotProgram::CBotProgram(CBotVar* pInstance)
     m_pClass    = NULL;
     m_pStack    = NULL;
     m_pInstance = pInstance;
+    m_pCode     = NULL;
 
     m_ErrorCode = 0;
     m_Ident     = 0;
     m_bDebugDD  = 0;
+
+    m_quota     = -1;
+    m_stepsUsed = 0;
+    m_allocUsed = 0;
+    m_heapUsed  = 0;
+    m_bDeferred = false;
 }
 
 
@@ -55,7 +69,7 @@ CBotProgram::~CBotProgram()
 
     CBotClass::FreeLock(this);
 
-    delete  m_Prog;
+    FreeFunctions();
 #if STACKMEM
     m_pStack->Delete();
 #else
@@ -73,11 +87,27 @@ bool CBotProgram::Compile( const char* program, CBotStringArray& ListFonctions,
     m_pClass->Purge();      // purge the old definitions of classes
                             // but without destroying the object
     m_pClass    = NULL;
-    delete      m_Prog;     m_Prog= NULL;
+    FreeFunctions();
 
     ListFonctions.SetSize(0);
     m_ErrorCode = 0;
 
+    // the same text was already compiled by another program?
+    CBotString  className;
+    if ( m_pInstance != NULL && m_pInstance->GetClass() != NULL )
+        className = m_pInstance->GetClass()->GetName();
+
+    CBotProgramCode* pCode = CBotProgramCode::Find(program, className);
+    if ( pCode != NULL )
+    {
+        pCode->AddUse();
+        m_pCode = pCode;
+        m_Prog  = pCode->m_Prog;
+        for ( int i = 0; i < pCode->m_extern.GetSize(); i++ )
+            ListFonctions.Add(pCode->m_extern[i]);
+        return true;
+    }
+
     if (m_pInstance != NULL && m_pInstance->m_pUserPtr != NULL)
         pUser = m_pInstance->m_pUserPtr;
 
@@ -158,9 +188,118 @@ bool CBotProgram::Compile( const char* program, CBotStringArray& ListFonctions,
     delete pBaseToken;
     delete pStack;
 
+    if ( m_Prog != NULL && m_pClass == NULL ) ShareFunctions(program, ListFonctions);
+
     return (m_Prog != NULL);
 }
 
+// gives the compiled functions to the other programs compiled from the same text
+
+void CBotProgram::ShareFunctions(const char* program, CBotStringArray& ListFonctions)
+{
+    // public functions are known by all the programs by their module
+    for ( CBotFunction* p = m_Prog; p != NULL; p = p->Next() )
+    {
+        if ( p->IsPublic() ) return;
+    }
+
+    CBotString  className;
+    if ( m_pInstance != NULL && m_pInstance->GetClass() != NULL )
+        className = m_pInstance->GetClass()->GetName();
+
+    m_pCode = new CBotProgramCode(program, className, m_Prog);
+    for ( int i = 0; i < ListFonctions.GetSize(); i++ )
+        m_pCode->m_extern.Add(ListFonctions[i]);
+
+    // each function belongs to the program running it
+    for ( CBotFunction* p = m_Prog; p != NULL; p = p->Next() )
+    {
+        p->m_pProg = NULL;
+    }
+}
+
+void CBotProgram::FreeFunctions()
+{
+    if ( m_pCode != NULL )
+    {
+        m_pCode->Release();             // deletes m_Prog if no other program uses it
+        m_pCode = NULL;
+    }
+    else
+    {
+        delete m_Prog;
+    }
+    m_Prog = NULL;
+}
+
+
+////////////////////////////////////////////////////////////////////////////
+// shared code of identical programs
+
+CBotProgramCode* CBotProgramCode::m_list = NULL;
+long             CBotProgramCode::m_generation = 0;
+
+CBotProgramCode::CBotProgramCode(const char* text, const CBotString& className, CBotFunction* pProg)
+{
+    m_hash  = Hash(text);
+    m_text  = text;
+    m_class = className;
+    m_nUse  = 1;
+    m_gener = m_generation;
+    m_Prog  = pProg;
+
+    m_prev  = NULL;
+    m_next  = m_list;
+    if ( m_list != NULL ) m_list->m_prev = this;
+    m_list  = this;
+}
+
+CBotProgramCode::~CBotProgramCode()
+{
+    if ( m_prev != NULL ) m_prev->m_next = m_next;
+    else m_list = m_next;
+    if ( m_next != NULL ) m_next->m_prev = m_prev;
+
+    delete m_Prog;
+}
+
+CBotProgramCode* CBotProgramCode::Find(const char* text, const CBotString& className)
+{
+    unsigned long hash = Hash(text);
+
+    for ( CBotProgramCode* p = m_list; p != NULL; p = p->m_next )
+    {
+        if ( p->m_gener == m_generation && p->m_hash == hash &&
+             p->m_class == className && p->m_text == text ) return p;
+    }
+    return NULL;
+}
+
+unsigned long CBotProgramCode::Hash(const char* text)
+{
+    unsigned long hash = 5381;
+    while ( *text != 0 )
+    {
+        hash = hash * 33 + static_cast<unsigned char>(*text++);
+    }
+    return hash;
+}
+
+void CBotProgramCode::NewGeneration()
+{
+    m_generation++;
+}
+
+void CBotProgramCode::AddUse()
+{
+    m_nUse++;
+}
+
+void CBotProgramCode::Release()
+{
+    if ( --m_nUse == 0 ) delete this;
+}
+
 
 bool CBotProgram::Start(const char* name)
 {
@@ -213,15 +352,23 @@ bool CBotProgram::GetPosition(const char* name, int& start, int& stop, CBotGet m
 bool CBotProgram::Run(void* pUser, int timer)
 {
     bool    ok;
+    long    nAlloc = CBotPool::GetAllocCount();
+    long    nHeap  = CBotPool::GetHeapCount();
 
     if (m_pStack == NULL || m_pRun == NULL) goto error;
 
     m_ErrorCode = 0;
+    m_stepsUsed = 0;
+    m_allocUsed = 0;
+    m_heapUsed  = 0;
+    m_bDeferred = false;
     if (m_pInstance != NULL && m_pInstance->m_pUserPtr != NULL)
         pUser = m_pInstance->m_pUserPtr;
 
+    if ( timer < 0 ) timer = m_quota;
+
     m_pStack->Reset(pUser);                         // empty the possible previous error, and resets the timer
-    if ( timer >= 0 ) m_pStack->SetTimer(timer);
+    if ( timer >= 0 ) m_pStack->StartTimer(timer);
 
     m_pStack->SetBotCall(this);                     // bases for routines
 
@@ -245,6 +392,11 @@ bool CBotProgram::Run(void* pUser, int timer)
     ok = m_pRun->Execute(NULL, m_pStack, m_pInstance);
 #endif
 
+    m_stepsUsed = m_pStack->GetTimerUsed();
+    m_bDeferred = m_pStack->IsDeferred();
+    m_allocUsed = CBotPool::GetAllocCount() - nAlloc;       // the run is done by this thread only
+    m_heapUsed  = CBotPool::GetHeapCount() - nHeap;
+
     // completed on a mistake?
     if (!ok && !m_pStack->IsOk())
     {
@@ -302,6 +454,42 @@ void CBotProgram::SetTimer(int n)
     CBotStack::SetTimer( n );
 }
 
+void CBotProgram::SetQuota(int n)
+{
+    m_quota = n;
+}
+
+int CBotProgram::GetQuota()
+{
+    return m_quota;
+}
+
+int CBotProgram::GetStepsUsed()
+{
+    return m_stepsUsed;
+}
+
+void CBotProgram::GetAllocUsed(long& nAlloc, long& nHeap)
+{
+    nAlloc = m_allocUsed;
+    nHeap  = m_heapUsed;
+}
+
+void CBotProgram::SetWorkerThread(bool bWorker)
+{
+    CBotStack::SetWorkerThread( bWorker );
+}
+
+bool CBotProgram::IsDeferred()
+{
+    return m_bDeferred;
+}
+
+void CBotProgram::RunDeferred()
+{
+    CBotVarClass::DestroyDeferred();
+}
+
 int CBotProgram::GetError()
 {
     return m_ErrorCode;
@@ -356,10 +544,11 @@ CBotFunction* CBotProgram::GetFunctions()
 
 bool CBotProgram::AddFunction(const char* name, 
                               bool rExec (CBotVar* pVar, CBotVar* pResult, int& Exception, void* pUser), 
-                              CBotTypResult rCompile (CBotVar* &pVar, void* pUser))
+                              CBotTypResult rCompile (CBotVar* &pVar, void* pUser),
+                              bool bThreadSafe)
 {
     // stores pointers to the two functions
-    return CBotCall::AddFunction(name, rExec, rCompile);
+    return CBotCall::AddFunction(name, rExec, rCompile, bThreadSafe);
 }
 
 
@@ -563,12 +752,14 @@ CBotCall* CBotCall::m_ListCalls = NULL;
     
 CBotCall::CBotCall(const char* name, 
                    bool rExec (CBotVar* pVar, CBotVar* pResult, int& Exception, void* pUser), 
-                   CBotTypResult rCompile (CBotVar* &pVar, void* pUser))
+                   CBotTypResult rCompile (CBotVar* &pVar, void* pUser),
+                   bool bThreadSafe)
 {
     m_name       = name;
     m_rExec      = rExec;
     m_rComp      = rCompile;
     m_next       = NULL;
+    m_bThreadSafe = bThreadSafe;
     m_nFuncIdent = CBotVar::NextUniqNum();
 }
 
@@ -585,7 +776,8 @@ void CBotCall::Free()
 
 bool CBotCall::AddFunction(const char* name, 
                            bool rExec (CBotVar* pVar, CBotVar* pResult, int& Exception, void* pUser), 
-                           CBotTypResult rCompile (CBotVar* &pVar, void* pUser))
+                           CBotTypResult rCompile (CBotVar* &pVar, void* pUser),
+                           bool bThreadSafe)
 {
     CBotCall*   p = m_ListCalls;
     CBotCall*   pp = NULL;
@@ -607,7 +799,7 @@ bool CBotCall::AddFunction(const char* name,
         p = p->m_next;
     }
 
-    pp = new CBotCall(name, rExec, rCompile);
+    pp = new CBotCall(name, rExec, rCompile, bThreadSafe);
     
     if (p) p->m_next = pp;
     else m_ListCalls = pp;
@@ -740,6 +932,8 @@ int CBotCall::DoCall(long& nIdent, CBotToken* token, CBotVar** ppVar, CBotStack*
 
 fund:
 #if !STACKRUN
+    if ( !pt->m_bThreadSafe && pStack->IfDefer() ) return false;
+
     // lists the parameters depending on the contents of the stack (pStackVar)
 
     CBotVar*    pVar = MakeListVars(ppVar, true);
@@ -830,6 +1024,9 @@ bool CBotCall::Run(CBotStack* pStack)
 {
     CBotStack*  pile = pStack->AddStackEOX(this);
     if ( pile == EOX ) return true;
+
+    // the parameters stay on the stack until the main thread does the call
+    if ( !m_bThreadSafe && pStack->IfDefer() ) return false;
     CBotVar*    pVar = pile->GetVar();
 
     CBotStack*  pile2 = pile->AddStack();
@@ -937,6 +1134,8 @@ int CBotCallMethode::DoCall(long& nIdent, const char* name, CBotVar* pThis, CBot
     {
         if ( pt->m_nFuncIdent == nIdent )
         {
+            if ( pStack->IfDefer() ) return false;
+
             // lists the parameters depending on the contents of the stack (pStackVar)
 
             CBotVar*    pVar = MakeListVars(ppVars, true);
@@ -970,6 +1169,8 @@ int CBotCallMethode::DoCall(long& nIdent, const char* name, CBotVar* pThis, CBot
     {
         if ( pt->m_name == name )
         {
+            if ( pStack->IfDefer() ) return false;
+
             // lists the parameters depending on the contents of the stack (pStackVar)
 
             CBotVar*    pVar = MakeListVars(ppVars, true);
@@ -1094,7 +1295,7 @@ void CBotProgram::Init()
     CBotToken::DefineNum( "CBotErrNoRun", 6004) ;       // active Run () without a function
     CBotToken::DefineNum( "CBotErrUndefFunc", 6005) ;   // Calling a function that no longer exists
 
-    CBotProgram::AddFunction("sizeof", rSizeOf, cSizeOf );
+    CBotProgram::AddFunction("sizeof", rSizeOf, cSizeOf, true );
 
     InitStringFunctions();
 
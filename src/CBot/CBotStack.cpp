@@ -28,14 +28,14 @@
 // management of a execution of a stack
 ////////////////////////////////////////////////////////////////////////////
 
-int         CBotStack::m_initimer = ITIMER;
-int         CBotStack::m_timer = 0;
-CBotVar*    CBotStack::m_retvar = NULL;
-int         CBotStack::m_error = 0;
-int         CBotStack::m_start = 0;
-int         CBotStack::m_end   = 0;
-CBotString  CBotStack::m_labelBreak="";
-void*       CBotStack::m_pUser = NULL;
+int         CBotStack::m_defaultTimer = ITIMER;
+thread_local CBotVar*    CBotStack::m_retvar = NULL;
+thread_local int         CBotStack::m_error = 0;
+thread_local int         CBotStack::m_start = 0;
+thread_local int         CBotStack::m_end   = 0;
+thread_local bool        CBotStack::m_bWorker = false;
+thread_local CBotString  CBotStack::m_labelBreak="";
+thread_local void*       CBotStack::m_pUser = NULL;
 
 #if    STACKMEM
 
@@ -47,13 +47,16 @@ CBotStack* CBotStack::FirstStack()
     size    *= (MAXSTACK+10);
 
     // request a slice of memory for the stack
-    p = static_cast<CBotStack*>(malloc(size));
+    void*   block = malloc(size);
 
     // completely empty
-    memset(p, 0, size);
+    memset(block, 0, size);
+    p = static_cast<CBotStack*>(block);
 
     p-> m_bBlock = true;
-    m_timer = m_initimer;                // sets the timer at the beginning
+    p-> m_root = p;
+    p-> m_initimer = m_defaultTimer;
+    p-> m_timer = m_defaultTimer;        // sets the timer at the beginning
 
     CBotStack* pp = p;
     pp += MAXSTACK;
@@ -105,7 +108,9 @@ void CBotStack::Delete()
     }
 
     delete m_var;
+    if ( m_listVar != NULL ) ReleaseSlots();
     delete m_listVar;
+    FreeSlots();
 
     CBotStack*    p = m_prev;
     bool        bOver = m_bOver;
@@ -150,11 +155,14 @@ CBotStack* CBotStack::AddStack(CBotInstr* instr, bool bBlock)
     p->m_bBlock         = bBlock;
     p->m_instr         = instr;
     p->m_prog         = m_prog;
+    p->m_root         = m_root;
     p->m_step         = 0;
     p->m_prev         = this;
     p->m_state         = 0;
     p->m_call         = NULL;
     p->m_bFunc         = false;
+    p->m_frame         = m_frame;
+    CBotPool::Count();
     return    p;
 }
 
@@ -194,7 +202,10 @@ CBotStack* CBotStack::AddStack2(bool bBlock)
     p->m_prev = this;
     p->m_bBlock = bBlock;
     p->m_prog = m_prog;
+    p->m_root = m_root;
     p->m_step = 0;
+    p->m_frame = m_frame;
+    CBotPool::Count();
     return    p;
 }
 
@@ -248,7 +259,10 @@ CBotStack::CBotStack(CBotStack* ppapa)
     m_state = 0;
     m_step = 1;
 
-    if (ppapa == NULL) m_timer = m_initimer;                // sets the timer at the beginning
+    m_root = (ppapa == NULL) ? this : ppapa->m_root;
+    m_initimer = m_defaultTimer;
+    m_timer = m_defaultTimer;                // sets the timer at the beginning
+    m_bDeferred = false;
 
     m_listVar = NULL;
     m_bDontDelete = false; 
@@ -258,6 +272,11 @@ CBotStack::CBotStack(CBotStack* ppapa)
     m_instr      = NULL;
     m_call      = NULL;
     m_bFunc      = false;
+
+    m_frame = (ppapa == NULL) ? NULL : ppapa->m_frame;
+    m_slots = NULL;
+    m_firstIdent = 0;
+    m_nSlots = 0;
 }
 
 // destructor
@@ -269,7 +288,9 @@ CBotStack::~CBotStack()
             m_prev->m_next = NULL;        // removes chain
 
     delete m_var;
+    ReleaseSlots();
     if ( !m_bDontDelete ) delete m_listVar;
+    FreeSlots();
 }
 
 // \TODO routine has/to optimize
@@ -349,7 +370,9 @@ bool CBotStack::StackOver()
 
 void CBotStack::Reset(void* pUser)
 {
-    m_timer = m_initimer;        // resets the timer
+    m_root->m_initimer = m_defaultTimer;         // a timer given to a previous run is not kept
+    m_root->m_timer = m_defaultTimer;            // resets the timer
+    m_root->m_bDeferred = false;
     m_error    = 0;
 //    m_start = 0;
 //    m_end    = 0;
@@ -383,7 +406,7 @@ CBotStack* CBotStack::RestoreStackEOX(CBotCall* instr)
 // routine for execution step by step
 bool CBotStack::IfStep()
 {
-    if ( m_initimer > 0 || m_step++ > 0 ) return false;
+    if ( m_root->m_initimer > 0 || m_step++ > 0 ) return false;
     return true;
 }
 
@@ -513,24 +536,34 @@ CBotVar* CBotStack::FindVar(const char* name)
 
 CBotVar* CBotStack::FindVar(long ident, bool bUpdate, bool bModif)
 {
-    CBotStack*    p = this;
-    while (p != NULL)
+    CBotVar*    pp = GetSlotVar(ident);         // direct access to a local variable
+
+    if ( pp == NULL )
     {
-        CBotVar*    pp = p->m_listVar;
-        while ( pp != NULL)
+        // otherwise searches every level, then keeps the variable
+        // if it belongs to the function (restored by RestoreState)
+        CBotStack*    p = this;
+        bool        bLocal = true;
+        while (p != NULL)
         {
-            if (pp->GetUniqNum() == ident)
-            {
-                if ( bUpdate ) 
-                    pp->Maj(m_pUser, false);
+            pp = p->m_listVar;
+            while ( pp != NULL && pp->GetUniqNum() != ident ) pp = pp->m_next;
 
-                return pp;
+            if ( pp != NULL )
+            {
+                if ( bLocal ) SetSlotVar(ident, pp);
+                break;
             }
-            pp = pp->m_next;
+            if ( p == m_frame ) bLocal = false;
+            p = p->m_prev;
         }
-        p = p->m_prev;
+        if ( pp == NULL ) return NULL;
     }
-    return NULL;
+
+    if ( bUpdate ) 
+        pp->Maj(m_pUser, false);
+
+    return pp;
 }
 
 
@@ -557,16 +590,16 @@ bool CBotStack::SetState(int n, int limite)
 {
     m_state = n;
 
-    m_timer--;                                    // decrement the operations \TODO decrement the operations
-    return ( m_timer > limite );                    // interrupted if timer pass
+    m_root->m_timer--;                            // decrement the operations \TODO decrement the operations
+    return ( m_root->m_timer > limite );            // interrupted if timer pass
 }
 
 bool CBotStack::IncState(int limite)
 {
     m_state++;
 
-    m_timer--;                                    // decrement the operations \TODO decompte les operations
-    return ( m_timer > limite );                    // interrupted if timer pass
+    m_root->m_timer--;                            // decrement the operations \TODO decompte les operations
+    return ( m_root->m_timer > limite );            // interrupted if timer pass
 }
 
 
@@ -596,7 +629,58 @@ void CBotStack::SetPosError(CBotToken* token)
 
 void CBotStack::SetTimer(int n)
 {
-    m_initimer = n;
+    m_defaultTimer = n;
+}
+
+void CBotStack::StartTimer(int n)
+{
+    m_root->m_initimer = n;
+    m_root->m_timer = n;
+}
+
+int CBotStack::GetTimerUsed()
+{
+    return m_root->m_initimer - m_root->m_timer;
+}
+
+int CBotStack::GetTimerLeft()
+{
+    return m_root->m_timer;
+}
+
+void CBotStack::SetTimerLeft(int n)
+{
+    m_root->m_timer = n;
+}
+
+bool CBotStack::IsStepMode()
+{
+    return m_root->m_initimer <= 0;
+}
+
+void CBotStack::SetWorkerThread(bool bWorker)
+{
+    m_bWorker = bWorker;
+}
+
+bool CBotStack::IsWorkerThread()
+{
+    return m_bWorker;
+}
+
+bool CBotStack::IfDefer()
+{
+    if ( !m_bWorker ) return false;
+
+    // the run is interrupted here, the call is done again
+    // when the host resumes the program on the main thread
+    m_root->m_bDeferred = true;
+    return true;
+}
+
+bool CBotStack::IsDeferred()
+{
+    return m_root->m_bDeferred;
 }
 
 bool CBotStack::Execute()
@@ -692,6 +776,8 @@ void CBotStack::AddVar(CBotVar* pVar)
 
     *pp = pVar;                    // added after
 
+    SetSlotVar(pVar->GetUniqNum(), pVar);
+
 #ifdef    _DEBUG
     if ( pVar->GetUniqNum() == 0 ) ASM_TRAP();
 #endif
@@ -704,6 +790,78 @@ void CBotStack::AddVar(CBotVar* pVar)
     m_listVar = pVar;        // direct replacement
 }*/
 
+// local variables of a function are found by their unique number,
+// which are consecutive for each function (see CBotFunction::Compile)
+
+void CBotStack::SetFrame(long firstIdent, int nSlots)
+{
+    if ( m_frame == this ) return;              // already done, when the function is resumed
+
+    m_frame        = this;
+    m_firstIdent   = firstIdent;
+    m_nSlots       = nSlots;
+    m_slots        = NULL;
+    if ( nSlots > 0 )
+    {
+        // the slots of most functions fit in a block of the pool
+        if ( nSlots <= POOLSLOTS )
+            m_slots = static_cast<CBotVar**>(CBotPool::Alloc(CBotPool::PoolSlots, sizeof(CBotVar*) * POOLSLOTS));
+        else
+            m_slots = new CBotVar*[nSlots];
+        for ( int i = 0; i < nSlots; i++ ) m_slots[i] = NULL;
+    }
+
+    // levels already restored by RestoreState belong to this function
+    if ( m_next  != NULL && m_next  != EOX ) m_next->SetFrameAbove(this);
+    if ( m_next2 != NULL && m_next2 != EOX ) m_next2->SetFrameAbove(this);
+}
+
+void CBotStack::SetFrameAbove(CBotStack* frame)
+{
+    m_frame = frame;
+    if ( m_next  != NULL && m_next  != EOX ) m_next->SetFrameAbove(frame);
+    if ( m_next2 != NULL && m_next2 != EOX ) m_next2->SetFrameAbove(frame);
+}
+
+CBotVar* CBotStack::GetSlotVar(long ident)
+{
+    if ( m_frame == NULL ) return NULL;
+
+    long    n = ident - m_frame->m_firstIdent;
+    if ( n < 0 || n >= m_frame->m_nSlots ) return NULL;
+    return m_frame->m_slots[n];
+}
+
+void CBotStack::SetSlotVar(long ident, CBotVar* pVar)
+{
+    if ( m_frame == NULL ) return;
+
+    long    n = ident - m_frame->m_firstIdent;
+    if ( n < 0 || n >= m_frame->m_nSlots ) return;
+    m_frame->m_slots[n] = pVar;
+}
+
+void CBotStack::FreeSlots()
+{
+    if ( m_slots == NULL ) return;
+
+    if ( m_nSlots <= POOLSLOTS )
+        CBotPool::Free(CBotPool::PoolSlots, m_slots, sizeof(CBotVar*) * POOLSLOTS);
+    else
+        delete[] m_slots;
+    m_slots = NULL;
+}
+
+// the variables of this level will be deleted
+
+void CBotStack::ReleaseSlots()
+{
+    for ( CBotVar* pp = m_listVar; pp != NULL; pp = pp->m_next )
+    {
+        if ( GetSlotVar(pp->GetUniqNum()) == pp ) SetSlotVar(pp->GetUniqNum(), NULL);
+    }
+}
+
 void CBotStack::SetBotCall(CBotProgram* p)
 {
     m_prog  = p;
@@ -26,6 +26,20 @@
 
 long CBotVar::m_identcpt = 0;
 
+// guards the counter and the list of instances,
+// as programs can create variables in several worker threads at once
+static std::atomic_flag m_sharedLock = ATOMIC_FLAG_INIT;
+
+static void LockShared()
+{
+    while ( m_sharedLock.test_and_set(std::memory_order_acquire) ) ;
+}
+
+static void UnlockShared()
+{
+    m_sharedLock.clear(std::memory_order_release);
+}
+
 CBotVar::CBotVar( )
 {
     m_next    = NULL;
@@ -104,7 +118,50 @@ CBotVarBoolean::CBotVarBoolean( const CBotToken* name )
     m_val        = 0;
 }
 
+// the values of simple types are taken from free lists (see CBotPool.cpp)
+
+void* CBotVarInt::operator new(size_t size)
+{
+    return CBotPool::Alloc(CBotPool::PoolInt, size);
+}
+
+void CBotVarInt::operator delete(void* p, size_t size)
+{
+    CBotPool::Free(CBotPool::PoolInt, p, size);
+}
+
+void* CBotVarFloat::operator new(size_t size)
+{
+    return CBotPool::Alloc(CBotPool::PoolFloat, size);
+}
+
+void CBotVarFloat::operator delete(void* p, size_t size)
+{
+    CBotPool::Free(CBotPool::PoolFloat, p, size);
+}
+
+void* CBotVarString::operator new(size_t size)
+{
+    return CBotPool::Alloc(CBotPool::PoolString, size);
+}
+
+void CBotVarString::operator delete(void* p, size_t size)
+{
+    CBotPool::Free(CBotPool::PoolString, p, size);
+}
+
+void* CBotVarBoolean::operator new(size_t size)
+{
+    return CBotPool::Alloc(CBotPool::PoolBoolean, size);
+}
+
+void CBotVarBoolean::operator delete(void* p, size_t size)
+{
+    CBotPool::Free(CBotPool::PoolBoolean, p, size);
+}
+
 CBotVarClass* CBotVarClass::m_ExClass = NULL;
+CBotVarClass* CBotVarClass::m_ExDestroy = NULL;
 
 CBotVarClass::CBotVarClass( const CBotToken* name, const CBotTypResult& type)
 {
@@ -145,14 +202,17 @@ void CBotVarClass::InitCBotVarClass( const CBotToken* name, CBotTypResult& type
     m_mPrivate    = 0;
     m_bConstructor = false;
     m_CptUse    = 0;
+    m_DestroyNext = NULL;
     m_ItemIdent = type.Eq(CBotTypIntrinsic) ? 0 : CBotVar::NextUniqNum();
 
     // se place tout seul dans la liste
     // TODO stands alone in the list (stands only in a list)
+    LockShared();
     if (m_ExClass) m_ExClass->m_ExPrev = this;
     m_ExNext  = m_ExClass;
     m_ExPrev  = NULL;
     m_ExClass = this;
+    UnlockShared();
 
     CBotClass* pClass = type.GetClass();
     CBotClass* pClass2 = pClass->GetParent();
@@ -179,12 +239,14 @@ CBotVarClass::~CBotVarClass( )
 //        m_Indirect->DecrementUse();
 
     // removes the class list
+    LockShared();
     if ( m_ExPrev ) m_ExPrev->m_ExNext = m_ExNext;
     else m_ExClass = m_ExNext;
 
     if ( m_ExNext ) m_ExNext->m_ExPrev = m_ExPrev;
     m_ExPrev = NULL;
     m_ExNext = NULL;
+    UnlockShared();
 
     delete    m_pVar;
 }
@@ -247,8 +309,11 @@ void CBotVar::SetUniqNum(long n)
 
 long CBotVar::NextUniqNum()
 {
+    LockShared();
     if (++m_identcpt < 10000) m_identcpt = 10000;
-    return m_identcpt;
+    long n = m_identcpt;
+    UnlockShared();
+    return n;
 }
 
 long CBotVar::GetUniqNum()
@@ -1531,6 +1596,9 @@ void CBotVarClass::Maj(void* pUser, bool bContinu)
 
     if ( m_pClass->m_rMaj == NULL ) return;
 
+    // the host updates the instances before starting the worker threads
+    if ( CBotStack::IsWorkerThread() ) return;
+
     // retrieves the user pointer according to the class
     // or according to the parameter passed to CBotProgram::Run()
 
@@ -1670,8 +1738,7 @@ void CBotVarClass::IncrementUse()
 
 void CBotVarClass::DecrementUse()
 {
-    m_CptUse--;
-    if ( m_CptUse == 0 ) 
+    if ( --m_CptUse == 0 ) 
     {
         // if there is one, call the destructor
         // but only if a constructor had been called.
@@ -1679,6 +1746,16 @@ void CBotVarClass::DecrementUse()
         {
             m_CptUse++;    // does not return to the destructor
 
+            // the destructor may call any function, the main thread runs it later
+            if ( CBotStack::IsWorkerThread() )
+            {
+                LockShared();
+                m_DestroyNext = m_ExDestroy;
+                m_ExDestroy = this;
+                UnlockShared();
+                return;
+            }
+
             // m_error is static in the stack
             // saves the value for return
             int    err, start, end;
@@ -1686,6 +1763,7 @@ void CBotVarClass::DecrementUse()
             err = pile->GetError(start,end);    // stack == NULL it does not bother!
 
             pile = CBotStack::FirstStack();        // clears the error
+
             CBotVar*    ppVars[1];
             ppVars[0] = NULL;
 
@@ -1709,6 +1787,22 @@ void CBotVarClass::DecrementUse()
     }
 }
 
+void CBotVarClass::DestroyDeferred()
+{
+    LockShared();
+    CBotVarClass*    p = m_ExDestroy;
+    m_ExDestroy = NULL;
+    UnlockShared();
+
+    while ( p != NULL )
+    {
+        CBotVarClass*    pNext = p->m_DestroyNext;
+        p->m_DestroyNext = NULL;
+        p->DecrementUse();    // calls the destructor, now on the main thread
+        p = pNext;
+    }
+}
+
 CBotVarClass* CBotVarClass::GetPointer()
 {
     return this;
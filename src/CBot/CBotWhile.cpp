@@ -38,6 +38,7 @@ CBotWhile::CBotWhile()
 {
     m_Condition =
     m_Block     = NULL;     // NULL so that delete is not possible further
+    m_code      = NULL;
     name = "CBotWhile";     // debug
 }
 
@@ -45,6 +46,7 @@ CBotWhile::~CBotWhile()
 {
     delete  m_Condition;    // frees the condition
     delete  m_Block;        // releases the block instruction
+    delete  m_code;         // frees the compiled loop
 }
 
 CBotInstr* CBotWhile::Compile(CBotToken* &p, CBotCStack* pStack)
@@ -76,6 +78,7 @@ CBotInstr* CBotWhile::Compile(CBotToken* &p, CBotCStack* pStack)
         {
             // the statement block is ok (it may be empty!
 
+            inst->m_code = CBotByteCode::Compile(inst, pStk);
             return pStack->Return(inst, pStk);  // return an object to the application
                                                 // makes the object to which the application
         }
@@ -95,6 +98,18 @@ bool CBotWhile :: Execute(CBotStack* &pj)
 
     if ( pile->IfStep() ) return false;
 
+    // the compiled loop runs from its beginning
+    if ( m_code != NULL && pile->GetState() == 0 )
+    {
+        switch ( m_code->Run(pile) )
+        {
+        case CBotByteCode::RunSuspend:
+            return false;                       // interrupted at the end of an iteration
+        case CBotByteCode::RunEnd:
+            return pj->Return(pile);            // sends the results and releases the stack
+        }
+    }
+
     while( true ) switch( pile->GetState() )    // executes the loop
     {                                           // there are two possible states (depending on recovery)
     case 0:
@@ -307,6 +322,7 @@ CBotDo::CBotDo()
 {
     m_Condition =
     m_Block     = NULL;     // NULL so that delete is not possible further
+    m_code      = NULL;
     name = "CBotDo";        // debug
 }
 
@@ -314,6 +330,7 @@ CBotDo::~CBotDo()
 {
     delete  m_Condition;    // frees the condition
     delete  m_Block;        // frees the instruction block
+    delete  m_code;         // frees the compiled loop
 }
 
 CBotInstr* CBotDo::Compile(CBotToken* &p, CBotCStack* pStack)
@@ -348,6 +365,7 @@ CBotInstr* CBotDo::Compile(CBotToken* &p, CBotCStack* pStack)
                 // the condition exists
                 if (IsOfType(p, ID_SEP))
                 {
+                    inst->m_code = CBotByteCode::Compile(inst, pStk);
                     return pStack->Return(inst, pStk);  // return an object to the application
                 }
                 pStk->SetError(TX_ENDOF, p->GetStart());
@@ -370,6 +388,18 @@ bool CBotDo :: Execute(CBotStack* &pj)
 
     if ( pile->IfStep() ) return false;
 
+    // the compiled loop runs from its beginning
+    if ( m_code != NULL && pile->GetState() == 0 )
+    {
+        switch ( m_code->Run(pile) )
+        {
+        case CBotByteCode::RunSuspend:
+            return false;                       // interrupted at the end of an iteration
+        case CBotByteCode::RunEnd:
+            return pj->Return(pile);            // sends the results and releases the stack
+        }
+    }
+
     while( true ) switch( pile->GetState() )            // executes the loop
     {                                                   // there are two possible states (depending on recovery)
     case 0:
@@ -440,6 +470,7 @@ CBotFor::CBotFor()
     m_Test      =
     m_Incr      =
     m_Block     = NULL;     // NULL so that delete is not possible further
+    m_code      = NULL;
     name = "CBotFor";       // debug
 }
 
@@ -449,6 +480,7 @@ CBotFor::~CBotFor()
     delete  m_Test; 
     delete  m_Incr; 
     delete  m_Block;        // frees the instruction block
+    delete  m_code;         // frees the compiled loop
 }
 
 CBotInstr* CBotFor::Compile(CBotToken* &p, CBotCStack* pStack)
@@ -501,7 +533,10 @@ CBotInstr* CBotFor::Compile(CBotToken* &p, CBotCStack* pStack)
                     inst->m_Block = CBotBlock::CompileBlkOrInst( p, pStk, true );
                     DecLvl();
                     if ( pStk->IsOk() )
-                        return pStack->Return(inst, pStk);;
+                    {
+                        inst->m_code = CBotByteCode::Compile(inst, pStk);
+                        return pStack->Return(inst, pStk);
+                    }
                 }
                 pStack->SetError(TX_CLOSEPAR, p->GetStart());
             }
@@ -522,6 +557,25 @@ bool CBotFor :: Execute(CBotStack* &pj)
 
     if ( pile->IfStep() ) return false;
 
+    // the compiled loop runs from the test, after the initialization
+    if ( m_code != NULL && pile->GetState() <= 1 )
+    {
+        if ( pile->GetState() == 0 )
+        {
+            if ( m_Init != NULL &&
+                 !m_Init->Execute(pile) ) return false;     // interrupted here ?
+            if (!pile->SetState(1)) return false;           // ready for further
+        }
+
+        switch ( m_code->Run(pile) )
+        {
+        case CBotByteCode::RunSuspend:
+            return false;                       // interrupted at the end of an iteration
+        case CBotByteCode::RunEnd:
+            return pj->Return(pile);            // sends the results and releases the stack
+        }
+    }
+
     while( true ) switch( pile->GetState() )    // executes the loop
     {                                           // there are four possible states (depending on recovery)
     case 0:
@@ -1117,14 +1171,14 @@ bool CBotTry :: Execute(CBotStack* &pj)
         }
 
         val = pile1->GetError();
-        if ( val == 0 && CBotStack::m_initimer == 0 )           // mode step?
+        if ( val == 0 && pj->m_root->m_initimer == 0 )          // mode step?
             return false;                                       // does not make the catch
 
         pile1->IncState();
         pile2->SetState(val);                                   // stores the error number
         pile1->SetError(0);                                     // for now there is are more errors!
 
-        if ( val == 0 && CBotStack::m_initimer < 0 )            // mode step?
+        if ( val == 0 && pj->m_root->m_initimer < 0 )           // mode step?
             return false;                                       // does not make the catch
     }
 
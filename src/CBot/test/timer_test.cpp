@@ -0,0 +1,116 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+// CBot/test/timer_test.cpp
+
+/*
+  Unit tests for the instruction timer of CBotProgram
+ */
+
+#include "CBot/CBotDll.h"
+
+#include "gtest/gtest.h"
+
+
+const char* const TEST_PROGRAM = "extern void main() { int s = 0; for (int i = 0; i < 3; i++) s += i; }";
+
+
+class TimerTest : public testing::Test
+{
+protected:
+    static void SetUpTestCase()
+    {
+        CBotProgram::Init();
+    }
+
+    static void TearDownTestCase()
+    {
+        CBotProgram::Free();
+    }
+
+    void Start(CBotProgram& program)
+    {
+        CBotStringArray list;
+        ASSERT_TRUE(program.Compile(TEST_PROGRAM, list, NULL));
+        ASSERT_TRUE(program.Start("main"));
+    }
+};
+
+
+TEST_F(TimerTest, DefaultTimerRunsToTheEnd)
+{
+    CBotProgram program;
+    Start(program);
+
+    EXPECT_TRUE(program.Run(NULL));
+    EXPECT_EQ(0, program.GetError());
+}
+
+TEST_F(TimerTest, ZeroTimerRunsStepByStep)
+{
+    CBotProgram program;
+    Start(program);
+
+    EXPECT_FALSE(program.Run(NULL, 0));
+    EXPECT_FALSE(program.Run(NULL, 0));
+    EXPECT_EQ(0, program.GetError());
+}
+
+TEST_F(TimerTest, ZeroTimerIsNotKeptForTheNextRun)
+{
+    CBotProgram program;
+    Start(program);
+
+    EXPECT_FALSE(program.Run(NULL, 0));
+
+    // The next run without a timer gets the default steps again
+    EXPECT_TRUE(program.Run(NULL));
+    EXPECT_EQ(0, program.GetError());
+}
+
+TEST_F(TimerTest, QuotaIsUsedWithoutTimer)
+{
+    CBotProgram program;
+    Start(program);
+    program.SetQuota(0);
+
+    EXPECT_FALSE(program.Run(NULL));
+    EXPECT_FALSE(program.Run(NULL));
+
+    program.SetQuota(-1);
+    EXPECT_TRUE(program.Run(NULL));
+}
+
+TEST_F(TimerTest, CompiledLoopCountsTheStepsOfTheInstructions)
+{
+    // steps counted by the instructions, without the compiled loop
+    const char* const text = "extern void main() { int s = 0; int i = 0; "
+                             "while (i < 10) { i++; if (i % 2 == 0) continue; s += i; } }";
+
+    CBotProgram program;
+    CBotStringArray list;
+    ASSERT_TRUE(program.Compile(text, list, NULL));
+    ASSERT_TRUE(program.Start("main"));
+
+    EXPECT_TRUE(program.Run(NULL, 1000));
+    EXPECT_EQ(158, program.GetStepsUsed());
+}
+
+int main(int argc, char* argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+// CBot/tests/CBot_console/src/app/benchmark.cpp
+
+/*
+  Runs a function of a CBot program several times and measures the time,
+  to compare versions of the interpreter on the scenarios, e.g.:
+    CBot_benchmark ../scenarios/fibo.txt t 10
+ */
+
+#include "CClass.h"
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cout << "Usage: " << argv[0] << " <filename> <function> [count]" << std::endl;
+        return 0;
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in.good())
+    {
+        std::cout << "Cannot read " << argv[1] << std::endl;
+        return 1;
+    }
+    std::string contents((std::istreambuf_iterator<char>(in)),
+        std::istreambuf_iterator<char>());
+
+    int count = (argc > 3) ? atoi(argv[3]) : 1;
+
+    CClass newclass;
+    if (!newclass.InitInstance())
+    {
+        std::cerr << "Initialization not complete!" << std::endl;
+        return 1;
+    }
+
+    CBotProgram* prog = new CBotProgram();
+    CBotStringArray liste;
+    if (!prog->Compile(contents.c_str(), liste, NULL))
+    {
+        std::cout << CBotProgram::GetErrorText(prog->GetError()) << std::endl;
+        delete prog;
+        newclass.ExitInstance();
+        return 1;
+    }
+
+    long steps = 0;
+    long allocs = 0, heap = 0;
+    long nAlloc, nHeap;
+    clock_t t0 = clock();
+    for (int i = 0; i < count; i++)
+    {
+        if (!prog->Start(argv[2]))
+        {
+            std::cout << "No function " << argv[2] << std::endl;
+            break;
+        }
+        bool done = false;
+        while (!done)
+        {
+            done = prog->Run();
+            steps += prog->GetStepsUsed();
+            prog->GetAllocUsed(nAlloc, nHeap);
+            allocs += nAlloc;
+            heap += nHeap;
+        }
+
+        if (prog->GetError() != 0)
+        {
+            std::cout << CBotProgram::GetErrorText(prog->GetError()) << std::endl;
+            break;
+        }
+    }
+    clock_t t1 = clock();
+
+    char buffer[200];
+    sprintf(buffer, "%d run(s) of %s in %.3f seconds, %ld steps, %ld allocations (%ld from the heap)\n",
+            count, argv[2], static_cast<double>(t1 - t0) / CLOCKS_PER_SEC, steps, allocs, heap);
+    std::cout << buffer;
+
+    delete prog;
+    newclass.ExitInstance();
+    return 0;
+}
@@ -19,6 +19,7 @@
 
 #include "app/app.h"
 
+#include "app/profiler.h"
 #include "app/system.h"
 
 #include "common/logger.h"
@@ -26,10 +27,13 @@
 #include "common/image.h"
 #include "common/key.h"
 
+#include "graphics/null/nulldevice.h"
 #include "graphics/opengl/gldevice.h"
 
 #include "object/robotmain.h"
 
+#include "script/scriptscheduler.h"
+
 #include <boost/filesystem.hpp>
 
 #include <SDL/SDL.h>
@@ -95,6 +99,7 @@ CApplication::CApplication()
     m_iMan          = new CInstanceManager();
     m_eventQueue    = new CEventQueue(m_iMan);
     m_profile       = new CProfile();
+    m_profiler      = new CProfiler();
 
     m_engine    = nullptr;
     m_device    = nullptr;
@@ -125,6 +130,7 @@ CApplication::CApplication()
     m_baseTimeStamp = CreateTimeStamp();
     m_curTimeStamp = CreateTimeStamp();
     m_lastTimeStamp = CreateTimeStamp();
+    m_loadingTimeStamp = CreateTimeStamp();
 
     m_joystickEnabled = false;
 
@@ -140,6 +146,13 @@ CApplication::CApplication()
 
     m_lowCPU = true;
 
+    m_scriptThreads = 0;
+    m_scriptFrameTime = SCRIPT_FRAME_TIME;
+    m_saveText = false;
+
+    m_benchmarkRank = 0;
+    m_benchmarkFrames = BENCHMARK_DEFAULT_FRAMES;
+
     for (int i = 0; i < DIR_MAX; ++i)
         m_dataDirs[i] = nullptr;
 
@@ -165,12 +178,16 @@ CApplication::~CApplication()
     delete m_profile;
     m_profile = nullptr;
 
+    delete m_profiler;
+    m_profiler = nullptr;
+
     delete m_iMan;
     m_iMan = nullptr;
 
     DestroyTimeStamp(m_baseTimeStamp);
     DestroyTimeStamp(m_curTimeStamp);
     DestroyTimeStamp(m_lastTimeStamp);
+    DestroyTimeStamp(m_loadingTimeStamp);
 }
 
 ParseArgsStatus CApplication::ParseArguments(int argc, char *argv[])
@@ -178,6 +195,12 @@ ParseArgsStatus CApplication::ParseArguments(int argc, char *argv[])
     bool waitDataDir = false;
     bool waitLogLevel = false;
     bool waitLanguage = false;
+    bool waitScriptThreads = false;
+    bool waitScriptFrameTime = false;
+    bool scriptFrameTimeGiven = false;
+    bool waitProfileFile = false;
+    bool waitBenchmarkScene = false;
+    bool waitBenchmarkFrames = false;
 
     for (int i = 1; i < argc; ++i)
     {
@@ -227,6 +250,53 @@ ParseArgsStatus CApplication::ParseArguments(int argc, char *argv[])
             continue;
         }
 
+        if (waitScriptThreads)
+        {
+            waitScriptThreads = false;
+            m_scriptThreads = atoi(arg.c_str());
+            if (m_scriptThreads < 0)
+                return PARSE_ARGS_FAIL;
+            continue;
+        }
+
+        if (waitScriptFrameTime)
+        {
+            waitScriptFrameTime = false;
+            scriptFrameTimeGiven = true;
+            m_scriptFrameTime = atof(arg.c_str());
+            if (m_scriptFrameTime < 0.0f)
+                return PARSE_ARGS_FAIL;
+            continue;
+        }
+
+        if (waitProfileFile)
+        {
+            waitProfileFile = false;
+            m_profileFile = arg;
+            continue;
+        }
+
+        if (waitBenchmarkScene)
+        {
+            waitBenchmarkScene = false;
+            // Scene name followed by its rank, as in scene file names
+            std::size_t digits = arg.find_last_not_of("0123456789");
+            if (digits == std::string::npos || digits + 1 == arg.size())
+                return PARSE_ARGS_FAIL;
+            m_benchmarkScene = arg.substr(0, digits + 1);
+            m_benchmarkRank = atoi(arg.substr(digits + 1).c_str());
+            continue;
+        }
+
+        if (waitBenchmarkFrames)
+        {
+            waitBenchmarkFrames = false;
+            m_benchmarkFrames = atoi(arg.c_str());
+            if (m_benchmarkFrames <= 0)
+                return PARSE_ARGS_FAIL;
+            continue;
+        }
+
         if (arg == "-debug")
         {
             SetDebugMode(true);
@@ -243,6 +313,30 @@ ParseArgsStatus CApplication::ParseArguments(int argc, char *argv[])
         {
             waitLanguage = true;
         }
+        else if (arg == "-scriptthreads")
+        {
+            waitScriptThreads = true;
+        }
+        else if (arg == "-scriptframe")
+        {
+            waitScriptFrameTime = true;
+        }
+        else if (arg == "-savetext")
+        {
+            m_saveText = true;
+        }
+        else if (arg == "-profile")
+        {
+            waitProfileFile = true;
+        }
+        else if (arg == "-benchmark")
+        {
+            waitBenchmarkScene = true;
+        }
+        else if (arg == "-benchmarkframes")
+        {
+            waitBenchmarkFrames = true;
+        }
         else if (arg == "-help")
         {
             GetLogger()->Message("\n");
@@ -254,6 +348,12 @@ ParseArgsStatus CApplication::ParseArguments(int argc, char *argv[])
             GetLogger()->Message("  -debug           enable debug mode (more info printed in logs)\n");
             GetLogger()->Message("  -loglevel level  set log level to level (one of: trace, debug, info, warn, error, none)\n");
             GetLogger()->Message("  -language lang   set language (one of: en, de, fr, pl)\n");
+            GetLogger()->Message("  -scriptthreads n run robot programs on n worker threads (default: 0)\n");
+            GetLogger()->Message("  -scriptframe ms  frame time kept by slowing down robot programs (default: %.0f, 0 with -benchmark, 0 = never)\n", SCRIPT_FRAME_TIME);
+            GetLogger()->Message("  -savetext        write saved games only in the text format, without the faster binary snapshot\n");
+            GetLogger()->Message("  -profile file    write frame times to file at exit (CSV, or JSON if file ends with .json)\n");
+            GetLogger()->Message("  -benchmark scene run given scene (e.g. scene101) without window and exit\n");
+            GetLogger()->Message("  -benchmarkframes n number of frames of the benchmark (default: %d)\n", BENCHMARK_DEFAULT_FRAMES);
             return PARSE_ARGS_HELP;
         }
         else
@@ -264,9 +364,15 @@ ParseArgsStatus CApplication::ParseArguments(int argc, char *argv[])
     }
 
     // Args not given?
-    if (waitDataDir || waitLogLevel || waitLanguage)
+    if (waitDataDir || waitLogLevel || waitLanguage || waitScriptThreads || waitScriptFrameTime ||
+        waitProfileFile || waitBenchmarkScene || waitBenchmarkFrames)
         return PARSE_ARGS_FAIL;
 
+    // With the fixed time step of the benchmark, slowing down the programs
+    // would only make the runs differ; they run at full speed unless asked
+    if (! m_benchmarkScene.empty() && ! scriptFrameTimeGiven)
+        m_scriptFrameTime = 0.0f;
+
     return PARSE_ARGS_OK;
 }
 
@@ -300,7 +406,10 @@ bool CApplication::Create()
             m_dataPath = path;
 
         #ifdef OPENAL_SOUND
-        m_sound = static_cast<CSoundInterface *>(new ALSound());
+        if (IsBenchmark())
+            m_sound = new CSoundInterface();
+        else
+            m_sound = static_cast<CSoundInterface *>(new ALSound());
         #else
         GetLogger()->Info("No sound support.\n");
         m_sound = new CSoundInterface();
@@ -322,6 +431,10 @@ bool CApplication::Create()
 
     Uint32 initFlags = SDL_INIT_VIDEO | SDL_INIT_TIMER;
 
+    // No window in benchmark mode
+    if (IsBenchmark())
+        initFlags = SDL_INIT_TIMER;
+
     if (SDL_Init(initFlags) < 0)
     {
         m_errorMessage = std::string("SDL initialization error:\n") +
@@ -331,12 +444,6 @@ bool CApplication::Create()
         return false;
     }
 
-    // This is non-fatal and besides seems to fix some memory leaks
-    if (SDL_InitSubSystem(SDL_INIT_JOYSTICK) < 0)
-    {
-        GetLogger()->Warn("Joystick subsystem init failed\nJoystick(s) will not be available\n");
-    }
-
     if ((IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) == 0)
     {
         m_errorMessage = std::string("SDL_Image initialization error:\n") +
@@ -345,42 +452,58 @@ bool CApplication::Create()
         m_exitCode = 3;
         return false;
     }
- 
-    // load settings from profile
-    int iValue;
-    if ( GetProfile().GetLocalProfileInt("Setup", "Resolution", iValue) ) {
-	std::vector<Math::IntPoint> modes;
-	GetVideoResolutionList(modes, true, true);
-	if (static_cast<unsigned int>(iValue) < modes.size())
-	    m_deviceConfig.size = modes.at(iValue);
-    }
-    
-    if ( GetProfile().GetLocalProfileInt("Setup", "Fullscreen", iValue) ) {
-	m_deviceConfig.fullScreen = (iValue == 1);
-    }
-    
-    if (! CreateVideoSurface())
-        return false; // dialog is in function
 
-    if (m_private->surface == nullptr)
+    if (IsBenchmark())
     {
-        m_errorMessage = std::string("SDL error while setting video mode:\n") +
-                         std::string(SDL_GetError());
-        GetLogger()->Error(m_errorMessage.c_str());
-        m_exitCode = 4;
-        return false;
+        // Nothing is displayed, the null device only counts draw calls
+        m_deviceConfig.doubleBuf = false;
+        m_device = new Gfx::CNullDevice();
     }
+    else
+    {
+        // This is non-fatal and besides seems to fix some memory leaks
+        if (SDL_InitSubSystem(SDL_INIT_JOYSTICK) < 0)
+        {
+            GetLogger()->Warn("Joystick subsystem init failed\nJoystick(s) will not be available\n");
+        }
+
+        // load settings from profile
+        int iValue;
+        if ( GetProfile().GetLocalProfileInt("Setup", "Resolution", iValue) ) {
+            std::vector<Math::IntPoint> modes;
+            GetVideoResolutionList(modes, true, true);
+            if (static_cast<unsigned int>(iValue) < modes.size())
+                m_deviceConfig.size = modes.at(iValue);
+        }
 
-    SDL_WM_SetCaption(m_windowTitle.c_str(), m_windowTitle.c_str());
+        if ( GetProfile().GetLocalProfileInt("Setup", "Fullscreen", iValue) ) {
+            m_deviceConfig.fullScreen = (iValue == 1);
+        }
 
-    // Enable translating key codes of key press events to unicode chars
-    SDL_EnableUNICODE(1);
+        if (! CreateVideoSurface())
+            return false; // dialog is in function
+
+        if (m_private->surface == nullptr)
+        {
+            m_errorMessage = std::string("SDL error while setting video mode:\n") +
+                             std::string(SDL_GetError());
+            GetLogger()->Error(m_errorMessage.c_str());
+            m_exitCode = 4;
+            return false;
+        }
+
+        SDL_WM_SetCaption(m_windowTitle.c_str(), m_windowTitle.c_str());
+
+        // Enable translating key codes of key press events to unicode chars
+        SDL_EnableUNICODE(1);
+
+        // Don't generate joystick events
+        SDL_JoystickEventState(SDL_IGNORE);
+
+        // The video is ready, we can create and initalize the graphics device
+        m_device = new Gfx::CGLDevice(m_deviceConfig);
+    }
 
-    // Don't generate joystick events
-    SDL_JoystickEventState(SDL_IGNORE);
-    
-    // The video is ready, we can create and initalize the graphics device
-    m_device = new Gfx::CGLDevice(m_deviceConfig);
     if (! m_device->Create() )
     {
         m_errorMessage = std::string("Error in CDevice::Create()\n") + standardInfoMessage;
@@ -402,8 +525,13 @@ bool CApplication::Create()
 
     // Create the robot application.
     m_robotMain = new CRobotMain(m_iMan, this);
+    m_robotMain->SetScriptThreads(m_scriptThreads);
+    m_robotMain->SetScriptFrameTime(m_scriptFrameTime);
+    m_robotMain->SetIOText(m_saveText);
 
-    m_robotMain->ChangePhase(PHASE_WELCOME1);
+    // The benchmark starts its scene in RunBenchmark()
+    if (! IsBenchmark())
+        m_robotMain->ChangePhase(PHASE_WELCOME1);
 
     GetLogger()->Info("CApplication created successfully\n");
 
@@ -683,6 +811,9 @@ void CApplication::UpdateMouse()
 
 int CApplication::Run()
 {
+    if (IsBenchmark())
+        return RunBenchmark();
+
     m_active = true;
 
     GetCurrentTimeStamp(m_baseTimeStamp);
@@ -783,6 +914,8 @@ int CApplication::Run()
         // Enter game update & frame rendering only if active
         if (m_active)
         {
+            m_profiler->StartSection(PROF_EVENTS);
+
             Event event;
             while (m_eventQueue->GetEvent(event))
             {
@@ -804,6 +937,8 @@ int CApplication::Run()
                     m_robotMain->EventProcess(event);
             }
 
+            m_profiler->StopSection(PROF_EVENTS);
+
             /* Update mouse position explicitly right before rendering
              * because mouse events are usually way behind */
             UpdateMouse();
@@ -818,15 +953,115 @@ int CApplication::Run()
             {
                 usleep(20000); // should still give plenty of fps
             }
+
+            m_profiler->EndFrame();
         }
     }
 
 end:
+    if (! m_profileFile.empty())
+        m_profiler->Write(m_profileFile);
+
     Destroy();
 
     return m_exitCode;
 }
 
+/** The scene is run with a fixed time step, as fast as possible,
+    and the times of each frame are written to the log. */
+int CApplication::RunBenchmark()
+{
+    GetLogger()->Info("Benchmark of scene %s%d, %d frames\n", m_benchmarkScene.c_str(),
+                      m_benchmarkRank, m_benchmarkFrames);
+
+    m_robotMain->StartScene(m_benchmarkScene, m_benchmarkRank);
+
+    Gfx::CNullDevice* device = static_cast<Gfx::CNullDevice*>(m_device);
+    CScriptScheduler* scheduler = CScriptScheduler::GetInstancePointer();
+
+    SystemTimeStamp* frameStart = CreateTimeStamp();
+    SystemTimeStamp* updateEnd = CreateTimeStamp();
+    SystemTimeStamp* frameEnd = CreateTimeStamp();
+
+    GetCurrentTimeStamp(m_baseTimeStamp);
+    GetCurrentTimeStamp(m_lastTimeStamp);
+    GetCurrentTimeStamp(m_curTimeStamp);
+
+    float totalTime = 0.0f;
+    float maxTime = 0.0f;
+    long long totalSteps = 0LL;
+
+    for (int frame = 0; frame < m_benchmarkFrames; frame++)
+    {
+        GetCurrentTimeStamp(frameStart);
+        long long steps = scheduler->GetStatisticSteps();
+
+        StepSimulation();
+
+        m_profiler->StartSection(PROF_EVENTS);
+
+        Event event;
+        while (m_eventQueue->GetEvent(event))
+        {
+            if (event.type == EVENT_QUIT)
+                continue;
+
+            bool passOn = ProcessEvent(event);
+
+            if (passOn)
+                passOn = m_engine->ProcessEvent(event);
+
+            if (passOn)
+                m_robotMain->EventProcess(event);
+        }
+
+        m_profiler->StopSection(PROF_EVENTS);
+
+        GetCurrentTimeStamp(updateEnd);
+
+        Render();
+
+        GetCurrentTimeStamp(frameEnd);
+        m_profiler->EndFrame();
+
+        float updateTime = TimeStampDiff(frameStart, updateEnd, STU_MSEC);
+        float renderTime = TimeStampDiff(updateEnd, frameEnd, STU_MSEC);
+        steps = scheduler->GetStatisticSteps() - steps;
+
+        GetLogger()->Info("Frame %d: update %.3f ms, render %.3f ms, %d triangles, %d draw calls, "
+                          "%d state changes, %lld instructions\n", frame, updateTime, renderTime,
+                          m_engine->GetStatisticTriangle(), device->GetStatisticDrawCall(),
+                          device->GetStatisticStateChange(), steps);
+
+        totalTime += updateTime + renderTime;
+        if (updateTime + renderTime > maxTime)
+            maxTime = updateTime + renderTime;
+        totalSteps += steps;
+    }
+
+    GetLogger()->Info("Benchmark done: %d frames in %.3f s, average %.3f ms, max %.3f ms, "
+                      "%lld instructions per frame\n", m_benchmarkFrames, totalTime / 1000.0f,
+                      totalTime / m_benchmarkFrames, maxTime, totalSteps / m_benchmarkFrames);
+
+    scheduler->LogStatistics();
+
+    DestroyTimeStamp(frameStart);
+    DestroyTimeStamp(updateEnd);
+    DestroyTimeStamp(frameEnd);
+
+    if (! m_profileFile.empty())
+        m_profiler->Write(m_profileFile);
+
+    Destroy();
+
+    return m_exitCode;
+}
+
+bool CApplication::IsBenchmark()
+{
+    return ! m_benchmarkScene.empty();
+}
+
 int CApplication::GetExitCode()
 {
     return m_exitCode;
@@ -1102,12 +1337,40 @@ Event CApplication::CreateVirtualEvent(const Event& sourceEvent)
 /** Renders the frame and swaps buffers as necessary */
 void CApplication::Render()
 {
+    CProfilerScope scope(PROF_RENDER);
+
     m_engine->Render();
 
     if (m_deviceConfig.doubleBuf)
         SDL_GL_SwapBuffers();
 }
 
+void CApplication::LoadingProgress(int done, int total)
+{
+    SystemTimeStamp* now = CreateTimeStamp();
+    GetCurrentTimeStamp(now);
+    float diff = TimeStampDiff(m_loadingTimeStamp, now, STU_MSEC);
+
+    // The first call of a loading shows it at once
+    if (done > 1 && done < total && diff < LOADING_PROGRESS_INTERVAL)
+    {
+        DestroyTimeStamp(now);
+        return;
+    }
+
+    CopyTimeStamp(m_loadingTimeStamp, now);
+    DestroyTimeStamp(now);
+
+    float progress = 1.0f;
+    if (total > 0)
+        progress = static_cast<float>(done) / static_cast<float>(total);
+
+    m_engine->RenderLoading(progress);
+
+    if (m_deviceConfig.doubleBuf)
+        SDL_GL_SwapBuffers();
+}
+
 void CApplication::SuspendSimulation()
 {
     m_simulationSuspended = true;
@@ -1147,16 +1410,29 @@ void CApplication::StepSimulation()
     if (m_simulationSuspended)
         return;
 
+    CProfilerScope scope(PROF_SIMULATION);
+
     CopyTimeStamp(m_lastTimeStamp, m_curTimeStamp);
     GetCurrentTimeStamp(m_curTimeStamp);
 
-    long long absDiff = TimeStampExactDiff(m_baseTimeStamp, m_curTimeStamp);
-    m_realAbsTime = m_realAbsTimeBase + absDiff;
-    // m_baseTimeStamp is updated on simulation speed change, so this is OK
-    m_exactAbsTime = m_absTimeBase + m_simulationSpeed * absDiff;
-    m_absTime = (m_absTimeBase + m_simulationSpeed * absDiff) / 1e9f;
+    if (IsBenchmark())
+    {
+        // Fixed time step, so that benchmark runs can be compared
+        m_realRelTime = BENCHMARK_REL_TIME;
+        m_realAbsTime += m_realRelTime;
+        m_exactAbsTime += m_simulationSpeed * m_realRelTime;
+        m_absTime = m_exactAbsTime / 1e9f;
+    }
+    else
+    {
+        long long absDiff = TimeStampExactDiff(m_baseTimeStamp, m_curTimeStamp);
+        m_realAbsTime = m_realAbsTimeBase + absDiff;
+        // m_baseTimeStamp is updated on simulation speed change, so this is OK
+        m_exactAbsTime = m_absTimeBase + m_simulationSpeed * absDiff;
+        m_absTime = (m_absTimeBase + m_simulationSpeed * absDiff) / 1e9f;
 
-    m_realRelTime = TimeStampExactDiff(m_lastTimeStamp, m_curTimeStamp);
+        m_realRelTime = TimeStampExactDiff(m_lastTimeStamp, m_curTimeStamp);
+    }
     m_exactRelTime = m_simulationSpeed * m_realRelTime;
     m_relTime = (m_simulationSpeed * m_realRelTime) / 1e9f;
 
@@ -29,6 +29,7 @@
 
 #include "graphics/core/device.h"
 #include "graphics/engine/engine.h"
+#include "graphics/engine/imageloader.h"
 #include "graphics/opengl/gldevice.h"
 
 
@@ -38,6 +39,7 @@
 
 class CInstanceManager;
 class CEventQueue;
+class CProfiler;
 class CRobotMain;
 class CSoundInterface;
 
@@ -112,6 +114,14 @@ enum MouseMode
     MOUSE_NONE,   //! < no cursor visible
 };
 
+//! Time step of the benchmark mode (in ns), 30 frames per second
+const long long BENCHMARK_REL_TIME = 33333333LL;
+//! Default number of frames of the benchmark mode
+const int BENCHMARK_DEFAULT_FRAMES = 1000;
+//! Minimum time between two updates of the loading progress (in ms)
+const float LOADING_PROGRESS_INTERVAL = 50.0f;
+
+
 struct ApplicationPrivate;
 
 /**
@@ -151,13 +161,20 @@ struct ApplicationPrivate;
  * means whether to pass the event on, or stop the chain. This is to enable handling some
  * events which are internal to CApplication or CEngine.
  *
+ * \section Benchmark Benchmark mode
+ *
+ * With -benchmark option, Create() makes neither window nor OpenGL context; a null
+ * device (Gfx::CNullDevice) only counts draw calls. Run() then loads the given scene,
+ * runs a fixed number of frames with a fixed time step and writes to the log the times
+ * of each frame, with triangle, draw call, state change and CBot instruction counts.
+ *
  * \section Portability Portability
  *
  * Currently, the class only handles OpenGL devices. SDL can be used with DirectX, but
  * for that to work, video initialization and video setting must be done differently.
  *
  */
-class CApplication : public CSingleton<CApplication>
+class CApplication : public CSingleton<CApplication>, public Gfx::CLoadingProgress
 {
 public:
     //! Constructor (can only be called once!)
@@ -304,6 +321,9 @@ public:
     bool        GetLowCPU();
     //@}
 
+    //! Shows the progress of loading a scene, at most every LOADING_PROGRESS_INTERVAL ms
+    void        LoadingProgress(int done, int total);
+
 protected:
     //! Creates the window's SDL_Surface
     bool CreateVideoSurface();
@@ -317,6 +337,11 @@ protected:
     //! Renders the image in window
     void        Render();
 
+    //! Runs the benchmark scene instead of the main loop
+    int         RunBenchmark();
+    //! Returns whether the application runs in benchmark mode
+    bool        IsBenchmark();
+
     //! Opens the joystick device
     bool OpenJoystick();
     //! Closes the joystick device
@@ -338,6 +363,8 @@ protected:
     //! Main class of the proper game engine
     CRobotMain*             m_robotMain;
     CProfile*               m_profile;
+    //! Frame profiler
+    CProfiler*              m_profiler;
 
     //! Code to return at exit
     int             m_exitCode;
@@ -362,6 +389,8 @@ protected:
     SystemTimeStamp* m_baseTimeStamp;
     SystemTimeStamp* m_lastTimeStamp;
     SystemTimeStamp* m_curTimeStamp;
+    //! Last time the loading progress was shown
+    SystemTimeStamp* m_loadingTimeStamp;
 
     long long       m_realAbsTimeBase;
     long long       m_realAbsTime;
@@ -409,5 +438,22 @@ protected:
 
     //! Low cpu mode
     bool            m_lowCPU;
+
+    //! Number of threads running robot programs (0 = main thread only)
+    int             m_scriptThreads;
+    //! Frame time kept by limiting the instructions of robot programs, in ms (0 = fixed quotas)
+    float           m_scriptFrameTime;
+    //! Saved games are written only in the text format, without binary snapshots
+    bool            m_saveText;
+
+    //! File to which the frame profile is written at exit (empty = none)
+    std::string     m_profileFile;
+
+    //! Scene of the benchmark mode, without rank (empty = normal mode)
+    std::string     m_benchmarkScene;
+    //! Rank of the benchmark scene
+    int             m_benchmarkRank;
+    //! Number of frames of the benchmark
+    int             m_benchmarkFrames;
 };
 
@@ -0,0 +1,312 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+
+#include "app/profiler.h"
+
+#include "app/system.h"
+
+#include "common/logger.h"
+
+#include <algorithm>
+#include <fstream>
+
+
+template<> CProfiler* CSingleton<CProfiler>::mInstance = nullptr;
+
+
+//! Names and levels of the sections, in the order of ProfilerSection
+static const char* SECTION_NAMES[PROF_MAX] =
+{
+    "Frame",
+    "Events",
+    "Update",
+    "Objects",
+    "Physics",
+    "Scripts",
+    "Pyros",
+    "Camera",
+    "Simulation",
+    "Particles",
+    "Render",
+    "Draw terrain",
+    "Draw shadows",
+    "Draw objects",
+    "Draw transparent",
+    "Draw particles",
+    "Draw interface",
+    "Terrain"
+};
+
+static const int SECTION_LEVELS[PROF_MAX] =
+{
+    0,  // frame
+    1,  // events
+    2,  // update
+    3,  // objects
+    4,  // physics
+    3,  // scripts
+    3,  // pyros
+    3,  // camera
+    1,  // simulation
+    2,  // particles
+    1,  // render
+    2,  // draw terrain
+    2,  // draw shadows
+    2,  // draw objects
+    2,  // draw transparent
+    2,  // draw particles
+    2,  // draw interface
+    1   // terrain
+};
+
+
+CProfiler::CProfiler()
+{
+    for (int i = 0; i < PROF_MAX; i++)
+    {
+        m_start[i] = CreateTimeStamp();
+        m_depth[i] = 0;
+        m_frameTime[i] = 0LL;
+        m_averageSum[i] = 0LL;
+    }
+
+    m_now = CreateTimeStamp();
+
+    m_history.resize(PROFILER_HISTORY * PROF_MAX, 0LL);
+    m_historyPos = 0;
+    m_historyCount = 0;
+    m_frameCount = 0LL;
+
+    StartSection(PROF_FRAME);
+}
+
+CProfiler::~CProfiler()
+{
+    for (int i = 0; i < PROF_MAX; i++)
+        DestroyTimeStamp(m_start[i]);
+
+    DestroyTimeStamp(m_now);
+}
+
+void CProfiler::StartSection(ProfilerSection section)
+{
+    if (m_depth[section]++ > 0)
+        return;
+
+    GetCurrentTimeStamp(m_start[section]);
+}
+
+void CProfiler::StopSection(ProfilerSection section)
+{
+    if (m_depth[section] == 0)
+        return;
+
+    if (--m_depth[section] > 0)
+        return;
+
+    GetCurrentTimeStamp(m_now);
+    m_frameTime[section] += TimeStampExactDiff(m_start[section], m_now);
+}
+
+void CProfiler::EndFrame()
+{
+    StopSection(PROF_FRAME);
+
+    // The oldest frame of the average goes out
+    if (m_historyCount >= PROFILER_AVERAGE)
+    {
+        int old = GetHistoryIndex(PROFILER_AVERAGE - 1);
+        for (int i = 0; i < PROF_MAX; i++)
+            m_averageSum[i] -= m_history[old + i];
+    }
+
+    int index = m_historyPos * PROF_MAX;
+    for (int i = 0; i < PROF_MAX; i++)
+    {
+        m_history[index + i] = m_frameTime[i];
+        m_averageSum[i] += m_frameTime[i];
+        m_frameTime[i] = 0LL;
+    }
+
+    m_historyPos = (m_historyPos + 1) % PROFILER_HISTORY;
+    if (m_historyCount < PROFILER_HISTORY)
+        m_historyCount++;
+    m_frameCount++;
+
+    StartSection(PROF_FRAME);
+}
+
+int CProfiler::GetHistoryIndex(int age)
+{
+    int pos = (m_historyPos - 1 - age + PROFILER_HISTORY) % PROFILER_HISTORY;
+    return pos * PROF_MAX;
+}
+
+float CProfiler::GetAverageTime(ProfilerSection section)
+{
+    int count = std::min(m_historyCount, PROFILER_AVERAGE);
+    if (count == 0)
+        return 0.0f;
+
+    return m_averageSum[section] / (count * 1e6f);
+}
+
+float CProfiler::GetMaxTime(ProfilerSection section)
+{
+    int count = std::min(m_historyCount, PROFILER_AVERAGE);
+
+    long long max = 0LL;
+    for (int age = 0; age < count; age++)
+    {
+        long long time = m_history[GetHistoryIndex(age) + section];
+        if (time > max)
+            max = time;
+    }
+
+    return max / 1e6f;
+}
+
+float CProfiler::GetLastTime(ProfilerSection section)
+{
+    if (m_historyCount == 0)
+        return 0.0f;
+
+    return m_history[GetHistoryIndex(0) + section] / 1e6f;
+}
+
+const char* CProfiler::GetSectionName(ProfilerSection section)
+{
+    return SECTION_NAMES[section];
+}
+
+int CProfiler::GetSectionLevel(ProfilerSection section)
+{
+    return SECTION_LEVELS[section];
+}
+
+bool CProfiler::WriteCSV(const std::string& fileName)
+{
+    std::ofstream stream;
+    stream.open(fileName.c_str(), std::ios_base::out);
+    if (!stream.good())
+    {
+        GetLogger()->Error("Could not write profile '%s'\n", fileName.c_str());
+        return false;
+    }
+
+    stream.setf(std::ios_base::fixed);
+    stream.precision(3);
+
+    stream << "frame";
+    for (int i = 0; i < PROF_MAX; i++)
+        stream << "," << SECTION_NAMES[i];
+    stream << "\n";
+
+    // Oldest frame first
+    for (int age = m_historyCount - 1; age >= 0; age--)
+    {
+        int index = GetHistoryIndex(age);
+        stream << m_frameCount - 1 - age;
+        for (int i = 0; i < PROF_MAX; i++)
+            stream << "," << m_history[index + i] / 1e6f;
+        stream << "\n";
+    }
+
+    stream.close();
+
+    GetLogger()->Info("Profile of %d frames written to '%s'\n", m_historyCount, fileName.c_str());
+    return true;
+}
+
+bool CProfiler::WriteJSON(const std::string& fileName)
+{
+    std::ofstream stream;
+    stream.open(fileName.c_str(), std::ios_base::out);
+    if (!stream.good())
+    {
+        GetLogger()->Error("Could not write profile '%s'\n", fileName.c_str());
+        return false;
+    }
+
+    stream.setf(std::ios_base::fixed);
+    stream.precision(3);
+
+    stream << "{\n";
+    stream << "  \"frames\": " << m_frameCount << ",\n";
+    stream << "  \"sections\": [\n";
+    for (int i = 0; i < PROF_MAX; i++)
+    {
+        ProfilerSection section = static_cast<ProfilerSection>(i);
+        stream << "    { \"name\": \"" << SECTION_NAMES[i] << "\", "
+               << "\"level\": " << SECTION_LEVELS[i] << ", "
+               << "\"average\": " << GetAverageTime(section) << ", "
+               << "\"max\": " << GetMaxTime(section) << " }";
+        stream << (i + 1 < PROF_MAX ? ",\n" : "\n");
+    }
+    stream << "  ],\n";
+
+    // Oldest frame first, values in the order of the sections
+    stream << "  \"history\": [\n";
+    for (int age = m_historyCount - 1; age >= 0; age--)
+    {
+        int index = GetHistoryIndex(age);
+        stream << "    [";
+        for (int i = 0; i < PROF_MAX; i++)
+        {
+            if (i > 0)
+                stream << ", ";
+            stream << m_history[index + i] / 1e6f;
+        }
+        stream << (age > 0 ? "],\n" : "]\n");
+    }
+    stream << "  ]\n";
+    stream << "}\n";
+
+    stream.close();
+
+    GetLogger()->Info("Profile of %d frames written to '%s'\n", m_historyCount, fileName.c_str());
+    return true;
+}
+
+bool CProfiler::Write(const std::string& fileName)
+{
+    const std::string ext = ".json";
+    if (fileName.size() >= ext.size() &&
+        fileName.compare(fileName.size() - ext.size(), ext.size(), ext) == 0)
+        return WriteJSON(fileName);
+
+    return WriteCSV(fileName);
+}
+
+
+CProfilerScope::CProfilerScope(ProfilerSection section)
+{
+    m_section = section;
+    m_profiler = nullptr;
+
+    if (CProfiler::IsCreated())
+    {
+        m_profiler = CProfiler::GetInstancePointer();
+        m_profiler->StartSection(m_section);
+    }
+}
+
+CProfilerScope::~CProfilerScope()
+{
+    if (m_profiler != nullptr)
+        m_profiler->StopSection(m_section);
+}
@@ -0,0 +1,182 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+/**
+ * \file app/profiler.h
+ * \brief Frame profiler - CProfiler and CProfilerScope classes
+ */
+
+#pragma once
+
+
+#include "common/singleton.h"
+
+#include <string>
+#include <vector>
+
+
+struct SystemTimeStamp;
+
+
+//! Number of frames kept in the history of the profiler
+const int PROFILER_HISTORY = 600;
+//! Number of frames over which the averages are computed
+const int PROFILER_AVERAGE = 60;
+
+
+/**
+ * \enum ProfilerSection
+ * \brief Parts of the frame timed by the profiler
+ *
+ * Sections are listed in the order of the frame; a section can contain
+ * others, as given by CProfiler::GetSectionLevel().
+ */
+enum ProfilerSection
+{
+    //! Whole frame, from one call of CProfiler::EndFrame() to the next
+    PROF_FRAME = 0,
+    //! Processing of events in CApplication::Run()
+    PROF_EVENTS,
+    //! CRobotMain::EventFrame()
+    PROF_UPDATE,
+    //! Frame of all objects
+    PROF_OBJECTS,
+    //! CPhysics::EventFrame() of all objects
+    PROF_PHYSICS,
+    //! Execution of the robot programs
+    PROF_SCRIPTS,
+    //! Pyrotechnic effects
+    PROF_PYROS,
+    //! Camera
+    PROF_CAMERA,
+    //! CApplication::StepSimulation() and CEngine::FrameUpdate()
+    PROF_SIMULATION,
+    //! CParticle::FrameParticle()
+    PROF_PARTICLES,
+    //! CApplication::Render(): CEngine::Render() and swap of buffers
+    PROF_RENDER,
+    //! Drawing of the terrain
+    PROF_DRAW_TERRAIN,
+    //! Drawing of the shadows
+    PROF_DRAW_SHADOWS,
+    //! Drawing of the objects
+    PROF_DRAW_OBJECTS,
+    //! Drawing of the transparent objects
+    PROF_DRAW_TRANSPARENT,
+    //! Drawing of water, particles and lightning
+    PROF_DRAW_PARTICLES,
+    //! Drawing of the interface
+    PROF_DRAW_INTERFACE,
+    //! Update of the terrain height field, wherever it happens in the frame
+    PROF_TERRAIN,
+
+    //! Number of sections
+    PROF_MAX
+};
+
+
+/**
+ * \class CProfiler
+ * \brief Measures the time spent in each part of the frame
+ *
+ * Code is timed in sections, usually with CProfilerScope. A section may be
+ * entered several times per frame (e.g. physics of each object); the times
+ * are added up. Entering a section again while it is running (recursion)
+ * is counted only once.
+ *
+ * EndFrame() stores the times of the frame in a history of PROFILER_HISTORY
+ * frames. Averages and maximums are given over the last PROFILER_AVERAGE
+ * frames, for the stats overlay of CEngine; the whole history can be written
+ * to a CSV or JSON file.
+ *
+ * The profiler is meant for the main thread only.
+ */
+class CProfiler : public CSingleton<CProfiler>
+{
+public:
+    CProfiler();
+    ~CProfiler();
+
+    //! Starts timing of a section
+    void        StartSection(ProfilerSection section);
+    //! Stops timing of a section
+    void        StopSection(ProfilerSection section);
+
+    //! Ends the current frame and stores its times in the history
+    void        EndFrame();
+
+    //! Returns the average time of a section in last frames (in ms)
+    float       GetAverageTime(ProfilerSection section);
+    //! Returns the maximum time of a section in last frames (in ms)
+    float       GetMaxTime(ProfilerSection section);
+    //! Returns the time of a section in the last ended frame (in ms)
+    float       GetLastTime(ProfilerSection section);
+
+    //! Returns the name of a section
+    static const char* GetSectionName(ProfilerSection section);
+    //! Returns the depth of a section in the frame (0 for the whole frame)
+    static int  GetSectionLevel(ProfilerSection section);
+
+    //! Writes the history to a CSV file, one line per frame, times in ms
+    bool        WriteCSV(const std::string& fileName);
+    //! Writes the averages, maximums and history to a JSON file, times in ms
+    bool        WriteJSON(const std::string& fileName);
+    //! Writes the history to a file, as JSON if the name ends with ".json", else as CSV
+    bool        Write(const std::string& fileName);
+
+protected:
+    //! Returns the index in m_history of the frame \a age frames ago (0 is the last one)
+    int         GetHistoryIndex(int age);
+
+protected:
+    //! Start of each running section
+    SystemTimeStamp* m_start[PROF_MAX];
+    //! Number of times each section was entered and not left
+    int         m_depth[PROF_MAX];
+    //! Time spent in each section in the current frame (in ns)
+    long long   m_frameTime[PROF_MAX];
+    //! Current time, used when stopping a section
+    SystemTimeStamp* m_now;
+
+    //! Times of the last frames (in ns), PROF_MAX values per frame
+    std::vector<long long> m_history;
+    //! Index in m_history of the next frame
+    int         m_historyPos;
+    //! Number of frames in m_history
+    int         m_historyCount;
+    //! Sum of the times of the last PROFILER_AVERAGE frames
+    long long   m_averageSum[PROF_MAX];
+    //! Number of frames ended
+    long long   m_frameCount;
+};
+
+
+/**
+ * \class CProfilerScope
+ * \brief Times a section of the profiler until the end of the scope
+ *
+ * Does nothing if the profiler does not exist.
+ */
+class CProfilerScope
+{
+public:
+    CProfilerScope(ProfilerSection section);
+    ~CProfilerScope();
+
+protected:
+    CProfiler*      m_profiler;
+    ProfilerSection m_section;
+};
@@ -26,6 +26,8 @@
 #include <SDL/SDL_image.h>
 #include <png.h>
 
+#include <algorithm>
+
 
 /* <---------------------------------------------------------------> */
 
@@ -340,6 +342,12 @@ bool CImage::Load(const std::string& fileName)
     return true;
 }
 
+void CImage::Swap(CImage &other)
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_error, other.m_error);
+}
+
 bool CImage::SavePNG(const std::string& fileName)
 {
     if (IsEmpty())
@@ -100,6 +100,9 @@ public:
     //! Returns the last error
     std::string GetError();
 
+    //! Exchanges the data and error of two images
+    void Swap(CImage &other);
+
 private:
     //! Last encountered error
     std::string m_error;
@@ -281,6 +281,8 @@ public:
     virtual Texture CreateTexture(CImage *image, const TextureCreateParams &params) = 0;
     //! Creates a texture from raw image data; image data can be freed after that
     virtual Texture CreateTexture(ImageData *data, const TextureCreateParams &params) = 0;
+    //! Replaces a rectangle of a texture, starting at \a offset, with raw image data in given format
+    virtual void UpdateTexture(const Texture &texture, Math::IntPoint offset, ImageData *data, TexImgFormat format) = 0;
     //! Deletes a given texture, freeing it from video memory
     virtual void DestroyTexture(const Texture &texture) = 0;
     //! Deletes all textures created so far
@@ -315,6 +317,31 @@ public:
                                Color color = Color(1.0f, 1.0f, 1.0f, 1.0f)) = 0;
     //! Renders primitive composed of vertices with color information
     virtual void DrawPrimitive(PrimitiveType type, const VertexCol *vertices , int vertexCount) = 0;
+    //! Renders primitive composed of vertices with single texture and color information
+    virtual void DrawPrimitive(PrimitiveType type, const VertexTexCol *vertices, int vertexCount) = 0;
+
+    //! Creates a static buffer composed of given primitives with single texture vertices
+    /** Static buffers keep their vertex data in video memory (if possible), so that geometry
+        which does not change from frame to frame is not sent to the driver every time.
+        Returns the ID of created buffer or 0 on failure. */
+    virtual unsigned int CreateStaticBuffer(PrimitiveType primitiveType, const Vertex* vertices, int vertexCount) = 0;
+    //! Creates a static buffer composed of given primitives with multitexturing (2 textures)
+    virtual unsigned int CreateStaticBuffer(PrimitiveType primitiveType, const VertexTex2* vertices, int vertexCount) = 0;
+    //! Creates a static buffer composed of given primitives with color information
+    virtual unsigned int CreateStaticBuffer(PrimitiveType primitiveType, const VertexCol* vertices, int vertexCount) = 0;
+
+    //! Updates the static buffer composed of given primitives with single texture vertices
+    virtual void UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const Vertex* vertices, int vertexCount) = 0;
+    //! Updates the static buffer composed of given primitives with multitexturing (2 textures)
+    virtual void UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const VertexTex2* vertices, int vertexCount) = 0;
+    //! Updates the static buffer composed of given primitives with color information
+    virtual void UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const VertexCol* vertices, int vertexCount) = 0;
+
+    //! Draws a static buffer
+    virtual void DrawStaticBuffer(unsigned int bufferId) = 0;
+
+    //! Deletes a static buffer
+    virtual void DestroyStaticBuffer(unsigned int bufferId) = 0;
 
     //! Tests whether a sphere intersects the 6 clipping planes of projection volume
     virtual int ComputeSphereVisibility(const Math::Vector &center, float radius) = 0;
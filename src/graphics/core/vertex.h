@@ -105,6 +105,43 @@ struct VertexCol
 };
 
 
+/**
+ * \struct VertexTexCol
+ * \brief Textured vertex with color
+ *
+ * It contains:
+ *  - vertex coordinates (x,y,z) as Math::Vector,
+ *  - RGBA color as Color,
+ *  - texture coordinates (u,v) as Math::Point.
+ *
+ * Lets many primitives of different colors be drawn in one call (e.g. batches of particles).
+ *
+ * Additional padding is provided to align to even multiplies of 4 floats for faster access.
+ */
+struct VertexTexCol
+{
+    Math::Vector coord;
+    float pad;
+    Color color;
+    Math::Point texCoord;
+
+    explicit VertexTexCol(Math::Vector aCoord = Math::Vector(),
+                          Color aColor = Color(),
+                          Math::Point aTexCoord = Math::Point())
+        : coord(aCoord), pad(0.0f), color(aColor), texCoord(aTexCoord) {}
+
+    //! Returns a string "(c: [...], col: [...], tc: [...])"
+    inline std::string ToString() const
+    {
+        std::stringstream s;
+        s.precision(3);
+        s << "(c: " << coord.ToString() << ", col: " << color.ToString()
+          << ", tc: " << texCoord.ToString() << ")";
+        return s.str();
+    }
+};
+
+
 /**
  * \struct VertexTex2
  * \brief Vertex with secondary texture coordinates
@@ -19,6 +19,7 @@
 #include "graphics/engine/engine.h"
 
 #include "app/app.h"
+#include "app/profiler.h"
 
 #include "common/iman.h"
 #include "common/image.h"
@@ -28,8 +29,10 @@
 #include "graphics/core/device.h"
 #include "graphics/engine/camera.h"
 #include "graphics/engine/cloud.h"
+#include "graphics/engine/imageloader.h"
 #include "graphics/engine/lightman.h"
 #include "graphics/engine/lightning.h"
+#include "graphics/engine/modelmanager.h"
 #include "graphics/engine/particle.h"
 #include "graphics/engine/planet.h"
 #include "graphics/engine/pyro.h"
@@ -39,10 +42,14 @@
 
 #include "math/geometry.h"
 
+#include "object/objectgrid.h"
+
 #include "sound/sound.h"
 
 #include "ui/interface.h"
 
+#include <algorithm>
+
 
 // Graphics module namespace
 namespace Gfx {
@@ -59,6 +66,20 @@ const int LEVEL3_PREALLOCATE_COUNT        = 5;
 const int LEVEL4_PREALLOCATE_COUNT        = 100;
 const int LEVEL4_VERTEX_PREALLOCATE_COUNT = 200;
 
+// Size of the culling grid cell and number of cells along one side
+const float CULL_CELL_SIZE = 100.0f;
+const int   CULL_GRID_SIZE = 40;
+
+// Textures packed into the interface atlas
+const int INTERFACE_ATLAS_COUNT = 4;
+static const char* INTERFACE_ATLAS_TEXTURES[INTERFACE_ATLAS_COUNT] =
+{
+    "button1.png",
+    "button2.png",
+    "button3.png",
+    "text.png"
+};
+
 
 EngineObjLevel1::EngineObjLevel1(bool used, const std::string& tex1Name, const std::string& tex2Name)
 {
@@ -92,10 +113,50 @@ EngineObjLevel4::EngineObjLevel4(bool used, EngineTriangleType type, const Mater
     this->type = type;
     this->material = material;
     this->state = state;
+    this->staticBufferId = 0;
+    this->updateStaticBuffer = false;
+    this->meshRank = -1;
 
     vertices.reserve(LEVEL4_VERTEX_PREALLOCATE_COUNT);
 }
 
+//! Arbitrary but consistent ordering of colors, used to group equal materials
+bool ColorLess(const Color& a, const Color& b)
+{
+    if (a.r != b.r) return a.r < b.r;
+    if (a.g != b.g) return a.g < b.g;
+    if (a.b != b.b) return a.b < b.b;
+    return a.a < b.a;
+}
+
+//! Arbitrary but consistent ordering of materials, used to group equal materials
+bool MaterialLess(const Material& a, const Material& b)
+{
+    if (a.diffuse != b.diffuse) return ColorLess(a.diffuse, b.diffuse);
+    if (a.ambient != b.ambient) return ColorLess(a.ambient, b.ambient);
+    return ColorLess(a.specular, b.specular);
+}
+
+bool EngineRenderBatch::operator<(const EngineRenderBatch& other) const
+{
+    if (objType != other.objType)
+        return objType < other.objType;
+
+    if (texRank != other.texRank)
+        return texRank < other.texRank;
+
+    if (state != other.state)
+        return state < other.state;
+
+    if (*material != *other.material)
+        return MaterialLess(*material, *other.material);
+
+    if (objRank != other.objRank)
+        return objRank < other.objRank;
+
+    return p4 < other.p4;
+}
+
 CEngine::CEngine(CInstanceManager *iMan, CApplication *app)
 {
     m_iMan   = iMan;
@@ -115,6 +176,9 @@ CEngine::CEngine(CInstanceManager *iMan, CApplication *app)
     m_planet     = nullptr;
     m_sound      = nullptr;
     m_terrain    = nullptr;
+    m_modelManager = nullptr;
+    m_imageLoader = nullptr;
+    m_interfaceAtlasDone = false;
 
     m_showStats = false;
 
@@ -182,6 +246,13 @@ CEngine::CEngine(CInstanceManager *iMan, CApplication *app)
     m_alphaMode = 1;
 
     m_updateGeometry = false;
+    m_updateStaticBuffers = false;
+
+    m_statisticTriangle = 0;
+    m_statisticStateChange = 0;
+    m_statisticDrawCall = 0;
+
+    m_cullCells.resize(CULL_GRID_SIZE*CULL_GRID_SIZE);
 
     m_interfaceMode = false;
 
@@ -270,6 +341,8 @@ bool CEngine::Create()
     m_cloud      = new CCloud(m_iMan, this);
     m_lightning  = new CLightning(m_iMan, this);
     m_planet     = new CPlanet(m_iMan, this);
+    m_modelManager = new CModelManager(m_iMan, this);
+    m_imageLoader = new CImageLoader();
 
     m_lightMan->SetDevice(m_device);
     m_particle->SetDevice(m_device);
@@ -310,6 +383,8 @@ void CEngine::Destroy()
 {
     m_text->Destroy();
 
+    m_interfaceAtlas.Destroy(m_device);
+
     delete m_lightMan;
     m_lightMan = nullptr;
 
@@ -330,12 +405,50 @@ void CEngine::Destroy()
 
     delete m_planet;
     m_planet = nullptr;
+
+    delete m_modelManager;
+    m_modelManager = nullptr;
+
+    delete m_imageLoader;
+    m_imageLoader = nullptr;
+
+    for (int i = 0; i < static_cast<int>( m_meshes.size() ); i++)
+    {
+        if (m_meshes[i].staticBufferId != 0)
+            m_device->DestroyStaticBuffer(m_meshes[i].staticBufferId);
+    }
+    m_meshes.clear();
 }
 
 void CEngine::ResetAfterDeviceChanged()
 {
     m_text->FlushCache();
 
+    // Static buffers were released together with the old device state, so recreate them all
+    for (int l1 = 0; l1 < static_cast<int>( m_objectTree.size() ); l1++)
+    {
+        EngineObjLevel1& p1 = m_objectTree[l1];
+        for (int l2 = 0; l2 < static_cast<int>( p1.next.size() ); l2++)
+        {
+            EngineObjLevel2& p2 = p1.next[l2];
+            for (int l3 = 0; l3 < static_cast<int>( p2.next.size() ); l3++)
+            {
+                EngineObjLevel3& p3 = p2.next[l3];
+                for (int l4 = 0; l4 < static_cast<int>( p3.next.size() ); l4++)
+                {
+                    p3.next[l4].staticBufferId = 0;
+                    p3.next[l4].updateStaticBuffer = p3.next[l4].meshRank == -1;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < static_cast<int>( m_meshes.size() ); i++)
+    {
+        m_meshes[i].staticBufferId = 0;
+        m_meshes[i].updateStaticBuffer = true;
+    }
+    m_updateStaticBuffers = true;
+
     // TODO reload textures, reset device state, etc.
 }
 
@@ -513,6 +626,16 @@ int CEngine::GetStatisticTriangle()
     return m_statisticTriangle;
 }
 
+int CEngine::GetStatisticStateChange()
+{
+    return m_statisticStateChange;
+}
+
+int CEngine::GetStatisticDrawCall()
+{
+    return m_statisticDrawCall;
+}
+
 
 
 /*******************************************************
@@ -554,9 +677,22 @@ int CEngine::CreateObject()
 
 void CEngine::FlushObject()
 {
+    for (int l1 = 0; l1 < static_cast<int>( m_objectTree.size() ); l1++)
+    {
+        EngineObjLevel1& p1 = m_objectTree[l1];
+        for (int l2 = 0; l2 < static_cast<int>( p1.next.size() ); l2++)
+            DeleteStaticBuffers(p1.next[l2]);
+    }
+
     m_objectTree.clear();
     m_objects.clear();
 
+    for (int i = 0; i < static_cast<int>( m_cullCells.size() ); i++)
+    {
+        m_cullCells[i].objRanks.clear();
+        m_cullCells[i].dirty = false;
+    }
+
     m_shadows.clear();
 
     FlushGroundSpot();
@@ -580,12 +716,15 @@ bool CEngine::DeleteObject(int objRank)
 
             if (p2.objRank == objRank)
             {
+                DeleteStaticBuffers(p2);
                 p2.used = false;
                 p2.next.clear();
             }
         }
     }
 
+    RemoveObjectCullCell(objRank);
+
     // Mark object as deleted
     m_objects[objRank].used = false;
 
@@ -619,6 +758,7 @@ bool CEngine::SetObjectTransform(int objRank, const Math::Matrix& transform)
         return false;
 
     m_objects[objRank].transform = transform;
+    UpdateObjectBounds(objRank);
     return true;
 }
 
@@ -831,8 +971,12 @@ bool CEngine::AddTriangles(int objRank, const std::vector<VertexTex2>& vertices,
     EngineObjLevel3& p3 = AddLevel3(p2, min, max);
     EngineObjLevel4& p4 = AddLevel4(p3, ENG_TRIANGLE_TYPE_TRIANGLES, material, state);
 
+    UnshareMesh(p4);
     p4.vertices.insert(p4.vertices.end(), vertices.begin(), vertices.end());
 
+    p4.updateStaticBuffer = true;
+    m_updateStaticBuffers = true;
+
     if (globalUpdate)
     {
         m_updateGeometry = true;
@@ -878,8 +1022,12 @@ bool CEngine::AddSurface(int objRank, const std::vector<VertexTex2>& vertices,
     EngineObjLevel3& p3 = AddLevel3(p2, min, max);
     EngineObjLevel4& p4 = AddLevel4(p3, ENG_TRIANGLE_TYPE_SURFACE, material, state);
 
+    UnshareMesh(p4);
     p4.vertices.insert(p4.vertices.end(), vertices.begin(), vertices.end());
 
+    p4.updateStaticBuffer = true;
+    m_updateStaticBuffers = true;
+
     if (globalUpdate)
     {
         m_updateGeometry = true;
@@ -922,6 +1070,11 @@ bool CEngine::AddQuick(int objRank, const EngineObjLevel4& buffer,
     p3.next.push_back(buffer);
     p3.next.back().used = true; // ensure that it is used
 
+    // The copy gets its own static buffer
+    p3.next.back().staticBufferId = 0;
+    p3.next.back().updateStaticBuffer = true;
+    m_updateStaticBuffers = true;
+
     if (globalUpdate)
     {
         m_updateGeometry = true;
@@ -950,6 +1103,99 @@ bool CEngine::AddQuick(int objRank, const EngineObjLevel4& buffer,
     return true;
 }
 
+int CEngine::CreateMesh(EngineTriangleType type, const std::vector<VertexTex2>& vertices)
+{
+    m_meshes.push_back(EngineMesh());
+
+    EngineMesh& mesh = m_meshes.back();
+    mesh.type = type;
+    mesh.vertices = vertices;
+    mesh.updateStaticBuffer = true;
+    m_updateStaticBuffers = true;
+
+    for (int i = 0; i < static_cast<int>( vertices.size() ); i++)
+    {
+        mesh.bboxMin.x = Math::Min(vertices[i].coord.x, mesh.bboxMin.x);
+        mesh.bboxMin.y = Math::Min(vertices[i].coord.y, mesh.bboxMin.y);
+        mesh.bboxMin.z = Math::Min(vertices[i].coord.z, mesh.bboxMin.z);
+        mesh.bboxMax.x = Math::Max(vertices[i].coord.x, mesh.bboxMax.x);
+        mesh.bboxMax.y = Math::Max(vertices[i].coord.y, mesh.bboxMax.y);
+        mesh.bboxMax.z = Math::Max(vertices[i].coord.z, mesh.bboxMax.z);
+    }
+
+    return static_cast<int>( m_meshes.size() ) - 1;
+}
+
+bool CEngine::AddMeshReference(int objRank, int meshRank,
+                                    const Material& material, int state,
+                                    std::string tex1Name, std::string tex2Name,
+                                    float min, float max)
+{
+    if ( objRank < 0 || objRank >= static_cast<int>( m_objects.size() ) )
+    {
+        GetLogger()->Error("AddMeshReference(): invalid object rank %d\n", objRank);
+        return false;
+    }
+
+    if ( meshRank < 0 || meshRank >= static_cast<int>( m_meshes.size() ) )
+    {
+        GetLogger()->Error("AddMeshReference(): invalid mesh rank %d\n", meshRank);
+        return false;
+    }
+
+    m_lastSize = m_size;
+    m_lastObjectDetail = m_objectDetail;
+    m_lastClippingDistance = m_clippingDistance;
+
+    const EngineMesh& mesh = m_meshes[meshRank];
+
+    EngineObjLevel1& p1 = AddLevel1(tex1Name, tex2Name);
+    EngineObjLevel2& p2 = AddLevel2(p1, objRank);
+    EngineObjLevel3& p3 = AddLevel3(p2, min, max);
+
+    // Always a new tier 4 object: it holds no vertices, only the reference
+    p3.next.push_back(EngineObjLevel4(true, mesh.type, material, state));
+    p3.next.back().vertices.shrink_to_fit();
+    p3.next.back().meshRank = meshRank;
+
+    m_objects[objRank].bboxMin.x = Math::Min(mesh.bboxMin.x, m_objects[objRank].bboxMin.x);
+    m_objects[objRank].bboxMin.y = Math::Min(mesh.bboxMin.y, m_objects[objRank].bboxMin.y);
+    m_objects[objRank].bboxMin.z = Math::Min(mesh.bboxMin.z, m_objects[objRank].bboxMin.z);
+    m_objects[objRank].bboxMax.x = Math::Max(mesh.bboxMax.x, m_objects[objRank].bboxMax.x);
+    m_objects[objRank].bboxMax.y = Math::Max(mesh.bboxMax.y, m_objects[objRank].bboxMax.y);
+    m_objects[objRank].bboxMax.z = Math::Max(mesh.bboxMax.z, m_objects[objRank].bboxMax.z);
+
+    m_objects[objRank].radius = Math::Max(m_objects[objRank].bboxMin.Length(),
+                                          m_objects[objRank].bboxMax.Length());
+
+    if (mesh.type == ENG_TRIANGLE_TYPE_TRIANGLES)
+        m_objects[objRank].totalTriangles += mesh.vertices.size() / 3;
+    else if (mesh.type == ENG_TRIANGLE_TYPE_SURFACE)
+        m_objects[objRank].totalTriangles += mesh.vertices.size() - 2;
+
+    return true;
+}
+
+const std::vector<VertexTex2>& CEngine::GetVertices(const EngineObjLevel4& p4)
+{
+    if (p4.meshRank != -1)
+        return m_meshes[p4.meshRank].vertices;
+
+    return p4.vertices;
+}
+
+void CEngine::UnshareMesh(EngineObjLevel4& p4)
+{
+    if (p4.meshRank == -1)
+        return;
+
+    p4.vertices = m_meshes[p4.meshRank].vertices;
+    p4.meshRank = -1;
+    p4.staticBufferId = 0;
+    p4.updateStaticBuffer = true;
+    m_updateStaticBuffers = true;
+}
+
 EngineObjLevel4* CEngine::FindTriangles(int objRank, const Material& material,
                                                   int state, std::string tex1Name,
                                                   std::string tex2Name, float min, float max)
@@ -1039,9 +1285,11 @@ int CEngine::GetPartialTriangles(int objRank, float min, float max, float percen
                     EngineObjLevel4& p4 = p3.next[l4];
                     if (! p4.used) continue;
 
+                    const std::vector<VertexTex2>& vertices = GetVertices(p4);
+
                     if (p4.type == ENG_TRIANGLE_TYPE_TRIANGLES)
                     {
-                        for (int i = 0; i < static_cast<int>( p4.vertices.size() ); i += 3)
+                        for (int i = 0; i < static_cast<int>( vertices.size() ); i += 3)
                         {
                             if (static_cast<float>(actualCount) / total >= percent)
                                 break;
@@ -1050,9 +1298,9 @@ int CEngine::GetPartialTriangles(int objRank, float min, float max, float percen
                                 break;
 
                             EngineTriangle t;
-                            t.triangle[0] = p4.vertices[i];
-                            t.triangle[1] = p4.vertices[i+1];
-                            t.triangle[2] = p4.vertices[i+2];
+                            t.triangle[0] = vertices[i];
+                            t.triangle[1] = vertices[i+1];
+                            t.triangle[2] = vertices[i+2];
                             t.material = p4.material;
                             t.state = p4.state;
                             t.tex1Name = p1.tex1Name;
@@ -1065,7 +1313,7 @@ int CEngine::GetPartialTriangles(int objRank, float min, float max, float percen
                     }
                     else if (p4.type == ENG_TRIANGLE_TYPE_SURFACE)
                     {
-                        for (int i = 0; i < static_cast<int>( p4.vertices.size() ); i += 1)
+                        for (int i = 0; i < static_cast<int>( vertices.size() ); i += 1)
                         {
                             if (static_cast<float>(actualCount) / total >= percent)
                                 break;
@@ -1074,9 +1322,9 @@ int CEngine::GetPartialTriangles(int objRank, float min, float max, float percen
                                 break;
 
                             EngineTriangle t;
-                            t.triangle[0] = p4.vertices[i];
-                            t.triangle[1] = p4.vertices[i+1];
-                            t.triangle[2] = p4.vertices[i+2];
+                            t.triangle[0] = vertices[i];
+                            t.triangle[1] = vertices[i+1];
+                            t.triangle[2] = vertices[i+2];
                             t.material = p4.material;
                             t.state = p4.state;
                             t.tex1Name = p1.tex1Name;
@@ -1195,6 +1443,8 @@ bool CEngine::ChangeTextureMapping(int objRank, const Material& mat, int state,
     if (p4 == nullptr)
         return false;
 
+    UnshareMesh(*p4);
+
     int nb = p4->vertices.size();
 
     if (mode == ENG_TEX_MAPPING_X)
@@ -1243,6 +1493,9 @@ bool CEngine::ChangeTextureMapping(int objRank, const Material& mat, int state,
         }
     }
 
+    p4->updateStaticBuffer = true;
+    m_updateStaticBuffers = true;
+
     return true;
 }
 
@@ -1627,15 +1880,16 @@ void CEngine::UpdateGeometry()
                     if (! p4.used) continue;
 
                     int objRank = p2.objRank;
+                    const std::vector<VertexTex2>& vertices = GetVertices(p4);
 
-                    for (int i = 0; i < static_cast<int>( p4.vertices.size() ); i++)
+                    for (int i = 0; i < static_cast<int>( vertices.size() ); i++)
                     {
-                            m_objects[objRank].bboxMin.x = Math::Min(p4.vertices[i].coord.x, m_objects[objRank].bboxMin.x);
-                            m_objects[objRank].bboxMin.y = Math::Min(p4.vertices[i].coord.y, m_objects[objRank].bboxMin.y);
-                            m_objects[objRank].bboxMin.z = Math::Min(p4.vertices[i].coord.z, m_objects[objRank].bboxMin.z);
-                            m_objects[objRank].bboxMax.x = Math::Max(p4.vertices[i].coord.x, m_objects[objRank].bboxMax.x);
-                            m_objects[objRank].bboxMax.y = Math::Max(p4.vertices[i].coord.y, m_objects[objRank].bboxMax.y);
-                            m_objects[objRank].bboxMax.z = Math::Max(p4.vertices[i].coord.z, m_objects[objRank].bboxMax.z);
+                            m_objects[objRank].bboxMin.x = Math::Min(vertices[i].coord.x, m_objects[objRank].bboxMin.x);
+                            m_objects[objRank].bboxMin.y = Math::Min(vertices[i].coord.y, m_objects[objRank].bboxMin.y);
+                            m_objects[objRank].bboxMin.z = Math::Min(vertices[i].coord.z, m_objects[objRank].bboxMin.z);
+                            m_objects[objRank].bboxMax.x = Math::Max(vertices[i].coord.x, m_objects[objRank].bboxMax.x);
+                            m_objects[objRank].bboxMax.y = Math::Max(vertices[i].coord.y, m_objects[objRank].bboxMax.y);
+                            m_objects[objRank].bboxMax.z = Math::Max(vertices[i].coord.z, m_objects[objRank].bboxMax.z);
                     }
 
                     m_objects[objRank].radius = Math::Max(m_objects[objRank].bboxMin.Length(),
@@ -1645,9 +1899,114 @@ void CEngine::UpdateGeometry()
         }
     }
 
+    for (int i = 0; i < static_cast<int>( m_objects.size() ); i++)
+    {
+        if (m_objects[i].used)
+            UpdateObjectBounds(i);
+    }
+
     m_updateGeometry = false;
 }
 
+void CEngine::UpdateStaticBuffer(EngineObjLevel4& p4)
+{
+    p4.updateStaticBuffer = false;
+
+    // Shared meshes have their own buffers
+    if (p4.meshRank != -1)
+        return;
+
+    UpdateStaticBuffer(p4.staticBufferId, p4.type, p4.vertices);
+}
+
+void CEngine::UpdateStaticBuffer(unsigned int& staticBufferId, EngineTriangleType type,
+                                 const std::vector<VertexTex2>& vertices)
+{
+    if (vertices.empty())
+    {
+        if (staticBufferId != 0)
+        {
+            m_device->DestroyStaticBuffer(staticBufferId);
+            staticBufferId = 0;
+        }
+        return;
+    }
+
+    PrimitiveType primitiveType;
+    if (type == ENG_TRIANGLE_TYPE_TRIANGLES)
+        primitiveType = PRIMITIVE_TRIANGLES;
+    else
+        primitiveType = PRIMITIVE_TRIANGLE_STRIP;
+
+    if (staticBufferId == 0)
+        staticBufferId = m_device->CreateStaticBuffer(primitiveType, &vertices[0], vertices.size());
+    else
+        m_device->UpdateStaticBuffer(staticBufferId, primitiveType, &vertices[0], vertices.size());
+}
+
+void CEngine::UpdateStaticBuffers()
+{
+    if (! m_updateStaticBuffers)
+        return;
+
+    for (int l1 = 0; l1 < static_cast<int>( m_objectTree.size() ); l1++)
+    {
+        EngineObjLevel1& p1 = m_objectTree[l1];
+        if (! p1.used) continue;
+
+        for (int l2 = 0; l2 < static_cast<int>( p1.next.size() ); l2++)
+        {
+            EngineObjLevel2& p2 = p1.next[l2];
+            if (! p2.used) continue;
+
+            for (int l3 = 0; l3 < static_cast<int>( p2.next.size() ); l3++)
+            {
+                EngineObjLevel3& p3 = p2.next[l3];
+                if (! p3.used) continue;
+
+                for (int l4 = 0; l4 < static_cast<int>( p3.next.size() ); l4++)
+                {
+                    EngineObjLevel4& p4 = p3.next[l4];
+                    if (! p4.used) continue;
+
+                    if (p4.updateStaticBuffer)
+                        UpdateStaticBuffer(p4);
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < static_cast<int>( m_meshes.size() ); i++)
+    {
+        if (m_meshes[i].updateStaticBuffer)
+        {
+            m_meshes[i].updateStaticBuffer = false;
+            UpdateStaticBuffer(m_meshes[i].staticBufferId, m_meshes[i].type, m_meshes[i].vertices);
+        }
+    }
+
+    m_updateStaticBuffers = false;
+}
+
+void CEngine::DeleteStaticBuffers(EngineObjLevel2& p2)
+{
+    for (int l3 = 0; l3 < static_cast<int>( p2.next.size() ); l3++)
+    {
+        EngineObjLevel3& p3 = p2.next[l3];
+
+        for (int l4 = 0; l4 < static_cast<int>( p3.next.size() ); l4++)
+        {
+            EngineObjLevel4& p4 = p3.next[l4];
+
+            if (p4.staticBufferId != 0)
+            {
+                m_device->DestroyStaticBuffer(p4.staticBufferId);
+                p4.staticBufferId = 0;
+            }
+        }
+    }
+}
+
 void CEngine::Update()
 {
     ComputeDistance();
@@ -1720,12 +2079,14 @@ int CEngine::DetectObject(Math::Point mouse)
                     EngineObjLevel4& p4 = p3.next[l4];
                     if (! p4.used) continue;
 
+                    const std::vector<VertexTex2>& vertices = GetVertices(p4);
+
                     if (p4.type == ENG_TRIANGLE_TYPE_TRIANGLES)
                     {
-                        for (int i = 0; i < static_cast<int>( p4.vertices.size() ); i += 3)
+                        for (int i = 0; i < static_cast<int>( vertices.size() ); i += 3)
                         {
                             float dist = 0.0f;
-                            if (DetectTriangle(mouse, &p4.vertices[i], p2.objRank, dist) && dist < min)
+                            if (DetectTriangle(mouse, &vertices[i], p2.objRank, dist) && dist < min)
                             {
                                 min = dist;
                                 nearest = p2.objRank;
@@ -1734,10 +2095,10 @@ int CEngine::DetectObject(Math::Point mouse)
                     }
                     else if (p4.type == ENG_TRIANGLE_TYPE_SURFACE)
                     {
-                        for (int i = 0; i < static_cast<int>( p4.vertices.size() ) - 2; i += 1)
+                        for (int i = 0; i < static_cast<int>( vertices.size() ) - 2; i += 1)
                         {
                             float dist = 0.0f;
-                            if (DetectTriangle(mouse, &p4.vertices[i], p2.objRank, dist) && dist < min)
+                            if (DetectTriangle(mouse, &vertices[i], p2.objRank, dist) && dist < min)
                             {
                                 min = dist;
                                 nearest = p2.objRank;
@@ -1752,7 +2113,7 @@ int CEngine::DetectObject(Math::Point mouse)
     return nearest;
 }
 
-bool CEngine::DetectTriangle(Math::Point mouse, VertexTex2* triangle, int objRank, float& dist)
+bool CEngine::DetectTriangle(Math::Point mouse, const VertexTex2* triangle, int objRank, float& dist)
 {
     Math::Vector p2D[3], p3D;
 
@@ -1796,10 +2157,192 @@ bool CEngine::DetectTriangle(Math::Point mouse, VertexTex2* triangle, int objRan
 
 bool CEngine::IsVisible(int objRank)
 {
-    // TODO: use ComputeSphereVisiblity() after tested OK
+    if ( objRank < 0 || objRank >= static_cast<int>( m_objects.size() ) )
+        return false;
+
+    return ! m_objects[objRank].culled;
+}
+
+void CEngine::UpdateObjectBounds(int objRank)
+{
+    EngineObject& obj = m_objects[objRank];
+
+    Math::Vector center = (obj.bboxMin + obj.bboxMax) * 0.5f;
+    float radius = (obj.bboxMax - obj.bboxMin).Length() * 0.5f;
+
+    // Objects may be scaled, so take the largest axis of the transform
+    const Math::Matrix& m = obj.transform;
+    float scale = Math::Max(Math::Vector(m.m[0], m.m[1], m.m[2]).Length(),
+                            Math::Vector(m.m[4], m.m[5], m.m[6]).Length(),
+                            Math::Vector(m.m[8], m.m[9], m.m[10]).Length());
+
+    obj.worldCenter = Math::Transform(m, center);
+    obj.worldRadius = radius * scale;
+
+    float half = CULL_CELL_SIZE * CULL_GRID_SIZE / 2.0f;
+    float last = static_cast<float>(CULL_GRID_SIZE - 1);
+    int x = static_cast<int>(Math::Max(0.0f, Math::Min(last, (obj.worldCenter.x + half) / CULL_CELL_SIZE)));
+    int z = static_cast<int>(Math::Max(0.0f, Math::Min(last, (obj.worldCenter.z + half) / CULL_CELL_SIZE)));
+    int cell = x + z * CULL_GRID_SIZE;
+
+    if (cell != obj.cullCell)
+    {
+        RemoveObjectCullCell(objRank);
+        m_cullCells[cell].objRanks.push_back(objRank);
+        obj.cullCell = cell;
+    }
+
+    m_cullCells[cell].dirty = true;
+}
+
+void CEngine::RemoveObjectCullCell(int objRank)
+{
+    int cell = m_objects[objRank].cullCell;
+    if (cell == -1)
+        return;
+
+    std::vector<int>& ranks = m_cullCells[cell].objRanks;
+    for (int i = 0; i < static_cast<int>( ranks.size() ); i++)
+    {
+        if (ranks[i] == objRank)
+        {
+            ranks[i] = ranks.back();
+            ranks.pop_back();
+            break;
+        }
+    }
+
+    m_cullCells[cell].dirty = true;
+    m_objects[objRank].cullCell = -1;
+}
+
+void CEngine::UpdateCullCellBounds(EngineCullCell& cell)
+{
+    cell.dirty = false;
+
+    for (int i = 0; i < static_cast<int>( cell.objRanks.size() ); i++)
+    {
+        const EngineObject& obj = m_objects[cell.objRanks[i]];
+        Math::Vector extent(obj.worldRadius, obj.worldRadius, obj.worldRadius);
+
+        if (i == 0)
+        {
+            cell.bboxMin = obj.worldCenter - extent;
+            cell.bboxMax = obj.worldCenter + extent;
+            continue;
+        }
+
+        cell.bboxMin.x = Math::Min(cell.bboxMin.x, obj.worldCenter.x - extent.x);
+        cell.bboxMin.y = Math::Min(cell.bboxMin.y, obj.worldCenter.y - extent.y);
+        cell.bboxMin.z = Math::Min(cell.bboxMin.z, obj.worldCenter.z - extent.z);
+        cell.bboxMax.x = Math::Max(cell.bboxMax.x, obj.worldCenter.x + extent.x);
+        cell.bboxMax.y = Math::Max(cell.bboxMax.y, obj.worldCenter.y + extent.y);
+        cell.bboxMax.z = Math::Max(cell.bboxMax.z, obj.worldCenter.z + extent.z);
+    }
+}
+
+void CEngine::ComputeFrustumPlanes()
+{
+    // The device flips the Z axis between view and projection (see CGLDevice)
+    Math::Matrix flip;
+    flip.LoadIdentity();
+    flip.Set(3, 3, -1.0f);
+
+    Math::Matrix m = Math::MultiplyMatrices(m_matProj, Math::MultiplyMatrices(flip, m_matView));
+
+    // Planes are sums and differences of the 4th row with the other rows:
+    // left, right, bottom, top, near and far
+    for (int i = 0; i < 6; i++)
+    {
+        int row = i / 2 + 1;
+        float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+
+        Math::Vector normal;
+        normal.x = m.Get(4, 1) + sign * m.Get(row, 1);
+        normal.y = m.Get(4, 2) + sign * m.Get(row, 2);
+        normal.z = m.Get(4, 3) + sign * m.Get(row, 3);
+        float dist = m.Get(4, 4) + sign * m.Get(row, 4);
+
+        float length = normal.Length();
+        if (length > 0.0f)
+        {
+            normal = normal * (1.0f / length);
+            dist /= length;
+        }
+
+        m_frustumNormal[i] = normal;
+        m_frustumDist[i] = dist;
+    }
+}
+
+bool CEngine::IsBoxInFrustum(const Math::Vector& min, const Math::Vector& max, bool& inside)
+{
+    inside = true;
+
+    for (int i = 0; i < 6; i++)
+    {
+        const Math::Vector& n = m_frustumNormal[i];
+
+        // Corners of the box farthest along and against the plane normal
+        Math::Vector pos(n.x >= 0.0f ? max.x : min.x,
+                         n.y >= 0.0f ? max.y : min.y,
+                         n.z >= 0.0f ? max.z : min.z);
+        Math::Vector neg(n.x >= 0.0f ? min.x : max.x,
+                         n.y >= 0.0f ? min.y : max.y,
+                         n.z >= 0.0f ? min.z : max.z);
+
+        if (Math::DotProduct(n, pos) + m_frustumDist[i] < 0.0f)
+            return false;
+
+        if (Math::DotProduct(n, neg) + m_frustumDist[i] < 0.0f)
+            inside = false;
+    }
+
+    return true;
+}
+
+bool CEngine::IsSphereInFrustum(const Math::Vector& center, float radius)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        if (Math::DotProduct(m_frustumNormal[i], center) + m_frustumDist[i] < -radius)
+            return false;
+    }
+
     return true;
 }
 
+void CEngine::UpdateVisibility()
+{
+    UpdateGeometry();
+    ComputeFrustumPlanes();
+
+    for (int c = 0; c < static_cast<int>( m_cullCells.size() ); c++)
+    {
+        EngineCullCell& cell = m_cullCells[c];
+        if (cell.objRanks.empty())
+            continue;
+
+        if (cell.dirty)
+            UpdateCullCellBounds(cell);
+
+        bool inside = false;
+        bool visible = IsBoxInFrustum(cell.bboxMin, cell.bboxMax, inside);
+
+        for (int i = 0; i < static_cast<int>( cell.objRanks.size() ); i++)
+        {
+            EngineObject& obj = m_objects[cell.objRanks[i]];
+
+            if (! visible)
+                obj.culled = true;
+            else if (inside)
+                obj.culled = false;
+            else
+                obj.culled = ! IsSphereInFrustum(obj.worldCenter, obj.worldRadius);
+        }
+    }
+}
+
 bool CEngine::TransformPoint(Math::Vector& p2D, int objRank, Math::Vector p3D)
 {
     p3D = Math::Transform(m_objects[objRank].transform, p3D);
@@ -1833,6 +2376,8 @@ void CEngine::SetState(int state, const Color& color)
     m_lastState = state;
     m_lastColor = color;
 
+    m_statisticStateChange++;
+
     if (m_alphaMode != 1 && (state & ENG_RSTATE_ALPHA))
     {
         state &= ~ENG_RSTATE_ALPHA;
@@ -1858,6 +2403,9 @@ void CEngine::SetState(int state, const Color& color)
         params.alphaOperation = TEX_MIX_OPER_DEFAULT; // TODO: replace with src color ?
         params.factor = color;
 
+        if (state & ENG_RSTATE_VERTEX_COLOR)
+            params.colorArg2 = TEX_MIX_ARG_SRC_COLOR;
+
         m_device->SetTextureEnabled(0, true);
         m_device->SetTextureStageParams(0, params);
     }
@@ -1877,6 +2425,10 @@ void CEngine::SetState(int state, const Color& color)
         params.alphaOperation = TEX_MIX_OPER_DEFAULT; // TODO: replace with src color ?
         params.factor = color.Inverse();
 
+        // Vertex colors are expected already inverted
+        if (state & ENG_RSTATE_VERTEX_COLOR)
+            params.colorArg2 = TEX_MIX_ARG_SRC_COLOR;
+
         m_device->SetTextureEnabled(0, true);
         m_device->SetTextureStageParams(0, params);
     }
@@ -2057,6 +2609,10 @@ void CEngine::SetState(int state, const Color& color)
 void CEngine::SetMaterial(const Material& mat)
 {
     m_lastMaterial = mat;
+
+    if (m_device->GetMaterial() != mat)
+        m_statisticStateChange++;
+
     m_device->SetMaterial(mat);
 }
 
@@ -2090,7 +2646,7 @@ Texture CEngine::CreateTexture(const std::string& texName, const TextureCreatePa
     if (image == nullptr)
     {
         CImage img;
-        if (! img.Load(m_app->GetDataFilePath(DIR_TEXTURE, texName)))
+        if (! m_imageLoader->LoadImage(m_app->GetDataFilePath(DIR_TEXTURE, texName), img))
         {
             std::string error = img.GetError();
             GetLogger()->Error("Couldn't load texture '%s': %s, blacklisting\n", texName.c_str(), error.c_str());
@@ -2142,8 +2698,44 @@ Texture CEngine::LoadTexture(const std::string& name, const TextureCreateParams&
     return tex;
 }
 
+void CEngine::PreloadTexture(const std::string& name)
+{
+    if (name.empty())
+        return;
+
+    if (m_texBlacklist.find(name) != m_texBlacklist.end())
+        return;
+
+    if (m_texNameMap.find(name) != m_texNameMap.end())
+        return;
+
+    m_imageLoader->Preload(m_app->GetDataFilePath(DIR_TEXTURE, name));
+}
+
 bool CEngine::LoadAllTextures()
 {
+    // Decode the images on worker threads; the textures are created below, in the same order
+    PreloadTexture("text.png");
+    PreloadTexture("mouse.png");
+    PreloadTexture("button1.png");
+    PreloadTexture("button2.png");
+    PreloadTexture("button3.png");
+    PreloadTexture("effect00.png");
+    PreloadTexture("effect01.png");
+    PreloadTexture("effect02.png");
+    PreloadTexture("map.png");
+    PreloadTexture(m_backgroundName);
+    PreloadTexture(m_foregroundName);
+
+    for (int l1 = 0; l1 < static_cast<int>( m_objectTree.size() ); l1++)
+    {
+        EngineObjLevel1& p1 = m_objectTree[l1];
+        if (! p1.used) continue;
+
+        PreloadTexture(p1.tex1Name);
+        PreloadTexture(p1.tex2Name);
+    }
+
     LoadTexture("text.png");
     m_miceTexture = LoadTexture("mouse.png");
     LoadTexture("button1.png");
@@ -2166,6 +2758,9 @@ bool CEngine::LoadAllTextures()
 
     m_planet->LoadTexture();
 
+    if (! m_interfaceAtlasDone)
+        CreateInterfaceAtlas();
+
     bool ok = true;
 
     for (int l1 = 0; l1 < static_cast<int>( m_objectTree.size() ); l1++)
@@ -2210,6 +2805,50 @@ bool CEngine::LoadAllTextures()
     return ok;
 }
 
+void CEngine::CreateInterfaceAtlas()
+{
+    m_interfaceAtlasDone = true;
+
+    std::vector<CImage*> images;
+
+    for (int i = 0; i < INTERFACE_ATLAS_COUNT; i++)
+    {
+        std::string name = INTERFACE_ATLAS_TEXTURES[i];
+        if (m_texBlacklist.find(name) != m_texBlacklist.end())
+            continue;
+
+        CImage* image = new CImage();
+        if (! m_imageLoader->LoadImage(m_app->GetDataFilePath(DIR_TEXTURE, name), *image))
+        {
+            delete image;
+            continue;
+        }
+
+        images.push_back(image);
+        m_interfaceAtlas.AddImage(name, image);
+    }
+
+    // Packed images are drawn at their size: no mipmaps
+    if (! m_interfaceAtlas.Build(m_device, m_terrainTexParams))
+        m_interfaceAtlas.Destroy(m_device);  // textures are then used one by one
+
+    for (int i = 0; i < static_cast<int>( images.size() ); i++)
+        delete images[i];
+}
+
+bool CEngine::SetInterfaceTexture(const std::string& name, TextureRegion& region)
+{
+    if (m_interfaceAtlas.GetRegion(name, region))
+    {
+        SetTexture(region.texture);
+        return true;
+    }
+
+    bool ok = SetTexture(name);
+    region = TextureRegion(m_device->GetTexture(0));
+    return ok;
+}
+
 bool IsExcludeColor(Math::Point *exclude, int x, int y)
 {
     int i = 0;
@@ -2387,29 +3026,33 @@ bool CEngine::SetTexture(const std::string& name, int stage)
     auto it = m_texNameMap.find(name);
     if (it != m_texNameMap.end())
     {
-        m_device->SetTexture(stage, (*it).second);
+        SetTexture((*it).second, stage);
         return true;
     }
 
     if (! LoadTexture(name).Valid())
     {
-        m_device->SetTexture(stage, 0); // invalid texture
+        SetTexture(Texture(), stage); // invalid texture
         return false;
     }
 
     it = m_texNameMap.find(name);
     if (it != m_texNameMap.end())
     {
-        m_device->SetTexture(stage, (*it).second);
+        SetTexture((*it).second, stage);
         return true;
     }
 
-    m_device->SetTexture(stage, 0); // invalid texture
+    SetTexture(Texture(), stage); // invalid texture
     return false; // should not happen normally
 }
 
 void CEngine::SetTexture(const Texture& tex, int stage)
 {
+    // Counted only when the device binds another texture
+    if (m_device->GetTexture(stage).id != tex.id)
+        m_statisticStateChange++;
+
     m_device->SetTexture(stage, tex);
 }
 
@@ -2908,12 +3551,17 @@ void CEngine::Render()
     if (! m_render) return;
 
     m_statisticTriangle = 0;
+    m_statisticStateChange = 0;
+    m_statisticDrawCall = 0;
     m_lastState = -1;
     m_lastColor = Color(-1.0f);
     m_lastMaterial = Material();
 
     m_lightMan->UpdateLights();
 
+    UpdateStaticBuffers();
+    UpdateVisibility();
+
     Color color;
     if (m_skyMode && m_cloud->GetLevel() != 0.0f)  // clouds?
         color = m_backgroundCloudDown;
@@ -2934,6 +3582,53 @@ void CEngine::Render()
     m_device->EndScene();
 }
 
+void CEngine::RenderLoading(float progress)
+{
+    m_device->SetClearColor(Color(0.0f, 0.0f, 0.0f, 0.0f));
+    m_device->BeginScene();
+
+    m_device->SetRenderState(RENDER_STATE_DEPTH_TEST, false);
+    m_device->SetRenderState(RENDER_STATE_LIGHTING, false);
+    m_device->SetRenderState(RENDER_STATE_FOG, false);
+
+    m_device->SetTransform(TRANSFORM_VIEW,       m_matViewInterface);
+    m_device->SetTransform(TRANSFORM_PROJECTION, m_matProjInterface);
+    m_device->SetTransform(TRANSFORM_WORLD,      m_matWorldInterface);
+
+    m_interfaceMode = true;
+    m_lastState = -1;
+    SetState(ENG_RSTATE_OPAQUE_COLOR);
+
+    progress = Math::Norm(progress);
+
+    Math::Point p1(0.2f, 0.10f);
+    Math::Point p2(0.8f, 0.13f);
+    float filled = p1.x + (p2.x - p1.x) * progress;
+
+    Color frame(0.3f, 0.3f, 0.3f, 0.0f);
+    Color bar(1.0f, 1.0f, 1.0f, 0.0f);
+
+    VertexCol vertex[4] =
+    {
+        VertexCol(Math::Vector(p1.x, p1.y, 0.0f), frame),
+        VertexCol(Math::Vector(p1.x, p2.y, 0.0f), frame),
+        VertexCol(Math::Vector(p2.x, p1.y, 0.0f), frame),
+        VertexCol(Math::Vector(p2.x, p2.y, 0.0f), frame)
+    };
+    m_device->DrawPrimitive(PRIMITIVE_TRIANGLE_STRIP, vertex, 4);
+
+    vertex[0] = VertexCol(Math::Vector(p1.x,   p1.y, 0.0f), bar);
+    vertex[1] = VertexCol(Math::Vector(p1.x,   p2.y, 0.0f), bar);
+    vertex[2] = VertexCol(Math::Vector(filled, p1.y, 0.0f), bar);
+    vertex[3] = VertexCol(Math::Vector(filled, p2.y, 0.0f), bar);
+    m_device->DrawPrimitive(PRIMITIVE_TRIANGLE_STRIP, vertex, 4);
+
+    m_interfaceMode = false;
+    m_lastState = -1;
+
+    m_device->EndScene();
+}
+
 void CEngine::Draw3DScene()
 {
     if (m_groundSpotVisible)
@@ -2959,90 +3654,97 @@ void CEngine::Draw3DScene()
 
     if (m_waterMode) m_water->DrawBack();  // draws water background
 
+    CProfiler* profiler = CProfiler::GetInstancePointer();
+
     if (m_shadowVisible)
     {
-        m_lightMan->UpdateDeviceLights(ENG_OBJTYPE_TERRAIN);
-
         // Draw the terrain
 
-        for (int l1 = 0; l1 < static_cast<int>( m_objectTree.size() ); l1++)
-        {
-            EngineObjLevel1& p1 = m_objectTree[l1];
-            if (! p1.used) continue;
+        profiler->StartSection(PROF_DRAW_TERRAIN);
+        CollectRenderQueue(ENG_RENDER_PASS_TERRAIN);
+        DrawRenderQueue(m_renderQueue, false);
+        profiler->StopSection(PROF_DRAW_TERRAIN);
 
-            // Should be loaded by now
-            SetTexture(p1.tex1, 0);
-            SetTexture(p1.tex2, 1);
+        // Draws the shadows
+        profiler->StartSection(PROF_DRAW_SHADOWS);
+        DrawShadow();
+        profiler->StopSection(PROF_DRAW_SHADOWS);
+    }
 
-            for (int l2 = 0; l2 < static_cast<int>( p1.next.size() ); l2++)
-            {
-                EngineObjLevel2& p2 = p1.next[l2];
-                if (! p2.used) continue;
+    // Draw objects (non-terrain)
 
-                int objRank = p2.objRank;
-                if (m_objects[objRank].type != ENG_OBJTYPE_TERRAIN)
-                    continue;
-                if (! m_objects[objRank].drawWorld)
-                    continue;
+    profiler->StartSection(PROF_DRAW_OBJECTS);
+    CollectRenderQueue(ENG_RENDER_PASS_WORLD);
+    DrawRenderQueue(m_renderQueue, false);
+    profiler->StopSection(PROF_DRAW_OBJECTS);
 
-                m_device->SetTransform(TRANSFORM_WORLD, m_objects[objRank].transform);
+    // Draw transparent objects
 
-                if (! IsVisible(objRank))
-                    continue;
+    profiler->StartSection(PROF_DRAW_TRANSPARENT);
+    DrawRenderQueue(m_transparentQueue, true);
+    profiler->StopSection(PROF_DRAW_TRANSPARENT);
 
-                for (int l3 = 0; l3 < static_cast<int>( p2.next.size() ); l3++)
-                {
-                    EngineObjLevel3& p3 = p2.next[l3];
-                    if (! p3.used) continue;
+    m_lightMan->UpdateDeviceLights(ENG_OBJTYPE_TERRAIN);
 
-                    if ( m_objects[objRank].distance <  p3.min ||
-                         m_objects[objRank].distance >= p3.max )
-                        continue;
+    profiler->StartSection(PROF_DRAW_PARTICLES);
+    if (m_waterMode) m_water->DrawSurf();    // draws water surface
 
-                    for (int l4 = 0; l4 < static_cast<int>( p3.next.size() ); l4++)
-                    {
-                        EngineObjLevel4& p4 = p3.next[l4];
-                        if (! p4.used) continue;
+    m_particle->DrawParticle(SH_WORLD); // draws the particles of the 3D world
+    m_lightning->Draw();                     // draws lightning
+    profiler->StopSection(PROF_DRAW_PARTICLES);
 
-                        SetMaterial(p4.material);
-                        SetState(p4.state);
+    // TODO: fix white screen error; commenting out temporarily
+    // if (m_lensMode) DrawForegroundImage();   // draws the foreground
 
-                        if (p4.type == ENG_TRIANGLE_TYPE_TRIANGLES)
-                        {
-                            m_device->DrawPrimitive( PRIMITIVE_TRIANGLES,
-                                                     &p4.vertices[0],
-                                                     p4.vertices.size() );
-                            m_statisticTriangle += p4.vertices.size() / 3;
-                        }
-                        if (p4.type == ENG_TRIANGLE_TYPE_SURFACE)
-                        {
-                            m_device->DrawPrimitive( PRIMITIVE_TRIANGLE_STRIP,
-                                                     &p4.vertices[0],
-                                                     p4.vertices.size() );
-                            m_statisticTriangle += p4.vertices.size() - 2;
-                        }
-                    }
-                }
-            }
-        }
+    if (! m_overFront) DrawOverColor();      // draws the foreground color
+}
 
-        // Draws the shadows
-        DrawShadow();
+void CEngine::DrawObject(const EngineObjLevel4& p4)
+{
+    const std::vector<VertexTex2>& vertices = GetVertices(p4);
+
+    if (vertices.empty())
+        return;
+
+    unsigned int staticBufferId = p4.staticBufferId;
+    if (p4.meshRank != -1)
+        staticBufferId = m_meshes[p4.meshRank].staticBufferId;
+
+    if (staticBufferId != 0)
+    {
+        m_device->DrawStaticBuffer(staticBufferId);
+    }
+    else if (p4.type == ENG_TRIANGLE_TYPE_TRIANGLES)
+    {
+        m_device->DrawPrimitive( PRIMITIVE_TRIANGLES,
+                                 &vertices[0],
+                                 vertices.size() );
+    }
+    else if (p4.type == ENG_TRIANGLE_TYPE_SURFACE)
+    {
+        m_device->DrawPrimitive( PRIMITIVE_TRIANGLE_STRIP,
+                                 &vertices[0],
+                                 vertices.size() );
     }
 
-    // Draw objects (non-terrain)
+    m_statisticDrawCall++;
+
+    if (p4.type == ENG_TRIANGLE_TYPE_TRIANGLES)
+        m_statisticTriangle += vertices.size() / 3;
+    else if (p4.type == ENG_TRIANGLE_TYPE_SURFACE)
+        m_statisticTriangle += vertices.size() - 2;
+}
 
-    bool transparent = false;
+void CEngine::CollectRenderQueue(EngineRenderPass pass)
+{
+    m_renderQueue.clear();
+    m_transparentQueue.clear();
 
     for (int l1 = 0; l1 < static_cast<int>( m_objectTree.size() ); l1++)
     {
         EngineObjLevel1& p1 = m_objectTree[l1];
         if (! p1.used) continue;
 
-        // Should be loaded by now
-        SetTexture(p1.tex1, 0);
-        SetTexture(p1.tex2, 1);
-
         for (int l2 = 0; l2 < static_cast<int>( p1.next.size() ); l2++)
         {
             EngineObjLevel2& p2 = p1.next[l2];
@@ -3050,18 +3752,32 @@ void CEngine::Draw3DScene()
 
             int objRank = p2.objRank;
 
-            if (m_shadowVisible && m_objects[objRank].type == ENG_OBJTYPE_TERRAIN)
-                continue;
-
-            if (! m_objects[objRank].drawWorld)
+            if (pass == ENG_RENDER_PASS_TERRAIN)
+            {
+                if (m_objects[objRank].type != ENG_OBJTYPE_TERRAIN)
+                    continue;
+            }
+            else if (m_shadowVisible && m_objects[objRank].type == ENG_OBJTYPE_TERRAIN)
+            {
                 continue;
+            }
 
-            m_device->SetTransform(TRANSFORM_WORLD, m_objects[objRank].transform);
+            if (pass == ENG_RENDER_PASS_FRONT)
+            {
+                if (! m_objects[objRank].drawFront)
+                    continue;
+            }
+            else
+            {
+                if (! m_objects[objRank].drawWorld)
+                    continue;
+            }
 
             if (! IsVisible(objRank))
                 continue;
 
-            m_lightMan->UpdateDeviceLights(m_objects[objRank].type);
+            bool transparent = pass == ENG_RENDER_PASS_WORLD &&
+                               m_objects[objRank].transparency != 0.0f;
 
             for (int l3 = 0; l3 < static_cast<int>( p2.next.size() ); l3++)
             {
@@ -3076,127 +3792,78 @@ void CEngine::Draw3DScene()
                     EngineObjLevel4& p4 = p3.next[l4];
                     if (! p4.used) continue;
 
-                    if (m_objects[objRank].transparency != 0.0f)  // transparent ?
-                    {
-                        transparent = true;
-                        continue;
-                    }
-
-                    SetMaterial(p4.material);
-                    SetState(p4.state);
-
-                    if (p4.type == ENG_TRIANGLE_TYPE_TRIANGLES)
-                    {
-                        m_device->DrawPrimitive( PRIMITIVE_TRIANGLES,
-                                                 &p4.vertices[0],
-                                                 p4.vertices.size() );
-
-                        m_statisticTriangle += p4.vertices.size() / 3;
-                    }
-                    else if (p4.type == ENG_TRIANGLE_TYPE_SURFACE)
-                    {
-                        m_device->DrawPrimitive( PRIMITIVE_TRIANGLE_STRIP,
-                                                 &p4.vertices[0],
-                                                 p4.vertices.size() );
-
-                        m_statisticTriangle += p4.vertices.size() - 2;
-                    }
+                    EngineRenderBatch batch;
+                    batch.objType  = m_objects[objRank].type;
+                    batch.texRank  = l1;
+                    batch.state    = p4.state;
+                    batch.material = &p4.material;
+                    batch.objRank  = objRank;
+                    batch.p4       = &p4;
+
+                    if (transparent)
+                        m_transparentQueue.push_back(batch);
+                    else
+                        m_renderQueue.push_back(batch);
                 }
             }
         }
     }
 
-    // Draw transparent objects
+    std::sort(m_renderQueue.begin(), m_renderQueue.end());
+    std::sort(m_transparentQueue.begin(), m_transparentQueue.end());
+}
+
+void CEngine::DrawRenderQueue(const std::vector<EngineRenderBatch>& queue, bool transparent)
+{
+    int tState = ENG_RSTATE_TTEXTURE_BLACK | ENG_RSTATE_2FACE;
+    Color tColor = Color(68.0f / 255.0f, 68.0f / 255.0f, 68.0f / 255.0f, 68.0f / 255.0f);
+
+    int lastTexRank = -1;
+    int lastObjRank = -1;
+    const Material* lastMaterial = nullptr;
 
-    if (transparent)
+    for (int i = 0; i < static_cast<int>( queue.size() ); i++)
     {
-        int tState = ENG_RSTATE_TTEXTURE_BLACK | ENG_RSTATE_2FACE;
-        Color tColor = Color(68.0f / 255.0f, 68.0f / 255.0f, 68.0f / 255.0f, 68.0f / 255.0f);
+        const EngineRenderBatch& batch = queue[i];
 
-        for (int l1 = 0; l1 < static_cast<int>( m_objectTree.size() ); l1++)
+        if (batch.texRank != lastTexRank)
         {
-            EngineObjLevel1& p1 = m_objectTree[l1];
-            if (! p1.used) continue;
+            lastTexRank = batch.texRank;
 
             // Should be loaded by now
-            SetTexture(p1.tex1, 0);
-            SetTexture(p1.tex2, 1);
-
-            for (int l2 = 0; l2 < static_cast<int>( p1.next.size() ); l2++)
-            {
-                EngineObjLevel2& p2 = p1.next[l2];
-                if (! p2.used) continue;
-
-                int objRank = p2.objRank;
-
-                if (m_shadowVisible && m_objects[objRank].type == ENG_OBJTYPE_TERRAIN)
-                    continue;
-
-                if (! m_objects[objRank].drawWorld)
-                    continue;
-
-                m_device->SetTransform(TRANSFORM_WORLD, m_objects[objRank].transform);
-
-                if (! IsVisible(objRank))
-                    continue;
-
-                m_lightMan->UpdateDeviceLights(m_objects[objRank].type);
-
-                for (int l3 = 0; l3 < static_cast<int>( p2.next.size() ); l3++)
-                {
-                    EngineObjLevel3& p3 = p2.next[l3];
-                    if (! p3.used) continue;
-
-                    if ( m_objects[objRank].distance <  p3.min ||
-                        m_objects[objRank].distance >= p3.max )  continue;
-
-                    for (int l4 = 0; l4 < static_cast<int>( p3.next.size() ); l4++)
-                    {
-                        EngineObjLevel4& p4 = p3.next[l4];
-                        if (! p4.used) continue;
-
-                        if (m_objects[objRank].transparency == 0.0f)
-                            continue;
-
-                        SetMaterial(p4.material);
-                        SetState(tState, tColor);
-
-                        if (p4.type == ENG_TRIANGLE_TYPE_TRIANGLES)
-                        {
-                            m_device->DrawPrimitive( PRIMITIVE_TRIANGLES,
-                                                     &p4.vertices[0],
-                                                     p4.vertices.size() );
-
-                            m_statisticTriangle += p4.vertices.size() / 3;
-                        }
-                        else if (p4.type == ENG_TRIANGLE_TYPE_SURFACE)
-                        {
-                            m_device->DrawPrimitive( PRIMITIVE_TRIANGLE_STRIP,
-                                                     &p4.vertices[0],
-                                                     p4.vertices.size() );
-                            m_statisticTriangle += p4.vertices.size() - 2;
-                        }
-                    }
-                }
-            }
+            SetTexture(m_objectTree[lastTexRank].tex1, 0);
+            SetTexture(m_objectTree[lastTexRank].tex2, 1);
         }
-    }
 
-    m_lightMan->UpdateDeviceLights(ENG_OBJTYPE_TERRAIN);
+        if (batch.objRank != lastObjRank)
+        {
+            lastObjRank = batch.objRank;
+            m_device->SetTransform(TRANSFORM_WORLD, m_objects[lastObjRank].transform);
 
-    if (m_waterMode) m_water->DrawSurf();    // draws water surface
+            // Lights are chosen for each object; the device only changes with the chosen lights
+            const EngineObject& obj = m_objects[lastObjRank];
+            m_lightMan->UpdateDeviceLights(batch.objType, obj.worldCenter, obj.worldRadius);
+        }
 
-    m_particle->DrawParticle(SH_WORLD); // draws the particles of the 3D world
-    m_lightning->Draw();                     // draws lightning
+        if (lastMaterial == nullptr || *batch.material != *lastMaterial)
+        {
+            lastMaterial = batch.material;
+            SetMaterial(*lastMaterial);
+        }
 
-    // TODO: fix white screen error; commenting out temporarily
-    // if (m_lensMode) DrawForegroundImage();   // draws the foreground
+        if (transparent)
+            SetState(tState, tColor);
+        else
+            SetState(batch.state);
 
-    if (! m_overFront) DrawOverColor();      // draws the foreground color
+        DrawObject(*batch.p4);
+    }
 }
 
 void CEngine::DrawInterface()
 {
+    CProfilerScope scope(PROF_DRAW_INTERFACE);
+
     m_device->SetRenderState(RENDER_STATE_DEPTH_TEST, false);
     m_device->SetRenderState(RENDER_STATE_LIGHTING, false);
     m_device->SetRenderState(RENDER_STATE_FOG, false);
@@ -3240,70 +3907,8 @@ void CEngine::DrawInterface()
 
         m_device->SetTransform(TRANSFORM_VIEW, m_matView);
 
-        for (int l1 = 0; l1 < static_cast<int>( m_objectTree.size() ); l1++)
-        {
-            EngineObjLevel1& p1 = m_objectTree[l1];
-            if (! p1.used) continue;
-
-            // Should be loaded by now
-            SetTexture(p1.tex1, 0);
-            SetTexture(p1.tex2, 1);
-
-            for (int l2 = 0; l2 < static_cast<int>( p1.next.size() ); l2++)
-            {
-                EngineObjLevel2& p2 = p1.next[l2];
-                if (! p2.used) continue;
-
-                int objRank = p2.objRank;
-
-                if (m_shadowVisible && m_objects[objRank].type == ENG_OBJTYPE_TERRAIN)
-                    continue;
-
-                if (! m_objects[objRank].drawFront)
-                    continue;
-
-                m_device->SetTransform(TRANSFORM_WORLD, m_objects[objRank].transform);
-
-                if (! IsVisible(objRank))
-                    continue;
-
-                m_lightMan->UpdateDeviceLights(m_objects[objRank].type);
-
-                for (int l3 = 0; l3 < static_cast<int>( p2.next.size() ); l3++)
-                {
-                    EngineObjLevel3& p3 = p2.next[l3];
-                    if (! p3.used) continue;
-
-                    if ( m_objects[objRank].distance <  p3.min ||
-                         m_objects[objRank].distance >= p3.max )  continue;
-
-                    for (int l4 = 0; l4 < static_cast<int>( p3.next.size() ); l4++)
-                    {
-                        EngineObjLevel4& p4 = p3.next[l4];
-                        if (! p4.used) continue;
-
-                        SetMaterial(p4.material);
-                        SetState(p4.state);
-
-                        if (p4.type == ENG_TRIANGLE_TYPE_TRIANGLES)
-                        {
-                            m_device->DrawPrimitive( PRIMITIVE_TRIANGLES,
-                                                     &p4.vertices[0],
-                                                     p4.vertices.size() );
-
-                            m_statisticTriangle += p4.vertices.size() / 3;
-                        }
-                        else if (p4.type == ENG_TRIANGLE_TYPE_SURFACE)
-                        {
-                            m_device->DrawPrimitive( PRIMITIVE_TRIANGLE_STRIP,
-                                                     &p4.vertices[0],
-                                                     p4.vertices.size() );
-                            m_statisticTriangle += p4.vertices.size() - 2;
-                        }
-                    }
-                }
-            }
-        }
+        CollectRenderQueue(ENG_RENDER_PASS_FRONT);
+        DrawRenderQueue(m_renderQueue, false);
 
         m_particle->DrawParticle(SH_FRONT);  // draws the particles of the 3D world
 
@@ -3827,8 +4432,8 @@ void CEngine::DrawMouse()
     material.diffuse = Color(1.0f, 1.0f, 1.0f);
     material.ambient = Color(0.5f, 0.5f, 0.5f);
 
-    m_device->SetMaterial(material);
-    m_device->SetTexture(0, m_miceTexture);
+    SetMaterial(material);
+    SetTexture(m_miceTexture);
 
     int index = static_cast<int>(m_mouseType);
 
@@ -3889,15 +4494,55 @@ void CEngine::DrawStats()
     if (!m_showStats)
         return;
 
+    std::vector<std::string> lines;
+
     std::stringstream str;
     str << "Triangles: ";
     str << m_statisticTriangle;
-    std::string triangleText = str.str();
+    lines.push_back(str.str());
+
+    str.str("");
+    str << "State changes: ";
+    str << m_statisticStateChange;
+    lines.push_back(str.str());
+
+    str.str("");
+    str << "Draw calls: ";
+    str << m_statisticDrawCall;
+    lines.push_back(str.str());
+
+    if (CObjectGrid::IsCreated())
+    {
+        str.str("");
+        str << "Collision tests: ";
+        str << CObjectGrid::GetInstancePointer()->GetStatisticPairTest();
+        lines.push_back(str.str());
+    }
+
+    lines.push_back(m_fpsText);
+
+    // Frame profile: average and maximum times in ms
+    CProfiler* profiler = CProfiler::GetInstancePointer();
+    str.precision(2);
+    str.setf(std::ios_base::fixed);
+    for (int i = 0; i < PROF_MAX; i++)
+    {
+        ProfilerSection section = static_cast<ProfilerSection>(i);
+
+        str.str("");
+        str << std::string(2 * CProfiler::GetSectionLevel(section), ' ');
+        str << CProfiler::GetSectionName(section) << ": ";
+        str << profiler->GetAverageTime(section) << " / ";
+        str << profiler->GetMaxTime(section) << " ms";
+        lines.push_back(str.str());
+    }
+
+    int count = static_cast<int>( lines.size() );
 
     float height = m_text->GetAscent(FONT_COLOBOT, 12.0f);
-    float width = 0.2f;
+    float width = 0.3f;
 
-    Math::Point pos(0.04f, 0.04f + height);
+    Math::Point pos(0.04f, 0.04f + (count - 1) * height);
 
     SetState(ENG_RSTATE_OPAQUE_COLOR);
 
@@ -3905,9 +4550,9 @@ void CEngine::DrawStats()
 
     VertexCol vertex[4] =
     {
-        VertexCol(Math::Vector(pos.x        , pos.y - height, 0.0f), black),
+        VertexCol(Math::Vector(pos.x        , pos.y - (count - 1) * height, 0.0f), black),
         VertexCol(Math::Vector(pos.x        , pos.y + height, 0.0f), black),
-        VertexCol(Math::Vector(pos.x + width, pos.y - height, 0.0f), black),
+        VertexCol(Math::Vector(pos.x + width, pos.y - (count - 1) * height, 0.0f), black),
         VertexCol(Math::Vector(pos.x + width, pos.y + height, 0.0f), black)
     };
 
@@ -3915,11 +4560,11 @@ void CEngine::DrawStats()
 
     SetState(ENG_RSTATE_TEXT);
 
-    m_text->DrawText(triangleText, FONT_COLOBOT, 12.0f, pos, 1.0f, TEXT_ALIGN_LEFT, 0, Color(1.0f, 1.0f, 1.0f, 1.0f));
-
-    pos.y -= height;
-
-    m_text->DrawText(m_fpsText, FONT_COLOBOT, 12.0f, pos, 1.0f, TEXT_ALIGN_LEFT, 0, Color(1.0f, 1.0f, 1.0f, 1.0f));
+    for (int i = 0; i < count; i++)
+    {
+        m_text->DrawText(lines[i], FONT_COLOBOT, 12.0f, pos, 1.0f, TEXT_ALIGN_LEFT, 0, Color(1.0f, 1.0f, 1.0f, 1.0f));
+        pos.y -= height;
+    }
 }
 
 
@@ -31,6 +31,7 @@
 #include "graphics/core/material.h"
 #include "graphics/core/texture.h"
 #include "graphics/core/vertex.h"
+#include "graphics/engine/textureatlas.h"
 
 #include "math/intpoint.h"
 #include "math/matrix.h"
@@ -62,6 +63,8 @@ class CParticle;
 class CWater;
 class CCloud;
 class CLightning;
+class CModelManager;
+class CImageLoader;
 class CPlanet;
 class CTerrain;
 
@@ -118,7 +121,9 @@ enum EngineRenderState
     //! Only opaque texture, no blending, etc.
     ENG_RSTATE_OPAQUE_TEXTURE     = (1<<19),
     //! Only opaque color, no texture, blending, etc.
-    ENG_RSTATE_OPAQUE_COLOR     = (1<<20)
+    ENG_RSTATE_OPAQUE_COLOR     = (1<<20),
+    //! With transparent texture: colors of vertices instead of the given color
+    ENG_RSTATE_VERTEX_COLOR     = (1<<21)
 };
 
 
@@ -210,6 +215,14 @@ struct EngineObject
     int                    shadowRank;
     //! Transparency of the object [0, 1]
     float                  transparency;
+    //! Center of bounding sphere in world coords
+    Math::Vector           worldCenter;
+    //! Radius of bounding sphere in world coords
+    float                  worldRadius;
+    //! Rank of culling grid cell containing the object (-1 if none)
+    int                    cullCell;
+    //! If true, the object is outside the view frustum in current frame
+    bool                   culled;
 
     //! Calls LoadDefault()
     EngineObject()
@@ -233,6 +246,58 @@ struct EngineObject
         radius = 0.0f;
         shadowRank = -1;
         transparency = 0.0f;
+        worldCenter.LoadZero();
+        worldRadius = 0.0f;
+        cullCell = -1;
+        culled = false;
+    }
+};
+
+/**
+ * \struct EngineCullCell
+ * \brief Cell of the grid used to cull whole groups of objects at once
+ */
+struct EngineCullCell
+{
+    //! Ranks of objects with center in this cell
+    std::vector<int>       objRanks;
+    //! Bounding box of all objects in the cell (world coords)
+    Math::Vector           bboxMin;
+    //! Bounding box of all objects in the cell (world coords)
+    Math::Vector           bboxMax;
+    //! If true, the bounding box must be recomputed
+    bool                   dirty;
+
+    EngineCullCell()
+    {
+        dirty = false;
+    }
+};
+
+/**
+ * \struct EngineMesh
+ * \brief Geometry shared by tier 4 objects of many engine objects
+ *
+ * Meshes are made once for each part of a cached model (see CModelManager)
+ * and are never modified afterwards; tier 4 objects reference them by rank.
+ */
+struct EngineMesh
+{
+    EngineTriangleType      type;
+    std::vector<VertexTex2> vertices;
+    //! Bounding box of the vertices
+    Math::Vector            bboxMin;
+    Math::Vector            bboxMax;
+    //! ID of device static buffer holding the vertices (0 if not created yet)
+    unsigned int            staticBufferId;
+    //! Whether the static buffer must be created before drawing
+    bool                    updateStaticBuffer;
+
+    EngineMesh()
+    {
+        type = ENG_TRIANGLE_TYPE_TRIANGLES;
+        staticBufferId = 0;
+        updateStaticBuffer = false;
     }
 };
 
@@ -252,6 +317,12 @@ struct EngineObjLevel4
     Material                material;
     int                     state;
     std::vector<VertexTex2> vertices;
+    //! ID of device static buffer holding the vertices (0 if not created yet)
+    unsigned int            staticBufferId;
+    //! Whether the static buffer must be rebuilt from vertices before drawing
+    bool                    updateStaticBuffer;
+    //! Rank of shared mesh used instead of own vertices (-1 if none)
+    int                     meshRank;
 
     EngineObjLevel4(bool used = false,
                     EngineTriangleType type = ENG_TRIANGLE_TYPE_TRIANGLES,
@@ -303,6 +374,46 @@ struct EngineObjLevel1
                     const std::string& tex2Name = "");
 };
 
+/**
+ * \enum EngineRenderPass
+ * \brief Pass of 3D scene drawing, used when collecting the render queue
+ */
+enum EngineRenderPass
+{
+    //! Terrain drawn before the shadows
+    ENG_RENDER_PASS_TERRAIN,
+    //! Objects of the 3D world
+    ENG_RENDER_PASS_WORLD,
+    //! Objects drawn in front of interface
+    ENG_RENDER_PASS_FRONT
+};
+
+/**
+ * \struct EngineRenderBatch
+ * \brief Tier 4 object queued for drawing in current frame
+ *
+ * Batches are sorted by the state they need, so that consecutive
+ * batches share as much of the state as possible.
+ */
+struct EngineRenderBatch
+{
+    //! Type of object (selects the lights)
+    EngineObjectType        objType;
+    //! Rank of tier 1 object (selects the textures)
+    int                     texRank;
+    //! Render state
+    int                     state;
+    //! Material
+    const Material*         material;
+    //! Rank of object (selects the world transform)
+    int                     objRank;
+    //! The tier 4 object itself
+    const EngineObjLevel4*  p4;
+
+    //! Order of drawing: lights, textures, state, material and transform
+    bool operator<(const EngineRenderBatch& other) const;
+};
+
 /**
  * \struct EngineShadowType
  * \brief Type of shadow drawn by the graphics engine
@@ -680,6 +791,8 @@ public:
 
     //! Called once per frame, the call is the entry point for rendering
     void            Render();
+    //! Renders only a progress bar, while a scene is loading (\a progress from 0 to 1)
+    void            RenderLoading(float progress);
 
 
     //! Processes incoming event
@@ -743,6 +856,10 @@ public:
     void            AddStatisticTriangle(int nb);
     //! Returns the number of triangles in current frame
     int             GetStatisticTriangle();
+    //! Returns the number of texture, state and material changes in current frame
+    int             GetStatisticStateChange();
+    //! Returns the number of draw calls in current frame
+    int             GetStatisticDrawCall();
 
 
     /* *************** Object management *************** */
@@ -797,6 +914,15 @@ public:
                              std::string tex1Name, std::string tex2Name,
                              float min, float max, bool globalUpdate);
 
+    //! Creates a mesh shared by many objects and returns its rank
+    int             CreateMesh(EngineTriangleType type, const std::vector<VertexTex2>& vertices);
+
+    //! Adds a reference to a shared mesh to given object with the specified params
+    bool            AddMeshReference(int objRank, int meshRank,
+                                     const Material& material, int state,
+                                     std::string tex1Name, std::string tex2Name,
+                                     float min, float max);
+
     //! Returns the first found tier 4 engine object for the given params or nullptr if not found
     EngineObjLevel4* FindTriangles(int objRank, const Material& material,
                                         int state, std::string tex1Name, std::string tex2Name,
@@ -898,6 +1024,10 @@ public:
     Texture         LoadTexture(const std::string& name, const TextureCreateParams& params);
     //! Loads all necessary textures
     bool            LoadAllTextures();
+    //! Binds a texture of the interface, giving its region in the interface atlas if it is packed there
+    bool            SetInterfaceTexture(const std::string& name, TextureRegion& region);
+    //! Starts decoding an image of the texture directory ahead of its loading
+    void            PreloadTexture(const std::string& name);
 
     //! Changes colors in a texture
     bool            ChangeTextureColor(const std::string& texName,
@@ -1186,6 +1316,9 @@ protected:
     //! Draw statistic texts
     void        DrawStats();
 
+    //! Packs the textures of the interface into m_interfaceAtlas
+    void        CreateInterfaceAtlas();
+
     //! Creates new tier 1 object
     EngineObjLevel1& AddLevel1(const std::string& tex1Name, const std::string& tex2Name);
     //! Creates a new tier 2 object
@@ -1202,6 +1335,21 @@ protected:
     //! Tests whether the given object is visible
     bool        IsVisible(int objRank);
 
+    //! Updates the world bounding sphere and culling cell of the object
+    void        UpdateObjectBounds(int objRank);
+    //! Removes the object from its culling cell
+    void        RemoveObjectCullCell(int objRank);
+    //! Recomputes the bounding box of the culling cell from its objects
+    void        UpdateCullCellBounds(EngineCullCell& cell);
+    //! Computes the view frustum planes from current view and projection matrices
+    void        ComputeFrustumPlanes();
+    //! Tests the box against view frustum; \a inside is set if the whole box is visible
+    bool        IsBoxInFrustum(const Math::Vector& min, const Math::Vector& max, bool& inside);
+    //! Tests the sphere against view frustum
+    bool        IsSphereInFrustum(const Math::Vector& center, float radius);
+    //! Marks objects outside the view frustum, testing whole culling cells first
+    void        UpdateVisibility();
+
     //! Detects whether an object is affected by the mouse
     bool        DetectBBox(int objRank, Math::Point mouse);
 
@@ -1209,7 +1357,7 @@ protected:
     bool        GetBBox2D(int objRank, Math::Point& min, Math::Point& max);
 
     //! Detects whether the mouse is in a triangle.
-    bool        DetectTriangle(Math::Point mouse, VertexTex2* triangle, int objRank, float& dist);
+    bool        DetectTriangle(Math::Point mouse, const VertexTex2* triangle, int objRank, float& dist);
 
     //! Transforms a 3D point (x, y, z) in 2D space (x, y, -) of the window
     /** The coordinated p2D.z gives the distance. */
@@ -1221,6 +1369,28 @@ protected:
     //! Updates geometric parameters of objects (bounding box and radius)
     void        UpdateGeometry();
 
+    //! Returns the vertices of tier 4 object, own or of its shared mesh
+    const std::vector<VertexTex2>& GetVertices(const EngineObjLevel4& p4);
+    //! Gives own copy of the shared mesh vertices to tier 4 object, before modifying them
+    void        UnshareMesh(EngineObjLevel4& p4);
+
+    //! Creates or updates the static buffer for given tier 4 object
+    void        UpdateStaticBuffer(EngineObjLevel4& p4);
+    //! Creates or updates a static buffer from given vertices
+    void        UpdateStaticBuffer(unsigned int& staticBufferId, EngineTriangleType type,
+                                   const std::vector<VertexTex2>& vertices);
+    //! Updates static buffers of all tier 4 objects with changed vertices
+    void        UpdateStaticBuffers();
+    //! Deletes the static buffers of all tier 4 objects in given tier 2 object
+    void        DeleteStaticBuffers(EngineObjLevel2& p2);
+    //! Draws the tier 4 object, using its static buffer if available
+    void        DrawObject(const EngineObjLevel4& p4);
+
+    //! Collects visible tier 4 objects for given pass into sorted render queues
+    void        CollectRenderQueue(EngineRenderPass pass);
+    //! Draws the queued batches, changing state only between different batches
+    void        DrawRenderQueue(const std::vector<EngineRenderBatch>& queue, bool transparent);
+
 protected:
     CInstanceManager* m_iMan;
     CApplication*     m_app;
@@ -1234,6 +1404,8 @@ protected:
     CLightning*       m_lightning;
     CPlanet*          m_planet;
     CTerrain*         m_terrain;
+    CModelManager*    m_modelManager;
+    CImageLoader*     m_imageLoader;
 
     //! Last encountered error
     std::string     m_error;
@@ -1277,6 +1449,14 @@ protected:
     std::vector<EngineObjLevel1>  m_objectTree;
     //! Object parameters
     std::vector<EngineObject>     m_objects;
+    //! Meshes shared by objects, kept until the engine is destroyed
+    std::vector<EngineMesh>       m_meshes;
+    //! Grid of objects for hierarchical culling
+    std::vector<EngineCullCell>   m_cullCells;
+    //! Normals of view frustum planes (pointing inside)
+    Math::Vector                  m_frustumNormal[6];
+    //! Distances of view frustum planes
+    float                         m_frustumDist[6];
     //! Shadow list
     std::vector<EngineShadow>     m_shadows;
     //! Ground spot list
@@ -1298,7 +1478,15 @@ protected:
     float           m_fogStart[2];
     Color           m_waterAddColor;
     int             m_statisticTriangle;
+    int             m_statisticStateChange;
+    int             m_statisticDrawCall;
     bool            m_updateGeometry;
+    //! Whether some static buffers need to be updated before drawing
+    bool            m_updateStaticBuffers;
+    //! Opaque batches of current pass, sorted by state
+    std::vector<EngineRenderBatch> m_renderQueue;
+    //! Transparent batches of current pass, sorted by state
+    std::vector<EngineRenderBatch> m_transparentQueue;
     int             m_alphaMode;
     bool            m_groundSpotVisible;
     bool            m_shadowVisible;
@@ -1367,6 +1555,12 @@ protected:
      *  so are disabled for subsequent load calls. */
     std::set<std::string> m_texBlacklist;
 
+    //! Button and text textures of the interface, packed together
+    /** Controls draw from it without switching textures (see SetInterfaceTexture()). */
+    CTextureAtlas   m_interfaceAtlas;
+    //! Whether packing m_interfaceAtlas was tried
+    bool            m_interfaceAtlasDone;
+
     //! Mouse cursor definitions
     EngineMouse     m_mice[ENG_MOUSE_COUNT];
     //! Texture with mouse cursors
@@ -0,0 +1,242 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+
+#include "graphics/engine/imageloader.h"
+
+#include "common/image.h"
+#include "common/logger.h"
+
+#include <SDL/SDL.h>
+
+#include <algorithm>
+#include <vector>
+
+
+template<> Gfx::CImageLoader* CSingleton<Gfx::CImageLoader>::mInstance = nullptr;
+
+
+// Graphics module namespace
+namespace Gfx {
+
+
+/**
+ * \struct ImageLoaderPrivate
+ * \brief Private data of CImageLoader class
+ */
+struct ImageLoaderPrivate
+{
+    //! Worker threads
+    std::vector<SDL_Thread*> threads;
+    //! Whether the worker threads were started
+    bool        started;
+    //! Guards the members of CImageLoader shared with worker threads
+    SDL_mutex*  mutex;
+    //! Signalled when a file is queued
+    SDL_cond*   workCond;
+    //! Signalled when a worker thread is done with a file
+    SDL_cond*   doneCond;
+};
+
+
+CImageLoader::CImageLoader()
+{
+    m_private = new ImageLoaderPrivate();
+    m_private->started = false;
+    m_private->mutex = SDL_CreateMutex();
+    m_private->workCond = SDL_CreateCond();
+    m_private->doneCond = SDL_CreateCond();
+
+    m_progress = nullptr;
+    m_busy = 0;
+    m_total = 0;
+    m_used = 0;
+    m_quit = false;
+}
+
+CImageLoader::~CImageLoader()
+{
+    SDL_LockMutex(m_private->mutex);
+    m_quit = true;
+    SDL_CondBroadcast(m_private->workCond);
+    SDL_UnlockMutex(m_private->mutex);
+
+    for (int i = 0; i < static_cast<int>( m_private->threads.size() ); i++)
+        SDL_WaitThread(m_private->threads[i], nullptr);
+
+    m_private->threads.clear();
+
+    Flush();
+
+    SDL_DestroyCond(m_private->doneCond);
+    SDL_DestroyCond(m_private->workCond);
+    SDL_DestroyMutex(m_private->mutex);
+
+    delete m_private;
+    m_private = nullptr;
+}
+
+void CImageLoader::SetProgress(CLoadingProgress* progress)
+{
+    m_progress = progress;
+}
+
+void CImageLoader::Preload(const std::string& fileName)
+{
+    if (! m_private->started)
+        StartThreads();
+
+    SDL_LockMutex(m_private->mutex);
+
+    if (m_images.find(fileName) == m_images.end())
+    {
+        m_images[fileName] = PreloadedImage();
+        m_queue.push_back(fileName);
+        m_total++;
+        SDL_CondSignal(m_private->workCond);
+    }
+
+    SDL_UnlockMutex(m_private->mutex);
+}
+
+bool CImageLoader::LoadImage(const std::string& fileName, CImage& image)
+{
+    SDL_LockMutex(m_private->mutex);
+
+    std::map<std::string, PreloadedImage>::iterator it = m_images.find(fileName);
+    if (it == m_images.end())
+    {
+        SDL_UnlockMutex(m_private->mutex);
+        return image.Load(fileName);
+    }
+
+    // Not taken by a worker yet: no use waiting for the files before it
+    std::deque<std::string>::iterator queued = std::find(m_queue.begin(), m_queue.end(), fileName);
+    if (queued != m_queue.end())
+    {
+        m_queue.erase(queued);
+        m_images.erase(it);
+        m_used++;
+        SDL_UnlockMutex(m_private->mutex);
+
+        bool ok = image.Load(fileName);
+        if (m_progress != nullptr)
+            m_progress->LoadingProgress(m_used, m_total);
+
+        return ok;
+    }
+
+    while (! it->second.done)
+        SDL_CondWait(m_private->doneCond, m_private->mutex);
+
+    CImage* preloaded = it->second.image;
+    m_images.erase(it);
+    m_used++;
+
+    SDL_UnlockMutex(m_private->mutex);
+
+    image.Swap(*preloaded);
+    delete preloaded;
+
+    if (m_progress != nullptr)
+        m_progress->LoadingProgress(m_used, m_total);
+
+    return ! image.IsEmpty();
+}
+
+void CImageLoader::Flush()
+{
+    SDL_LockMutex(m_private->mutex);
+
+    m_queue.clear();
+    while (m_busy > 0)
+        SDL_CondWait(m_private->doneCond, m_private->mutex);
+
+    for (std::map<std::string, PreloadedImage>::iterator it = m_images.begin(); it != m_images.end(); ++it)
+        delete (*it).second.image;
+
+    if (! m_images.empty())
+        GetLogger()->Trace("Freed %d preloaded images not used\n", static_cast<int>( m_images.size() ));
+
+    m_images.clear();
+    m_total = 0;
+    m_used = 0;
+
+    SDL_UnlockMutex(m_private->mutex);
+}
+
+void CImageLoader::StartThreads()
+{
+    m_private->started = true;
+
+    for (int i = 0; i < IMAGE_LOADER_THREAD_COUNT; i++)
+    {
+        SDL_Thread* thread = SDL_CreateThread(WorkerThread, this);
+        if (thread == nullptr)
+        {
+            GetLogger()->Error("Could not create image loader thread: %s\n", SDL_GetError());
+            break;
+        }
+        m_private->threads.push_back(thread);
+    }
+
+    // Without threads, queued files are loaded by LoadImage() as if not preloaded
+    GetLogger()->Info("Decoding images on %d worker threads\n", static_cast<int>( m_private->threads.size() ));
+}
+
+int CImageLoader::WorkerThread(void* data)
+{
+    static_cast<CImageLoader*>(data)->WorkerLoop();
+    return 0;
+}
+
+void CImageLoader::WorkerLoop()
+{
+    SDL_LockMutex(m_private->mutex);
+
+    while (true)
+    {
+        while (! m_quit && m_queue.empty())
+            SDL_CondWait(m_private->workCond, m_private->mutex);
+
+        if (m_quit)
+            break;
+
+        std::string fileName = m_queue.front();
+        m_queue.pop_front();
+        m_busy++;
+
+        SDL_UnlockMutex(m_private->mutex);
+
+        // Errors stay in the image and are logged by the user of the image
+        CImage* image = new CImage();
+        image->Load(fileName);
+
+        SDL_LockMutex(m_private->mutex);
+
+        PreloadedImage& preloaded = m_images[fileName];
+        preloaded.image = image;
+        preloaded.done = true;
+        m_busy--;
+
+        SDL_CondBroadcast(m_private->doneCond);
+    }
+
+    SDL_UnlockMutex(m_private->mutex);
+}
+
+
+} // namespace Gfx
@@ -0,0 +1,137 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+/**
+ * \file graphics/engine/imageloader.h
+ * \brief Decoding of images on worker threads - CImageLoader class
+ */
+
+#pragma once
+
+
+#include "common/singleton.h"
+
+#include <deque>
+#include <map>
+#include <string>
+
+
+class CImage;
+
+
+// Graphics module namespace
+namespace Gfx {
+
+struct ImageLoaderPrivate;
+
+
+//! Number of worker threads decoding images
+const int IMAGE_LOADER_THREAD_COUNT = 3;
+
+
+/**
+ * \class CLoadingProgress
+ * \brief Receives the progress of loading, e.g. to update a loading screen
+ */
+class CLoadingProgress
+{
+public:
+    virtual ~CLoadingProgress() {}
+
+    //! Called on the main thread each time a preloaded image is used
+    virtual void LoadingProgress(int done, int total) = 0;
+};
+
+/**
+ * \struct PreloadedImage
+ * \brief Image queued in CImageLoader
+ */
+struct PreloadedImage
+{
+    //! Decoded image; \c nullptr until done
+    CImage*     image;
+    //! Whether a worker thread finished decoding the image
+    bool        done;
+
+    PreloadedImage()
+    {
+        image = nullptr;
+        done = false;
+    }
+};
+
+/**
+ * \class CImageLoader
+ * \brief Decodes image files on worker threads ahead of their use
+ *
+ * Loading a scene reads many images: terrain relief and resources, then
+ * textures, which are only uploaded to the device on the main thread.
+ * Files which will be needed are given to Preload() as soon as they are
+ * known (see CRobotMain::PreloadScene() and CEngine::LoadAllTextures());
+ * worker threads decode them while the main thread goes on with the scene.
+ *
+ * LoadImage() then gives the decoded image, waiting for it if needed;
+ * files which were not preloaded are simply decoded on the spot.
+ * Flush() frees images which were preloaded but not used.
+ *
+ * Only the main thread calls the public functions.
+ */
+class CImageLoader : public CSingleton<CImageLoader>
+{
+public:
+    CImageLoader();
+    ~CImageLoader();
+
+    //! Starts decoding given file on the worker threads, if not queued yet
+    void        Preload(const std::string& fileName);
+    //! Loads an image, taking the preloaded one if possible
+    bool        LoadImage(const std::string& fileName, CImage& image);
+    //! Frees all images preloaded and not used
+    void        Flush();
+
+    //! Sets the receiver of the loading progress; \c nullptr for none
+    void        SetProgress(CLoadingProgress* progress);
+
+protected:
+    //! Entry point of worker threads
+    static int  WorkerThread(void* data);
+    //! Decodes queued files until the loader is destroyed
+    void        WorkerLoop();
+    //! Starts the worker threads
+    void        StartThreads();
+
+protected:
+    //! SDL threads and synchronization
+    ImageLoaderPrivate* m_private;
+    //! Receiver of the loading progress
+    CLoadingProgress*   m_progress;
+
+    //! Preloaded images, by file name
+    std::map<std::string, PreloadedImage> m_images;
+    //! Files waiting for a worker thread
+    std::deque<std::string> m_queue;
+    //! Number of files being decoded
+    int         m_busy;
+    //! Number of files preloaded since the last Flush()
+    int         m_total;
+    //! Number of preloaded images used since the last Flush()
+    int         m_used;
+    //! Whether worker threads must exit
+    bool        m_quit;
+};
+
+
+} // namespace Gfx
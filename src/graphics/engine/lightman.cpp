@@ -26,6 +26,7 @@
 #include "math/geometry.h"
 
 
+#include <algorithm>
 #include <cmath>
 
 
@@ -74,6 +75,8 @@ DynamicLight::DynamicLight()
     used = enabled = false;
     priority = LIGHT_PRI_LOW;
     includeType = excludeType = ENG_OBJTYPE_NULL;
+    range = -1.0f;
+    brightness = 0.0f;
 }
 
 
@@ -87,6 +90,7 @@ CLightManager::CLightManager(CInstanceManager* iMan, CEngine* engine)
     m_engine = engine;
 
     m_time = 0.0f;
+    m_deviceDirty = true;
 }
 
 CLightManager::~CLightManager()
@@ -102,11 +106,13 @@ void CLightManager::SetDevice(CDevice* device)
 {
     m_device = device;
     m_lightMap = std::vector<int>(m_device->GetMaxLightCount(), -1);
+    m_deviceDirty = true;
 }
 
 void CLightManager::FlushLights()
 {
     m_dynLights.clear();
+    m_activeLights.clear();
 }
 
 /** Returns the index of light created. */
@@ -149,6 +155,7 @@ bool CLightManager::DeleteLight(int lightRank)
         return false;
 
     m_dynLights[lightRank].used = false;
+    m_deviceDirty = true;  // the rank may be used again
     return true;
 }
 
@@ -163,6 +170,7 @@ bool CLightManager::SetLight(int lightRank, const Light &light)
     m_dynLights[lightRank].colorGreen.Init(m_dynLights[lightRank].light.diffuse.g);
     m_dynLights[lightRank].colorBlue.Init(m_dynLights[lightRank].light.diffuse.b);
 
+    m_deviceDirty = true;
     return true;
 }
 
@@ -358,6 +366,8 @@ void CLightManager::UpdateProgression(float rTime)
 
 void CLightManager::UpdateLights()
 {
+    m_activeLights.clear();
+
     for (int i = 0; i < static_cast<int>( m_dynLights.size() ); i++)
     {
         if (! m_dynLights[i].used)
@@ -378,6 +388,12 @@ void CLightManager::UpdateLights()
 
             value = m_dynLights[i].colorBlue.current * m_dynLights[i].intensity.current;
             m_dynLights[i].light.diffuse.b = value;
+
+            const Color& diffuse = m_dynLights[i].light.diffuse;
+            m_dynLights[i].brightness = Math::Max(diffuse.r, diffuse.g, diffuse.b);
+            m_dynLights[i].range = GetLightRange(m_dynLights[i]);
+
+            m_activeLights.push_back(i);
         }
         else
         {
@@ -386,80 +402,135 @@ void CLightManager::UpdateLights()
             m_dynLights[i].light.diffuse.b = 0.0f;
         }
     }
+
+    // Colors changed, lights in the device are out of date
+    m_deviceDirty = true;
+}
+
+/**
+ * The range is the distance at which the attenuated light falls below LIGHT_CULL_THRESHOLD.
+ * Directional lights and lights with constant attenuation only have unlimited range.
+ */
+float CLightManager::GetLightRange(const DynamicLight &dynLight)
+{
+    const Light& light = dynLight.light;
+
+    if (light.type == LIGHT_DIRECTIONAL)
+        return -1.0f;
+
+    // Solves attenuation2*d^2 + attenuation1*d + attenuation0 = brightness/threshold
+    float c = light.attenuation0 - dynLight.brightness / LIGHT_CULL_THRESHOLD;
+    if (c >= 0.0f)
+        return 0.0f;  // never bright enough
+
+    if (light.attenuation2 > 0.0f)
+    {
+        float delta = light.attenuation1*light.attenuation1 - 4.0f*light.attenuation2*c;
+        return (-light.attenuation1 + sqrtf(delta)) / (2.0f*light.attenuation2);
+    }
+
+    if (light.attenuation1 > 0.0f)
+        return -c / light.attenuation1;
+
+    return -1.0f;
 }
 
 void CLightManager::UpdateDeviceLights(EngineObjectType type)
 {
-    for (int i = 0; i < static_cast<int>( m_lightMap.size() ); ++i)
-        m_lightMap[i] = -1;
+    UpdateDeviceLights(type, Math::Vector(0.0f, 0.0f, 0.0f), -1.0f);
+}
+
+/**
+ * With negative \a radius, the position of the object is unknown and lights are chosen
+ * by priority and brightness only.
+ */
+void CLightManager::UpdateDeviceLights(EngineObjectType type, const Math::Vector &center, float radius)
+{
+    m_candidates.clear();
 
-    // High priority
-    for (int i = 0; i < static_cast<int>( m_dynLights.size() ); i++)
+    for (int i = 0; i < static_cast<int>( m_activeLights.size() ); i++)
     {
-        if (! m_dynLights[i].used)
+        int rank = m_activeLights[i];
+        const DynamicLight& dynLight = m_dynLights[rank];
+
+        if (! dynLight.used)
             continue;
-        if (! m_dynLights[i].enabled)
+        if (! dynLight.enabled)
             continue;
-        if (Math::IsZero(m_dynLights[i].intensity.current))
+
+        bool enabled = true;
+        if (dynLight.includeType != ENG_OBJTYPE_NULL)
+            enabled = (dynLight.includeType == type);
+
+        if (dynLight.excludeType != ENG_OBJTYPE_NULL)
+            enabled = (dynLight.excludeType != type);
+
+        if (! enabled)
             continue;
-        if (m_dynLights[i].priority == LIGHT_PRI_LOW)
+
+        // Distance from the light to the surface of the object
+        float distance = 0.0f;
+        if (radius >= 0.0f && dynLight.light.type != LIGHT_DIRECTIONAL)
+            distance = Math::Max(0.0f, Math::Distance(dynLight.light.position, center) - radius);
+
+        if (dynLight.range >= 0.0f && distance > dynLight.range)
             continue;
 
-        bool enabled = true;
-        if (m_dynLights[i].includeType != ENG_OBJTYPE_NULL)
-            enabled = (m_dynLights[i].includeType == type);
+        const Light& light = dynLight.light;
+        float attenuation = light.attenuation0 + light.attenuation1*distance +
+                            light.attenuation2*distance*distance;
+        if (attenuation <= 0.0f)
+            attenuation = 1.0f;
+
+        LightCandidate candidate;
+        candidate.rank  = rank;
+        candidate.high  = (dynLight.priority == LIGHT_PRI_HIGH);
+        candidate.score = dynLight.brightness / attenuation /
+                          (1.0f + distance / LIGHT_RELEVANCE_DISTANCE);
+        m_candidates.push_back(candidate);
+    }
 
-        if (m_dynLights[i].excludeType != ENG_OBJTYPE_NULL)
-            enabled = (m_dynLights[i].excludeType != type);
+    int slotCount = m_lightMap.size();
+    int count = m_candidates.size();
+    if (count > slotCount)
+        count = slotCount;
+    std::partial_sort(m_candidates.begin(), m_candidates.begin() + count, m_candidates.end());
 
-        if (enabled)
+    // Lights already in the device keep their slots
+    m_newLightMap.assign(slotCount, -1);
+    for (int j = 0; j < slotCount; j++)
+    {
+        for (int c = 0; c < count; c++)
         {
-            for (int j = 0; j < static_cast<int>( m_lightMap.size() ); ++j)
+            if (m_candidates[c].rank == m_lightMap[j])
             {
-                if (m_lightMap[j] == -1)
-                {
-                    m_lightMap[j] = i;
-                    break;
-                }
+                m_newLightMap[j] = m_lightMap[j];
+                m_candidates[c].rank = -1;  // placed
+                break;
             }
         }
     }
 
-    // Low priority
-    for (int i = 0; i < static_cast<int>( m_dynLights.size() ); i++)
+    int free = 0;
+    for (int c = 0; c < count; c++)
     {
-        if (! m_dynLights[i].used)
-            continue;
-        if (! m_dynLights[i].enabled)
-            continue;
-        if (m_dynLights[i].intensity.current == 0.0f)
-            continue;
-        if (m_dynLights[i].priority == LIGHT_PRI_HIGH)
+        if (m_candidates[c].rank == -1)
             continue;
 
-        bool enabled = true;
-        if (m_dynLights[i].includeType != ENG_OBJTYPE_NULL)
-            enabled = (m_dynLights[i].includeType == type);
-
-        if (m_dynLights[i].excludeType != ENG_OBJTYPE_NULL)
-            enabled = (m_dynLights[i].excludeType != type);
+        while (m_newLightMap[free] != -1)
+            free++;
 
-        if (enabled)
-        {
-            for (int j = 0; j < static_cast<int>( m_lightMap.size() ); ++j)
-            {
-                if (m_lightMap[j] == -1)
-                {
-                    m_lightMap[j] = i;
-                    break;
-                }
-            }
-        }
+        m_newLightMap[free] = m_candidates[c].rank;
     }
 
-    for (int i = 0; i < static_cast<int>( m_lightMap.size() ); ++i)
+    for (int i = 0; i < slotCount; ++i)
     {
-        int rank = m_lightMap[i];
+        int rank = m_newLightMap[i];
+        if (!m_deviceDirty && rank == m_lightMap[i])
+            continue;
+
+        m_lightMap[i] = rank;
+
         if (rank != -1)
         {
             m_device->SetLight(i, m_dynLights[rank].light);
@@ -470,6 +541,8 @@ void CLightManager::UpdateDeviceLights(EngineObjectType type)
             m_device->SetLightEnabled(i, false);
         }
     }
+
+    m_deviceDirty = false;
 }
 
 
@@ -33,6 +33,11 @@
 // Graphics module namespace
 namespace Gfx {
 
+//! Light weaker than this (after attenuation) is considered not to light anything
+const float LIGHT_CULL_THRESHOLD = 1.0f/256.0f;
+//! Distance at which a light counts half as much when choosing the lights of an object
+const float LIGHT_RELEVANCE_DISTANCE = 50.0f;
+
 /**
  * \struct LightProgression
  * \brief Describes the progression of light parameters change
@@ -109,9 +114,37 @@ struct DynamicLight
     //! Type of objects excluded from lighting with this light; if ENG_OBJTYPE_NULL is used, it is ignored
     EngineObjectType excludeType;
 
+    //! Radius of the sphere around the position lit by the light; negative if unlimited
+    float range;
+    //! Brightness of the light, from its current diffuse color
+    float brightness;
+
     DynamicLight();
 };
 
+/**
+ * \struct LightCandidate
+ * \brief Light which may be used for the object being drawn
+ */
+struct LightCandidate
+{
+    //! Index of dynamic light
+    int   rank;
+    //! If true, the light has high priority
+    bool  high;
+    //! Relevance of the light for the object
+    float score;
+
+    //! Order of choice: high priority first, then the most relevant
+    bool operator<(const LightCandidate& other) const
+    {
+        if (high != other.high)
+            return high;
+
+        return score > other.score;
+    }
+};
+
 /**
  * \class CLightManager
  * \brief Manager for dynamic lights in 3D scene
@@ -124,6 +157,11 @@ struct DynamicLight
  * updating the models with new values, while only one function, UpdateDeviceLights(), performs the actual
  * synchronization to the device. It allocates device's light slots as necessary, with two priority levels
  * for lights.
+ *
+ * When the object being drawn is known, the lights are chosen for it: lights with limited range
+ * (see DynamicLight::range) that cannot reach it are skipped and the others are ranked by their
+ * brightness at the object's distance. A light keeps its device slot while it stays selected,
+ * and the device is only updated for the slots that changed.
  */
 class CLightManager
 {
@@ -187,8 +225,12 @@ public:
     void            UpdateLights();
     //! Enables or disables dynamic lights affecting the given object type
     void            UpdateDeviceLights(EngineObjectType type);
+    //! Enables the dynamic lights most relevant for an object of given type and bounding sphere
+    void            UpdateDeviceLights(EngineObjectType type, const Math::Vector &center, float radius);
 
 protected:
+    //! Computes the range of a light, from its attenuation
+    float           GetLightRange(const DynamicLight &dynLight);
     CInstanceManager* m_iMan;
     CEngine*          m_engine;
     CDevice*          m_device;
@@ -199,6 +241,14 @@ protected:
     std::vector<DynamicLight> m_dynLights;
     //! Map of current light allotment: graphics light -> dynamic light
     std::vector<int>  m_lightMap;
+    //! Lights which may be enabled in the current frame
+    std::vector<int>  m_activeLights;
+    //! Lights considered for the object being drawn
+    std::vector<LightCandidate> m_candidates;
+    //! Map of light allotment being computed
+    std::vector<int>  m_newLightMap;
+    //! If true, lights in the device must all be set again
+    bool              m_deviceDirty;
 };
 
 }; // namespace Gfx
@@ -24,6 +24,7 @@
 #include "common/stringutils.h"
 
 #include "graphics/engine/engine.h"
+#include "graphics/engine/modelmanager.h"
 
 #include "math/geometry.h"
 
@@ -330,6 +331,8 @@ CModelFile::CModelFile(CInstanceManager* iMan)
     m_engine = static_cast<CEngine*>(m_iMan->SearchInstance(CLASS_ENGINE));
 #endif
 
+    m_model = nullptr;
+
     m_triangles.reserve(TRIANGLE_PREALLOCATE_COUNT);
 }
 
@@ -450,6 +453,15 @@ struct OldModelTriangle3
 bool CModelFile::ReadModel(const std::string& fileName)
 {
     m_triangles.clear();
+    m_model = nullptr;
+
+#ifndef MODELFILE_NO_ENGINE
+    if (CModelManager::IsCreated())
+    {
+        m_model = CModelManager::GetInstancePointer()->LoadModel(fileName, false);
+        return m_model != nullptr;
+    }
+#endif
 
     std::ifstream stream;
     stream.open(fileName.c_str(), std::ios_base::in | std::ios_base::binary);
@@ -465,6 +477,7 @@ bool CModelFile::ReadModel(const std::string& fileName)
 bool CModelFile::ReadModel(std::istream& stream)
 {
     m_triangles.clear();
+    m_model = nullptr;
 
     OldModelHeader header;
 
@@ -674,6 +687,8 @@ bool CModelFile::WriteModel(const std::string& fileName)
 
 bool CModelFile::WriteModel(std::ostream& stream)
 {
+    DetachModel();
+
     if (m_triangles.size() == 0)
     {
         GetLogger()->Error("Empty model\n");
@@ -818,6 +833,7 @@ bool CModelFile::ReadTextModel(const std::string& fileName)
 bool CModelFile::ReadTextModel(std::istream& stream)
 {
     m_triangles.clear();
+    m_model = nullptr;
 
     NewModelHeader header;
 
@@ -926,6 +942,8 @@ bool CModelFile::WriteTextModel(const std::string &fileName)
 
 bool CModelFile::WriteTextModel(std::ostream& stream)
 {
+    DetachModel();
+
     if (m_triangles.size() == 0)
     {
         GetLogger()->Error("Empty model\n");
@@ -1004,6 +1022,7 @@ bool CModelFile::ReadBinaryModel(const std::string& fileName)
 bool CModelFile::ReadBinaryModel(std::istream& stream)
 {
     m_triangles.clear();
+    m_model = nullptr;
 
     NewModelHeader header;
 
@@ -1099,6 +1118,8 @@ bool CModelFile::WriteBinaryModel(const std::string& fileName)
 
 bool CModelFile::WriteBinaryModel(std::ostream& stream)
 {
+    DetachModel();
+
     if (m_triangles.size() == 0)
     {
         GetLogger()->Error("Empty model\n");
@@ -1158,6 +1179,9 @@ bool CModelFile::WriteBinaryModel(std::ostream& stream)
 
 bool CModelFile::CreateEngineObject(int objRank)
 {
+    if (m_model != nullptr)
+        return CModelManager::GetInstancePointer()->AddModelReference(m_model, objRank);
+
     std::vector<VertexTex2> vs(3, VertexTex2());
 
     float limit[2];
@@ -1225,6 +1249,21 @@ bool CModelFile::CreateEngineObject(int objRank)
 
 void CModelFile::Mirror()
 {
+#ifndef MODELFILE_NO_ENGINE
+    if (m_model != nullptr)
+    {
+        // The mirrored model is cached on its own
+        const ModelInfo* mirrored = CModelManager::GetInstancePointer()->LoadModel(m_model->fileName, !m_model->mirrored);
+        if (mirrored != nullptr)
+        {
+            m_model = mirrored;
+            return;
+        }
+
+        DetachModel();
+    }
+#endif
+
     for (int i = 0; i < static_cast<int>( m_triangles.size() ); i++)
     {
         VertexTex2  t = m_triangles[i].p1;
@@ -1243,31 +1282,45 @@ void CModelFile::Mirror()
 
 const std::vector<ModelTriangle>& CModelFile::GetTriangles()
 {
+    if (m_model != nullptr)
+        return m_model->triangles;
+
     return m_triangles;
 }
 
 int CModelFile::GetTriangleCount()
 {
-    return m_triangles.size();
+    return GetTriangles().size();
+}
+
+void CModelFile::DetachModel()
+{
+    if (m_model == nullptr)
+        return;
+
+    m_triangles = m_model->triangles;
+    m_model = nullptr;
 }
 
 float CModelFile::GetHeight(Math::Vector pos)
 {
+    const std::vector<ModelTriangle>& triangles = GetTriangles();
+
     float limit = 5.0f;
 
-    for (int i = 0; i < static_cast<int>( m_triangles.size() ); i++)
+    for (int i = 0; i < static_cast<int>( triangles.size() ); i++)
     {
-        if ( fabs(pos.x - m_triangles[i].p1.coord.x) < limit &&
-             fabs(pos.z - m_triangles[i].p1.coord.z) < limit )
-            return m_triangles[i].p1.coord.y;
+        if ( fabs(pos.x - triangles[i].p1.coord.x) < limit &&
+             fabs(pos.z - triangles[i].p1.coord.z) < limit )
+            return triangles[i].p1.coord.y;
 
-        if ( fabs(pos.x - m_triangles[i].p2.coord.x) < limit &&
-             fabs(pos.z - m_triangles[i].p2.coord.z) < limit )
-            return m_triangles[i].p2.coord.y;
+        if ( fabs(pos.x - triangles[i].p2.coord.x) < limit &&
+             fabs(pos.z - triangles[i].p2.coord.z) < limit )
+            return triangles[i].p2.coord.y;
 
-        if ( fabs(pos.x - m_triangles[i].p3.coord.x) < limit &&
-             fabs(pos.z - m_triangles[i].p3.coord.z) < limit )
-            return m_triangles[i].p3.coord.y;
+        if ( fabs(pos.x - triangles[i].p3.coord.x) < limit &&
+             fabs(pos.z - triangles[i].p3.coord.z) < limit )
+            return triangles[i].p3.coord.y;
     }
 
     return 0.0f;
@@ -1275,6 +1328,8 @@ float CModelFile::GetHeight(Math::Vector pos)
 
 void CModelFile::CreateTriangle(Math::Vector p1, Math::Vector p2, Math::Vector p3, float min, float max)
 {
+    DetachModel();
+
     ModelTriangle triangle;
 
     Math::Vector n = Math::NormalToPlane(p3, p2, p1);
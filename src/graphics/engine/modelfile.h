@@ -40,6 +40,7 @@ class CInstanceManager;
 namespace Gfx {
 
 class CEngine;
+struct ModelInfo;
 
 
 /**
@@ -125,7 +126,7 @@ public:
     //! Returns the number of triangles in model
     int                  GetTriangleCount();
 
-    //! Returns the triangle vector
+    //! Returns the triangle vector (own or of the cached model)
     const std::vector<ModelTriangle>& GetTriangles();
 
     //! Returns the height of model -- closest point to X and Z coords of \a pos
@@ -140,6 +141,8 @@ public:
 protected:
     //! Adds a triangle to the list
     void                 CreateTriangle(Math::Vector p1, Math::Vector p2, Math::Vector p3, float min, float max);
+    //! Copies the triangles of the cached model, to work on own triangles
+    void                 DetachModel();
 
 protected:
     CInstanceManager*    m_iMan;
@@ -147,6 +150,8 @@ protected:
 
     //! Model triangles
     std::vector<ModelTriangle> m_triangles;
+    //! Cached model used instead of own triangles (see CModelManager), nullptr if none
+    const ModelInfo*     m_model;
 };
 
 }; // namespace Gfx
@@ -0,0 +1,196 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+
+#include "graphics/engine/modelmanager.h"
+
+#include "common/logger.h"
+
+#include "graphics/engine/engine.h"
+
+#include <cstdio>
+#include <fstream>
+
+
+template<> Gfx::CModelManager* CSingleton<Gfx::CModelManager>::mInstance = nullptr;
+
+
+// Graphics module namespace
+namespace Gfx {
+
+
+CModelManager::CModelManager(CInstanceManager* iMan, CEngine* engine)
+{
+    m_iMan = iMan;
+    m_engine = engine;
+}
+
+CModelManager::~CModelManager()
+{
+}
+
+const ModelInfo* CModelManager::LoadModel(const std::string& fileName, bool mirrored)
+{
+    std::pair<std::string, bool> key(fileName, mirrored);
+
+    std::map<std::pair<std::string, bool>, ModelInfo>::iterator it = m_models.find(key);
+    if (it != m_models.end())
+        return &(*it).second;
+
+    std::ifstream stream;
+    stream.open(fileName.c_str(), std::ios_base::in | std::ios_base::binary);
+    if (!stream.good())
+    {
+        GetLogger()->Error("Could not open file '%s'\n", fileName.c_str());
+        return nullptr;
+    }
+
+    CModelFile modelFile(m_iMan);
+    if (! modelFile.ReadModel(stream))
+    {
+        GetLogger()->Error("Could not read model '%s'\n", fileName.c_str());
+        return nullptr;
+    }
+
+    if (mirrored)
+        modelFile.Mirror();
+
+    ModelInfo& model = m_models[key];
+    model.fileName = fileName;
+    model.mirrored = mirrored;
+    model.triangles = modelFile.GetTriangles();
+
+    GetLogger()->Trace("Model '%s' cached (%d triangles)\n", fileName.c_str(),
+                       static_cast<int>( model.triangles.size() ));
+
+    return &model;
+}
+
+void CModelManager::CreateParts(ModelInfo& model)
+{
+    model.partsCreated = true;
+
+    std::vector< std::vector<VertexTex2> > vertices;
+
+    for (int i = 0; i < static_cast<int>( model.triangles.size() ); i++)
+    {
+        const ModelTriangle& t = model.triangles[i];
+
+        int p = 0;
+        for ( ; p < static_cast<int>( model.parts.size() ); p++)
+        {
+            const ModelPart& part = model.parts[p];
+            if ( part.material == t.material && part.state == t.state &&
+                 part.tex1Name == t.tex1Name && part.tex2Name == t.tex2Name &&
+                 part.variableTex2 == t.variableTex2 &&
+                 part.min == t.min && part.max == t.max )
+                break;
+        }
+
+        if (p == static_cast<int>( model.parts.size() ))
+        {
+            ModelPart part;
+            part.material     = t.material;
+            part.state        = t.state;
+            part.tex1Name     = t.tex1Name;
+            part.tex2Name     = t.tex2Name;
+            part.variableTex2 = t.variableTex2;
+            part.min          = t.min;
+            part.max          = t.max;
+            part.meshRank     = -1;
+            model.parts.push_back(part);
+            vertices.push_back(std::vector<VertexTex2>());
+        }
+
+        vertices[p].push_back(t.p1);
+        vertices[p].push_back(t.p2);
+        vertices[p].push_back(t.p3);
+    }
+
+    for (int p = 0; p < static_cast<int>( model.parts.size() ); p++)
+        model.parts[p].meshRank = m_engine->CreateMesh(ENG_TRIANGLE_TYPE_TRIANGLES, vertices[p]);
+}
+
+bool CModelManager::AddModelReference(const ModelInfo* model, int objRank)
+{
+    if (model == nullptr)
+        return false;
+
+    // Parts are made on first use only, as the cache is read-only for everyone else
+    ModelInfo& info = m_models[std::make_pair(model->fileName, model->mirrored)];
+    if (! info.partsCreated)
+        CreateParts(info);
+
+    float limit[2];
+    limit[0] = m_engine->GetLimitLOD(0);  // frontier AB as config
+    limit[1] = m_engine->GetLimitLOD(1);  // frontier BC as config
+
+    for (int i = 0; i < static_cast<int>( info.parts.size() ); i++)
+    {
+        const ModelPart& part = info.parts[i];
+
+        float min = part.min;
+        float max = part.max;
+
+        // Standard frontiers -> config
+        if (min == 0.0f && max == 100.0f)  // resolution A ?
+        {
+            max = limit[0];
+        }
+        else if (min == 100.0f && max == 200.0f)  // resolution B ?
+        {
+            min = limit[0];
+            max = limit[1];
+        }
+        else if (min == 200.0f && max == 1000000.0f)  // resolution C ?
+        {
+            min = limit[1];
+        }
+
+        int state = part.state;
+        std::string tex2Name = part.tex2Name;
+
+        if (part.variableTex2)
+        {
+            int texNum = m_engine->GetSecondTexture();
+
+            if (texNum >= 1 && texNum <= 10)
+                state |= ENG_RSTATE_DUAL_BLACK;
+
+            if (texNum >= 11 && texNum <= 20)
+                state |= ENG_RSTATE_DUAL_WHITE;
+
+            char name[20] = { 0 };
+            sprintf(name, "dirty%.2d.png", texNum);
+            tex2Name = name;
+        }
+
+        bool ok = m_engine->AddMeshReference(objRank, part.meshRank, part.material, state,
+                                             part.tex1Name, tex2Name, min, max);
+        if (!ok)
+            return false;
+    }
+
+    return true;
+}
+
+int CModelManager::GetModelCount()
+{
+    return m_models.size();
+}
+
+
+} // namespace Gfx
@@ -0,0 +1,129 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+/**
+ * \file graphics/engine/modelmanager.h
+ * \brief Cache of loaded models - CModelManager class
+ */
+
+#pragma once
+
+
+#include "common/singleton.h"
+
+#include "graphics/core/material.h"
+#include "graphics/engine/modelfile.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+class CInstanceManager;
+
+
+// Graphics module namespace
+namespace Gfx {
+
+class CEngine;
+
+
+/**
+ * \struct ModelPart
+ * \brief Triangles of a model sharing material, state, textures and LOD
+ *
+ * Each part becomes one shared mesh in the engine (see CEngine::CreateMesh()).
+ */
+struct ModelPart
+{
+    Material        material;
+    int             state;
+    std::string     tex1Name;
+    std::string     tex2Name;
+    //! If true, 2nd texture will be taken from current engine setting
+    bool            variableTex2;
+    //! LOD thresholds, as in the model file
+    float           min;
+    float           max;
+    //! Rank of the shared mesh in the engine
+    int             meshRank;
+};
+
+/**
+ * \struct ModelInfo
+ * \brief Model read from file, shared by all instances
+ */
+struct ModelInfo
+{
+    //! Name of the file
+    std::string                 fileName;
+    //! If true, the model is mirrored along the Z axis
+    bool                        mirrored;
+    //! Model triangles
+    std::vector<ModelTriangle>  triangles;
+    //! Parts of the model, made on first instance
+    std::vector<ModelPart>      parts;
+    //! If true, the parts and their meshes were created
+    bool                        partsCreated;
+
+    ModelInfo()
+    {
+        mirrored = false;
+        partsCreated = false;
+    }
+};
+
+
+/**
+ * \class CModelManager
+ * \brief Cache of models read from files
+ *
+ * Each model file is read only once, for each mirror flag, and kept until
+ * the engine is destroyed. Engine objects created from a cached model
+ * reference the shared meshes of its parts instead of getting a copy of
+ * the triangles; only transform and state remain per object.
+ *
+ * CModelFile uses the cache transparently in ReadModel(), Mirror() and
+ * CreateEngineObject() when the manager exists.
+ */
+class CModelManager : public CSingleton<CModelManager>
+{
+public:
+    CModelManager(CInstanceManager* iMan, CEngine* engine);
+    ~CModelManager();
+
+    //! Returns the model read from given file, reading the file only the first time
+    const ModelInfo*    LoadModel(const std::string& fileName, bool mirrored);
+    //! Adds an instance of a loaded model to the engine object
+    bool                AddModelReference(const ModelInfo* model, int objRank);
+
+    //! Returns the number of models in the cache
+    int                 GetModelCount();
+
+protected:
+    //! Groups the triangles of a model in parts and creates their meshes
+    void                CreateParts(ModelInfo& model);
+
+protected:
+    CInstanceManager*   m_iMan;
+    CEngine*            m_engine;
+
+    //! Cached models, by file name and mirror flag
+    std::map<std::pair<std::string, bool>, ModelInfo> m_models;
+};
+
+
+}; // namespace Gfx
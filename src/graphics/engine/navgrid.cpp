@@ -0,0 +1,895 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+
+#include "graphics/engine/navgrid.h"
+
+#include "common/iman.h"
+#include "graphics/engine/terrain.h"
+#include "graphics/engine/water.h"
+#include "math/geometry.h"
+#include "object/object.h"
+
+#include <algorithm>
+
+
+// Graphics module namespace
+namespace Gfx {
+
+//! Half size of the grid (in world units)
+const float NAV_GRID_HALF = NAV_CELL_SIZE*NAV_GRID_SIZE/2.0f;
+//! Margin added around crash spheres
+const float NAV_SPHERE_MARGIN = 4.0f;
+//! Sampling step of straight lines
+const float NAV_LINE_STEP = NAV_CELL_SIZE*0.5f;
+//! Smallest margin of the search box around start and goal (in cells)
+const int   NAV_SEARCH_MARGIN = 20;
+
+// Flags of cells in CNavSearch
+const unsigned char NAV_KNOWN   = 1;    // walkable state computed
+const unsigned char NAV_BLOCKED = 2;    // cell can't be crossed
+const unsigned char NAV_OPENED  = 4;    // cell was added to the open list
+const unsigned char NAV_CLOSED  = 8;    // cell was expanded
+
+
+bool NavPathKey::operator<(const NavPathKey& other) const
+{
+    if (start != other.start) return start < other.start;
+    if (goal != other.goal) return goal < other.goal;
+    if (slopeLimit != other.slopeLimit) return slopeLimit < other.slopeLimit;
+    if (radius != other.radius) return radius < other.radius;
+    if (goalRadius != other.goalRadius) return goalRadius < other.goalRadius;
+    if (altitude != other.altitude) return altitude < other.altitude;
+    if (fly != other.fly) return fly < other.fly;
+    return acceptWater < other.acceptWater;
+}
+
+
+CNavGrid::CNavGrid(CInstanceManager* iMan, CTerrain* terrain)
+{
+    m_iMan    = iMan;
+    m_terrain = terrain;
+    m_water   = static_cast<CWater*>( m_iMan->SearchInstance(CLASS_WATER) );
+
+    m_height.resize(NAV_GRID_SIZE*NAV_GRID_SIZE, 0.0f);
+    m_slope.resize(NAV_GRID_SIZE*NAV_GRID_SIZE, 0.0f);
+    m_lowest.resize(NAV_GRID_SIZE*NAV_GRID_SIZE, 0.0f);
+    m_terrainValid.resize(NAV_GRID_SIZE*NAV_GRID_SIZE, 0);
+    m_ground.resize(NAV_GRID_SIZE*NAV_GRID_SIZE, 0);
+    m_air.resize(NAV_GRID_SIZE*NAV_GRID_SIZE, 0);
+    m_airAltitude = -1.0f;
+}
+
+CNavGrid::~CNavGrid()
+{
+}
+
+void CNavGrid::Flush()
+{
+    std::fill(m_terrainValid.begin(), m_terrainValid.end(), 0);
+    std::fill(m_ground.begin(), m_ground.end(), 0);
+    std::fill(m_air.begin(), m_air.end(), 0);
+    m_airAltitude = -1.0f;
+
+    m_objects.clear();
+    m_dirty.clear();
+    m_pathCache.clear();
+}
+
+void CNavGrid::InvalidateTerrain(const Math::Vector& min, const Math::Vector& max)
+{
+    int minX = Math::Max(GetCellX(min)-1, 0);
+    int minY = Math::Max(GetCellY(min)-1, 0);
+    int maxX = Math::Min(GetCellX(max)+1, NAV_GRID_SIZE-1);
+    int maxY = Math::Min(GetCellY(max)+1, NAV_GRID_SIZE-1);
+
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int x = minX; x <= maxX; x++)
+            m_terrainValid[x+y*NAV_GRID_SIZE] = 0;
+    }
+
+    // The floor below objects changed too
+    InvalidateObjects();
+    m_pathCache.clear();
+}
+
+void CNavGrid::InvalidateTerrain()
+{
+    std::fill(m_terrainValid.begin(), m_terrainValid.end(), 0);
+
+    InvalidateObjects();
+    m_pathCache.clear();
+}
+
+void CNavGrid::AddObject(CObject* object)
+{
+    if (m_objects.find(object) != m_objects.end())
+        return;
+
+    m_objects[object] = NavObject();
+    m_dirty.push_back(object);
+}
+
+void CNavGrid::DeleteObject(CObject* object)
+{
+    std::map<CObject*, NavObject>::iterator it = m_objects.find(object);
+    if (it == m_objects.end())
+        return;
+
+    StampCircles((*it).second, -1);
+    m_objects.erase(it);
+}
+
+void CNavGrid::UpdateObject(CObject* object)
+{
+    std::map<CObject*, NavObject>::iterator it = m_objects.find(object);
+    if (it == m_objects.end())
+        return;
+
+    if ((*it).second.dirty)
+        return;
+
+    (*it).second.dirty = true;
+    m_dirty.push_back(object);
+}
+
+void CNavGrid::InvalidateObjects()
+{
+    m_dirty.clear();
+
+    std::map<CObject*, NavObject>::iterator it;
+    for (it = m_objects.begin(); it != m_objects.end(); ++it)
+    {
+        (*it).second.dirty = true;
+        m_dirty.push_back((*it).first);
+    }
+}
+
+void CNavGrid::Refresh()
+{
+    for (int i = 0; i < static_cast<int>( m_dirty.size() ); i++)
+    {
+        // The object may have been deleted since
+        std::map<CObject*, NavObject>::iterator it = m_objects.find(m_dirty[i]);
+        if (it == m_objects.end())
+            continue;
+
+        NavObject& nav = (*it).second;
+        if (! nav.dirty)
+            continue;
+
+        StampCircles(nav, -1);
+        ComputeCircles((*it).first, nav);
+        StampCircles(nav, 1);
+        nav.dirty = false;
+    }
+    m_dirty.clear();
+}
+
+void CNavGrid::ComputeCircles(CObject* object, NavObject& nav)
+{
+    nav.circles.clear();
+
+    // Carried objects are not obstacles
+    if (object->GetTruck() != 0)
+        return;
+
+    float floor = m_terrain->GetFloorLevel(object->GetPosition(0), false);
+
+    Math::Vector pos;
+    float radius = 0.0f;
+    int j = 0;
+    while (object->GetCrashSphere(j++, pos, radius))
+    {
+        NavCircle circle;
+        circle.x = GetCellX(pos);
+        circle.y = GetCellY(pos);
+        circle.height = pos.y;
+        circle.sphereRadius = radius;
+        circle.floor = floor;
+
+        if (object->GetType() == OBJECT_PARA)  radius -= 2.0f;
+        circle.radius = (radius+NAV_SPHERE_MARGIN)/NAV_CELL_SIZE;
+
+        circle.ground = false;
+        circle.air = false;
+        nav.circles.push_back(circle);
+    }
+}
+
+void CNavGrid::StampCircles(NavObject& nav, int delta)
+{
+    for (int i = 0; i < static_cast<int>( nav.circles.size() ); i++)
+    {
+        NavCircle& circle = nav.circles[i];
+
+        if (delta > 0)
+        {
+            circle.ground = (circle.height-circle.sphereRadius <= circle.floor+8.0f);
+
+            float h = circle.floor+m_airAltitude;
+            circle.air = m_airAltitude >= 0.0f &&
+                         circle.height-circle.sphereRadius <= h+8.0f &&
+                         circle.height+circle.sphereRadius >= h-8.0f;
+        }
+
+        if (circle.ground)  StampCircle(m_ground, circle, delta);
+        if (circle.air)     StampCircle(m_air, circle, delta);
+
+        if (delta < 0)
+        {
+            circle.ground = false;
+            circle.air = false;
+        }
+    }
+}
+
+void CNavGrid::StampCircle(std::vector<unsigned short>& layer, const NavCircle& circle, int delta)
+{
+    int r = static_cast<int>(circle.radius);
+
+    for (int y = circle.y-r; y <= circle.y+r; y++)
+    {
+        if (y < 0 || y >= NAV_GRID_SIZE)  continue;
+
+        for (int x = circle.x-r; x <= circle.x+r; x++)
+        {
+            if (x < 0 || x >= NAV_GRID_SIZE)  continue;
+
+            float d = Math::Point(static_cast<float>(x-circle.x), static_cast<float>(y-circle.y)).Length();
+            if (d > circle.radius)  continue;
+
+            layer[x+y*NAV_GRID_SIZE] += delta;
+        }
+    }
+}
+
+void CNavGrid::SetAirAltitude(float altitude)
+{
+    if (altitude == m_airAltitude)
+        return;
+
+    std::fill(m_air.begin(), m_air.end(), 0);
+    m_airAltitude = altitude;
+
+    std::map<CObject*, NavObject>::iterator it;
+    for (it = m_objects.begin(); it != m_objects.end(); ++it)
+    {
+        std::vector<NavCircle>& circles = (*it).second.circles;
+        for (int i = 0; i < static_cast<int>( circles.size() ); i++)
+        {
+            NavCircle& circle = circles[i];
+            float h = circle.floor+m_airAltitude;
+            circle.air = circle.height-circle.sphereRadius <= h+8.0f &&
+                         circle.height+circle.sphereRadius >= h-8.0f;
+
+            if (circle.air)  StampCircle(m_air, circle, 1);
+        }
+    }
+}
+
+void CNavGrid::BeginQuery(const NavAgent& agent)
+{
+    Refresh();
+
+    if (agent.altitude > 0.0f)
+        SetAirAltitude(agent.altitude);
+
+    // The robot and its target are not obstacles
+    std::map<CObject*, NavObject>::iterator it;
+    it = m_objects.find(agent.object);
+    if (it != m_objects.end())  StampCircles((*it).second, -1);
+    it = m_objects.find(agent.target);
+    if (it != m_objects.end())  StampCircles((*it).second, -1);
+
+    m_dilateX.clear();
+    m_dilateY.clear();
+    // Cells partly covered by the robot count too: the radius is rounded up
+    float r = agent.radius/NAV_CELL_SIZE;
+    int n = static_cast<int>(ceilf(r));
+    for (int y = -n; y <= n; y++)
+    {
+        for (int x = -n; x <= n; x++)
+        {
+            if (Math::Point(static_cast<float>(x), static_cast<float>(y)).Length() > r+0.5f)  continue;
+            m_dilateX.push_back(x);
+            m_dilateY.push_back(y);
+        }
+    }
+}
+
+void CNavGrid::EndQuery(const NavAgent& agent)
+{
+    std::map<CObject*, NavObject>::iterator it;
+    it = m_objects.find(agent.object);
+    if (it != m_objects.end())  StampCircles((*it).second, 1);
+    it = m_objects.find(agent.target);
+    if (it != m_objects.end())  StampCircles((*it).second, 1);
+}
+
+bool CNavGrid::IsBlocked(const NavAgent& agent, int x, int y)
+{
+    if (x < 0 || x >= NAV_GRID_SIZE ||
+        y < 0 || y >= NAV_GRID_SIZE)  return false;
+
+    if (agent.freeRadius > 0.0f)
+    {
+        int fx = GetCellX(agent.freePos);
+        int fy = GetCellY(agent.freePos);
+        float d = Math::Point(static_cast<float>(x-fx), static_cast<float>(y-fy)).Length();
+        if (d <= agent.freeRadius/NAV_CELL_SIZE)  return false;
+    }
+
+    if (IsTerrainBlocked(agent, x, y))  return true;
+
+    const std::vector<unsigned short>& layer = agent.altitude > 0.0f ? m_air : m_ground;
+    for (int i = 0; i < static_cast<int>( m_dilateX.size() ); i++)
+    {
+        int cx = x+m_dilateX[i];
+        int cy = y+m_dilateY[i];
+        if (cx < 0 || cx >= NAV_GRID_SIZE ||
+            cy < 0 || cy >= NAV_GRID_SIZE)  continue;
+
+        if (layer[cx+cy*NAV_GRID_SIZE] != 0)  return true;
+    }
+
+    return false;
+}
+
+bool CNavGrid::IsTerrainBlocked(const NavAgent& agent, int x, int y)
+{
+    ReadTerrain(x, y);
+
+    if (agent.fly)
+        return m_height[x+y*NAV_GRID_SIZE] >= m_terrain->GetFlyingMaxHeight()-5.0f;
+
+    // Accepts that a robot is 50cm under water, for example Tropica 3,
+    // but keeps a cell free around deeper places
+    if (! agent.acceptWater)
+    {
+        ReadLowest(x, y);
+        if (m_lowest[x+y*NAV_GRID_SIZE] < m_water->GetLevel()-2.0f)  return true;
+    }
+
+    return m_slope[x+y*NAV_GRID_SIZE] > agent.slopeLimit;
+}
+
+void CNavGrid::ReadLowest(int x, int y)
+{
+    int i = x+y*NAV_GRID_SIZE;
+    if (m_terrainValid[i] == 2)
+        return;
+
+    float lowest = m_height[i];
+    static const int around[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+    for (int j = 0; j < 4; j++)
+    {
+        int cx = x+around[j][0];
+        int cy = y+around[j][1];
+        if (cx < 0 || cx >= NAV_GRID_SIZE ||
+            cy < 0 || cy >= NAV_GRID_SIZE)  continue;
+
+        ReadTerrain(cx, cy);
+        lowest = Math::Min(lowest, m_height[cx+cy*NAV_GRID_SIZE]);
+    }
+
+    m_lowest[i] = lowest;
+    m_terrainValid[i] = 2;
+}
+
+void CNavGrid::ReadTerrain(int x, int y)
+{
+    int i = x+y*NAV_GRID_SIZE;
+    if (m_terrainValid[i] != 0)
+        return;
+
+    Math::Vector p;
+    p.x = x*NAV_CELL_SIZE-NAV_GRID_HALF;
+    p.y = 0.0f;
+    p.z = y*NAV_CELL_SIZE-NAV_GRID_HALF;
+
+    m_height[i] = m_terrain->GetFloorLevel(p, true);
+    m_slope[i]  = m_terrain->GetFineSlope(p);
+    m_terrainValid[i] = 1;
+}
+
+bool CNavGrid::IsLineFree(const NavAgent& agent, const Math::Vector& start, const Math::Vector& goal)
+{
+    float dist = Math::DistanceProjected(start, goal);
+    if (dist == 0.0f)  return true;
+
+    Math::Vector inc;
+    inc.x = (goal.x-start.x)*NAV_LINE_STEP/dist;
+    inc.z = (goal.z-start.z)*NAV_LINE_STEP/dist;
+
+    Math::Vector pos = start;
+    int max = static_cast<int>(dist/NAV_LINE_STEP);
+    if (max == 0)  max = 1;
+    for (int i = 0; i < max; i++)
+    {
+        if (i == max-1)
+        {
+            pos = goal;  // tests the point of arrival
+        }
+        else
+        {
+            pos.x += inc.x;
+            pos.z += inc.z;
+        }
+
+        if (IsBlocked(agent, GetCellX(pos), GetCellY(pos)))  return false;
+    }
+    return true;
+}
+
+bool CNavGrid::TestPosition(const NavAgent& agent, const Math::Vector& pos)
+{
+    BeginQuery(agent);
+    bool blocked = IsBlocked(agent, GetCellX(pos), GetCellY(pos));
+    EndQuery(agent);
+    return blocked;
+}
+
+bool CNavGrid::TestLine(const NavAgent& agent, const Math::Vector& start, const Math::Vector& goal)
+{
+    BeginQuery(agent);
+    bool free = IsLineFree(agent, start, goal);
+    EndQuery(agent);
+    return free;
+}
+
+bool CNavGrid::GetCachedPath(const NavPathKey& key, std::vector<Math::Vector>& points)
+{
+    std::map<NavPathKey, std::vector<Math::Vector> >::iterator it = m_pathCache.find(key);
+    if (it == m_pathCache.end())
+        return false;
+
+    points = (*it).second;
+    return true;
+}
+
+void CNavGrid::AddCachedPath(const NavPathKey& key, const std::vector<Math::Vector>& points)
+{
+    if (static_cast<int>( m_pathCache.size() ) >= NAV_PATH_CACHE_SIZE)
+        m_pathCache.clear();
+
+    m_pathCache[key] = points;
+}
+
+int CNavGrid::GetCellX(const Math::Vector& pos)
+{
+    return static_cast<int>((pos.x+NAV_GRID_HALF)/NAV_CELL_SIZE);
+}
+
+int CNavGrid::GetCellY(const Math::Vector& pos)
+{
+    return static_cast<int>((pos.z+NAV_GRID_HALF)/NAV_CELL_SIZE);
+}
+
+Math::Vector CNavGrid::GetCellCenter(int x, int y)
+{
+    return Math::Vector((x+0.5f)*NAV_CELL_SIZE-NAV_GRID_HALF,
+                        0.0f,
+                        (y+0.5f)*NAV_CELL_SIZE-NAV_GRID_HALF);
+}
+
+
+CNavSearch::CNavSearch()
+{
+    m_grid = nullptr;
+    m_bDone = true;
+    m_goalRadius = 0.0f;
+    m_goalX = m_goalY = 0;
+    m_minX = m_minY = 0;
+    m_sizeX = m_sizeY = 0;
+    m_margin = 0;
+    m_tested = 0;
+}
+
+CNavSearch::~CNavSearch()
+{
+}
+
+void CNavSearch::Start(CNavGrid* grid, const NavAgent& agent, const Math::Vector& start,
+                       const Math::Vector& goal, float goalRadius)
+{
+    m_grid       = grid;
+    m_agent      = agent;
+    m_start      = start;
+    m_goal       = goal;
+    m_goalRadius = goalRadius;
+    m_goalX      = CNavGrid::GetCellX(goal);
+    m_goalY      = CNavGrid::GetCellY(goal);
+    m_bDone      = false;
+    m_path.clear();
+
+    int startX = CNavGrid::GetCellX(start);
+    int startY = CNavGrid::GetCellY(start);
+    if (startX < 0 || startX >= NAV_GRID_SIZE ||
+        startY < 0 || startY >= NAV_GRID_SIZE)
+    {
+        m_bDone = true;  // outside the grid
+        return;
+    }
+
+    // Box around start and goal, large enough to go round most obstacles
+    m_margin = Math::Max(abs(m_goalX-startX), abs(m_goalY-startY))/2;
+    m_margin = Math::Max(m_margin, NAV_SEARCH_MARGIN);
+
+    // Tries the path found last time from the same cell
+    std::vector<Math::Vector> points;
+    if (m_grid->GetCachedPath(GetKey(), points))
+    {
+        m_path.clear();
+        m_path.push_back(m_start);
+        for (int i = 0; i < static_cast<int>( points.size() ); i++)
+            m_path.push_back(points[i]);
+        m_path.push_back(GetFinalPoint(m_path.back()));
+
+        m_grid->BeginQuery(m_agent);
+        bool free = true;
+        for (int i = 0; i < static_cast<int>( m_path.size() )-1 && free; i++)
+            free = m_grid->IsLineFree(m_agent, m_path[i], m_path[i+1]);
+        m_grid->EndQuery(m_agent);
+
+        if (free)
+        {
+            m_bDone = true;
+            return;
+        }
+        m_path.clear();
+    }
+
+    StartBox();
+}
+
+void CNavSearch::StartBox()
+{
+    int startX = CNavGrid::GetCellX(m_start);
+    int startY = CNavGrid::GetCellY(m_start);
+
+    m_minX = Math::Max(Math::Min(startX, m_goalX)-m_margin, 0);
+    m_minY = Math::Max(Math::Min(startY, m_goalY)-m_margin, 0);
+    int maxX = Math::Min(Math::Max(startX, m_goalX)+m_margin, NAV_GRID_SIZE-1);
+    int maxY = Math::Min(Math::Max(startY, m_goalY)+m_margin, NAV_GRID_SIZE-1);
+    m_sizeX = maxX-m_minX+1;
+    m_sizeY = maxY-m_minY+1;
+
+    m_flags.assign(m_sizeX*m_sizeY, 0);
+    m_cost.assign(m_sizeX*m_sizeY, 0.0f);
+    m_parent.assign(m_sizeX*m_sizeY, -1);
+    m_open.clear();
+
+    int index = (startX-m_minX)+(startY-m_minY)*m_sizeX;
+    m_flags[index] |= NAV_OPENED;
+    NavNode node;
+    node.cost = 0.0f;
+    node.index = index;
+    m_open.push_back(node);
+}
+
+Error CNavSearch::Step(int budget, int maxPoints)
+{
+    if (m_bDone)
+        return m_path.empty() ? ERR_GOTO_IMPOSSIBLE : ERR_OK;
+
+    m_grid->BeginQuery(m_agent);
+
+    Error ret = ERR_CONTINUE;
+    m_tested = 0;
+    while (m_tested < budget)
+    {
+        if (m_open.empty())
+        {
+            if (m_sizeX < NAV_GRID_SIZE || m_sizeY < NAV_GRID_SIZE)
+            {
+                // Maybe the way round leaves the box: searches again in a larger one
+                m_margin *= 4;
+                StartBox();
+                break;
+            }
+
+            ret = ERR_GOTO_IMPOSSIBLE;
+            break;
+        }
+
+        std::pop_heap(m_open.begin(), m_open.end());
+        int index = m_open.back().index;
+        m_open.pop_back();
+
+        if (m_flags[index] & NAV_CLOSED)  continue;  // already expanded with a lower cost
+        m_flags[index] |= NAV_CLOSED;
+
+        if (IsGoal(m_minX+index%m_sizeX, m_minY+index/m_sizeX))
+        {
+            ret = BuildPath(index, maxPoints);
+            break;
+        }
+
+        Expand(index);
+    }
+
+    m_grid->EndQuery(m_agent);
+
+    if (ret != ERR_CONTINUE)
+    {
+        m_bDone = true;
+        m_open.clear();
+    }
+    return ret;
+}
+
+const std::vector<Math::Vector>& CNavSearch::GetPath()
+{
+    return m_path;
+}
+
+bool CNavSearch::IsWalkable(int x, int y)
+{
+    if (x < m_minX || x >= m_minX+m_sizeX ||
+        y < m_minY || y >= m_minY+m_sizeY)  return false;
+
+    m_tested ++;
+
+    unsigned char& flags = m_flags[(x-m_minX)+(y-m_minY)*m_sizeX];
+    if (! (flags & NAV_KNOWN))
+    {
+        flags |= NAV_KNOWN;
+        if (m_grid->IsBlocked(m_agent, x, y))  flags |= NAV_BLOCKED;
+    }
+    return ! (flags & NAV_BLOCKED);
+}
+
+bool CNavSearch::IsGoal(int x, int y)
+{
+    if (m_goalRadius == 0.0f)
+        return x == m_goalX && y == m_goalY;
+
+    return Math::DistanceProjected(CNavGrid::GetCellCenter(x, y), m_goal) <= m_goalRadius;
+}
+
+bool CNavSearch::JumpStraight(int x, int y, int dx, int dy, int &jx, int &jy)
+{
+    while (IsWalkable(x, y))
+    {
+        if (IsGoal(x, y))  break;
+
+        // Forced neighbours: an obstacle beside ends behind us
+        if (dx != 0)
+        {
+            if ( (IsWalkable(x, y-1) && !IsWalkable(x-dx, y-1)) ||
+                 (IsWalkable(x, y+1) && !IsWalkable(x-dx, y+1)) )  break;
+        }
+        else
+        {
+            if ( (IsWalkable(x-1, y) && !IsWalkable(x-1, y-dy)) ||
+                 (IsWalkable(x+1, y) && !IsWalkable(x+1, y-dy)) )  break;
+        }
+
+        x += dx;
+        y += dy;
+    }
+
+    if (! IsWalkable(x, y))  return false;
+
+    jx = x;
+    jy = y;
+    return true;
+}
+
+bool CNavSearch::Jump(int x, int y, int dx, int dy, int &jx, int &jy)
+{
+    if (dx == 0 || dy == 0)
+        return JumpStraight(x, y, dx, dy, jx, jy);
+
+    int sx = 0, sy = 0;
+    while (IsWalkable(x, y))
+    {
+        if ( IsGoal(x, y) ||
+             JumpStraight(x+dx, y, dx, 0, sx, sy) ||
+             JumpStraight(x, y+dy, 0, dy, sx, sy) )
+        {
+            jx = x;
+            jy = y;
+            return true;
+        }
+
+        // Diagonal moves don't cut corners
+        if (! IsWalkable(x+dx, y) || ! IsWalkable(x, y+dy))  return false;
+
+        x += dx;
+        y += dy;
+    }
+    return false;
+}
+
+void CNavSearch::AddNode(int x, int y, int parent)
+{
+    int index = (x-m_minX)+(y-m_minY)*m_sizeX;
+    if (m_flags[index] & NAV_CLOSED)  return;
+
+    int px = m_minX+parent%m_sizeX;
+    int py = m_minY+parent/m_sizeX;
+    float ax = static_cast<float>(abs(x-px));
+    float ay = static_cast<float>(abs(y-py));
+    float cost = m_cost[parent] + Math::Max(ax, ay) + (sqrtf(2.0f)-1.0f)*Math::Min(ax, ay);
+
+    if ((m_flags[index] & NAV_OPENED) && cost >= m_cost[index])  return;
+
+    m_flags[index] |= NAV_OPENED;
+    m_cost[index] = cost;
+    m_parent[index] = parent;
+
+    // Octile distance to the goal
+    ax = static_cast<float>(abs(x-m_goalX));
+    ay = static_cast<float>(abs(y-m_goalY));
+
+    NavNode node;
+    node.cost = cost + Math::Max(ax, ay) + (sqrtf(2.0f)-1.0f)*Math::Min(ax, ay);
+    node.index = index;
+    m_open.push_back(node);
+    std::push_heap(m_open.begin(), m_open.end());
+}
+
+void CNavSearch::Expand(int index)
+{
+    int x = m_minX+index%m_sizeX;
+    int y = m_minY+index/m_sizeX;
+    int dirX[8], dirY[8];
+    int total = 0;
+
+    int parent = m_parent[index];
+    if (parent == -1)  // start: all directions
+    {
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                if (dx == 0 && dy == 0)  continue;
+                if (dx != 0 && dy != 0 &&
+                    (! IsWalkable(x+dx, y) || ! IsWalkable(x, y+dy)))  continue;
+
+                dirX[total] = dx;
+                dirY[total] = dy;
+                total ++;
+            }
+        }
+    }
+    else    // prunes the neighbours according to the direction of arrival
+    {
+        int px = m_minX+parent%m_sizeX;
+        int py = m_minY+parent/m_sizeX;
+        int dx = (x > px) ? 1 : ((x < px) ? -1 : 0);
+        int dy = (y > py) ? 1 : ((y < py) ? -1 : 0);
+
+        if (dx != 0 && dy != 0)
+        {
+            bool walkX = IsWalkable(x+dx, y);
+            bool walkY = IsWalkable(x, y+dy);
+            if (walkY)  { dirX[total] = 0;  dirY[total] = dy; total ++; }
+            if (walkX)  { dirX[total] = dx; dirY[total] = 0;  total ++; }
+            if (walkX && walkY)  { dirX[total] = dx; dirY[total] = dy; total ++; }
+        }
+        else if (dx != 0)
+        {
+            bool next   = IsWalkable(x+dx, y);
+            bool top    = IsWalkable(x, y+1);
+            bool bottom = IsWalkable(x, y-1);
+            if (next)
+            {
+                dirX[total] = dx; dirY[total] = 0; total ++;
+                if (top)     { dirX[total] = dx; dirY[total] =  1; total ++; }
+                if (bottom)  { dirX[total] = dx; dirY[total] = -1; total ++; }
+            }
+            if (top)     { dirX[total] = 0; dirY[total] =  1; total ++; }
+            if (bottom)  { dirX[total] = 0; dirY[total] = -1; total ++; }
+        }
+        else
+        {
+            bool next  = IsWalkable(x, y+dy);
+            bool right = IsWalkable(x+1, y);
+            bool left  = IsWalkable(x-1, y);
+            if (next)
+            {
+                dirX[total] = 0; dirY[total] = dy; total ++;
+                if (right)  { dirX[total] =  1; dirY[total] = dy; total ++; }
+                if (left)   { dirX[total] = -1; dirY[total] = dy; total ++; }
+            }
+            if (right)  { dirX[total] =  1; dirY[total] = 0; total ++; }
+            if (left)   { dirX[total] = -1; dirY[total] = 0; total ++; }
+        }
+    }
+
+    for (int i = 0; i < total; i++)
+    {
+        int jx = 0, jy = 0;
+        if (Jump(x+dirX[i], y+dirY[i], dirX[i], dirY[i], jx, jy))
+            AddNode(jx, jy, index);
+    }
+}
+
+Error CNavSearch::BuildPath(int index, int maxPoints)
+{
+    std::vector<Math::Vector> points;
+    while (m_parent[index] != -1)
+    {
+        points.push_back(CNavGrid::GetCellCenter(m_minX+index%m_sizeX, m_minY+index/m_sizeX));
+        index = m_parent[index];
+    }
+    std::reverse(points.begin(), points.end());
+
+    points.insert(points.begin(), m_start);
+    points.push_back(GetFinalPoint(points.back()));
+
+    // Skips the points which can be seen from an earlier one
+    m_path.clear();
+    m_path.push_back(points[0]);
+    int i = 0;
+    while (i < static_cast<int>( points.size() )-1)
+    {
+        int j = static_cast<int>( points.size() )-1;
+        for ( ; j > i+1; j--)
+        {
+            if (m_grid->IsLineFree(m_agent, points[i], points[j]))  break;
+        }
+        m_path.push_back(points[j]);
+        i = j;
+    }
+
+    if (static_cast<int>( m_path.size() )-1 > maxPoints)
+    {
+        m_path.clear();
+        return ERR_GOTO_ITER;
+    }
+
+    std::vector<Math::Vector> inside(m_path.begin()+1, m_path.end()-1);
+    m_grid->AddCachedPath(GetKey(), inside);
+    return ERR_OK;
+}
+
+Math::Vector CNavSearch::GetFinalPoint(const Math::Vector& from)
+{
+    if (m_goalRadius == 0.0f)
+        return m_goal;
+
+    float dist = Math::DistanceProjected(from, m_goal);
+    if (dist <= m_goalRadius)
+        return from;
+
+    Math::Vector pos;
+    pos.x = from.x + (m_goal.x-from.x)*(dist-m_goalRadius)/dist;
+    pos.y = 0.0f;
+    pos.z = from.z + (m_goal.z-from.z)*(dist-m_goalRadius)/dist;
+    return pos;
+}
+
+NavPathKey CNavSearch::GetKey()
+{
+    NavPathKey key;
+    key.start       = CNavGrid::GetCellX(m_start)+CNavGrid::GetCellY(m_start)*NAV_GRID_SIZE;
+    key.goal        = m_goalX+m_goalY*NAV_GRID_SIZE;
+    key.slopeLimit  = static_cast<int>(m_agent.slopeLimit*1000.0f);
+    key.radius      = static_cast<int>(m_agent.radius*100.0f);
+    key.goalRadius  = static_cast<int>(m_goalRadius*100.0f);
+    key.altitude    = static_cast<int>(m_agent.altitude*100.0f);
+    key.fly         = m_agent.fly;
+    key.acceptWater = m_agent.acceptWater;
+    return key;
+}
+
+
+} // namespace Gfx
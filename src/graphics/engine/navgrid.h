@@ -0,0 +1,368 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+/**
+ * \file graphics/engine/navgrid.h
+ * \brief Navigation grid and path planner - CNavGrid and CNavSearch classes
+ */
+
+#pragma once
+
+
+#include "common/global.h"
+
+#include "math/vector.h"
+
+#include <map>
+#include <vector>
+
+
+class CInstanceManager;
+class CObject;
+
+
+// Graphics module namespace
+namespace Gfx {
+
+class CTerrain;
+class CWater;
+
+
+//! Size of a single navigation cell (in world units)
+const float NAV_CELL_SIZE = 5.0f;
+//! Number of navigation cells along one side of the grid
+const int   NAV_GRID_SIZE = 640;
+//! Maximum number of paths kept in the path cache
+const int   NAV_PATH_CACHE_SIZE = 64;
+
+
+/**
+ * \struct NavAgent
+ * \brief Description of a robot looking for a path
+ *
+ * The same navigation grid serves all robots; the agent tells how to read it.
+ */
+struct NavAgent
+{
+    //! Robot itself, not an obstacle for itself
+    CObject*        object;
+    //! Object to reach (e.g. cargo to take), not an obstacle either
+    CObject*        target;
+    //! Radius of the robot
+    float           radius;
+    //! Steepest slope the robot can climb
+    float           slopeLimit;
+    //! Flying robot: only too high terrain blocks it
+    bool            fly;
+    //! Robot going under water
+    bool            acceptWater;
+    //! Flight altitude over the ground, 0 when moving on the ground
+    float           altitude;
+    //! Center of a zone always considered free (around the departure)
+    Math::Vector    freePos;
+    //! Radius of the free zone, 0 if none
+    float           freeRadius;
+
+    NavAgent()
+    {
+        object      = nullptr;
+        target      = nullptr;
+        radius      = 0.0f;
+        slopeLimit  = 0.0f;
+        fly         = false;
+        acceptWater = false;
+        altitude    = 0.0f;
+        freeRadius  = 0.0f;
+    }
+};
+
+/**
+ * \struct NavCircle
+ * \brief Crash sphere of an object, as stamped in the navigation grid
+ */
+struct NavCircle
+{
+    //! Center cell
+    int             x, y;
+    //! Radius of the stamped circle (in cells)
+    float           radius;
+    //! Height of the sphere center
+    float           height;
+    //! Radius of the sphere
+    float           sphereRadius;
+    //! Floor level below the object
+    float           floor;
+    //! Circle is stamped in the ground layer
+    bool            ground;
+    //! Circle is stamped in the air layer
+    bool            air;
+};
+
+/**
+ * \struct NavObject
+ * \brief Circles stamped by an object in the navigation grid
+ */
+struct NavObject
+{
+    std::vector<NavCircle> circles;
+    //! Object moved since its circles were stamped
+    bool            dirty;
+
+    NavObject()
+    {
+        dirty = true;
+    }
+};
+
+/**
+ * \struct NavPathKey
+ * \brief Key of the path cache: start and goal cells plus kind of robot
+ */
+struct NavPathKey
+{
+    int             start;
+    int             goal;
+    int             slopeLimit;
+    int             radius;
+    int             goalRadius;
+    int             altitude;
+    bool            fly;
+    bool            acceptWater;
+
+    bool operator<(const NavPathKey& other) const;
+};
+
+/**
+ * \class CNavGrid
+ * \brief Occupancy grid shared by all robots looking for a path
+ *
+ * The grid covers the XZ plane with cells of NAV_CELL_SIZE, the same way
+ * the bitmap of CTaskGoto did. It is owned by CTerrain and keeps two kinds
+ * of data up to date incrementally, instead of rebuilding them on each goto:
+ *
+ *  - terrain: floor level and slope of each cell, read lazily from CTerrain
+ *    and dropped when the relief changes (CTerrain::Terraform() etc.)
+ *  - objects: number of crash circles covering each cell. Objects mark
+ *    themselves as moved (see UpdateObject()) and only those are stamped
+ *    again before the next query.
+ *
+ * Circles are stamped enlarged by the usual margin but without the radius
+ * of the robot; the grid is dilated by this radius when testing a cell.
+ * Circles of objects on the ground go to the ground layer; flying robots
+ * use an air layer built for their altitude.
+ *
+ * The grid also keeps a cache of paths found by CNavSearch, keyed by
+ * start and goal cells; a cached path is reused after checking that it
+ * is still free.
+ */
+class CNavGrid
+{
+public:
+    CNavGrid(CInstanceManager* iMan, CTerrain* terrain);
+    ~CNavGrid();
+
+    //! Removes all objects and cached data
+    void        Flush();
+
+    //! Drops terrain data of cells in given XZ box, after the relief was modified
+    void        InvalidateTerrain(const Math::Vector& min, const Math::Vector& max);
+    //! Drops terrain data of all cells
+    void        InvalidateTerrain();
+
+    //! Registers a new object
+    void        AddObject(CObject* object);
+    //! Unregisters an object and removes its circles
+    void        DeleteObject(CObject* object);
+    //! Notifies that the object moved or changed its crash spheres
+    void        UpdateObject(CObject* object);
+
+    //! Prepares the grid for queries of an agent
+    void        BeginQuery(const NavAgent& agent);
+    //! Ends queries started by BeginQuery()
+    void        EndQuery(const NavAgent& agent);
+    //! Tests if a cell is blocked for an agent; only between BeginQuery() and EndQuery()
+    bool        IsBlocked(const NavAgent& agent, int x, int y);
+    //! Tests if a straight line is free; only between BeginQuery() and EndQuery()
+    bool        IsLineFree(const NavAgent& agent, const Math::Vector& start, const Math::Vector& goal);
+
+    //! Tests if a position is blocked for an agent
+    bool        TestPosition(const NavAgent& agent, const Math::Vector& pos);
+    //! Tests if an agent can go along a straight line
+    bool        TestLine(const NavAgent& agent, const Math::Vector& start, const Math::Vector& goal);
+
+    //! Looks for a path in the cache; gives the intermediate points
+    bool        GetCachedPath(const NavPathKey& key, std::vector<Math::Vector>& points);
+    //! Adds a path to the cache
+    void        AddCachedPath(const NavPathKey& key, const std::vector<Math::Vector>& points);
+
+    //! Returns the cell X coordinate of a position
+    static int  GetCellX(const Math::Vector& pos);
+    //! Returns the cell Y coordinate of a position
+    static int  GetCellY(const Math::Vector& pos);
+    //! Returns the position of the center of a cell
+    static Math::Vector GetCellCenter(int x, int y);
+
+protected:
+    //! Stamps again the circles of moved objects
+    void        Refresh();
+    //! Marks all objects as moved
+    void        InvalidateObjects();
+    //! Builds the air layer for given altitude
+    void        SetAirAltitude(float altitude);
+    //! Computes the circles of an object
+    void        ComputeCircles(CObject* object, NavObject& nav);
+    //! Adds or removes the circles of an object in the layers
+    void        StampCircles(NavObject& nav, int delta);
+    //! Adds or removes one circle in a layer
+    void        StampCircle(std::vector<unsigned short>& layer, const NavCircle& circle, int delta);
+    //! Tests if a cell is blocked by the terrain for an agent
+    bool        IsTerrainBlocked(const NavAgent& agent, int x, int y);
+    //! Reads the terrain data of a cell
+    void        ReadTerrain(int x, int y);
+    //! Computes the lowest floor level of a cell and its four neighbours
+    void        ReadLowest(int x, int y);
+
+protected:
+    CInstanceManager* m_iMan;
+    CTerrain*       m_terrain;
+    CWater*         m_water;
+
+    //! Floor level of each cell
+    std::vector<float> m_height;
+    //! Slope of each cell
+    std::vector<float> m_slope;
+    //! Lowest floor level of each cell and its four neighbours
+    std::vector<float> m_lowest;
+    //! Terrain data of the cell is valid: 1 height and slope, 2 also lowest level
+    std::vector<unsigned char> m_terrainValid;
+
+    //! Number of circles covering each cell, for robots on the ground
+    std::vector<unsigned short> m_ground;
+    //! Number of circles covering each cell, for flying robots
+    std::vector<unsigned short> m_air;
+    //! Altitude for which the air layer was built, negative if not built
+    float           m_airAltitude;
+
+    //! Circles of each object
+    std::map<CObject*, NavObject> m_objects;
+    //! Objects moved since the last query
+    std::vector<CObject*> m_dirty;
+
+    //! Cells covered by the robot of the current query, as offsets
+    std::vector<int> m_dilateX;
+    std::vector<int> m_dilateY;
+
+    //! Cached paths
+    std::map<NavPathKey, std::vector<Math::Vector> > m_pathCache;
+};
+
+
+/**
+ * \struct NavNode
+ * \brief Node in the open list of CNavSearch
+ */
+struct NavNode
+{
+    //! Estimated cost of the whole path
+    float           cost;
+    //! Index of the cell in the search box
+    int             index;
+
+    //! Order of the heap: the cheapest node first
+    bool operator<(const NavNode& other) const
+    {
+        return cost > other.cost;
+    }
+};
+
+/**
+ * \class CNavSearch
+ * \brief Jump point search in the navigation grid
+ *
+ * Looks for a path of an agent in a box around start and goal. Cells are
+ * 8-connected and diagonal moves must not cut corners. When no path is
+ * found in the box, the search starts again in a larger box, up to the
+ * whole grid. The search can be split over several frames: Step() stops
+ * after looking at a given number of cells and returns ERR_CONTINUE.
+ */
+class CNavSearch
+{
+public:
+    CNavSearch();
+    ~CNavSearch();
+
+    //! Starts a new search; goalRadius: distance at which the goal is reached
+    void        Start(CNavGrid* grid, const NavAgent& agent, const Math::Vector& start,
+                      const Math::Vector& goal, float goalRadius);
+    //! Continues the search, looking at about \a budget cells
+    Error       Step(int budget, int maxPoints);
+    //! Returns the points of the path found, from start to goal
+    const std::vector<Math::Vector>& GetPath();
+
+protected:
+    //! Starts the search in the box given by m_margin
+    void        StartBox();
+    //! Tests if a cell can be crossed, remembering the answer
+    bool        IsWalkable(int x, int y);
+    //! Tests if a cell is in the goal area
+    bool        IsGoal(int x, int y);
+    //! Jumps horizontally or vertically, returns true if a jump point was found
+    bool        JumpStraight(int x, int y, int dx, int dy, int &jx, int &jy);
+    //! Jumps in any direction, returns true if a jump point was found
+    bool        Jump(int x, int y, int dx, int dy, int &jx, int &jy);
+    //! Adds a jump point to the open list
+    void        AddNode(int x, int y, int parent);
+    //! Expands a node of the open list
+    void        Expand(int index);
+    //! Makes the list of points, ending with given node
+    Error       BuildPath(int index, int maxPoints);
+    //! Computes the last point of the path, near the goal
+    Math::Vector GetFinalPoint(const Math::Vector& from);
+    //! Returns the key of the search in the path cache
+    NavPathKey  GetKey();
+
+protected:
+    CNavGrid*       m_grid;
+    NavAgent        m_agent;
+    Math::Vector    m_start;
+    Math::Vector    m_goal;
+    float           m_goalRadius;
+    int             m_goalX, m_goalY;
+
+    //! Search box (in cells)
+    int             m_margin;
+    int             m_minX, m_minY;
+    int             m_sizeX, m_sizeY;
+
+    //! Flags of each cell of the box
+    std::vector<unsigned char> m_flags;
+    //! Cost from the start of each cell of the box
+    std::vector<float> m_cost;
+    //! Previous jump point of each cell of the box
+    std::vector<int> m_parent;
+    //! Open list (heap)
+    std::vector<NavNode> m_open;
+
+    //! Number of cells looked at in the current step
+    int             m_tested;
+    //! Search finished
+    bool            m_bDone;
+    //! Path found
+    std::vector<Math::Vector> m_path;
+};
+
+
+} // namespace Gfx
@@ -18,6 +18,8 @@
 
 #include "graphics/engine/particle.h"
 
+#include "app/profiler.h"
+
 #include "common/logger.h"
 
 #include "graphics/core/device.h"
@@ -40,6 +42,9 @@ namespace Gfx {
 const float FOG_HSUP    = 10.0f;
 const float FOG_HINF    = 100.0f;
 
+//! How big the batch of quads is by default (in vertices)
+const int PARTICLE_BATCH_PREALLOCATE_COUNT = 6*MAXPARTICULE;
+
 
 
 
@@ -132,6 +137,9 @@ CParticle::CParticle(CInstanceManager *iMan, CEngine* engine)
     m_exploGunCounter = 0;
     m_lastTimeGunDel = 0.0f;
     m_absTime = 0.0f;
+    m_batchState = ENG_RSTATE_TTEXTURE_BLACK;
+
+    m_batch.reserve(PARTICLE_BATCH_PREALLOCATE_COUNT);
 
     FlushParticle();
 }
@@ -149,7 +157,32 @@ void CParticle::SetDevice(CDevice* device)
 void CParticle::FlushParticle()
 {
     for (int i = 0; i < MAXPARTICULE*MAXPARTITYPE; i++)
+    {
         m_particle[i].used = false;
+        m_liveIndex[i] = -1;
+
+        // Free ranks go through the kinematics loop too, without moving
+        m_pos[i] = Math::Vector(0.0f, 0.0f, 0.0f);
+        m_speed[i] = Math::Vector(0.0f, 0.0f, 0.0f);
+        m_mass[i] = 0.0f;
+        m_windSensitivity[i] = 0.0f;
+        m_windJitter[i] = 0.0f;
+        m_moveTime[i] = 0.0f;
+    }
+
+    for (int t = 0; t < MAXPARTITYPE; t++)
+    {
+        m_live[t].clear();
+        m_live[t].reserve(MAXPARTICULE);
+
+        // Lowest ranks are taken first
+        m_free[t].clear();
+        m_free[t].reserve(MAXPARTICULE);
+        for (int j = MAXPARTICULE-1; j >= 0; j--)
+            m_free[t].push_back(MAXPARTICULE*t+j);
+
+        m_rankEnd[t] = MAXPARTICULE*t;
+    }
 
     for (int i = 0; i < MAXPARTITYPE; i++)
     {
@@ -174,12 +207,16 @@ void CParticle::FlushParticle()
 
 void CParticle::FlushParticle(int sheet)
 {
-    for (int i = 0; i < MAXPARTICULE*MAXPARTITYPE; i++)
+    for (int t = 0; t < MAXPARTITYPE; t++)
     {
-        if (!m_particle[i].used) continue;
-        if (m_particle[i].sheet != sheet) continue;
+        // Backwards, as FreeRank() moves the last particle in place of the removed one
+        for (int k = static_cast<int>( m_live[t].size() )-1; k >= 0; k--)
+        {
+            int i = m_live[t][k];
+            if (m_particle[i].sheet != sheet) continue;
 
-        m_particle[i].used = false;
+            FreeRank(i);
+        }
     }
 
     for (int i = 0; i < MAXPARTITYPE; i++)
@@ -326,66 +363,59 @@ int CParticle::CreateParticle(Math::Vector pos, Math::Vector speed, Math::Point
     if (t >= MAXPARTITYPE) return -1;
     if (t == -1) return -1;
 
-    for (int j = 0; j < MAXPARTICULE; j++)
-    {
-        int i = MAXPARTICULE*t+j;
-
-        if (! m_particle[i].used)
-        {
-            memset(&m_particle[i], 0, sizeof(Particle));
-            m_particle[i].used      = true;
-            m_particle[i].ray       = false;
-            m_particle[i].uniqueStamp = m_uniqueStamp++;
-            m_particle[i].sheet     = sheet;
-            m_particle[i].mass      = mass;
-            m_particle[i].duration  = duration;
-            m_particle[i].pos       = pos;
-            m_particle[i].goal      = pos;
-            m_particle[i].speed     = speed;
-            m_particle[i].windSensitivity = windSensitivity;
-            m_particle[i].dim       = dim;
-            m_particle[i].zoom      = 1.0f;
-            m_particle[i].angle     = 0.0f;
-            m_particle[i].intensity = 1.0f;
-            m_particle[i].type      = type;
-            m_particle[i].phase     = PARPHSTART;
-            m_particle[i].texSup.x  = 0.0f;
-            m_particle[i].texSup.y  = 0.0f;
-            m_particle[i].texInf.x  = 0.0f;
-            m_particle[i].texInf.y  = 0.0f;
-            m_particle[i].time      = 0.0f;
-            m_particle[i].phaseTime = 0.0f;
-            m_particle[i].testTime  = 0.0f;
-            m_particle[i].objLink   = 0;
-            m_particle[i].objFather = 0;
-            m_particle[i].trackRank = -1;
+    int i = NewRank(t);
+    if (i == -1) return -1;
 
-            m_totalInterface[t][sheet] ++;
+    memset(&m_particle[i], 0, sizeof(Particle));
+    m_particle[i].used      = true;
+    m_particle[i].ray       = false;
+    m_particle[i].uniqueStamp = m_uniqueStamp++;
+    m_particle[i].sheet     = sheet;
+    m_mass[i] = mass;
+    m_particle[i].duration  = duration;
+    m_pos[i] = pos;
+    m_particle[i].goal      = pos;
+    m_speed[i] = speed;
+    m_windSensitivity[i] = (sheet == SH_WORLD) ? windSensitivity : 0.0f;  // wind blows only in the world
+    m_particle[i].dim       = dim;
+    m_particle[i].zoom      = 1.0f;
+    m_particle[i].angle     = 0.0f;
+    m_particle[i].intensity = 1.0f;
+    m_particle[i].type      = type;
+    m_particle[i].phase     = PARPHSTART;
+    m_particle[i].texSup.x  = 0.0f;
+    m_particle[i].texSup.y  = 0.0f;
+    m_particle[i].texInf.x  = 0.0f;
+    m_particle[i].texInf.y  = 0.0f;
+    m_particle[i].time      = 0.0f;
+    m_particle[i].phaseTime = 0.0f;
+    m_particle[i].testTime  = 0.0f;
+    m_particle[i].objLink   = 0;
+    m_particle[i].objFather = 0;
+    m_particle[i].trackRank = -1;
 
-            if ( type == PARTIEXPLOT ||
-                 type == PARTIEXPLOO )
-            {
-                m_particle[i].angle = Math::Rand()*Math::PI*2.0f;
-            }
+    m_totalInterface[t][sheet] ++;
 
-            if ( type == PARTIGUN1 ||
-                 type == PARTIGUN4 )
-            {
-                m_particle[i].testTime = 1.0f;  // impact immediately
-            }
+    if ( type == PARTIEXPLOT ||
+         type == PARTIEXPLOO )
+    {
+        m_particle[i].angle = Math::Rand()*Math::PI*2.0f;
+    }
 
-            if ( type >= PARTIFOG0 &&
-                 type <= PARTIFOG9 )
-            {
-                if (m_fogTotal < MAXPARTIFOG)
-                m_fog[m_fogTotal++] = i;
-            }
+    if ( type == PARTIGUN1 ||
+         type == PARTIGUN4 )
+    {
+        m_particle[i].testTime = 1.0f;  // impact immediately
+    }
 
-            return i | ((m_particle[i].uniqueStamp&0xffff)<<16);
-        }
+    if ( type >= PARTIFOG0 &&
+         type <= PARTIFOG9 )
+    {
+        if (m_fogTotal < MAXPARTIFOG)
+        m_fog[m_fogTotal++] = i;
     }
 
-    return -1;
+    return i | ((m_particle[i].uniqueStamp&0xffff)<<16);
 }
 
 /** Returns the channel of the particle created or -1 on error */
@@ -396,100 +426,93 @@ int CParticle::CreateFrag(Math::Vector pos, Math::Vector speed,
                           float windSensitivity, int sheet)
 {
     int t = 0;
-    for (int j = 0; j < MAXPARTICULE; j++)
-    {
-        int i = MAXPARTICULE*t+j;
-
-        if (!m_particle[i].used)
-        {
-            memset(&m_particle[i], 0, sizeof(Particle));
-            m_particle[i].used      = true;
-            m_particle[i].ray       = false;
-            m_particle[i].uniqueStamp = m_uniqueStamp++;
-            m_particle[i].sheet     = sheet;
-            m_particle[i].mass      = mass;
-            m_particle[i].duration  = duration;
-            m_particle[i].pos       = pos;
-            m_particle[i].goal      = pos;
-            m_particle[i].speed     = speed;
-            m_particle[i].windSensitivity = windSensitivity;
-            m_particle[i].zoom      = 1.0f;
-            m_particle[i].angle     = 0.0f;
-            m_particle[i].intensity = 1.0f;
-            m_particle[i].type      = type;
-            m_particle[i].phase     = PARPHSTART;
-            m_particle[i].texSup.x  = 0.0f;
-            m_particle[i].texSup.y  = 0.0f;
-            m_particle[i].texInf.x  = 0.0f;
-            m_particle[i].texInf.y  = 0.0f;
-            m_particle[i].time      = 0.0f;
-            m_particle[i].phaseTime = 0.0f;
-            m_particle[i].testTime  = 0.0f;
-            m_particle[i].objLink   = 0;
-            m_particle[i].objFather = 0;
-            m_particle[i].trackRank = -1;
-            m_triangle[i] = *triangle;
-
-            m_totalInterface[t][sheet] ++;
-
-            Math::Vector    p1;
-            p1.x = m_triangle[i].triangle[0].coord.x;
-            p1.y = m_triangle[i].triangle[0].coord.y;
-            p1.z = m_triangle[i].triangle[0].coord.z;
-
-            Math::Vector p2;
-            p2.x = m_triangle[i].triangle[1].coord.x;
-            p2.y = m_triangle[i].triangle[1].coord.y;
-            p2.z = m_triangle[i].triangle[1].coord.z;
-
-            Math::Vector p3;
-            p3.x = m_triangle[i].triangle[2].coord.x;
-            p3.y = m_triangle[i].triangle[2].coord.y;
-            p3.z = m_triangle[i].triangle[2].coord.z;
-
-            float l1 = Math::Distance(p1, p2);
-            float l2 = Math::Distance(p2, p3);
-            float l3 = Math::Distance(p3, p1);
-            float dx = fabs(Math::Min(l1, l2, l3))*0.5f;
-            float dy = fabs(Math::Max(l1, l2, l3))*0.5f;
-            p1 = Math::Vector(-dx,  dy, 0.0f);
-            p2 = Math::Vector( dx,  dy, 0.0f);
-            p3 = Math::Vector(-dx, -dy, 0.0f);
-
-            m_triangle[i].triangle[0].coord.x = p1.x;
-            m_triangle[i].triangle[0].coord.y = p1.y;
-            m_triangle[i].triangle[0].coord.z = p1.z;
-
-            m_triangle[i].triangle[1].coord.x = p2.x;
-            m_triangle[i].triangle[1].coord.y = p2.y;
-            m_triangle[i].triangle[1].coord.z = p2.z;
-
-            m_triangle[i].triangle[2].coord.x = p3.x;
-            m_triangle[i].triangle[2].coord.y = p3.y;
-            m_triangle[i].triangle[2].coord.z = p3.z;
-
-            Math::Vector n(0.0f, 0.0f, -1.0f);
-
-            m_triangle[i].triangle[0].normal.x = n.x;
-            m_triangle[i].triangle[0].normal.y = n.y;
-            m_triangle[i].triangle[0].normal.z = n.z;
-
-            m_triangle[i].triangle[1].normal.x = n.x;
-            m_triangle[i].triangle[1].normal.y = n.y;
-            m_triangle[i].triangle[1].normal.z = n.z;
-
-            m_triangle[i].triangle[2].normal.x = n.x;
-            m_triangle[i].triangle[2].normal.y = n.y;
-            m_triangle[i].triangle[2].normal.z = n.z;
-
-            if (type == PARTIFRAG)
-                m_particle[i].angle = Math::Rand()*Math::PI*2.0f;
-
-            return i | ((m_particle[i].uniqueStamp&0xffff)<<16);
-        }
-    }
-
-    return -1;
+    int i = NewRank(t);
+    if (i == -1) return -1;
+
+    memset(&m_particle[i], 0, sizeof(Particle));
+    m_particle[i].used      = true;
+    m_particle[i].ray       = false;
+    m_particle[i].uniqueStamp = m_uniqueStamp++;
+    m_particle[i].sheet     = sheet;
+    m_mass[i] = mass;
+    m_particle[i].duration  = duration;
+    m_pos[i] = pos;
+    m_particle[i].goal      = pos;
+    m_speed[i] = speed;
+    m_windSensitivity[i] = (sheet == SH_WORLD) ? windSensitivity : 0.0f;  // wind blows only in the world
+    m_particle[i].zoom      = 1.0f;
+    m_particle[i].angle     = 0.0f;
+    m_particle[i].intensity = 1.0f;
+    m_particle[i].type      = type;
+    m_particle[i].phase     = PARPHSTART;
+    m_particle[i].texSup.x  = 0.0f;
+    m_particle[i].texSup.y  = 0.0f;
+    m_particle[i].texInf.x  = 0.0f;
+    m_particle[i].texInf.y  = 0.0f;
+    m_particle[i].time      = 0.0f;
+    m_particle[i].phaseTime = 0.0f;
+    m_particle[i].testTime  = 0.0f;
+    m_particle[i].objLink   = 0;
+    m_particle[i].objFather = 0;
+    m_particle[i].trackRank = -1;
+    m_triangle[i] = *triangle;
+
+    m_totalInterface[t][sheet] ++;
+
+    Math::Vector    p1;
+    p1.x = m_triangle[i].triangle[0].coord.x;
+    p1.y = m_triangle[i].triangle[0].coord.y;
+    p1.z = m_triangle[i].triangle[0].coord.z;
+
+    Math::Vector p2;
+    p2.x = m_triangle[i].triangle[1].coord.x;
+    p2.y = m_triangle[i].triangle[1].coord.y;
+    p2.z = m_triangle[i].triangle[1].coord.z;
+
+    Math::Vector p3;
+    p3.x = m_triangle[i].triangle[2].coord.x;
+    p3.y = m_triangle[i].triangle[2].coord.y;
+    p3.z = m_triangle[i].triangle[2].coord.z;
+
+    float l1 = Math::Distance(p1, p2);
+    float l2 = Math::Distance(p2, p3);
+    float l3 = Math::Distance(p3, p1);
+    float dx = fabs(Math::Min(l1, l2, l3))*0.5f;
+    float dy = fabs(Math::Max(l1, l2, l3))*0.5f;
+    p1 = Math::Vector(-dx,  dy, 0.0f);
+    p2 = Math::Vector( dx,  dy, 0.0f);
+    p3 = Math::Vector(-dx, -dy, 0.0f);
+
+    m_triangle[i].triangle[0].coord.x = p1.x;
+    m_triangle[i].triangle[0].coord.y = p1.y;
+    m_triangle[i].triangle[0].coord.z = p1.z;
+
+    m_triangle[i].triangle[1].coord.x = p2.x;
+    m_triangle[i].triangle[1].coord.y = p2.y;
+    m_triangle[i].triangle[1].coord.z = p2.z;
+
+    m_triangle[i].triangle[2].coord.x = p3.x;
+    m_triangle[i].triangle[2].coord.y = p3.y;
+    m_triangle[i].triangle[2].coord.z = p3.z;
+
+    Math::Vector n(0.0f, 0.0f, -1.0f);
+
+    m_triangle[i].triangle[0].normal.x = n.x;
+    m_triangle[i].triangle[0].normal.y = n.y;
+    m_triangle[i].triangle[0].normal.z = n.z;
+
+    m_triangle[i].triangle[1].normal.x = n.x;
+    m_triangle[i].triangle[1].normal.y = n.y;
+    m_triangle[i].triangle[1].normal.z = n.z;
+
+    m_triangle[i].triangle[2].normal.x = n.x;
+    m_triangle[i].triangle[2].normal.y = n.y;
+    m_triangle[i].triangle[2].normal.z = n.z;
+
+    if (type == PARTIFRAG)
+        m_particle[i].angle = Math::Rand()*Math::PI*2.0f;
+
+    return i | ((m_particle[i].uniqueStamp&0xffff)<<16);
 }
 
 
@@ -500,45 +523,38 @@ int CParticle::CreatePart(Math::Vector pos, Math::Vector speed,
                           float windSensitivity, int sheet)
 {
     int t = 0;
-    for (int j = 0; j < MAXPARTICULE; j++)
-    {
-        int i = MAXPARTICULE*t+j;
-
-        if (!m_particle[i].used)
-        {
-            memset(&m_particle[i], 0, sizeof(Particle));
-            m_particle[i].used      = true;
-            m_particle[i].ray       = false;
-            m_particle[i].uniqueStamp = m_uniqueStamp++;
-            m_particle[i].sheet     = sheet;
-            m_particle[i].mass      = mass;
-            m_particle[i].weight    = weight;
-            m_particle[i].duration  = duration;
-            m_particle[i].pos       = pos;
-            m_particle[i].goal      = pos;
-            m_particle[i].speed     = speed;
-            m_particle[i].windSensitivity = windSensitivity;
-            m_particle[i].zoom      = 1.0f;
-            m_particle[i].angle     = 0.0f;
-            m_particle[i].intensity = 1.0f;
-            m_particle[i].type      = type;
-            m_particle[i].phase     = PARPHSTART;
-            m_particle[i].texSup.x  = 0.0f;
-            m_particle[i].texSup.y  = 0.0f;
-            m_particle[i].texInf.x  = 0.0f;
-            m_particle[i].texInf.y  = 0.0f;
-            m_particle[i].time      = 0.0f;
-            m_particle[i].phaseTime = 0.0f;
-            m_particle[i].testTime  = 0.0f;
-            m_particle[i].trackRank = -1;
-
-            m_totalInterface[t][sheet] ++;
-
-            return i | ((m_particle[i].uniqueStamp&0xffff)<<16);
-        }
-    }
-
-    return -1;
+    int i = NewRank(t);
+    if (i == -1) return -1;
+
+    memset(&m_particle[i], 0, sizeof(Particle));
+    m_particle[i].used      = true;
+    m_particle[i].ray       = false;
+    m_particle[i].uniqueStamp = m_uniqueStamp++;
+    m_particle[i].sheet     = sheet;
+    m_mass[i] = mass;
+    m_particle[i].weight    = weight;
+    m_particle[i].duration  = duration;
+    m_pos[i] = pos;
+    m_particle[i].goal      = pos;
+    m_speed[i] = speed;
+    m_windSensitivity[i] = (sheet == SH_WORLD) ? windSensitivity : 0.0f;  // wind blows only in the world
+    m_particle[i].zoom      = 1.0f;
+    m_particle[i].angle     = 0.0f;
+    m_particle[i].intensity = 1.0f;
+    m_particle[i].type      = type;
+    m_particle[i].phase     = PARPHSTART;
+    m_particle[i].texSup.x  = 0.0f;
+    m_particle[i].texSup.y  = 0.0f;
+    m_particle[i].texInf.x  = 0.0f;
+    m_particle[i].texInf.y  = 0.0f;
+    m_particle[i].time      = 0.0f;
+    m_particle[i].phaseTime = 0.0f;
+    m_particle[i].testTime  = 0.0f;
+    m_particle[i].trackRank = -1;
+
+    m_totalInterface[t][sheet] ++;
+
+    return i | ((m_particle[i].uniqueStamp&0xffff)<<16);
 }
 
 /** Returns the channel of the particle created or -1 on error */
@@ -557,47 +573,40 @@ int CParticle::CreateRay(Math::Vector pos, Math::Vector goal,
     if (t >= MAXPARTITYPE) return -1;
     if (t == -1) return -1;
 
-    for (int j = 0; j < MAXPARTICULE; j++)
-    {
-        int i = MAXPARTICULE*t+j;
-
-        if (!m_particle[i].used)
-        {
-            memset(&m_particle[i], 0, sizeof(Particle));
-            m_particle[i].used      = true;
-            m_particle[i].ray       = true;
-            m_particle[i].uniqueStamp = m_uniqueStamp++;
-            m_particle[i].sheet     = sheet;
-            m_particle[i].mass      = 0.0f;
-            m_particle[i].duration  = duration;
-            m_particle[i].pos       = pos;
-            m_particle[i].goal      = goal;
-            m_particle[i].speed     = Math::Vector(0.0f, 0.0f, 0.0f);
-            m_particle[i].windSensitivity = 0.0f;
-            m_particle[i].dim       = dim;
-            m_particle[i].zoom      = 1.0f;
-            m_particle[i].angle     = 0.0f;
-            m_particle[i].intensity = 1.0f;
-            m_particle[i].type      = type;
-            m_particle[i].phase     = PARPHSTART;
-            m_particle[i].texSup.x  = 0.0f;
-            m_particle[i].texSup.y  = 0.0f;
-            m_particle[i].texInf.x  = 0.0f;
-            m_particle[i].texInf.y  = 0.0f;
-            m_particle[i].time      = 0.0f;
-            m_particle[i].phaseTime = 0.0f;
-            m_particle[i].testTime  = 0.0f;
-            m_particle[i].objLink   = 0;
-            m_particle[i].objFather = 0;
-            m_particle[i].trackRank = -1;
-
-            m_totalInterface[t][sheet] ++;
-
-            return i | ((m_particle[i].uniqueStamp&0xffff)<<16);
-        }
-    }
-
-    return -1;
+    int i = NewRank(t);
+    if (i == -1) return -1;
+
+    memset(&m_particle[i], 0, sizeof(Particle));
+    m_particle[i].used      = true;
+    m_particle[i].ray       = true;
+    m_particle[i].uniqueStamp = m_uniqueStamp++;
+    m_particle[i].sheet     = sheet;
+    m_mass[i] = 0.0f;
+    m_particle[i].duration  = duration;
+    m_pos[i] = pos;
+    m_particle[i].goal      = goal;
+    m_speed[i] = Math::Vector(0.0f, 0.0f, 0.0f);
+    m_windSensitivity[i] = 0.0f;
+    m_particle[i].dim       = dim;
+    m_particle[i].zoom      = 1.0f;
+    m_particle[i].angle     = 0.0f;
+    m_particle[i].intensity = 1.0f;
+    m_particle[i].type      = type;
+    m_particle[i].phase     = PARPHSTART;
+    m_particle[i].texSup.x  = 0.0f;
+    m_particle[i].texSup.y  = 0.0f;
+    m_particle[i].texInf.x  = 0.0f;
+    m_particle[i].texInf.y  = 0.0f;
+    m_particle[i].time      = 0.0f;
+    m_particle[i].phaseTime = 0.0f;
+    m_particle[i].testTime  = 0.0f;
+    m_particle[i].objLink   = 0;
+    m_particle[i].objFather = 0;
+    m_particle[i].trackRank = -1;
+
+    m_totalInterface[t][sheet] ++;
+
+    return i | ((m_particle[i].uniqueStamp&0xffff)<<16);
 }
 
 /** "length" is the length of the tail of drag (in seconds)! */
@@ -671,6 +680,48 @@ void CParticle::CreateWheelTrace(const Math::Vector &p1, const Math::Vector &p2,
 
 
 
+int CParticle::NewRank(int t)
+{
+    if (m_free[t].empty()) return -1;
+
+    int rank = m_free[t].back();
+    m_free[t].pop_back();
+
+    m_liveIndex[rank] = m_live[t].size();
+    m_live[t].push_back(rank);
+
+    if (rank >= m_rankEnd[t])
+        m_rankEnd[t] = rank+1;
+
+    m_windJitter[rank] = Math::Rand();
+    m_moveTime[rank] = 0.0f;
+    return rank;
+}
+
+void CParticle::FreeRank(int rank)
+{
+    m_particle[rank].used = false;
+
+    int index = m_liveIndex[rank];
+    if (index == -1) return;
+
+    // The last live particle takes the place of the removed one
+    std::vector<int>& live = m_live[rank/MAXPARTICULE];
+    int last = live.back();
+    live[index] = last;
+    m_liveIndex[last] = index;
+    live.pop_back();
+
+    m_liveIndex[rank] = -1;
+    m_moveTime[rank] = 0.0f;
+
+    int t = rank/MAXPARTICULE;
+    m_free[t].push_back(rank);
+
+    while (m_rankEnd[t] > MAXPARTICULE*t && m_liveIndex[m_rankEnd[t]-1] == -1)
+        m_rankEnd[t]--;
+}
+
 /** Adapts the channel so it can be used as an offset in m_particle */
 bool CParticle::CheckChannel(int &channel)
 {
@@ -704,17 +755,20 @@ void CParticle::DeleteRank(int rank)
     if (i != -1)  // drag associated?
         m_track[i].used = false;  // frees the drag
 
-    m_particle[rank].used = false;
+    FreeRank(rank);
 }
 
 void CParticle::DeleteParticle(ParticleType type)
 {
-    for (int i = 0; i < MAXPARTICULE*MAXPARTITYPE; i++)
+    for (int t = 0; t < MAXPARTITYPE; t++)
     {
-        if (!m_particle[i].used) continue;
-        if (m_particle[i].type != type) continue;
+        for (int k = static_cast<int>( m_live[t].size() )-1; k >= 0; k--)
+        {
+            int i = m_live[t][k];
+            if (m_particle[i].type != type) continue;
 
-        DeleteRank(i);
+            DeleteRank(i);
+        }
     }
 }
 
@@ -729,7 +783,7 @@ void CParticle::DeleteParticle(int channel)
     if (i != -1)  // drag associated?
         m_track[i].used = false;  // frees the drag
 
-    m_particle[channel].used = false;
+    FreeRank(channel);
 }
 
 void CParticle::SetObjectLink(int channel, CObject *object)
@@ -747,7 +801,7 @@ void CParticle::SetObjectFather(int channel, CObject *object)
 void CParticle::SetPosition(int channel, Math::Vector pos)
 {
     if (!CheckChannel(channel))  return;
-    m_particle[channel].pos = pos;
+    m_pos[channel] = pos;
 }
 
 void CParticle::SetDimension(int channel, Math::Point dim)
@@ -778,7 +832,7 @@ void CParticle::SetParam(int channel, Math::Vector pos, Math::Point dim, float z
                           float angle, float intensity)
 {
     if (!CheckChannel(channel))  return;
-    m_particle[channel].pos       = pos;
+    m_pos[channel]       = pos;
     m_particle[channel].dim       = dim;
     m_particle[channel].zoom      = zoom;
     m_particle[channel].angle     = angle;
@@ -796,7 +850,7 @@ void CParticle::SetPhase(int channel, ParticlePhase phase, float duration)
 bool CParticle::GetPosition(int channel, Math::Vector &pos)
 {
     if (!CheckChannel(channel))  return false;
-    pos = m_particle[channel].pos;
+    pos = m_pos[channel];
     return true;
 }
 
@@ -807,6 +861,8 @@ void CParticle::SetFrameUpdate(int sheet, bool update)
 
 void CParticle::FrameParticle(float rTime)
 {
+    CProfilerScope scope(PROF_PARTICLES);
+
     if (m_main == nullptr)
         m_main = static_cast<CRobotMain*>(m_iMan->SearchInstance(CLASS_MAIN));
 
@@ -830,41 +886,101 @@ void CParticle::FrameParticle(float rTime)
     Math::Point ts, ti;
     Math::Vector pos;
 
-    for (int i = 0; i < MAXPARTICULE*MAXPARTITYPE; i++)
-    {
-        if (!m_particle[i].used) continue;
-        if (!m_frameUpdate[m_particle[i].sheet]) continue;
+    // The wind gusts shift the random phase of each particle at every frame
+    float gust = Math::Rand();
 
-        if (m_particle[i].type != PARTISHOW)
+    // Lists the particles to update, only looking at live ones
+    m_frameList.clear();
+    m_frameStamp.clear();
+    m_floorList.clear();
+    for (int t = 0; t < MAXPARTITYPE; t++)
+    {
+        for (int k = 0; k < static_cast<int>( m_live[t].size() ); k++)
         {
-            if (pause && m_particle[i].sheet != SH_INTERFACE) continue;
-        }
+            int i = m_live[t][k];
+            m_moveTime[i] = 0.0f;
+
+            if (!m_frameUpdate[m_particle[i].sheet]) continue;
+
+            if (m_particle[i].type != PARTISHOW)
+            {
+                if (pause && m_particle[i].sheet != SH_INTERFACE) continue;
+            }
+
+            m_frameList.push_back(i);
+            m_frameStamp.push_back(m_particle[i].uniqueStamp);
+
+            if (m_particle[i].type == PARTIQUARTZ)  // does not move by itself
+            {
+                float jitter = m_windJitter[i]+gust;
+                if (jitter >= 1.0f) jitter -= 1.0f;
+                m_pos[i] += wind*(rTime*m_windSensitivity[i]*jitter*2.0f);
+            }
+            else
+            {
+                m_moveTime[i] = rTime;
+            }
 
-        if (m_particle[i].type != PARTIQUARTZ)
-            m_particle[i].pos += m_particle[i].speed*rTime;
+            if ( m_mass[i] != 0.0f                   &&
+                 m_particle[i].type  != PARTIQUARTZ  &&
+                 m_particle[i].sheet != SH_INTERFACE )
+                m_floorList.push_back(i);
+        }
+    }
 
-        if (m_particle[i].sheet == SH_WORLD)
+    // Common kinematics: speed, wind and gravity, straight through the used ranks;
+    // the particles which do not move this frame have no time of displacement
+    for (int t = 0; t < MAXPARTITYPE; t++)
+    {
+        int end = m_rankEnd[t];
+        for (int i = MAXPARTICULE*t; i < end; i++)
         {
-            float h = rTime*m_particle[i].windSensitivity*Math::Rand()*2.0f;
-            m_particle[i].pos += wind*h;
+            float time = m_moveTime[i];
+
+            float jitter = m_windJitter[i]+gust;
+            if (jitter >= 1.0f) jitter -= 1.0f;
+
+            float h = time*m_windSensitivity[i]*jitter*2.0f;
+            m_pos[i] += m_speed[i]*time + wind*h;
+            m_speed[i].y -= m_mass[i]*time;
         }
+    }
+
+    // Ground under the particles that fall, in one query
+    int floorCount = m_floorList.size();
+    if (floorCount > 0)
+    {
+        m_floorPos.resize(floorCount);
+        m_floorLevels.resize(floorCount);
+        for (int k = 0; k < floorCount; k++)
+            m_floorPos[k] = m_pos[m_floorList[k]];
+
+        m_terrain->GetFloorLevels(&m_floorPos[0], &m_floorLevels[0], nullptr, floorCount, true);
+
+        for (int k = 0; k < floorCount; k++)
+            m_floorLevel[m_floorList[k]] = m_floorLevels[k];
+    }
+
+    for (int k = 0; k < static_cast<int>( m_frameList.size() ); k++)
+    {
+        int i = m_frameList[k];
+        if (!m_particle[i].used) continue;  // removed by another particle
+        if (m_particle[i].uniqueStamp != m_frameStamp[k]) continue;  // created in this frame
 
         float progress = (m_particle[i].time-m_particle[i].phaseTime)/m_particle[i].duration;
 
         // Manages the particles with mass that bounce.
-        if ( m_particle[i].mass != 0.0f        &&
+        if ( m_mass[i] != 0.0f        &&
              m_particle[i].type != PARTIQUARTZ )
         {
-            m_particle[i].speed.y -= m_particle[i].mass*rTime;
-
             float h;
             if (m_particle[i].sheet == SH_INTERFACE)
                 h = 0.0f;
             else
-                h = m_terrain->GetFloorLevel(m_particle[i].pos, true);
+                h = m_floorLevel[i];
 
             h += m_particle[i].dim.y*0.75f;
-            if (m_particle[i].pos.y < h)  // impact with the ground?
+            if (m_pos[i].y < h)  // impact with the ground?
             {
                 if ( m_particle[i].type == PARTIPART &&
                      m_particle[i].weight > 3.0f &&  // heavy enough?
@@ -875,21 +991,21 @@ void CParticle::FrameParticle(float rTime)
                     if (amplitude > 1.0f)  amplitude = 1.0f;
                     if (amplitude > 0.0f)
                     {
-                        Play(SOUND_BOUM, m_particle[i].pos, amplitude);
+                        Play(SOUND_BOUM, m_pos[i], amplitude);
                     }
                 }
 
                 if (m_particle[i].bounce < 3)
                 {
-                    m_particle[i].pos.y = h;
-                    m_particle[i].speed.y *= -0.4f;
-                    m_particle[i].speed.x *=  0.4f;
-                    m_particle[i].speed.z *=  0.4f;
+                    m_pos[i].y = h;
+                    m_speed[i].y *= -0.4f;
+                    m_speed[i].x *=  0.4f;
+                    m_speed[i].z *=  0.4f;
                     m_particle[i].bounce ++;  // more impact
                 }
                 else    // disappears after 3 bounces?
                 {
-                    if ( m_particle[i].pos.y < h-10.0f ||
+                    if ( m_pos[i].y < h-10.0f ||
                          m_particle[i].time >= 20.0f   )
                     {
                         DeleteRank(i);
@@ -903,7 +1019,7 @@ void CParticle::FrameParticle(float rTime)
         int r = m_particle[i].trackRank;
         if (r != -1)  // drag exists?
         {
-            if (TrackMove(r, m_particle[i].pos, progress))
+            if (TrackMove(r, m_pos[i], progress))
             {
                 DeleteRank(i);
                 continue;
@@ -985,8 +1101,8 @@ void CParticle::FrameParticle(float rTime)
 
         if (m_particle[i].type == PARTITRACK11)  // phazer shot?
         {
-            CObject* object = SearchObjectGun(m_particle[i].goal, m_particle[i].pos, m_particle[i].type, m_particle[i].objFather);
-            m_particle[i].goal = m_particle[i].pos;
+            CObject* object = SearchObjectGun(m_particle[i].goal, m_pos[i], m_particle[i].type, m_particle[i].objFather);
+            m_particle[i].goal = m_pos[i];
             if (object != nullptr)
             {
                 if (object->GetType() == OBJECT_MOTHER)
@@ -1148,7 +1264,7 @@ void CParticle::FrameParticle(float rTime)
             {
                 m_particle[i].testTime = 0.0f;
 
-                if (m_terrain->GetHeightToFloor(m_particle[i].pos, true) < -2.0f)
+                if (m_terrain->GetHeightToFloor(m_pos[i], true) < -2.0f)
                 {
                     m_exploGunCounter++;
 
@@ -1189,8 +1305,8 @@ void CParticle::FrameParticle(float rTime)
                     continue;
                 }
 
-                CObject* object = SearchObjectGun(m_particle[i].goal, m_particle[i].pos, m_particle[i].type, m_particle[i].objFather);
-                m_particle[i].goal = m_particle[i].pos;
+                CObject* object = SearchObjectGun(m_particle[i].goal, m_pos[i], m_particle[i].type, m_particle[i].objFather);
+                m_particle[i].goal = m_pos[i];
                 if (object != nullptr)
                 {
                     object->ExploObject(EXPLO_BURN, 0.0f, GetDecay(object->GetType()));
@@ -1199,7 +1315,7 @@ void CParticle::FrameParticle(float rTime)
 
                     if (m_exploGunCounter % 2 == 0)
                     {
-                        pos = m_particle[i].pos;
+                        pos = m_pos[i];
                         Math::Vector speed;
                         speed.x = 0.0f;
                         speed.z = 0.0f;
@@ -1254,17 +1370,17 @@ void CParticle::FrameParticle(float rTime)
             if (m_particle[i].testTime >= 0.2f)
             {
                 m_particle[i].testTime = 0.0f;
-                CObject* object = SearchObjectGun(m_particle[i].goal, m_particle[i].pos, m_particle[i].type, m_particle[i].objFather);
-                m_particle[i].goal = m_particle[i].pos;
+                CObject* object = SearchObjectGun(m_particle[i].goal, m_pos[i], m_particle[i].type, m_particle[i].objFather);
+                m_particle[i].goal = m_pos[i];
                 if (object != nullptr)
                 {
                     if (object->GetShieldRadius() > 0.0f)  // protected by shield?
                     {
-                        CreateParticle(m_particle[i].pos, Math::Vector(0.0f, 0.0f, 0.0f), Math::Point(6.0f, 6.0f), PARTIGUNDEL, 2.0f);
+                        CreateParticle(m_pos[i], Math::Vector(0.0f, 0.0f, 0.0f), Math::Point(6.0f, 6.0f), PARTIGUNDEL, 2.0f);
                         if (m_lastTimeGunDel > 0.2f)
                         {
                             m_lastTimeGunDel = 0.0f;
-                            Play(SOUND_GUNDEL, m_particle[i].pos, 1.0f);
+                            Play(SOUND_GUNDEL, m_pos[i], 1.0f);
                         }
                         DeleteRank(i);
                         continue;
@@ -1272,7 +1388,7 @@ void CParticle::FrameParticle(float rTime)
                     else
                     {
                         if (object->GetType() != OBJECT_HUMAN)
-                            Play(SOUND_TOUCH, m_particle[i].pos, 1.0f);
+                            Play(SOUND_TOUCH, m_pos[i], 1.0f);
 
                         object->ExploObject(EXPLO_BOUM, 0.0f);  // starts explosion
                     }
@@ -1299,17 +1415,17 @@ void CParticle::FrameParticle(float rTime)
             if (m_particle[i].testTime >= 0.2f)
             {
                 m_particle[i].testTime = 0.0f;
-                CObject* object = SearchObjectGun(m_particle[i].goal, m_particle[i].pos, m_particle[i].type, m_particle[i].objFather);
-                m_particle[i].goal = m_particle[i].pos;
+                CObject* object = SearchObjectGun(m_particle[i].goal, m_pos[i], m_particle[i].type, m_particle[i].objFather);
+                m_particle[i].goal = m_pos[i];
                 if (object != nullptr)
                 {
                     if (object->GetShieldRadius() > 0.0f)
                     {
-                        CreateParticle(m_particle[i].pos, Math::Vector(0.0f, 0.0f, 0.0f), Math::Point(6.0f, 6.0f), PARTIGUNDEL, 2.0f);
+                        CreateParticle(m_pos[i], Math::Vector(0.0f, 0.0f, 0.0f), Math::Point(6.0f, 6.0f), PARTIGUNDEL, 2.0f);
                         if (m_lastTimeGunDel > 0.2f)
                         {
                             m_lastTimeGunDel = 0.0f;
-                            Play(SOUND_GUNDEL, m_particle[i].pos, 1.0f);
+                            Play(SOUND_GUNDEL, m_pos[i], 1.0f);
                         }
                         DeleteRank(i);
                         continue;
@@ -1339,7 +1455,7 @@ void CParticle::FrameParticle(float rTime)
             {
                 m_particle[i].testTime = 0.0f;
 
-                if (m_terrain->GetHeightToFloor(m_particle[i].pos, true) < -2.0f)
+                if (m_terrain->GetHeightToFloor(m_pos[i], true) < -2.0f)
                 {
                     m_exploGunCounter ++;
 
@@ -1368,8 +1484,8 @@ void CParticle::FrameParticle(float rTime)
                     continue;
                 }
 
-                CObject* object = SearchObjectGun(m_particle[i].goal, m_particle[i].pos, m_particle[i].type, m_particle[i].objFather);
-                m_particle[i].goal = m_particle[i].pos;
+                CObject* object = SearchObjectGun(m_particle[i].goal, m_pos[i], m_particle[i].type, m_particle[i].objFather);
+                m_particle[i].goal = m_pos[i];
                 if (object != nullptr)
                 {
                     object->ExploObject(EXPLO_BOUM, 0.0f, GetDecay(object->GetType()));
@@ -1378,7 +1494,7 @@ void CParticle::FrameParticle(float rTime)
 
                     if (m_exploGunCounter % 2 == 0)
                     {
-                        pos = m_particle[i].pos;
+                        pos = m_pos[i];
                         Math::Vector speed;
                         speed.x = 0.0f;
                         speed.z = 0.0f;
@@ -1627,15 +1743,15 @@ void CParticle::FrameParticle(float rTime)
         {
             float h = 10.0f;
 
-            if ( m_particle[i].pos.y >= eye.y   &&
-                 m_particle[i].pos.y <  eye.y+h )
+            if ( m_pos[i].y >= eye.y   &&
+                 m_pos[i].y <  eye.y+h )
             {
-                m_particle[i].intensity *= (m_particle[i].pos.y-eye.y)/h;
+                m_particle[i].intensity *= (m_pos[i].y-eye.y)/h;
             }
-            if ( m_particle[i].pos.y >  eye.y-h &&
-                 m_particle[i].pos.y <  eye.y   )
+            if ( m_pos[i].y >  eye.y-h &&
+                 m_pos[i].y <  eye.y   )
             {
-                m_particle[i].intensity *= (eye.y-m_particle[i].pos.y)/h;
+                m_particle[i].intensity *= (eye.y-m_pos[i].y)/h;
             }
         }
 
@@ -1716,7 +1832,7 @@ void CParticle::FrameParticle(float rTime)
         if (m_particle[i].type == PARTIBUBBLE)
         {
             if ( progress >= 1.0f ||
-                 m_particle[i].pos.y >= m_water->GetLevel() )
+                 m_pos[i].y >= m_water->GetLevel() )
             {
                 DeleteRank(i);
                 continue;
@@ -1983,7 +2099,7 @@ void CParticle::FrameParticle(float rTime)
             {
                 m_particle[i].testTime = 0.0f;
 
-                pos = m_particle[i].pos;
+                pos = m_pos[i];
                 Math::Vector speed = Math::Vector(0.0f, 0.0f, 0.0f);
                 Math::Point dim;
                 dim.x = 1.0f*(Math::Rand()*0.8f+0.6f);
@@ -2003,12 +2119,12 @@ void CParticle::FrameParticle(float rTime)
             {
                 DeleteRank(i);
 
-                pos = m_particle[i].pos;
+                pos = m_pos[i];
                 Math::Point dim;
                 dim.x    = m_particle[i].dim.x/4.0f;
                 dim.y    = dim.x;
                 float duration = m_particle[i].duration;
-                float mass     = m_particle[i].mass;
+                float mass     = m_mass[i];
                 int total = static_cast<int>((10.0f*m_engine->GetParticleDensity()));
                 for (int j = 0; j < total; j++)
                 {
@@ -2181,9 +2297,9 @@ void CParticle::FrameParticle(float rTime)
             {
                 m_particle[i].time = 0.0f;
                 m_particle[i].duration = 0.5f+Math::Rand()*2.0f;
-                m_particle[i].pos.x = m_particle[i].speed.x + (Math::Rand()-0.5f)*m_particle[i].mass;
-                m_particle[i].pos.y = m_particle[i].speed.y + (Math::Rand()-0.5f)*m_particle[i].mass;
-                m_particle[i].pos.z = m_particle[i].speed.z + (Math::Rand()-0.5f)*m_particle[i].mass;
+                m_pos[i].x = m_speed[i].x + (Math::Rand()-0.5f)*m_mass[i];
+                m_pos[i].y = m_speed[i].y + (Math::Rand()-0.5f)*m_mass[i];
+                m_pos[i].z = m_speed[i].z + (Math::Rand()-0.5f)*m_mass[i];
                 m_particle[i].dim.x = 0.5f+Math::Rand()*1.5f;
                 m_particle[i].dim.y = m_particle[i].dim.x;
                 progress = 0.0f;
@@ -2461,7 +2577,7 @@ void CParticle::FrameParticle(float rTime)
         if (m_particle[i].type == PARTIDROP)
         {
             if (progress >= 1.0f ||
-                m_particle[i].pos.y < m_water->GetLevel())
+                m_pos[i].y < m_water->GetLevel())
             {
                 DeleteRank(i);
                 continue;
@@ -2479,7 +2595,7 @@ void CParticle::FrameParticle(float rTime)
         if (m_particle[i].type == PARTIWATER)
         {
             if (progress >= 1.0f ||
-                m_particle[i].pos.y < m_water->GetLevel())
+                m_pos[i].y < m_water->GetLevel())
             {
                 DeleteRank(i);
                 continue;
@@ -2504,7 +2620,7 @@ void CParticle::FrameParticle(float rTime)
             if (m_particle[i].testTime >= 0.2f)
             {
                 m_particle[i].testTime = 0.0f;
-                CObject* object = SearchObjectRay(m_particle[i].pos, m_particle[i].goal,
+                CObject* object = SearchObjectRay(m_pos[i], m_particle[i].goal,
                                          m_particle[i].type, m_particle[i].objFather);
                 if (object != nullptr)
                     object->ExploObject(EXPLO_BOUM, 0.0f);
@@ -2761,7 +2877,7 @@ void CParticle::DrawParticleTriangle(int i)
     if (m_particle[i].zoom == 0.0f)  return;
 
     Math::Vector eye = m_engine->GetEyePt();
-    Math::Vector pos = m_particle[i].pos;
+    Math::Vector pos = m_pos[i];
 
     CObject* object = m_particle[i].objLink;
     if (object != nullptr)
@@ -2792,13 +2908,11 @@ void CParticle::DrawParticleNorm(int i)
 
 
     Math::Vector corner[4];
-    Vertex vertex[4];
+    VertexTexCol vertex[4];
 
     if (m_particle[i].sheet == SH_INTERFACE)
     {
-        Math::Vector pos = m_particle[i].pos;
-
-        Math::Vector n(0.0f, 0.0f, -1.0f);
+        Math::Vector pos = m_pos[i];
 
         Math::Point dim;
         dim.x = m_particle[i].dim.x * zoom;
@@ -2820,18 +2934,18 @@ void CParticle::DrawParticleNorm(int i)
         corner[3].y = pos.y-dim.y;
         corner[3].z = 0.0f;
 
-        vertex[0] = Vertex(corner[1], n, Math::Point(m_particle[i].texSup.x, m_particle[i].texSup.y));
-        vertex[1] = Vertex(corner[0], n, Math::Point(m_particle[i].texInf.x, m_particle[i].texSup.y));
-        vertex[2] = Vertex(corner[3], n, Math::Point(m_particle[i].texSup.x, m_particle[i].texInf.y));
-        vertex[3] = Vertex(corner[2], n, Math::Point(m_particle[i].texInf.x, m_particle[i].texInf.y));
+        Color color = GetBatchColor(m_particle[i].intensity);
+        vertex[0] = VertexTexCol(corner[1], color, Math::Point(m_particle[i].texSup.x, m_particle[i].texSup.y));
+        vertex[1] = VertexTexCol(corner[0], color, Math::Point(m_particle[i].texInf.x, m_particle[i].texSup.y));
+        vertex[2] = VertexTexCol(corner[3], color, Math::Point(m_particle[i].texSup.x, m_particle[i].texInf.y));
+        vertex[3] = VertexTexCol(corner[2], color, Math::Point(m_particle[i].texInf.x, m_particle[i].texInf.y));
 
-        m_device->DrawPrimitive(PRIMITIVE_TRIANGLE_STRIP, vertex, 4);
-        m_engine->AddStatisticTriangle(2);
+        AddBatchQuad(vertex);
     }
     else
     {
         Math::Vector eye = m_engine->GetEyePt();
-        Math::Vector pos = m_particle[i].pos;
+        Math::Vector pos = m_pos[i];
 
         CObject* object = m_particle[i].objLink;
         if (object != nullptr)
@@ -2847,9 +2961,6 @@ void CParticle::DrawParticleNorm(int i)
         mat.Set(1, 4, pos.x);
         mat.Set(2, 4, pos.y);
         mat.Set(3, 4, pos.z);
-        m_device->SetTransform(TRANSFORM_WORLD, mat);
-
-        Math::Vector n(0.0f, 0.0f, -1.0f);
 
         Math::Point dim;
         dim.x = m_particle[i].dim.x * zoom;
@@ -2871,13 +2982,17 @@ void CParticle::DrawParticleNorm(int i)
         corner[3].y = -dim.y;
         corner[3].z =  0.0f;
 
-        vertex[0] = Vertex(corner[1], n, Math::Point(m_particle[i].texSup.x, m_particle[i].texSup.y));
-        vertex[1] = Vertex(corner[0], n, Math::Point(m_particle[i].texInf.x, m_particle[i].texSup.y));
-        vertex[2] = Vertex(corner[3], n, Math::Point(m_particle[i].texSup.x, m_particle[i].texInf.y));
-        vertex[3] = Vertex(corner[2], n, Math::Point(m_particle[i].texInf.x, m_particle[i].texInf.y));
+        // Batched particles are drawn in world coordinates
+        for (int k = 0; k < 4; k++)
+            corner[k] = Math::Transform(mat, corner[k]);
 
-        m_device->DrawPrimitive(PRIMITIVE_TRIANGLE_STRIP, vertex, 4);
-        m_engine->AddStatisticTriangle(2);
+        Color color = GetBatchColor(m_particle[i].intensity);
+        vertex[0] = VertexTexCol(corner[1], color, Math::Point(m_particle[i].texSup.x, m_particle[i].texSup.y));
+        vertex[1] = VertexTexCol(corner[0], color, Math::Point(m_particle[i].texInf.x, m_particle[i].texSup.y));
+        vertex[2] = VertexTexCol(corner[3], color, Math::Point(m_particle[i].texSup.x, m_particle[i].texInf.y));
+        vertex[3] = VertexTexCol(corner[2], color, Math::Point(m_particle[i].texInf.x, m_particle[i].texInf.y));
+
+        AddBatchQuad(vertex);
     }
 }
 
@@ -2886,7 +3001,7 @@ void CParticle::DrawParticleFlat(int i)
     if (m_particle[i].zoom == 0.0f) return;
     if (m_particle[i].intensity == 0.0f) return;
 
-    Math::Vector pos = m_particle[i].pos;
+    Math::Vector pos = m_pos[i];
 
     CObject* object = m_particle[i].objLink;
     if (object != nullptr)
@@ -2909,9 +3024,6 @@ void CParticle::DrawParticleFlat(int i)
     mat.Set(1, 4, pos.x);
     mat.Set(2, 4, pos.y);
     mat.Set(3, 4, pos.z);
-    m_device->SetTransform(TRANSFORM_WORLD, mat);
-
-    Math::Vector n(0.0f, 0.0f, -1.0f);
 
     Math::Point dim;
     dim.x = m_particle[i].dim.x * m_particle[i].zoom;
@@ -2934,14 +3046,17 @@ void CParticle::DrawParticleFlat(int i)
     corner[3].y = -dim.y;
     corner[3].z =  0.0f;
 
-    Vertex vertex[4];
-    vertex[0] = Vertex(corner[1], n, Math::Point(m_particle[i].texSup.x, m_particle[i].texSup.y));
-    vertex[1] = Vertex(corner[0], n, Math::Point(m_particle[i].texInf.x, m_particle[i].texSup.y));
-    vertex[2] = Vertex(corner[3], n, Math::Point(m_particle[i].texSup.x, m_particle[i].texInf.y));
-    vertex[3] = Vertex(corner[2], n, Math::Point(m_particle[i].texInf.x, m_particle[i].texInf.y));
+    for (int k = 0; k < 4; k++)
+        corner[k] = Math::Transform(mat, corner[k]);
 
-    m_device->DrawPrimitive(PRIMITIVE_TRIANGLE_STRIP, vertex, 4);
-    m_engine->AddStatisticTriangle(2);
+    VertexTexCol vertex[4];
+    Color color = GetBatchColor(m_particle[i].intensity);
+    vertex[0] = VertexTexCol(corner[1], color, Math::Point(m_particle[i].texSup.x, m_particle[i].texSup.y));
+    vertex[1] = VertexTexCol(corner[0], color, Math::Point(m_particle[i].texInf.x, m_particle[i].texSup.y));
+    vertex[2] = VertexTexCol(corner[3], color, Math::Point(m_particle[i].texSup.x, m_particle[i].texInf.y));
+    vertex[3] = VertexTexCol(corner[2], color, Math::Point(m_particle[i].texInf.x, m_particle[i].texInf.y));
+
+    AddBatchQuad(vertex);
 }
 
 void CParticle::DrawParticleFog(int i)
@@ -2949,7 +3064,7 @@ void CParticle::DrawParticleFog(int i)
     if (!m_engine->GetFog()) return;
     if (m_particle[i].intensity == 0.0f) return;
 
-    Math::Vector pos = m_particle[i].pos;
+    Math::Vector pos = m_pos[i];
 
     Math::Point dim;
     dim.x = m_particle[i].dim.x;
@@ -2998,9 +3113,6 @@ void CParticle::DrawParticleFog(int i)
     mat.Set(1, 4, pos.x);
     mat.Set(2, 4, pos.y);
     mat.Set(3, 4, pos.z);
-    m_device->SetTransform(TRANSFORM_WORLD, mat);
-
-    Math::Vector n(0.0f, 0.0f, -1.0f);
 
     Math::Vector corner[4];
 
@@ -3020,15 +3132,18 @@ void CParticle::DrawParticleFog(int i)
     corner[3].y = -dim.y;
     corner[3].z =  0.0f;
 
-    Vertex vertex[4];
+    for (int k = 0; k < 4; k++)
+        corner[k] = Math::Transform(mat, corner[k]);
+
+    VertexTexCol vertex[4];
 
-    vertex[0] = Vertex(corner[1], n, Math::Point(m_particle[i].texSup.x, m_particle[i].texSup.y));
-    vertex[1] = Vertex(corner[0], n, Math::Point(m_particle[i].texInf.x, m_particle[i].texSup.y));
-    vertex[2] = Vertex(corner[3], n, Math::Point(m_particle[i].texSup.x, m_particle[i].texInf.y));
-    vertex[3] = Vertex(corner[2], n, Math::Point(m_particle[i].texInf.x, m_particle[i].texInf.y));
+    Color color = GetBatchColor(m_particle[i].intensity);
+    vertex[0] = VertexTexCol(corner[1], color, Math::Point(m_particle[i].texSup.x, m_particle[i].texSup.y));
+    vertex[1] = VertexTexCol(corner[0], color, Math::Point(m_particle[i].texInf.x, m_particle[i].texSup.y));
+    vertex[2] = VertexTexCol(corner[3], color, Math::Point(m_particle[i].texSup.x, m_particle[i].texInf.y));
+    vertex[3] = VertexTexCol(corner[2], color, Math::Point(m_particle[i].texInf.x, m_particle[i].texInf.y));
 
-    m_device->DrawPrimitive(PRIMITIVE_TRIANGLE_STRIP, vertex, 4);
-    m_engine->AddStatisticTriangle(2);
+    AddBatchQuad(vertex);
 }
 
 void CParticle::DrawParticleRay(int i)
@@ -3037,7 +3152,7 @@ void CParticle::DrawParticleRay(int i)
     if (m_particle[i].intensity == 0.0f)  return;
 
     Math::Vector eye = m_engine->GetEyePt();
-    Math::Vector pos = m_particle[i].pos;
+    Math::Vector pos = m_pos[i];
     Math::Vector goal = m_particle[i].goal;
 
     CObject* object = m_particle[i].objLink;
@@ -3202,9 +3317,9 @@ void CParticle::DrawParticleSphere(int i)
     mat.Set(1, 1, zoom);
     mat.Set(2, 2, zoom);
     mat.Set(3, 3, zoom);
-    mat.Set(1, 4, m_particle[i].pos.x);
-    mat.Set(2, 4, m_particle[i].pos.y);
-    mat.Set(3, 4, m_particle[i].pos.z);
+    mat.Set(1, 4, m_pos[i].x);
+    mat.Set(2, 4, m_pos[i].y);
+    mat.Set(3, 4, m_pos[i].z);
 
     if (m_particle[i].angle != 0.0f)
     {
@@ -3311,9 +3426,9 @@ void CParticle::DrawParticleCylinder(int i)
     mat.Set(1, 1, zoom);
     mat.Set(2, 2, zoom);
     mat.Set(3, 3, zoom);
-    mat.Set(1, 4, m_particle[i].pos.x);
-    mat.Set(2, 4, m_particle[i].pos.y);
-    mat.Set(3, 4, m_particle[i].pos.z);
+    mat.Set(1, 4, m_pos[i].x);
+    mat.Set(2, 4, m_pos[i].y);
+    mat.Set(3, 4, m_pos[i].z);
     m_device->SetTransform(TRANSFORM_WORLD, mat);
 
     Math::Point ts, ti;
@@ -3510,16 +3625,15 @@ void CParticle::DrawParticleWheel(int i)
     ti.x = ti.x-dp;
     ti.y = ti.y-dp;
 
-    Math::Vector n(0.0f, 1.0f, 0.0f);
+    Color color = GetBatchColor(1.0f);
 
-    Vertex vertex[4];
-    vertex[0] = Vertex(pos[0], n, Math::Point(ts.x, ts.y));
-    vertex[1] = Vertex(pos[1], n, Math::Point(ti.x, ts.y));
-    vertex[2] = Vertex(pos[2], n, Math::Point(ts.x, ti.y));
-    vertex[3] = Vertex(pos[3], n, Math::Point(ti.x, ti.y));
+    VertexTexCol vertex[4];
+    vertex[0] = VertexTexCol(pos[0], color, Math::Point(ts.x, ts.y));
+    vertex[1] = VertexTexCol(pos[1], color, Math::Point(ti.x, ts.y));
+    vertex[2] = VertexTexCol(pos[2], color, Math::Point(ts.x, ti.y));
+    vertex[3] = VertexTexCol(pos[3], color, Math::Point(ti.x, ti.y));
 
-    m_device->DrawPrimitive(PRIMITIVE_TRIANGLE_STRIP, vertex, 4);
-    m_engine->AddStatisticTriangle(2);
+    AddBatchQuad(vertex);
 }
 
 void CParticle::DrawParticle(int sheet)
@@ -3527,9 +3641,9 @@ void CParticle::DrawParticle(int sheet)
     // Draw the basic particles of triangles.
     if (m_totalInterface[0][sheet] > 0)
     {
-        for (int i = 0; i < MAXPARTICULE; i++)
+        for (int k = 0; k < static_cast<int>( m_live[0].size() ); k++)
         {
-            if (!m_particle[i].used)  continue;
+            int i = m_live[0][k];
             if (m_particle[i].sheet != sheet)  continue;
             if (m_particle[i].type == PARTIPART)  continue;
 
@@ -3553,13 +3667,12 @@ void CParticle::DrawParticle(int sheet)
     if (m_wheelTraceTotal > 0 && sheet == SH_WORLD)
     {
         m_engine->SetTexture("text.png");
-        m_engine->SetState(ENG_RSTATE_TTEXTURE_WHITE);
-        Math::Matrix mat;
-        mat.LoadIdentity();
-        m_device->SetTransform(TRANSFORM_WORLD, mat);
+        m_batchState = ENG_RSTATE_TTEXTURE_WHITE;
 
         for (int i = 0; i < m_wheelTraceTotal; i++)
             DrawParticleWheel(i);
+
+        FlushBatch();
     }
 
     for (int t = MAXPARTITYPE-1; t >= 1; t--)  // black behind!
@@ -3572,11 +3685,11 @@ void CParticle::DrawParticle(int sheet)
         if (t == 4) state = ENG_RSTATE_TTEXTURE_WHITE;  // text.png
         else        state = ENG_RSTATE_TTEXTURE_BLACK;  // effect[00..02].png
         m_engine->SetState(state);
+        m_batchState = state;
 
-        for (int j = 0; j < MAXPARTICULE; j++)
+        for (int k = 0; k < static_cast<int>( m_live[t].size() ); k++)
         {
-            int i = MAXPARTICULE*t+j;
-            if (!m_particle[i].used)  continue;
+            int i = m_live[t][k];
             if (m_particle[i].sheet != sheet)  continue;
 
             if (!loadTexture)
@@ -3587,18 +3700,21 @@ void CParticle::DrawParticle(int sheet)
                 loadTexture = true;
             }
 
+            // Quads are batched; anything else is drawn at once,
+            // after the batch, to keep the order of drawing
             int r = m_particle[i].trackRank;
             if (r != -1)
             {
+                FlushBatch();
                 m_engine->SetState(state);
                 TrackDraw(r, m_particle[i].type);  // draws the drag
                 if (!m_track[r].drawParticle)  continue;
             }
 
-            m_engine->SetState(state, IntensityToColor(m_particle[i].intensity));
-
             if (m_particle[i].ray)  // ray?
             {
+                FlushBatch();
+                m_engine->SetState(state, IntensityToColor(m_particle[i].intensity));
                 DrawParticleRay(i);
             }
             else if ( m_particle[i].type == PARTIFLIC  ||  // circle in the water?
@@ -3616,11 +3732,15 @@ void CParticle::DrawParticle(int sheet)
             else if ( m_particle[i].type >= PARTISPHERE0 &&
                       m_particle[i].type <= PARTISPHERE9 )  // sphere?
             {
+                FlushBatch();
+                m_engine->SetState(state, IntensityToColor(m_particle[i].intensity));
                 DrawParticleSphere(i);
             }
             else if ( m_particle[i].type >= PARTIPLOUF0 &&
                       m_particle[i].type <= PARTIPLOUF4 )  // cylinder?
             {
+                FlushBatch();
+                m_engine->SetState(state, IntensityToColor(m_particle[i].intensity));
                 DrawParticleCylinder(i);
             }
             else    // normal?
@@ -3628,9 +3748,57 @@ void CParticle::DrawParticle(int sheet)
                 DrawParticleNorm(i);
             }
         }
+
+        FlushBatch();
     }
 }
 
+Color CParticle::GetBatchColor(float intensity)
+{
+    Color color = IntensityToColor(intensity);
+
+    // As the factor of the state (see CEngine::SetState())
+    if (m_batchState & ENG_RSTATE_TTEXTURE_WHITE)
+        color = color.Inverse();
+
+    return color;
+}
+
+void CParticle::AddBatchQuad(const VertexTexCol* vertex)
+{
+    // Triangle strip 0-1-2-3 as two triangles
+    m_batch.push_back(vertex[0]);
+    m_batch.push_back(vertex[1]);
+    m_batch.push_back(vertex[2]);
+    m_batch.push_back(vertex[2]);
+    m_batch.push_back(vertex[1]);
+    m_batch.push_back(vertex[3]);
+}
+
+void CParticle::FlushBatch()
+{
+    if (m_batch.empty())
+        return;
+
+    m_engine->SetState(m_batchState | ENG_RSTATE_VERTEX_COLOR);
+
+    // Vertex colors are used only without lighting
+    bool lighting = m_device->GetRenderState(RENDER_STATE_LIGHTING);
+    m_device->SetRenderState(RENDER_STATE_LIGHTING, false);
+
+    Math::Matrix mat;
+    mat.LoadIdentity();
+    m_device->SetTransform(TRANSFORM_WORLD, mat);
+
+    int count = m_batch.size();
+    m_device->DrawPrimitive(PRIMITIVE_TRIANGLES, &m_batch[0], count);
+    m_engine->AddStatisticTriangle(count / 3);
+
+    m_device->SetRenderState(RENDER_STATE_LIGHTING, lighting);
+
+    m_batch.clear();
+}
+
 CObject* CParticle::SearchObjectGun(Math::Vector old, Math::Vector pos,
                                     ParticleType type, CObject *father)
 {
@@ -3839,20 +4007,20 @@ Color CParticle::GetFogColor(Math::Vector pos)
     {
         int i = m_fog[fog];  // i = rank of the particle
 
-        if (pos.y >= m_particle[i].pos.y+FOG_HSUP)  continue;
-        if (pos.y <= m_particle[i].pos.y-FOG_HINF)  continue;
+        if (pos.y >= m_pos[i].y+FOG_HSUP)  continue;
+        if (pos.y <= m_pos[i].y-FOG_HINF)  continue;
 
-        float dist = Math::DistanceProjected(pos, m_particle[i].pos);
+        float dist = Math::DistanceProjected(pos, m_pos[i]);
         if (dist >= m_particle[i].dim.x*1.5f)  continue;
 
         // Calculates the horizontal distance.
         float factor = 1.0f-powf(dist/(m_particle[i].dim.x*1.5f), 4.0f);
 
         // Calculates the vertical distance.
-        if (pos.y > m_particle[i].pos.y)
-            factor *= 1.0f-(pos.y-m_particle[i].pos.y)/FOG_HSUP;
+        if (pos.y > m_pos[i].y)
+            factor *= 1.0f-(pos.y-m_pos[i].y)/FOG_HSUP;
         else
-            factor *= 1.0f-(m_particle[i].pos.y-pos.y)/FOG_HINF;
+            factor *= 1.0f-(m_pos[i].y-pos.y)/FOG_HINF;
 
         factor *= 0.3f;
 
@@ -205,6 +205,13 @@ enum ParticlePhase
     PARPHEND        = 1,
 };
 
+/**
+ * \struct Particle
+ * \brief State of a particle
+ *
+ * Position, speed, mass and wind sensitivity are kept apart, in arrays of
+ * CParticle, to update the kinematics of all particles in one tight loop.
+ */
 struct Particle
 {
     char            used;      // TRUE -> particle used
@@ -213,13 +220,9 @@ struct Particle
     short           sheet;      // sheet (0..n)
     ParticleType    type;       // type PARTI*
     ParticlePhase   phase;      // phase PARPH*
-    float           mass;       // mass of the particle (in rebounding)
     float           weight;     // weight of the particle (for noise)
     float           duration;   // length of life
-    Math::Vector    pos;        // absolute position (relative if object links)
     Math::Vector    goal;       // goal position (if ray)
-    Math::Vector    speed;      // speed of displacement
-    float           windSensitivity;
     short           bounce;     // number of rebounds
     Math::Point     dim;        // dimensions of the rectangle
     float           zoom;       // zoom (0..1)
@@ -339,6 +342,10 @@ public:
     bool        WriteWheelTrace(const char *filename, int width, int height, Math::Vector dl, Math::Vector ur);
 
 protected:
+    //! Takes a free rank in given type group and adds it to the live list, -1 if none left
+    int         NewRank(int t);
+    //! Marks the particle of given rank unused and gives the rank back to the free list
+    void        FreeRank(int rank);
     //! Removes a particle of given rank
     void        DeleteRank(int rank);
     //! Check a channel number
@@ -359,6 +366,12 @@ protected:
     void        DrawParticleCylinder(int i);
     //! Draws a tire mark
     void        DrawParticleWheel(int i);
+    //! Returns the color of batch vertices for given intensity
+    Color       GetBatchColor(float intensity);
+    //! Adds a quad, given as triangle strip, to the batch
+    void        AddBatchQuad(const VertexTexCol* vertex);
+    //! Draws all quads of the batch in one call
+    void        FlushBatch();
     //! Seeks if an object collided with a bullet
     CObject*    SearchObjectGun(Math::Vector old, Math::Vector pos, ParticleType type, CObject *father);
     //! Seeks if an object collided with a ray
@@ -380,6 +393,31 @@ protected:
     CSoundInterface*  m_sound;
 
     Particle       m_particle[MAXPARTICULE*MAXPARTITYPE];
+    //! Kinematics of the particles, by rank (see Particle)
+    Math::Vector   m_pos[MAXPARTICULE*MAXPARTITYPE];     // absolute position (relative if object links)
+    Math::Vector   m_speed[MAXPARTICULE*MAXPARTITYPE];   // speed of displacement
+    float          m_mass[MAXPARTICULE*MAXPARTITYPE];    // mass of the particle (in rebounding)
+    float          m_windSensitivity[MAXPARTICULE*MAXPARTITYPE];  // 0 outside of the world
+    float          m_windJitter[MAXPARTICULE*MAXPARTITYPE];  // random phase of the wind gusts, in [0..1[
+    float          m_moveTime[MAXPARTICULE*MAXPARTITYPE];    // time of displacement in the current frame, 0 if not moving
+    //! Ranks of the live particles of each type group, in no particular order
+    std::vector<int> m_live[MAXPARTITYPE];
+    //! Index of each particle in its live list, -1 if free
+    int            m_liveIndex[MAXPARTICULE*MAXPARTITYPE];
+    //! Free ranks of each type group
+    std::vector<int> m_free[MAXPARTITYPE];
+    //! End of the used ranks of each type group, for the kinematics loop
+    int            m_rankEnd[MAXPARTITYPE];
+    //! Particles updated in the current frame
+    std::vector<int> m_frameList;
+    //! Unique marks of the particles of m_frameList
+    std::vector<unsigned short> m_frameStamp;
+    //! Particles of m_frameList falling on the ground, and their positions and ground levels
+    std::vector<int> m_floorList;
+    std::vector<Math::Vector> m_floorPos;
+    std::vector<float> m_floorLevels;
+    //! Ground level under each falling particle, for the current frame
+    float          m_floorLevel[MAXPARTICULE*MAXPARTITYPE];
     EngineTriangle m_triangle[MAXPARTICULE];  // triangle if PartiType == 0
     Track          m_track[MAXTRACK];
     int           m_wheelTraceTotal;
@@ -393,6 +431,11 @@ protected:
     int           m_exploGunCounter;
     float         m_lastTimeGunDel;
     float         m_absTime;
+
+    //! Quads of particles with the same texture and state, in world coordinates
+    std::vector<VertexTexCol> m_batch;
+    //! State of the batch
+    int           m_batchState;
 };
 
 
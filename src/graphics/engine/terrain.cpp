@@ -19,10 +19,13 @@
 #include "graphics/engine/terrain.h"
 
 #include "app/app.h"
+#include "app/profiler.h"
 #include "common/iman.h"
 #include "common/image.h"
 #include "common/logger.h"
 #include "graphics/engine/engine.h"
+#include "graphics/engine/imageloader.h"
+#include "graphics/engine/navgrid.h"
 #include "graphics/engine/water.h"
 #include "math/geometry.h"
 
@@ -64,6 +67,9 @@ CTerrain::CTerrain(CInstanceManager* iMan)
     m_flyingLimits.reserve(FLYING_LIMIT_PREALLOCATE_COUNT);
     m_buildingLevels.reserve(BUILDING_LEVEL_PREALLOCATE_COUNT);
 
+    m_navGrid = new CNavGrid(m_iMan, this);
+    m_heightFieldDirty = true;
+
     FlushBuildingLevel();
     FlushFlyingLimit();
     FlushMaterials();
@@ -71,6 +77,8 @@ CTerrain::CTerrain(CInstanceManager* iMan)
 
 CTerrain::~CTerrain()
 {
+    delete m_navGrid;
+    m_navGrid = nullptr;
 }
 
 bool CTerrain::Generate(int mosaicCount, int brickCountPow2, float brickSize,
@@ -101,6 +109,10 @@ bool CTerrain::Generate(int mosaicCount, int brickCountPow2, float brickSize,
     dim = m_mosaicCount*m_mosaicCount;
     std::vector<int>(dim).swap(m_objRanks);
 
+    m_heightField.clear();  // made again with the new size
+    InvalidateHeightField();
+    m_navGrid->InvalidateTerrain();
+
     return true;
 }
 
@@ -199,7 +211,7 @@ bool CTerrain::LoadResources(const std::string& fileName)
 {
     CImage img;
     std::string path = CApplication::GetInstance().GetDataFilePath(DIR_TEXTURE, fileName);
-    if (! img.Load(path))
+    if (! CImageLoader::GetInstancePointer()->LoadImage(path, img))
     {
         GetLogger()->Error("Cannot load resource file: '%s'\n", path.c_str());
         return false;
@@ -267,6 +279,9 @@ TerrainRes CTerrain::GetResource(const Math::Vector &p)
 void CTerrain::FlushRelief()
 {
     m_relief.clear();
+    m_changes.clear();
+    InvalidateHeightField();
+    m_navGrid->InvalidateTerrain();
 }
 
 /**
@@ -279,7 +294,7 @@ bool CTerrain::LoadRelief(const std::string &fileName, float scaleRelief,
 
     CImage img;
     std::string path = CApplication::GetInstance().GetDataFilePath(DIR_TEXTURE, fileName);
-    if (! img.Load(path))
+    if (! CImageLoader::GetInstancePointer()->LoadImage(path, img))
     {
         GetLogger()->Error("Could not load relief file: '%s'!\n", path.c_str());
         return false;
@@ -320,6 +335,7 @@ bool CTerrain::LoadRelief(const std::string &fileName, float scaleRelief,
         }
     }
 
+    InvalidateHeightField();
     return true;
 }
 
@@ -340,6 +356,7 @@ bool CTerrain::AddReliefPoint(Math::Vector pos, float scaleRelief)
     if (m_relief[x+y*size] < pos.y*scaleRelief)
         m_relief[x+y*size] = pos.y*scaleRelief;
 
+    InvalidateHeightField();
     return true;
 }
 
@@ -1185,6 +1202,8 @@ bool CTerrain::CreateSquare(int x, int y)
 bool CTerrain::CreateObjects()
 {
     AdjustRelief();
+    InvalidateHeightField();
+    m_navGrid->InvalidateTerrain();
 
     for (int y = 0; y < m_mosaicCount; y++)
     {
@@ -1257,6 +1276,16 @@ bool CTerrain::Terraform(const Math::Vector &p1, const Math::Vector &p2, float h
     }
     AdjustRelief();
 
+    // Changed points, their neighbours and the points interpolated by AdjustRelief()
+    UpdateHeightField(tp1.x-4, tp1.y-4, tp2.x+4, tp2.y+4);
+
+    Math::Vector min, max;
+    min.x = (tp1.x-2)*m_brickSize-dim;
+    min.z = (tp1.y-2)*m_brickSize-dim;
+    max.x = (tp2.x+2)*m_brickSize-dim;
+    max.z = (tp2.y+2)*m_brickSize-dim;
+    m_navGrid->InvalidateTerrain(min, max);
+
     Math::IntPoint pp1, pp2;
     pp1.x = (tp1.x-2)/m_brickCount;
     pp1.y = (tp1.y-2)/m_brickCount;
@@ -1278,9 +1307,20 @@ bool CTerrain::Terraform(const Math::Vector &p1, const Math::Vector &p2, float h
     }
     m_engine->Update();
 
+    TerrainChange change;
+    change.p1 = p1;
+    change.p2 = p2;
+    change.height = height;
+    m_changes.push_back(change);
+
     return true;
 }
 
+const std::vector<TerrainChange>& CTerrain::GetChanges()
+{
+    return m_changes;
+}
+
 void CTerrain::SetWind(Math::Vector speed)
 {
     m_wind = speed;
@@ -1326,132 +1366,202 @@ float CTerrain::GetCoarseSlope(const Math::Vector &pos)
 
 bool CTerrain::GetNormal(Math::Vector &n, const Math::Vector &p)
 {
-    float dim = (m_mosaicCount*m_brickCount*m_brickSize)/2.0f;
-
-    int x = static_cast<int>((p.x+dim)/m_brickSize);
-    int y = static_cast<int>((p.z+dim)/m_brickSize);
-
-    if ( x < 0 || x > m_mosaicCount*m_brickCount ||
-         y < 0 || y > m_mosaicCount*m_brickCount )  return false;
-
-    Math::Vector p1 = GetVector(x+0, y+0);
-    Math::Vector p2 = GetVector(x+1, y+0);
-    Math::Vector p3 = GetVector(x+0, y+1);
-    Math::Vector p4 = GetVector(x+1, y+1);
-
-    if ( fabs(p.z - p2.z) < fabs(p.x - p2.x) )
-        n = Math::NormalToPlane(p1,p2,p3);
-    else
-        n = Math::NormalToPlane(p2,p4,p3);
+    float dx, dz;
+    const TerrainCell* cell = GetCell(p, dx, dz);
+    if (cell == nullptr)  return false;
 
+    GetCellLevel(cell, dx, dz, &n);
     return true;
 }
 
 float CTerrain::GetFloorLevel(const Math::Vector &pos, bool brut, bool water)
 {
-    float dim = (m_mosaicCount*m_brickCount*m_brickSize)/2.0f;
-
-    int x = static_cast<int>((pos.x+dim)/m_brickSize);
-    int y = static_cast<int>((pos.z+dim)/m_brickSize);
+    float dx, dz;
+    const TerrainCell* cell = GetCell(pos, dx, dz);
+    if (cell == nullptr)  return 0.0f;
 
-    if ( x < 0 || x > m_mosaicCount*m_brickCount ||
-         y < 0 || y > m_mosaicCount*m_brickCount )  return false;
+    Math::Vector ps = pos;
+    ps.y = GetCellLevel(cell, dx, dz, nullptr);
 
-    Math::Vector p1 = GetVector(x+0, y+0);
-    Math::Vector p2 = GetVector(x+1, y+0);
-    Math::Vector p3 = GetVector(x+0, y+1);
-    Math::Vector p4 = GetVector(x+1, y+1);
+    if (!brut && cell->buildingCount > 0) AdjustBuildingLevel(ps);
 
-    Math::Vector ps = pos;
-    if ( fabs(pos.z-p2.z) < fabs(pos.x-p2.x) )
+    if (water)  // not going underwater?
     {
-        if ( !IntersectY(p1, p2, p3, ps) )  return 0.0f;
+        float level = m_water->GetLevel();
+        if (ps.y < level) ps.y = level;  // not under water
     }
-    else
+
+    return ps.y;
+}
+
+float CTerrain::GetHeightToFloor(const Math::Vector &pos, bool brut, bool water)
+{
+    float dx, dz;
+    const TerrainCell* cell = GetCell(pos, dx, dz);
+    if (cell == nullptr)  return 0.0f;
+
+    Math::Vector ps = pos;
+    ps.y = GetCellLevel(cell, dx, dz, nullptr);
+
+    if (!brut && cell->buildingCount > 0) AdjustBuildingLevel(ps);
+
+    if (water)  // not going underwater?
     {
-        if ( !IntersectY(p2, p4, p3, ps) )  return 0.0f;
+        float level = m_water->GetLevel();
+        if (ps.y < level ) ps.y = level;  // not under water
     }
 
-    if (! brut) AdjustBuildingLevel(ps);
+    return pos.y-ps.y;
+}
+
+bool CTerrain::AdjustToFloor(Math::Vector &pos, bool brut, bool water)
+{
+    float dx, dz;
+    const TerrainCell* cell = GetCell(pos, dx, dz);
+    if (cell == nullptr)  return false;
+
+    pos.y = GetCellLevel(cell, dx, dz, nullptr);
+
+    if (!brut && cell->buildingCount > 0) AdjustBuildingLevel(pos);
 
     if (water)  // not going underwater?
     {
         float level = m_water->GetLevel();
-        if (ps.y < level) ps.y = level;  // not under water
+        if (pos.y < level) pos.y = level;  // not under water
     }
 
-    return ps.y;
+    return true;
 }
 
-float CTerrain::GetHeightToFloor(const Math::Vector &pos, bool brut, bool water)
+/**
+ * Gives the same results as GetFloorLevel() for each position; positions
+ * outside of the terrain get 0. Normals, if \a normal is not null, are those
+ * of the relief, without the building levels, as given by GetNormal().
+ */
+void CTerrain::GetFloorLevels(const Math::Vector* pos, float* level, Math::Vector* normal,
+                              int count, bool brut, bool water)
 {
-    float dim = (m_mosaicCount*m_brickCount*m_brickSize)/2.0f;
+    float waterLevel = water ? m_water->GetLevel() : 0.0f;
 
-    int x = static_cast<int>((pos.x+dim)/m_brickSize);
-    int y = static_cast<int>((pos.z+dim)/m_brickSize);
+    for (int i = 0; i < count; i++)
+    {
+        float dx, dz;
+        const TerrainCell* cell = GetCell(pos[i], dx, dz);
+        if (cell == nullptr)
+        {
+            level[i] = 0.0f;
+            if (normal != nullptr)
+                normal[i] = Math::Vector(0.0f, 1.0f, 0.0f);
+            continue;
+        }
 
-    if ( x < 0 || x > m_mosaicCount*m_brickCount ||
-         y < 0 || y > m_mosaicCount*m_brickCount )  return false;
+        Math::Vector ps = pos[i];
+        ps.y = GetCellLevel(cell, dx, dz, normal == nullptr ? nullptr : &normal[i]);
 
-    Math::Vector p1 = GetVector(x+0, y+0);
-    Math::Vector p2 = GetVector(x+1, y+0);
-    Math::Vector p3 = GetVector(x+0, y+1);
-    Math::Vector p4 = GetVector(x+1, y+1);
+        if (!brut && cell->buildingCount > 0) AdjustBuildingLevel(ps);
 
-    Math::Vector ps = pos;
-    if ( fabs(pos.z-p2.z) < fabs(pos.x-p2.x) )
-    {
-        if ( !IntersectY(p1, p2, p3, ps) )  return 0.0f;
+        if (water && ps.y < waterLevel)  // not under water
+            ps.y = waterLevel;
+
+        level[i] = ps.y;
     }
-    else
+}
+
+void CTerrain::InvalidateHeightField()
+{
+    m_heightFieldDirty = true;
+}
+
+void CTerrain::UpdateHeightField(int x1, int y1, int x2, int y2)
+{
+    int size = m_mosaicCount*m_brickCount+1;
+    if (static_cast<int>( m_heightField.size() ) != size*size)  return;  // made at next query
+
+    CProfilerScope scope(PROF_TERRAIN);
+
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 > size-1) x2 = size-1;
+    if (y2 > size-1) y2 = size-1;
+
+    for (int y = y1; y <= y2; y++)
     {
-        if ( !IntersectY(p2, p4, p3, ps) )  return 0.0f;
+        for (int x = x1; x <= x2; x++)
+        {
+            // Same corners as the triangles of CreateMosaic()
+            float h1 = GetVector(x+0, y+0).y;
+            float h2 = GetVector(x+1, y+0).y;
+            float h3 = GetVector(x+0, y+1).y;
+            float h4 = GetVector(x+1, y+1).y;
+
+            TerrainCell& cell = m_heightField[x+y*size];
+            cell.slopeX1 = (h2-h1)/m_brickSize;
+            cell.slopeZ1 = (h3-h1)/m_brickSize;
+            cell.base1   = h1;
+            cell.slopeX2 = (h4-h3)/m_brickSize;
+            cell.slopeZ2 = (h4-h2)/m_brickSize;
+            cell.base2   = h2+h3-h4;
+        }
     }
+}
 
-    if (! brut) AdjustBuildingLevel(ps);
+void CTerrain::ValidateHeightField()
+{
+    if (! m_heightFieldDirty)  return;
 
-    if (water)  // not going underwater?
+    int size = m_mosaicCount*m_brickCount+1;
+    if (static_cast<int>( m_heightField.size() ) != size*size)
     {
-        float level = m_water->GetLevel();
-        if (ps.y < level ) ps.y = level;  // not under water
+        std::vector<TerrainCell>(size*size).swap(m_heightField);
+
+        for (int i = 0; i < static_cast<int>( m_buildingLevels.size() ); i++)
+            StampBuildingLevel(m_buildingLevels[i], 1);
     }
 
-    return pos.y-ps.y;
+    m_heightFieldDirty = false;
+    UpdateHeightField(0, 0, size-1, size-1);
 }
 
-bool CTerrain::AdjustToFloor(Math::Vector &pos, bool brut, bool water)
+const TerrainCell* CTerrain::GetCell(const Math::Vector& pos, float& dx, float& dz)
 {
+    int size = m_mosaicCount*m_brickCount+1;
+
+    ValidateHeightField();
+
     float dim = (m_mosaicCount*m_brickCount*m_brickSize)/2.0f;
 
-    int x = static_cast<int>((pos.x + dim) / m_brickSize);
-    int y = static_cast<int>((pos.z + dim) / m_brickSize);
+    int x = static_cast<int>((pos.x+dim)/m_brickSize);
+    int y = static_cast<int>((pos.z+dim)/m_brickSize);
 
-    if ( x < 0 || x > m_mosaicCount*m_brickCount ||
-         y < 0 || y > m_mosaicCount*m_brickCount )  return false;
+    if ( x < 0 || x >= size ||
+         y < 0 || y >= size )  return nullptr;
 
-    Math::Vector p1 = GetVector(x+0, y+0);
-    Math::Vector p2 = GetVector(x+1, y+0);
-    Math::Vector p3 = GetVector(x+0, y+1);
-    Math::Vector p4 = GetVector(x+1, y+1);
+    dx = pos.x - (x*m_brickSize-dim);
+    dz = pos.z - (y*m_brickSize-dim);
 
-    if (fabs(pos.z - p2.z) < fabs(pos.x - p2.x))
+    return &m_heightField[x+y*size];
+}
+
+float CTerrain::GetCellLevel(const TerrainCell* cell, float dx, float dz, Math::Vector* normal)
+{
+    float slopeX, slopeZ, base;
+    if ( fabs(dz) < fabs(dx-m_brickSize) )  // first triangle?
     {
-        if (! Math::IntersectY(p1, p2, p3, pos)) return false;
+        slopeX = cell->slopeX1;
+        slopeZ = cell->slopeZ1;
+        base   = cell->base1;
     }
     else
     {
-        if (! Math::IntersectY(p2, p4, p3, pos)) return false;
+        slopeX = cell->slopeX2;
+        slopeZ = cell->slopeZ2;
+        base   = cell->base2;
     }
 
-    if (! brut) AdjustBuildingLevel(pos);
+    if (normal != nullptr)
+        *normal = Math::Normalize(Math::Vector(-slopeX, 1.0f, -slopeZ));
 
-    if (water)  // not going underwater?
-    {
-        float level = m_water->GetLevel();
-        if (pos.y < level) pos.y = level;  // not under water
-    }
-
-    return true;
+    return dx*slopeX + dz*slopeZ + base;
 }
 
 /**
@@ -1531,12 +1641,17 @@ bool CTerrain::AdjustToBounds(Math::Vector& pos, float margin)
 
 void CTerrain::FlushBuildingLevel()
 {
+    for (int i = 0; i < static_cast<int>( m_buildingLevels.size() ); i++)
+        StampBuildingLevel(m_buildingLevels[i], -1);
+
     m_buildingLevels.clear();
 }
 
 bool CTerrain::AddBuildingLevel(Math::Vector center, float min, float max,
                                      float height, float factor)
 {
+    float level = GetFloorLevel(center, true);
+
     int i = 0;
     for ( ; i < static_cast<int>( m_buildingLevels.size() ); i++)
     {
@@ -1549,11 +1664,13 @@ bool CTerrain::AddBuildingLevel(Math::Vector center, float min, float max,
 
     if (i == static_cast<int>( m_buildingLevels.size() ))
         m_buildingLevels.push_back(BuildingLevel());
+    else
+        StampBuildingLevel(m_buildingLevels[i], -1);
 
     m_buildingLevels[i].center   = center;
     m_buildingLevels[i].min      = min;
     m_buildingLevels[i].max      = max;
-    m_buildingLevels[i].level    = GetFloorLevel(center, true);
+    m_buildingLevels[i].level    = level;
     m_buildingLevels[i].height   = height;
     m_buildingLevels[i].factor   = factor;
     m_buildingLevels[i].bboxMinX = center.x-max;
@@ -1561,6 +1678,8 @@ bool CTerrain::AddBuildingLevel(Math::Vector center, float min, float max,
     m_buildingLevels[i].bboxMinZ = center.z-max;
     m_buildingLevels[i].bboxMaxZ = center.z+max;
 
+    StampBuildingLevel(m_buildingLevels[i], 1);
+
     return true;
 }
 
@@ -1586,6 +1705,8 @@ bool CTerrain::DeleteBuildingLevel(Math::Vector center)
         if ( center.x == m_buildingLevels[i].center.x &&
              center.z == m_buildingLevels[i].center.z )
         {
+            StampBuildingLevel(m_buildingLevels[i], -1);
+
             for (int j = i+1; j < static_cast<int>( m_buildingLevels.size() ); j++)
                 m_buildingLevels[j-1] = m_buildingLevels[j];
 
@@ -1649,6 +1770,31 @@ void CTerrain::AdjustBuildingLevel(Math::Vector &p)
     }
 }
 
+void CTerrain::StampBuildingLevel(const BuildingLevel& level, int delta)
+{
+    int size = m_mosaicCount*m_brickCount+1;
+    if (static_cast<int>( m_heightField.size() ) != size*size)  return;  // stamped when the field is made
+
+    float dim = (m_mosaicCount*m_brickCount*m_brickSize)/2.0f;
+
+    // Same rounding as GetCell(), so that all points of the box fall in stamped cells
+    int x1 = static_cast<int>((level.bboxMinX+dim)/m_brickSize);
+    int y1 = static_cast<int>((level.bboxMinZ+dim)/m_brickSize);
+    int x2 = static_cast<int>((level.bboxMaxX+dim)/m_brickSize);
+    int y2 = static_cast<int>((level.bboxMaxZ+dim)/m_brickSize);
+
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 > size-1) x2 = size-1;
+    if (y2 > size-1) y2 = size-1;
+
+    for (int y = y1; y <= y2; y++)
+    {
+        for (int x = x1; x <= x2; x++)
+            m_heightField[x+y*size].buildingCount += delta;
+    }
+}
+
 float CTerrain::GetHardness(const Math::Vector &p)
 {
     float factor = GetBuildingFactor(p);
@@ -1802,5 +1948,10 @@ float CTerrain::GetFlyingLimit(Math::Vector pos, bool noLimit)
     return m_flyingMaxHeight;
 }
 
+CNavGrid* CTerrain::GetNavGrid()
+{
+    return m_navGrid;
+}
+
 
 } // namespace Gfx
@@ -34,6 +34,7 @@ namespace Gfx {
 
 class CEngine;
 class CWater;
+class CNavGrid;
 
 
 //! Limit of slope considered a flat piece of land
@@ -87,6 +88,35 @@ struct BuildingLevel
     }
 };
 
+/**
+ * \struct TerrainCell
+ * \brief Precomputed ground of one cell of the relief
+ *
+ * Each cell is made of two triangles; the height of a point in a triangle is
+ * dx*slopeX + dz*slopeZ + base, where dx and dz are measured from the lower
+ * corner of the cell. The structure takes 32 bytes, so a cell is read
+ * with a single cache line.
+ */
+struct TerrainCell
+{
+    //! Triangle with corners (0,0), (1,0), (0,1)
+    float       slopeX1, slopeZ1, base1;
+    //! Triangle with corners (1,0), (1,1), (0,1)
+    float       slopeX2, slopeZ2, base2;
+    //! Number of building levels covering the cell
+    int         buildingCount;
+    //! Unused, rounds the size up to 32 bytes
+    int         pad;
+
+    TerrainCell()
+    {
+        slopeX1 = slopeZ1 = base1 = 0.0f;
+        slopeX2 = slopeZ2 = base2 = 0.0f;
+        buildingCount = 0;
+        pad = 0;
+    }
+};
+
 /**
  * \struct TerrainMaterial
  * \brief Material for ground surface
@@ -130,6 +160,22 @@ struct TerrainMaterialPoint
     }
 };
 
+/**
+ * \struct TerrainChange
+ * \brief Modification of the relief done by CTerrain::Terraform()
+ */
+struct TerrainChange
+{
+    Math::Vector p1;
+    Math::Vector p2;
+    float        height;
+
+    TerrainChange()
+    {
+        height = 0.0f;
+    }
+};
+
 /**
  * \struct FlyingLimit
  * \brief Spherical limit of flight
@@ -219,6 +265,21 @@ struct FlyingLimit
  *
  * Terrain also specifies flying limits for player: one global level and possible
  * additional spherical restrictions.
+ *
+ * The navigation grid used by robots to find paths (CNavGrid) is owned
+ * by the terrain, which invalidates it when the relief changes.
+ *
+ * \section HeightField Height field
+ *
+ * Ground level queries (GetFloorLevel(), GetNormal() etc.) read a grid of
+ * TerrainCell with the planes of the relief triangles already computed.
+ * The grid is rebuilt lazily after the relief is loaded or generated;
+ * Terraform() updates only the cells it changed. Cells also count building
+ * levels covering them, so the building levels are only looked at
+ * where there are some. GetFloorLevels() answers many queries at once.
+ *
+ * Queries are read-only once the grid is built: ValidateHeightField() builds it
+ * ahead of queries made from several threads.
  */
 class CTerrain
 {
@@ -255,6 +316,8 @@ public:
 
     //! Modifies the terrain's relief
     bool        Terraform(const Math::Vector& p1, const Math::Vector& p2, float height);
+    //! Returns the modifications done by Terraform() since the relief was flushed
+    const std::vector<TerrainChange>& GetChanges();
 
     //@{
     //! Management of the wind
@@ -262,6 +325,9 @@ public:
     Math::Vector GetWind();
     //@}
 
+    //! Rebuilds the height field now if it is out of date
+    void        ValidateHeightField();
+
     //! Gives the exact slope of the terrain at 2D (XZ) position
     float       GetFineSlope(const Math::Vector& pos);
     //! Gives the approximate slope of the terrain at 2D (XZ) position
@@ -274,6 +340,9 @@ public:
     float       GetHeightToFloor(const Math::Vector& pos, bool brut=false, bool water=false);
     //! Modifies the Y coordinate of 3D position to rest on the ground floor
     bool        AdjustToFloor(Math::Vector& pos, bool brut=false, bool water=false);
+    //! Returns the heights of the ground level, and optionally the normals, at many 2D (XZ) positions
+    void        GetFloorLevels(const Math::Vector* pos, float* level, Math::Vector* normal,
+                               int count, bool brut=false, bool water=false);
     //! Adjusts 3D position so that it is within standard terrain boundaries
     bool        AdjustToStandardBounds(Math::Vector &pos);
     //! Adjusts 3D position so that it is within terrain boundaries and the given margin
@@ -320,6 +389,9 @@ public:
     //! Returns the maximum height of flight
     float       GetFlyingLimit(Math::Vector pos, bool noLimit);
 
+    //! Returns the navigation grid used to find paths on the terrain
+    CNavGrid*   GetNavGrid();
+
 protected:
     //! Adds a point of elevation in the buffer of relief
     bool        AddReliefPoint(Math::Vector pos, float scaleRelief);
@@ -357,14 +429,29 @@ protected:
 
     //! Adjusts a position according to a possible rise
     void        AdjustBuildingLevel(Math::Vector &p);
+    //! Adds \a delta to the building count of cells covered by a building level
+    void        StampBuildingLevel(const BuildingLevel& level, int delta);
+
+    //! Marks the whole height field to be rebuilt before the next query
+    void        InvalidateHeightField();
+    //! Computes the cells of the height field in given range (in cells)
+    void        UpdateHeightField(int x1, int y1, int x2, int y2);
+    //! Returns the cell of the height field at position, and the position within the cell
+    const TerrainCell* GetCell(const Math::Vector& pos, float& dx, float& dz);
+    //! Returns the raw height of the relief in a cell, and optionally the normal
+    float       GetCellLevel(const TerrainCell* cell, float dx, float dz, Math::Vector* normal);
 
 protected:
     CInstanceManager* m_iMan;
     CEngine*        m_engine;
     CWater*         m_water;
+    //! Navigation grid, kept up to date with the relief
+    CNavGrid*       m_navGrid;
 
     //! Relief data points
     std::vector<float> m_relief;
+    //! Modifications of the relief, in order, to replay them when loading a game
+    std::vector<TerrainChange> m_changes;
     //! Resources data
     std::vector<unsigned char> m_resources;
     //! Texture indices
@@ -411,6 +498,11 @@ protected:
 
     std::vector<BuildingLevel> m_buildingLevels;
 
+    //! Precomputed relief, (m_mosaicCount*m_brickCount+1)^2 cells
+    std::vector<TerrainCell> m_heightField;
+    //! Height field must be rebuilt
+    bool            m_heightFieldDirty;
+
     //! Wind speed
     Math::Vector    m_wind;
 
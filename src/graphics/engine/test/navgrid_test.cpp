@@ -0,0 +1,146 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+// graphics/engine/test/navgrid_test.cpp
+
+/*
+  Unit tests for the navigation grid and its path planner, on flat ground
+ */
+
+#include "common/iman.h"
+#include "graphics/engine/navgrid.h"
+#include "graphics/engine/terrain.h"
+#include "graphics/engine/water.h"
+#include "math/geometry.h"
+#include "object/object.h"
+
+#include "gtest/gtest.h"
+
+
+class NavGridTest : public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        m_water   = new Gfx::CWater(&m_iMan, nullptr);
+        m_terrain = new Gfx::CTerrain(&m_iMan);
+        m_grid    = new Gfx::CNavGrid(&m_iMan, m_terrain);
+
+        // Wheeled robot, crash sphere of OBJECT_MOBILEwa
+        m_agent.radius     = 4.5f;
+        m_agent.slopeLimit = 20.0f*Math::PI/180.0f;
+    }
+
+    virtual void TearDown()
+    {
+        for (int i = 0; i < static_cast<int>( m_objects.size() ); i++)
+            delete m_objects[i];
+
+        delete m_grid;
+        delete m_terrain;
+        delete m_water;
+    }
+
+    CObject* AddObstacle(const Math::Vector& pos, float radius)
+    {
+        CObject* object = new CObject(&m_iMan);
+        object->SetType(OBJECT_STONE);
+        object->SetPosition(0, pos);
+        object->CreateCrashSphere(Math::Vector(0.0f, 1.0f, 0.0f), radius, SOUND_BOUMm);
+        m_grid->AddObject(object);
+        m_objects.push_back(object);
+        return object;
+    }
+
+    std::vector<Math::Vector> FindPath(const Math::Vector& start, const Math::Vector& goal)
+    {
+        Gfx::CNavSearch search;
+        search.Start(m_grid, m_agent, start, goal, 0.0f);
+
+        Error err = ERR_CONTINUE;
+        while (err == ERR_CONTINUE)
+            err = search.Step(1000, 100);
+
+        EXPECT_EQ(ERR_OK, err);
+        return search.GetPath();
+    }
+
+    //! Smallest distance in the XZ plane between a path and a point
+    float GetDistance(const std::vector<Math::Vector>& path, const Math::Vector& center)
+    {
+        float min = 1e6f;
+        for (int i = 0; i+1 < static_cast<int>( path.size() ); i++)
+        {
+            for (int j = 0; j <= 100; j++)
+            {
+                Math::Vector p = path[i] + (path[i+1]-path[i])*(j/100.0f);
+                min = Math::Min(min, Math::DistanceProjected(p, center));
+            }
+        }
+        return min;
+    }
+
+    CInstanceManager m_iMan;
+    Gfx::CWater* m_water;
+    Gfx::CTerrain* m_terrain;
+    Gfx::CNavGrid* m_grid;
+    Gfx::NavAgent m_agent;
+    std::vector<CObject*> m_objects;
+};
+
+
+TEST_F(NavGridTest, StraightPathWithoutObstacle)
+{
+    std::vector<Math::Vector> path = FindPath(Math::Vector(-40.0f, 0.0f, 2.5f), Math::Vector(40.0f, 0.0f, 2.5f));
+
+    EXPECT_EQ(2, static_cast<int>( path.size() ));
+}
+
+TEST_F(NavGridTest, WheeledPathKeepsRadiusFromCrashSphere)
+{
+    for (int k = 0; k < 5; k++)
+    {
+        // Several places of the sphere in its cell
+        Math::Vector center(k*1.2f, 0.0f, 1.0f+k*0.7f);
+        float radius = 5.0f;
+
+        TearDown();
+        m_objects.clear();
+        SetUp();
+        AddObstacle(center, radius);
+
+        std::vector<Math::Vector> path = FindPath(Math::Vector(-40.0f, 0.0f, center.z), Math::Vector(40.0f, 0.0f, center.z));
+
+        ASSERT_GE(static_cast<int>( path.size() ), 3);
+        EXPECT_GE(GetDistance(path, center), radius+m_agent.radius);
+    }
+}
+
+TEST_F(NavGridTest, PositionTouchingCrashSphereIsBlocked)
+{
+    Math::Vector center(2.5f, 0.0f, 2.5f);
+    AddObstacle(center, 5.0f);
+
+    // The robot would overlap the sphere
+    EXPECT_TRUE(m_grid->TestPosition(m_agent, center+Math::Vector(5.0f+m_agent.radius-1.0f, 0.0f, 0.0f)));
+    EXPECT_FALSE(m_grid->TestPosition(m_agent, center+Math::Vector(30.0f, 0.0f, 0.0f)));
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,64 @@
+#include "object/object.h"
+
+// Only the position, type and crash spheres of the object
+
+CObject::CObject(CInstanceManager* iMan)
+{
+    m_iMan = iMan;
+    m_type = OBJECT_NULL;
+    m_truck = nullptr;
+    m_crashSphereUsed = 0;
+    m_objectPart[0].position = Math::Vector(0.0f, 0.0f, 0.0f);
+}
+
+CObject::~CObject()
+{
+}
+
+void CObject::SetType(ObjectType type)
+{
+    m_type = type;
+}
+
+ObjectType CObject::GetType()
+{
+    return m_type;
+}
+
+int CObject::CreateCrashSphere(Math::Vector pos, float radius, Sound sound, float hardness)
+{
+    m_crashSpherePos[m_crashSphereUsed] = pos;
+    m_crashSphereRadius[m_crashSphereUsed] = radius;
+    m_crashSphereHardness[m_crashSphereUsed] = hardness;
+    m_crashSphereSound[m_crashSphereUsed] = sound;
+    return m_crashSphereUsed++;
+}
+
+bool CObject::GetCrashSphere(int rank, Math::Vector &pos, float &radius)
+{
+    if ( rank < 0 || rank >= m_crashSphereUsed )
+    {
+        pos = m_objectPart[0].position;
+        radius = 0.0f;
+        return false;
+    }
+
+    pos = m_objectPart[0].position + m_crashSpherePos[rank];
+    radius = m_crashSphereRadius[rank];
+    return true;
+}
+
+void CObject::SetPosition(int part, const Math::Vector &pos)
+{
+    m_objectPart[part].position = pos;
+}
+
+Math::Vector CObject::GetPosition(int part)
+{
+    return m_objectPart[part].position;
+}
+
+CObject* CObject::GetTruck()
+{
+    return m_truck;
+}
@@ -0,0 +1,34 @@
+#include "graphics/engine/terrain.h"
+#include "common/iman.h"
+
+namespace Gfx {
+
+// Flat ground at level 0
+
+CTerrain::CTerrain(CInstanceManager* iMan)
+{
+    m_iMan = iMan;
+    m_iMan->AddInstance(CLASS_TERRAIN, this);
+    m_flyingMaxHeight = 280.0f;
+}
+
+CTerrain::~CTerrain()
+{
+}
+
+float CTerrain::GetFineSlope(const Math::Vector& pos)
+{
+    return 0.0f;
+}
+
+float CTerrain::GetFloorLevel(const Math::Vector& pos, bool brut, bool water)
+{
+    return 0.0f;
+}
+
+float CTerrain::GetFlyingMaxHeight()
+{
+    return m_flyingMaxHeight;
+}
+
+} // namespace Gfx
@@ -0,0 +1,23 @@
+#include "graphics/engine/water.h"
+
+namespace Gfx {
+
+// Water far below the ground
+
+CWater::CWater(CInstanceManager* iMan, CEngine* engine)
+{
+    m_iMan = iMan;
+    m_iMan->AddInstance(CLASS_WATER, this);
+    m_level = -100.0f;
+}
+
+CWater::~CWater()
+{
+}
+
+float CWater::GetLevel()
+{
+    return m_level;
+}
+
+} // namespace Gfx
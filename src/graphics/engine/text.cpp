@@ -33,6 +33,21 @@
 namespace Gfx {
 
 
+/**
+ * \struct FontTexture
+ * \brief Texture holding characters of one font, filled row by row
+ */
+struct FontTexture
+{
+    Texture texture;
+    //! Position for the next character
+    Math::IntPoint pos;
+    //! Height of the highest character in the current row
+    int rowHeight;
+
+    FontTexture() : rowHeight(0) {}
+};
+
 /**
  * \struct CachedFont
  * \brief Base TTF font with UTF-8 char cache
@@ -41,8 +56,12 @@ struct CachedFont
 {
     TTF_Font* font;
     std::map<UTF8Char, CharTexture> cache;
+    //! Textures holding the characters in cache
+    std::vector<FontTexture> textures;
+    //! Value of CText::m_useCounter when the font was last drawn
+    int lastUse;
 
-    CachedFont() : font(nullptr) {}
+    CachedFont() : font(nullptr), lastUse(0) {}
 };
 
 
@@ -62,6 +81,10 @@ CText::CText(CInstanceManager *iMan, CEngine* engine)
     m_lastFontType = FONT_COLOBOT;
     m_lastFontSize = 0;
     m_lastCachedFont = nullptr;
+
+    m_fontTextureCount = 0;
+    m_useCounter = 0;
+    m_quadTexture = 0;
 }
 
 CText::~CText()
@@ -109,6 +132,7 @@ void CText::Destroy()
         {
             CachedFont* cf = (*jt).second;
 
+            FreeFontTextures(cf);
             TTF_CloseFont(cf->font);
 
             cf->font = nullptr;
@@ -138,6 +162,10 @@ std::string CText::GetError()
 
 void CText::FlushCache()
 {
+    // The textures belong to the previous device and are not destroyed here
+    m_quads.clear();
+    m_fontTextureCount = 0;
+
     for (auto it = m_fonts.begin(); it != m_fonts.end(); ++it)
     {
         MultisizeFont *mf = (*it).second;
@@ -145,6 +173,7 @@ void CText::FlushCache()
         {
             CachedFont *f = (*jt).second;
             f->cache.clear();
+            f->textures.clear();
         }
     }
 }
@@ -313,12 +342,15 @@ float CText::GetStringWidth(const std::string &text, FontType font, float size)
 
     // TODO: special chars?
 
-    CachedFont* cf = GetOrOpenFont(font, size);
-    assert(cf != nullptr);
-    Math::IntPoint wndSize;
-    TTF_SizeUTF8(cf->font, text.c_str(), &wndSize.x, &wndSize.y);
-    Math::Point ifSize = m_engine->WindowToInterfaceSize(wndSize);
-    return ifSize.x;
+    // Sum of cached character widths is cheaper than laying out the string with TTF_SizeUTF8()
+    std::vector<UTF8Char> chars;
+    StringToUTFCharList(text, chars);
+
+    float width = 0.0f;
+    for (int i = 0; i < static_cast<int>( chars.size() ); i++)
+        width += GetCharWidth(chars[i], font, size, width);
+
+    return width;
 }
 
 float CText::GetCharWidth(UTF8Char ch, FontType font, float size, float offset)
@@ -332,13 +364,7 @@ float CText::GetCharWidth(UTF8Char ch, FontType font, float size, float offset)
     CachedFont* cf = GetOrOpenFont(font, size);
     assert(cf != nullptr);
 
-    CharTexture tex;
-    auto it = cf->cache.find(ch);
-    if (it != cf->cache.end())
-        tex = (*it).second;
-    else
-        tex = CreateCharTexture(ch, cf);
-
+    CharTexture tex = GetCharTexture(ch, cf);
     return tex.charSize.x;
 }
 
@@ -504,6 +530,8 @@ void CText::DrawString(const std::string &text, std::map<unsigned int, FontMetaC
                        float size, Math::Point pos, float width, int eol, Color color)
 {
     m_engine->SetState(ENG_RSTATE_TEXT);
+    m_quadColor = color;
+    m_useCounter++;
 
     float start = pos.x;
 
@@ -544,6 +572,8 @@ void CText::DrawString(const std::string &text, std::map<unsigned int, FontMetaC
         fmtIndex++;
     }
 
+    FlushQuads();
+
     // TODO: eol
 }
 
@@ -575,6 +605,8 @@ void CText::DrawString(const std::string &text, FontType font,
     assert(font != FONT_BUTTON);
 
     m_engine->SetState(ENG_RSTATE_TEXT);
+    m_quadColor = color;
+    m_useCounter++;
 
     std::vector<UTF8Char> chars;
     StringToUTFCharList(text, chars);
@@ -582,6 +614,8 @@ void CText::DrawString(const std::string &text, FontType font,
     {
         DrawCharAndAdjustPos(*it, font, size, pos, color);
     }
+
+    FlushQuads();
 }
 
 void CText::DrawHighlight(FontHighlight hl, Math::Point pos, Math::Point size)
@@ -685,38 +719,34 @@ void CText::DrawCharAndAdjustPos(UTF8Char ch, FontType font, float size, Math::P
             width = 4;
     }
 
-    auto it = cf->cache.find(ch);
-    CharTexture tex;
-    if (it != cf->cache.end())
-    {
-        tex = (*it).second;
-    }
-    else
-    {
-        tex = CreateCharTexture(ch, cf);
+    CharTexture tex = GetCharTexture(ch, cf);
+    if (tex.id == 0) // invalid
+        return;
 
-        if (tex.id == 0) // invalid
-            return;
+    cf->lastUse = m_useCounter;
 
-        cf->cache[ch] = tex;
+    if (tex.id != m_quadTexture)
+    {
+        FlushQuads();
+        m_quadTexture = tex.id;
     }
 
-    Math::Point p1(pos.x, pos.y + tex.charSize.y - tex.texSize.y);
-    Math::Point p2(pos.x + tex.texSize.x * width, pos.y + tex.charSize.y);
+    Math::Point p1(pos.x, pos.y);
+    Math::Point p2(pos.x + tex.charSize.x * width, pos.y + tex.charSize.y);
 
     Math::Vector n(0.0f, 0.0f, -1.0f);  // normal
 
-    Vertex quad[4] =
-    {
-        Vertex(Math::Vector(p1.x, p1.y, 0.0f), n, Math::Point(0.0f, 1.0f)),
-        Vertex(Math::Vector(p1.x, p2.y, 0.0f), n, Math::Point(0.0f, 0.0f)),
-        Vertex(Math::Vector(p2.x, p1.y, 0.0f), n, Math::Point(1.0f, 1.0f)),
-        Vertex(Math::Vector(p2.x, p2.y, 0.0f), n, Math::Point(1.0f, 0.0f))
-    };
+    Vertex bottomLeft (Math::Vector(p1.x, p1.y, 0.0f), n, Math::Point(tex.uv1.x, tex.uv2.y));
+    Vertex topLeft    (Math::Vector(p1.x, p2.y, 0.0f), n, Math::Point(tex.uv1.x, tex.uv1.y));
+    Vertex bottomRight(Math::Vector(p2.x, p1.y, 0.0f), n, Math::Point(tex.uv2.x, tex.uv2.y));
+    Vertex topRight   (Math::Vector(p2.x, p2.y, 0.0f), n, Math::Point(tex.uv2.x, tex.uv1.y));
 
-    m_device->SetTexture(0, tex.id);
-    m_device->DrawPrimitive(PRIMITIVE_TRIANGLE_STRIP, quad, 4, color);
-    m_engine->AddStatisticTriangle(2);
+    m_quads.push_back(bottomLeft);
+    m_quads.push_back(topLeft);
+    m_quads.push_back(bottomRight);
+    m_quads.push_back(bottomRight);
+    m_quads.push_back(topLeft);
+    m_quads.push_back(topRight);
 
     pos.x += tex.charSize.x * width;
 }
@@ -762,6 +792,33 @@ CachedFont* CText::GetOrOpenFont(FontType font, float size)
     return m_lastCachedFont;
 }
 
+void CText::FlushQuads()
+{
+    if (m_quads.empty())
+        return;
+
+    int count = static_cast<int>( m_quads.size() );
+
+    m_device->SetTexture(0, m_quadTexture);
+    m_device->DrawPrimitive(PRIMITIVE_TRIANGLES, &m_quads[0], count, m_quadColor);
+    m_engine->AddStatisticTriangle(count / 3);
+
+    m_quads.clear();
+}
+
+CharTexture CText::GetCharTexture(UTF8Char ch, CachedFont* font)
+{
+    auto it = font->cache.find(ch);
+    if (it != font->cache.end())
+        return (*it).second;
+
+    CharTexture tex = CreateCharTexture(ch, font);
+    if (tex.id != 0)
+        font->cache[ch] = tex;
+
+    return tex;
+}
+
 CharTexture CText::CreateCharTexture(UTF8Char ch, CachedFont* font)
 {
     CharTexture texture;
@@ -777,16 +834,74 @@ CharTexture CText::CreateCharTexture(UTF8Char ch, CachedFont* font)
         return texture;
     }
 
-    int w = Math::NextPowerOfTwo(textSurface->w);
-    int h = Math::NextPowerOfTwo(textSurface->h);
+    Math::IntPoint size(textSurface->w, textSurface->h);
+
+    FontTexture* fontTexture = GetFontTextureForChar(font, size);
+    if (fontTexture == nullptr)
+    {
+        SDL_FreeSurface(textSurface);
+        return texture;
+    }
 
     textSurface->flags = textSurface->flags & (~SDL_SRCALPHA);
-    SDL_Surface* textureSurface = SDL_CreateRGBSurface(0, w, h, 32, 0x00ff0000, 0x0000ff00,
-                                                       0x000000ff, 0xff000000);
-    SDL_BlitSurface(textSurface, NULL, textureSurface, NULL);
+    SDL_Surface* charSurface = SDL_CreateRGBSurface(0, size.x, size.y, 32, 0x00ff0000, 0x0000ff00,
+                                                    0x000000ff, 0xff000000);
+    SDL_BlitSurface(textSurface, NULL, charSurface, NULL);
 
     ImageData data;
-    data.surface = textureSurface;
+    data.surface = charSurface;
+
+    m_device->UpdateTexture(fontTexture->texture, fontTexture->pos, &data, TEX_IMG_RGBA);
+
+    data.surface = nullptr;
+
+    texture.id = fontTexture->texture.id;
+    texture.uv1.x = static_cast<float>(fontTexture->pos.x) / FONT_TEXTURE_SIZE;
+    texture.uv1.y = static_cast<float>(fontTexture->pos.y) / FONT_TEXTURE_SIZE;
+    texture.uv2.x = static_cast<float>(fontTexture->pos.x + size.x) / FONT_TEXTURE_SIZE;
+    texture.uv2.y = static_cast<float>(fontTexture->pos.y + size.y) / FONT_TEXTURE_SIZE;
+    texture.charSize = m_engine->WindowToInterfaceSize(size);
+
+    fontTexture->pos.x += size.x + FONT_TEXTURE_PADDING;
+    if (size.y > fontTexture->rowHeight)
+        fontTexture->rowHeight = size.y;
+
+    SDL_FreeSurface(textSurface);
+    SDL_FreeSurface(charSurface);
+
+    return texture;
+}
+
+FontTexture* CText::GetFontTextureForChar(CachedFont* font, Math::IntPoint size)
+{
+    if (size.x > FONT_TEXTURE_SIZE || size.y > FONT_TEXTURE_SIZE)
+    {
+        m_error = "Character too big for font texture";
+        return nullptr;
+    }
+
+    if (! font->textures.empty())
+    {
+        FontTexture& fontTexture = font->textures.back();
+
+        if (fontTexture.pos.x + size.x > FONT_TEXTURE_SIZE)  // next row
+        {
+            fontTexture.pos.x = 0;
+            fontTexture.pos.y += fontTexture.rowHeight + FONT_TEXTURE_PADDING;
+            fontTexture.rowHeight = 0;
+        }
+
+        if (fontTexture.pos.y + size.y <= FONT_TEXTURE_SIZE)
+            return &fontTexture;
+    }
+
+    if (m_fontTextureCount >= FONT_MAX_TEXTURES)
+        FreeOldestFont(font);
+
+    // New SDL surfaces are cleared, so the texture starts fully transparent
+    ImageData data;
+    data.surface = SDL_CreateRGBSurface(0, FONT_TEXTURE_SIZE, FONT_TEXTURE_SIZE, 32, 0x00ff0000, 0x0000ff00,
+                                        0x000000ff, 0xff000000);
 
     TextureCreateParams createParams;
     createParams.format = TEX_IMG_RGBA;
@@ -794,26 +909,60 @@ CharTexture CText::CreateCharTexture(UTF8Char ch, CachedFont* font)
     createParams.magFilter = TEX_MAG_FILTER_NEAREST;
     createParams.mipmap = false;
 
-    Texture tex = m_device->CreateTexture(&data, createParams);
+    FontTexture fontTexture;
+    fontTexture.texture = m_device->CreateTexture(&data, createParams);
 
+    SDL_FreeSurface(data.surface);
     data.surface = nullptr;
 
-    if (! tex.Valid())
+    if (! fontTexture.texture.Valid())
     {
         m_error = "Texture create error";
-        return texture;
+        return nullptr;
     }
-    else
+
+    font->textures.push_back(fontTexture);
+    m_fontTextureCount++;
+
+    return &font->textures.back();
+}
+
+void CText::FreeOldestFont(CachedFont* current)
+{
+    // Characters waiting to be drawn may be in the freed textures
+    FlushQuads();
+
+    CachedFont* oldest = nullptr;
+
+    for (auto it = m_fonts.begin(); it != m_fonts.end(); ++it)
     {
-        texture.id = tex.id;
-        texture.texSize =  m_engine->WindowToInterfaceSize(Math::IntPoint(textureSurface->w, textureSurface->h));
-        texture.charSize = m_engine->WindowToInterfaceSize(Math::IntPoint(textSurface->w, textSurface->h));
+        MultisizeFont* mf = (*it).second;
+        for (auto jt = mf->fonts.begin(); jt != mf->fonts.end(); ++jt)
+        {
+            CachedFont* cf = (*jt).second;
+            if (cf == current || cf->textures.empty())
+                continue;
+
+            if (oldest == nullptr || cf->lastUse < oldest->lastUse)
+                oldest = cf;
+        }
     }
 
-    SDL_FreeSurface(textSurface);
-    SDL_FreeSurface(textureSurface);
+    if (oldest == nullptr)
+        oldest = current;
 
-    return texture;
+    FreeFontTextures(oldest);
+}
+
+void CText::FreeFontTextures(CachedFont* font)
+{
+    for (int i = 0; i < static_cast<int>( font->textures.size() ); i++)
+        m_device->DestroyTexture(font->textures[i].texture);
+
+    m_fontTextureCount -= static_cast<int>( font->textures.size() );
+
+    font->textures.clear();
+    font->cache.clear();
 }
 
 
@@ -24,7 +24,9 @@
 
 
 #include "graphics/core/color.h"
+#include "graphics/core/vertex.h"
 
+#include "math/intpoint.h"
 #include "math/point.h"
 
 #include <vector>
@@ -45,6 +47,13 @@ const float FONT_SIZE_SMALL = 12.0f;
 //! Standard big font size
 const float FONT_SIZE_BIG = 18.0f;
 
+//! Width and height of textures holding rendered characters
+const int FONT_TEXTURE_SIZE = 256;
+//! Empty pixels between characters in a font texture
+const int FONT_TEXTURE_PADDING = 1;
+//! Maximum number of font textures of all fonts together
+const int FONT_MAX_TEXTURES = 32;
+
 /**
  * \enum TextAlign
  * \brief Type of text alignment
@@ -181,19 +190,24 @@ struct UTF8Char
 
 /**
  * \struct CharTexture
- * \brief Texture of font character
+ * \brief Font character in a font texture
  */
 struct CharTexture
 {
+    //! Font texture holding the character
     unsigned int id;
-    Math::Point texSize;
+    //! Top-left corner of the character in the texture
+    Math::Point uv1;
+    //! Bottom-right corner of the character in the texture
+    Math::Point uv2;
     Math::Point charSize;
 
     CharTexture() : id(0) {}
 };
 
-// Definition is private - in text.cpp
+// Definitions are private - in text.cpp
 struct CachedFont;
+struct FontTexture;
 
 /**
  * \struct MultisizeFont
@@ -222,6 +236,13 @@ struct MultisizeFont
  *   with per-character formatting information (font, highlights and some other info used by CEdit)
  *
  * All font rendering is done in UTF-8.
+ *
+ * Characters are rendered once and packed in rows into shared font textures,
+ * one set of textures per font and size. Characters drawn one after another
+ * are collected into a single batch of triangles, sent to the device only
+ * when the font texture changes or the string is finished. When all
+ * FONT_MAX_TEXTURES are used, the textures of the font not used for the
+ * longest time are freed.
  */
 class CText
 {
@@ -240,7 +261,7 @@ public:
     //! Frees resources before exit
     void        Destroy();
 
-    //! Flushes cached textures
+    //! Flushes cached textures; to be called when the old textures are no longer valid
     void        FlushCache();
 
     //! Draws text (multi-format)
@@ -290,7 +311,17 @@ public:
 
 protected:
     CachedFont* GetOrOpenFont(FontType type, float size);
+    //! Returns the cached character, creating it if needed
+    CharTexture GetCharTexture(UTF8Char ch, CachedFont* font);
     CharTexture CreateCharTexture(UTF8Char ch, CachedFont* font);
+    //! Returns the font texture with free space at its position for a character of given size
+    FontTexture* GetFontTextureForChar(CachedFont* font, Math::IntPoint size);
+    //! Frees the textures of the font used least recently, other than \a current if possible
+    void        FreeOldestFont(CachedFont* current);
+    //! Destroys the textures of a font and empties its cache
+    void        FreeFontTextures(CachedFont* font);
+    //! Draws the characters collected so far
+    void        FlushQuads();
 
     void        DrawString(const std::string &text, std::map<unsigned int, FontMetaChar> &format,
                            float size, Math::Point pos, float width, int eol, Color color);
@@ -313,6 +344,18 @@ protected:
     FontType     m_lastFontType;
     int          m_lastFontSize;
     CachedFont*  m_lastCachedFont;
+
+    //! Number of font textures of all fonts
+    int          m_fontTextureCount;
+    //! Incremented with each drawn string; see CachedFont::lastUse
+    int          m_useCounter;
+
+    //! Triangles of characters waiting to be drawn
+    std::vector<Vertex> m_quads;
+    //! Font texture of m_quads
+    unsigned int m_quadTexture;
+    //! Color of m_quads
+    Color        m_quadColor;
 };
 
 
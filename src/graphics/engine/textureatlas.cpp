@@ -0,0 +1,199 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+
+#include "graphics/engine/textureatlas.h"
+
+#include "common/image.h"
+#include "common/logger.h"
+
+#include "graphics/core/device.h"
+
+
+// Graphics module namespace
+namespace Gfx {
+
+
+CTextureAtlas::CTextureAtlas()
+{
+}
+
+CTextureAtlas::~CTextureAtlas()
+{
+}
+
+void CTextureAtlas::AddImage(const std::string& name, CImage* image)
+{
+    if (m_index.find(name) != m_index.end())
+        return;
+
+    AtlasImage atlasImage;
+    atlasImage.name = name;
+    atlasImage.image = image;
+    atlasImage.size = image->GetSize();
+
+    m_index[name] = static_cast<int>( m_images.size() );
+    m_images.push_back(atlasImage);
+}
+
+bool CTextureAtlas::Pack(Math::IntPoint size)
+{
+    // Highest images first, so that rows are filled evenly
+    std::vector<int> order;
+    for (int i = 0; i < static_cast<int>( m_images.size() ); i++)
+    {
+        int j = static_cast<int>( order.size() );
+        order.push_back(i);
+        while (j > 0 && m_images[order[j-1]].size.y < m_images[i].size.y)
+        {
+            order[j] = order[j-1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    int x = 0;
+    int y = 0;
+    int rowHeight = 0;
+
+    for (int i = 0; i < static_cast<int>( order.size() ); i++)
+    {
+        AtlasImage& atlasImage = m_images[order[i]];
+        int w = atlasImage.size.x + 2 * ATLAS_PADDING;
+        int h = atlasImage.size.y + 2 * ATLAS_PADDING;
+
+        if (x + w > size.x)  // next row
+        {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+
+        if (x + w > size.x || y + h > size.y)
+            return false;
+
+        atlasImage.pos = Math::IntPoint(x + ATLAS_PADDING, y + ATLAS_PADDING);
+
+        x += w;
+        if (h > rowHeight)
+            rowHeight = h;
+    }
+
+    return true;
+}
+
+bool CTextureAtlas::Build(CDevice* device, const TextureCreateParams& params)
+{
+    if (m_images.empty())
+        return false;
+
+    // Smallest power of two size, growing the width first
+    Math::IntPoint size(64, 64);
+    while (! Pack(size))
+    {
+        if (size.x <= size.y)
+            size.x *= 2;
+        else
+            size.y *= 2;
+
+        if (size.y > ATLAS_MAX_SIZE)
+        {
+            GetLogger()->Error("Images do not fit in a texture atlas of %dx%d\n", ATLAS_MAX_SIZE, ATLAS_MAX_SIZE);
+            return false;
+        }
+    }
+
+    CImage atlas(size);
+
+    for (int i = 0; i < static_cast<int>( m_images.size() ); i++)
+    {
+        AtlasImage& atlasImage = m_images[i];
+
+        // Pixels of the padding repeat the nearest edge of the image
+        for (int y = -ATLAS_PADDING; y < atlasImage.size.y + ATLAS_PADDING; y++)
+        {
+            int srcY = y;
+            if (srcY < 0) srcY = 0;
+            if (srcY >= atlasImage.size.y) srcY = atlasImage.size.y - 1;
+
+            for (int x = -ATLAS_PADDING; x < atlasImage.size.x + ATLAS_PADDING; x++)
+            {
+                int srcX = x;
+                if (srcX < 0) srcX = 0;
+                if (srcX >= atlasImage.size.x) srcX = atlasImage.size.x - 1;
+
+                Gfx::IntColor color = atlasImage.image->GetPixelInt(Math::IntPoint(srcX, srcY));
+                atlas.SetPixelInt(Math::IntPoint(atlasImage.pos.x + x, atlasImage.pos.y + y), color);
+            }
+        }
+
+        atlasImage.image = nullptr;
+    }
+
+    m_size = size;
+    m_texture = device->CreateTexture(&atlas, params);
+    if (! m_texture.Valid())
+    {
+        GetLogger()->Error("Could not create texture atlas\n");
+        return false;
+    }
+
+    GetLogger()->Trace("Packed %d images in a texture atlas of %dx%d\n",
+                       static_cast<int>( m_images.size() ), size.x, size.y);
+    return true;
+}
+
+void CTextureAtlas::Destroy(CDevice* device)
+{
+    if (m_texture.Valid())
+        device->DestroyTexture(m_texture);
+
+    m_texture.SetInvalid();
+    m_images.clear();
+    m_index.clear();
+}
+
+bool CTextureAtlas::IsBuilt()
+{
+    return m_texture.Valid();
+}
+
+Texture CTextureAtlas::GetTexture()
+{
+    return m_texture;
+}
+
+bool CTextureAtlas::GetRegion(const std::string& name, TextureRegion& region)
+{
+    if (! m_texture.Valid())
+        return false;
+
+    std::map<std::string, int>::iterator it = m_index.find(name);
+    if (it == m_index.end())
+        return false;
+
+    const AtlasImage& atlasImage = m_images[(*it).second];
+
+    region.texture = m_texture;
+    region.uv1.x = static_cast<float>(atlasImage.pos.x) / m_size.x;
+    region.uv1.y = static_cast<float>(atlasImage.pos.y) / m_size.y;
+    region.uv2.x = static_cast<float>(atlasImage.pos.x + atlasImage.size.x) / m_size.x;
+    region.uv2.y = static_cast<float>(atlasImage.pos.y + atlasImage.size.y) / m_size.y;
+    return true;
+}
+
+
+} // namespace Gfx
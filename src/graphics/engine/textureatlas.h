@@ -0,0 +1,138 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+/**
+ * \file graphics/engine/textureatlas.h
+ * \brief Packing of images into one texture - CTextureAtlas class
+ */
+
+#pragma once
+
+
+#include "graphics/core/texture.h"
+
+#include "math/point.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+class CImage;
+
+
+// Graphics module namespace
+namespace Gfx {
+
+class CDevice;
+
+
+//! Maximum width and height of an atlas texture
+const int ATLAS_MAX_SIZE = 2048;
+//! Border around each image, filled with its edge pixels against bleeding of filtering
+const int ATLAS_PADDING = 1;
+
+
+/**
+ * \struct TextureRegion
+ * \brief Part of a texture used as a whole image
+ *
+ * Texture coordinates given for the image (0..1) are mapped with Map()
+ * to the rectangle \a uv1 - \a uv2 of \a texture.
+ */
+struct TextureRegion
+{
+    //! Texture containing the image
+    Texture         texture;
+    //! Top-left corner of the image in the texture
+    Math::Point     uv1;
+    //! Bottom-right corner of the image in the texture
+    Math::Point     uv2;
+
+    //! Makes a region covering a whole texture
+    explicit TextureRegion(Texture aTexture = Texture())
+        : texture(aTexture), uv1(0.0f, 0.0f), uv2(1.0f, 1.0f) {}
+
+    //! Maps texture coordinates of the image to coordinates in the texture
+    inline Math::Point Map(const Math::Point& uv) const
+    {
+        return Math::Point(uv1.x + (uv2.x - uv1.x) * uv.x,
+                           uv1.y + (uv2.y - uv1.y) * uv.y);
+    }
+};
+
+/**
+ * \struct AtlasImage
+ * \brief Image added to CTextureAtlas
+ */
+struct AtlasImage
+{
+    std::string     name;
+    //! Image data, only until the atlas is built
+    CImage*         image;
+    Math::IntPoint  size;
+    //! Position in the atlas, padding excluded
+    Math::IntPoint  pos;
+};
+
+/**
+ * \class CTextureAtlas
+ * \brief Packs several images into one texture
+ *
+ * Images drawn one after another (e.g. the button textures of the interface)
+ * can then be drawn without switching textures. Images are added with
+ * AddImage() and packed by Build() in rows, highest first, into the smallest
+ * power of two texture holding them all. Each image is then found with
+ * GetRegion().
+ *
+ * Texture coordinates of an image must stay in 0..1: wrapping (repeated
+ * textures) is not possible inside the atlas.
+ */
+class CTextureAtlas
+{
+public:
+    CTextureAtlas();
+    ~CTextureAtlas();
+
+    //! Adds an image to pack; the image must exist until Build()
+    void            AddImage(const std::string& name, CImage* image);
+    //! Packs the added images and creates the texture
+    bool            Build(CDevice* device, const TextureCreateParams& params);
+    //! Destroys the texture and removes all images
+    void            Destroy(CDevice* device);
+
+    //! Returns whether the texture was built
+    bool            IsBuilt();
+    //! Returns the texture of the atlas
+    Texture         GetTexture();
+    //! Returns the region of an image in the atlas; false if the image is not there
+    bool            GetRegion(const std::string& name, TextureRegion& region);
+
+protected:
+    //! Places the images in rows in a texture of given size; false if they do not fit
+    bool            Pack(Math::IntPoint size);
+
+protected:
+    std::vector<AtlasImage> m_images;
+    //! Index in m_images by name
+    std::map<std::string, int> m_index;
+    //! Size of the texture
+    Math::IntPoint  m_size;
+    Texture         m_texture;
+};
+
+
+} // namespace Gfx
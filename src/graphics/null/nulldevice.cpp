@@ -0,0 +1,531 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+
+#include "graphics/null/nulldevice.h"
+
+#include "common/image.h"
+#include "common/logger.h"
+
+#include <SDL/SDL.h>
+
+
+// Graphics module namespace
+namespace Gfx {
+
+
+//! Number of lights of the null device, as in most OpenGL implementations
+const int NULL_DEVICE_LIGHT_COUNT = 8;
+//! Number of texture stages of the null device
+const int NULL_DEVICE_TEXTURE_COUNT = 4;
+//! Number of render states (see RenderState)
+const int NULL_DEVICE_RENDER_STATE_COUNT = RENDER_STATE_DITHERING + 1;
+
+
+CNullDevice::CNullDevice()
+{
+    m_lastTextureId = 0;
+    m_lastStaticBufferId = 0;
+
+    m_depthTestFunc = COMP_FUNC_LESS;
+    m_depthBias = 0.0f;
+    m_alphaTestFunc = COMP_FUNC_ALWAYS;
+    m_alphaTestRef = 0.0f;
+    m_srcBlend = BLEND_ONE;
+    m_dstBlend = BLEND_ZERO;
+    m_fogMode = FOG_LINEAR;
+    m_fogStart = 0.0f;
+    m_fogEnd = 1.0f;
+    m_fogDensity = 1.0f;
+    m_cullMode = CULL_CCW;
+    m_shadeModel = SHADE_SMOOTH;
+    m_fillMode = FILL_POLY;
+
+    ResetStatistics();
+}
+
+CNullDevice::~CNullDevice()
+{
+}
+
+void CNullDevice::DebugHook()
+{
+}
+
+bool CNullDevice::Create()
+{
+    GetLogger()->Info("Creating null device\n");
+
+    m_lights        = std::vector<Light>(NULL_DEVICE_LIGHT_COUNT, Light());
+    m_lightsEnabled = std::vector<bool> (NULL_DEVICE_LIGHT_COUNT, false);
+
+    m_currentTextures    = std::vector<Texture>           (NULL_DEVICE_TEXTURE_COUNT, Texture());
+    m_texturesEnabled    = std::vector<bool>              (NULL_DEVICE_TEXTURE_COUNT, false);
+    m_textureStageParams = std::vector<TextureStageParams>(NULL_DEVICE_TEXTURE_COUNT, TextureStageParams());
+
+    m_renderStates = std::vector<bool>(NULL_DEVICE_RENDER_STATE_COUNT, false);
+
+    return true;
+}
+
+void CNullDevice::Destroy()
+{
+    m_lights.clear();
+    m_lightsEnabled.clear();
+
+    m_currentTextures.clear();
+    m_texturesEnabled.clear();
+    m_textureStageParams.clear();
+
+    m_allTextures.clear();
+    m_staticBuffers.clear();
+}
+
+void CNullDevice::BeginScene()
+{
+    ResetStatistics();
+}
+
+void CNullDevice::EndScene()
+{
+}
+
+void CNullDevice::Clear()
+{
+}
+
+void CNullDevice::SetTransform(TransformType type, const Math::Matrix &matrix)
+{
+    if      (type == TRANSFORM_WORLD)
+        m_worldMat = matrix;
+    else if (type == TRANSFORM_VIEW)
+        m_viewMat = matrix;
+    else if (type == TRANSFORM_PROJECTION)
+        m_projectionMat = matrix;
+}
+
+const Math::Matrix& CNullDevice::GetTransform(TransformType type)
+{
+    if      (type == TRANSFORM_VIEW)
+        return m_viewMat;
+    else if (type == TRANSFORM_PROJECTION)
+        return m_projectionMat;
+
+    return m_worldMat;
+}
+
+void CNullDevice::MultiplyTransform(TransformType type, const Math::Matrix &matrix)
+{
+    SetTransform(type, Math::MultiplyMatrices(GetTransform(type), matrix));
+}
+
+void CNullDevice::SetMaterial(const Material &material)
+{
+    m_material = material;
+    m_statisticStateChange++;
+}
+
+const Material& CNullDevice::GetMaterial()
+{
+    return m_material;
+}
+
+int CNullDevice::GetMaxLightCount()
+{
+    return m_lights.size();
+}
+
+void CNullDevice::SetLight(int index, const Light &light)
+{
+    m_lights[index] = light;
+    m_statisticStateChange++;
+}
+
+const Light& CNullDevice::GetLight(int index)
+{
+    return m_lights[index];
+}
+
+void CNullDevice::SetLightEnabled(int index, bool enabled)
+{
+    m_lightsEnabled[index] = enabled;
+    m_statisticStateChange++;
+}
+
+bool CNullDevice::GetLightEnabled(int index)
+{
+    return m_lightsEnabled[index];
+}
+
+Texture CNullDevice::CreateTexture(CImage *image, const TextureCreateParams &params)
+{
+    ImageData *data = image->GetData();
+    if (data == NULL)
+    {
+        GetLogger()->Error("Invalid texture data\n");
+        return Texture(); // invalid texture
+    }
+
+    return CreateTexture(data, params);
+}
+
+Texture CNullDevice::CreateTexture(ImageData *data, const TextureCreateParams &params)
+{
+    Texture result;
+
+    result.id = ++m_lastTextureId;
+    result.size.x = data->surface->w;
+    result.size.y = data->surface->h;
+
+    if (params.format == TEX_IMG_RGBA || params.format == TEX_IMG_BGRA)
+        result.alpha = true;
+    else if (params.format == TEX_IMG_AUTO)
+        result.alpha = (data->surface->format->Amask != 0);
+
+    m_allTextures[result.id] = result;
+
+    return result;
+}
+
+void CNullDevice::UpdateTexture(const Texture &texture, Math::IntPoint offset, ImageData *data, TexImgFormat format)
+{
+    // Nothing is kept of the pixels
+}
+
+void CNullDevice::DestroyTexture(const Texture &texture)
+{
+    // Unbind the texture from all stages
+    for (int index = 0; index < static_cast<int>( m_currentTextures.size() ); ++index)
+    {
+        if (m_currentTextures[index].id == texture.id)
+            m_currentTextures[index] = Texture();
+    }
+
+    m_allTextures.erase(texture.id);
+}
+
+void CNullDevice::DestroyAllTextures()
+{
+    for (int index = 0; index < static_cast<int>( m_currentTextures.size() ); ++index)
+        m_currentTextures[index] = Texture();
+
+    m_allTextures.clear();
+}
+
+int CNullDevice::GetMaxTextureCount()
+{
+    return m_currentTextures.size();
+}
+
+void CNullDevice::SetTexture(int index, const Texture &texture)
+{
+    m_currentTextures[index] = texture;
+    m_statisticStateChange++;
+}
+
+void CNullDevice::SetTexture(int index, unsigned int textureId)
+{
+    std::map<unsigned int, Texture>::iterator it = m_allTextures.find(textureId);
+    if (it == m_allTextures.end())
+        m_currentTextures[index] = Texture();
+    else
+        m_currentTextures[index] = (*it).second;
+
+    m_statisticStateChange++;
+}
+
+Texture CNullDevice::GetTexture(int index)
+{
+    return m_currentTextures[index];
+}
+
+void CNullDevice::SetTextureEnabled(int index, bool enabled)
+{
+    m_texturesEnabled[index] = enabled;
+    m_statisticStateChange++;
+}
+
+bool CNullDevice::GetTextureEnabled(int index)
+{
+    return m_texturesEnabled[index];
+}
+
+void CNullDevice::SetTextureStageParams(int index, const TextureStageParams &params)
+{
+    m_textureStageParams[index] = params;
+    m_statisticStateChange++;
+}
+
+TextureStageParams CNullDevice::GetTextureStageParams(int index)
+{
+    return m_textureStageParams[index];
+}
+
+void CNullDevice::SetTextureStageWrap(int index, TexWrapMode wrapS, TexWrapMode wrapT)
+{
+    m_textureStageParams[index].wrapS = wrapS;
+    m_textureStageParams[index].wrapT = wrapT;
+    m_statisticStateChange++;
+}
+
+void CNullDevice::DrawPrimitive(PrimitiveType type, const Vertex *vertices, int vertexCount, Color color)
+{
+    AddDrawCall(vertexCount);
+}
+
+void CNullDevice::DrawPrimitive(PrimitiveType type, const VertexTex2 *vertices, int vertexCount, Color color)
+{
+    AddDrawCall(vertexCount);
+}
+
+void CNullDevice::DrawPrimitive(PrimitiveType type, const VertexCol *vertices, int vertexCount)
+{
+    AddDrawCall(vertexCount);
+}
+
+void CNullDevice::DrawPrimitive(PrimitiveType type, const VertexTexCol *vertices, int vertexCount)
+{
+    AddDrawCall(vertexCount);
+}
+
+void CNullDevice::AddDrawCall(int vertexCount)
+{
+    m_statisticDrawCall++;
+    m_statisticVertex += vertexCount;
+}
+
+unsigned int CNullDevice::CreateStaticBuffer(PrimitiveType primitiveType, const Vertex* vertices, int vertexCount)
+{
+    return CreateStaticBufferImpl(vertexCount);
+}
+
+unsigned int CNullDevice::CreateStaticBuffer(PrimitiveType primitiveType, const VertexTex2* vertices, int vertexCount)
+{
+    return CreateStaticBufferImpl(vertexCount);
+}
+
+unsigned int CNullDevice::CreateStaticBuffer(PrimitiveType primitiveType, const VertexCol* vertices, int vertexCount)
+{
+    return CreateStaticBufferImpl(vertexCount);
+}
+
+unsigned int CNullDevice::CreateStaticBufferImpl(int vertexCount)
+{
+    unsigned int id = ++m_lastStaticBufferId;
+    m_staticBuffers[id] = vertexCount;
+    return id;
+}
+
+void CNullDevice::UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const Vertex* vertices, int vertexCount)
+{
+    UpdateStaticBufferImpl(bufferId, vertexCount);
+}
+
+void CNullDevice::UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const VertexTex2* vertices, int vertexCount)
+{
+    UpdateStaticBufferImpl(bufferId, vertexCount);
+}
+
+void CNullDevice::UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const VertexCol* vertices, int vertexCount)
+{
+    UpdateStaticBufferImpl(bufferId, vertexCount);
+}
+
+void CNullDevice::UpdateStaticBufferImpl(unsigned int bufferId, int vertexCount)
+{
+    std::map<unsigned int, int>::iterator it = m_staticBuffers.find(bufferId);
+    if (it == m_staticBuffers.end())
+        return;
+
+    (*it).second = vertexCount;
+}
+
+void CNullDevice::DrawStaticBuffer(unsigned int bufferId)
+{
+    std::map<unsigned int, int>::iterator it = m_staticBuffers.find(bufferId);
+    if (it == m_staticBuffers.end())
+        return;
+
+    AddDrawCall((*it).second);
+}
+
+void CNullDevice::DestroyStaticBuffer(unsigned int bufferId)
+{
+    m_staticBuffers.erase(bufferId);
+}
+
+int CNullDevice::ComputeSphereVisibility(const Math::Vector &center, float radius)
+{
+    // Everything is drawn, as far as the engine knows
+    return INTERSECT_PLANE_ALL;
+}
+
+void CNullDevice::SetRenderState(RenderState state, bool enabled)
+{
+    m_renderStates[state] = enabled;
+    m_statisticStateChange++;
+}
+
+bool CNullDevice::GetRenderState(RenderState state)
+{
+    return m_renderStates[state];
+}
+
+void CNullDevice::SetDepthTestFunc(CompFunc func)
+{
+    m_depthTestFunc = func;
+    m_statisticStateChange++;
+}
+
+CompFunc CNullDevice::GetDepthTestFunc()
+{
+    return m_depthTestFunc;
+}
+
+void CNullDevice::SetDepthBias(float factor)
+{
+    m_depthBias = factor;
+    m_statisticStateChange++;
+}
+
+float CNullDevice::GetDepthBias()
+{
+    return m_depthBias;
+}
+
+void CNullDevice::SetAlphaTestFunc(CompFunc func, float refValue)
+{
+    m_alphaTestFunc = func;
+    m_alphaTestRef = refValue;
+    m_statisticStateChange++;
+}
+
+void CNullDevice::GetAlphaTestFunc(CompFunc &func, float &refValue)
+{
+    func = m_alphaTestFunc;
+    refValue = m_alphaTestRef;
+}
+
+void CNullDevice::SetBlendFunc(BlendFunc srcBlend, BlendFunc dstBlend)
+{
+    m_srcBlend = srcBlend;
+    m_dstBlend = dstBlend;
+    m_statisticStateChange++;
+}
+
+void CNullDevice::GetBlendFunc(BlendFunc &srcBlend, BlendFunc &dstBlend)
+{
+    srcBlend = m_srcBlend;
+    dstBlend = m_dstBlend;
+}
+
+void CNullDevice::SetClearColor(const Color &color)
+{
+    m_clearColor = color;
+}
+
+Color CNullDevice::GetClearColor()
+{
+    return m_clearColor;
+}
+
+void CNullDevice::SetGlobalAmbient(const Color &color)
+{
+    m_globalAmbient = color;
+    m_statisticStateChange++;
+}
+
+Color CNullDevice::GetGlobalAmbient()
+{
+    return m_globalAmbient;
+}
+
+void CNullDevice::SetFogParams(FogMode mode, const Color &color, float start, float end, float density)
+{
+    m_fogMode = mode;
+    m_fogColor = color;
+    m_fogStart = start;
+    m_fogEnd = end;
+    m_fogDensity = density;
+    m_statisticStateChange++;
+}
+
+void CNullDevice::GetFogParams(FogMode &mode, Color &color, float &start, float &end, float &density)
+{
+    mode = m_fogMode;
+    color = m_fogColor;
+    start = m_fogStart;
+    end = m_fogEnd;
+    density = m_fogDensity;
+}
+
+void CNullDevice::SetCullMode(CullMode mode)
+{
+    m_cullMode = mode;
+    m_statisticStateChange++;
+}
+
+CullMode CNullDevice::GetCullMode()
+{
+    return m_cullMode;
+}
+
+void CNullDevice::SetShadeModel(ShadeModel model)
+{
+    m_shadeModel = model;
+    m_statisticStateChange++;
+}
+
+ShadeModel CNullDevice::GetShadeModel()
+{
+    return m_shadeModel;
+}
+
+void CNullDevice::SetFillMode(FillMode mode)
+{
+    m_fillMode = mode;
+    m_statisticStateChange++;
+}
+
+FillMode CNullDevice::GetFillMode()
+{
+    return m_fillMode;
+}
+
+void CNullDevice::ResetStatistics()
+{
+    m_statisticDrawCall = 0;
+    m_statisticVertex = 0;
+    m_statisticStateChange = 0;
+}
+
+int CNullDevice::GetStatisticDrawCall()
+{
+    return m_statisticDrawCall;
+}
+
+int CNullDevice::GetStatisticVertex()
+{
+    return m_statisticVertex;
+}
+
+int CNullDevice::GetStatisticStateChange()
+{
+    return m_statisticStateChange;
+}
+
+
+} // namespace Gfx
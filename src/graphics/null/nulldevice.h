@@ -0,0 +1,219 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+/**
+ * \file graphics/null/nulldevice.h
+ * \brief Null implementation - CNullDevice class
+ */
+
+#pragma once
+
+
+#include "graphics/core/device.h"
+
+#include <map>
+#include <vector>
+
+
+// Graphics module namespace
+namespace Gfx {
+
+/**
+  \class CNullDevice
+  \brief Implementation of CDevice interface which draws nothing
+
+  Keeps the state set by the engine, so that it can be read back, and counts
+  draw calls, vertices and state changes instead of rendering anything.
+  It needs neither window nor OpenGL context; it is used by the benchmark
+  mode of CApplication.
+
+  Textures and static buffers only get an ID; textures keep the size
+  of their image.
+*/
+class CNullDevice : public CDevice
+{
+public:
+    CNullDevice();
+    virtual ~CNullDevice();
+
+    virtual void DebugHook();
+
+    virtual bool Create();
+    virtual void Destroy();
+
+    virtual void BeginScene();
+    virtual void EndScene();
+
+    virtual void Clear();
+
+    virtual void SetTransform(TransformType type, const Math::Matrix &matrix);
+    virtual const Math::Matrix& GetTransform(TransformType type);
+    virtual void MultiplyTransform(TransformType type, const Math::Matrix &matrix);
+
+    virtual void SetMaterial(const Material &material);
+    virtual const Material& GetMaterial();
+
+    virtual int GetMaxLightCount();
+    virtual void SetLight(int index, const Light &light);
+    virtual const Light& GetLight(int index);
+    virtual void SetLightEnabled(int index, bool enabled);
+    virtual bool GetLightEnabled(int index);
+
+    virtual Texture CreateTexture(CImage *image, const TextureCreateParams &params);
+    virtual Texture CreateTexture(ImageData *data, const TextureCreateParams &params);
+    virtual void UpdateTexture(const Texture &texture, Math::IntPoint offset, ImageData *data, TexImgFormat format);
+    virtual void DestroyTexture(const Texture &texture);
+    virtual void DestroyAllTextures();
+
+    virtual int GetMaxTextureCount();
+    virtual void SetTexture(int index, const Texture &texture);
+    virtual void SetTexture(int index, unsigned int textureId);
+    virtual Texture GetTexture(int index);
+    virtual void SetTextureEnabled(int index, bool enabled);
+    virtual bool GetTextureEnabled(int index);
+
+    virtual void SetTextureStageParams(int index, const TextureStageParams &params);
+    virtual TextureStageParams GetTextureStageParams(int index);
+
+    virtual void SetTextureStageWrap(int index, Gfx::TexWrapMode wrapS, Gfx::TexWrapMode wrapT);
+
+    virtual void DrawPrimitive(PrimitiveType type, const Vertex *vertices    , int vertexCount,
+                               Color color = Color(1.0f, 1.0f, 1.0f, 1.0f));
+    virtual void DrawPrimitive(PrimitiveType type, const VertexTex2 *vertices, int vertexCount,
+                               Color color = Color(1.0f, 1.0f, 1.0f, 1.0f));
+    virtual void DrawPrimitive(PrimitiveType type, const VertexCol *vertices , int vertexCount);
+    virtual void DrawPrimitive(PrimitiveType type, const VertexTexCol *vertices, int vertexCount);
+
+    virtual unsigned int CreateStaticBuffer(PrimitiveType primitiveType, const Vertex* vertices, int vertexCount);
+    virtual unsigned int CreateStaticBuffer(PrimitiveType primitiveType, const VertexTex2* vertices, int vertexCount);
+    virtual unsigned int CreateStaticBuffer(PrimitiveType primitiveType, const VertexCol* vertices, int vertexCount);
+    virtual void UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const Vertex* vertices, int vertexCount);
+    virtual void UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const VertexTex2* vertices, int vertexCount);
+    virtual void UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const VertexCol* vertices, int vertexCount);
+    virtual void DrawStaticBuffer(unsigned int bufferId);
+    virtual void DestroyStaticBuffer(unsigned int bufferId);
+
+    virtual int ComputeSphereVisibility(const Math::Vector &center, float radius);
+
+    virtual void SetRenderState(RenderState state, bool enabled);
+    virtual bool GetRenderState(RenderState state);
+
+    virtual void SetDepthTestFunc(CompFunc func);
+    virtual CompFunc GetDepthTestFunc();
+
+    virtual void SetDepthBias(float factor);
+    virtual float GetDepthBias();
+
+    virtual void SetAlphaTestFunc(CompFunc func, float refValue);
+    virtual void GetAlphaTestFunc(CompFunc &func, float &refValue);
+
+    virtual void SetBlendFunc(BlendFunc srcBlend, BlendFunc dstBlend);
+    virtual void GetBlendFunc(BlendFunc &srcBlend, BlendFunc &dstBlend);
+
+    virtual void SetClearColor(const Color &color);
+    virtual Color GetClearColor();
+
+    virtual void SetGlobalAmbient(const Color &color);
+    virtual Color GetGlobalAmbient();
+
+    virtual void SetFogParams(FogMode mode, const Color &color, float start, float end, float density);
+    virtual void GetFogParams(FogMode &mode, Color &color, float &start, float &end, float &density);
+
+    virtual void SetCullMode(CullMode mode);
+    virtual CullMode GetCullMode();
+
+    virtual void SetShadeModel(ShadeModel model);
+    virtual ShadeModel GetShadeModel();
+
+    virtual void SetFillMode(FillMode mode) ;
+    virtual FillMode GetFillMode();
+
+    //! Resets the counters of draw calls, vertices and state changes
+    void ResetStatistics();
+    //! Returns the number of draw calls since the last reset
+    int  GetStatisticDrawCall();
+    //! Returns the number of vertices drawn since the last reset
+    int  GetStatisticVertex();
+    //! Returns the number of state changes since the last reset
+    int  GetStatisticStateChange();
+
+private:
+    //! Counts a draw call of given number of vertices
+    void AddDrawCall(int vertexCount);
+    //! Creates a static buffer with given vertex count
+    unsigned int CreateStaticBufferImpl(int vertexCount);
+    //! Updates the vertex count of a static buffer
+    void UpdateStaticBufferImpl(unsigned int bufferId, int vertexCount);
+
+private:
+    //! Current world matrix
+    Math::Matrix m_worldMat;
+    //! Current view matrix
+    Math::Matrix m_viewMat;
+    //! Current projection matrix
+    Math::Matrix m_projectionMat;
+
+    //! The current material
+    Material m_material;
+
+    //! Current lights
+    std::vector<Light> m_lights;
+    //! Current lights enable status
+    std::vector<bool> m_lightsEnabled;
+
+    //! Current textures; invalid texture means unassigned
+    std::vector<Texture> m_currentTextures;
+    //! Current texture stages enable status
+    std::vector<bool> m_texturesEnabled;
+    //! Current texture params
+    std::vector<TextureStageParams> m_textureStageParams;
+    //! Created textures (by ID)
+    std::map<unsigned int, Texture> m_allTextures;
+    //! Last ID given to texture
+    unsigned int m_lastTextureId;
+
+    //! Vertex count of created static buffers (by ID)
+    std::map<unsigned int, int> m_staticBuffers;
+    //! Last ID given to static buffer
+    unsigned int m_lastStaticBufferId;
+
+    //! Render states
+    std::vector<bool> m_renderStates;
+    CompFunc m_depthTestFunc;
+    float m_depthBias;
+    CompFunc m_alphaTestFunc;
+    float m_alphaTestRef;
+    BlendFunc m_srcBlend;
+    BlendFunc m_dstBlend;
+    Color m_clearColor;
+    Color m_globalAmbient;
+    FogMode m_fogMode;
+    Color m_fogColor;
+    float m_fogStart;
+    float m_fogEnd;
+    float m_fogDensity;
+    CullMode m_cullMode;
+    ShadeModel m_shadeModel;
+    FillMode m_fillMode;
+
+    //! Statistics since the last reset
+    int m_statisticDrawCall;
+    int m_statisticVertex;
+    int m_statisticStateChange;
+};
+
+
+} // namespace Gfx
@@ -43,6 +43,8 @@
 #include <SDL/SDL.h>
 
 #include <cassert>
+#include <cstddef>
+#include <cstdio>
 
 
 // Graphics module namespace
@@ -73,6 +75,8 @@ CGLDevice::CGLDevice(const GLDeviceConfig &config)
 {
     m_config = config;
     m_lighting = false;
+    m_useVbo = false;
+    m_lastStaticBufferId = 0;
 }
 
 
@@ -145,6 +149,12 @@ bool CGLDevice::Create()
     m_texturesEnabled    = std::vector<bool>              (maxTextures, false);
     m_textureStageParams = std::vector<TextureStageParams>(maxTextures, TextureStageParams());
 
+    m_useVbo = DetectVboSupport();
+    if (m_useVbo)
+        GetLogger()->Info("Using VBOs for static buffers\n");
+    else
+        GetLogger()->Info("VBOs not supported, using display lists for static buffers\n");
+
     GetLogger()->Info("CDevice created successfully\n");
 
     return true;
@@ -156,6 +166,9 @@ void CGLDevice::Destroy()
     // Should not be strictly necessary, but just in case
     DestroyAllTextures();
 
+    // Same for static buffers
+    DestroyAllStaticBuffers();
+
     m_lights.clear();
     m_lightsEnabled.clear();
 
@@ -560,6 +573,33 @@ Texture CGLDevice::CreateTexture(ImageData *data, const TextureCreateParams &par
     return result;
 }
 
+void CGLDevice::UpdateTexture(const Texture &texture, Math::IntPoint offset, ImageData *data, TexImgFormat format)
+{
+    if (! texture.Valid())
+        return;
+
+    GLenum sourceFormat = 0;
+    if      (format == TEX_IMG_RGB)  sourceFormat = GL_RGB;
+    else if (format == TEX_IMG_BGR)  sourceFormat = GL_BGR;
+    else if (format == TEX_IMG_RGBA) sourceFormat = GL_RGBA;
+    else if (format == TEX_IMG_BGRA) sourceFormat = GL_BGRA;
+    else  assert(false); // format must be given
+
+    glActiveTexture(GL_TEXTURE0);
+    glEnable(GL_TEXTURE_2D);
+
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, offset.x, offset.y, data->surface->w, data->surface->h,
+                    sourceFormat, GL_UNSIGNED_BYTE, data->surface->pixels);
+
+    // Restore the previous state of 1st stage
+    glBindTexture(GL_TEXTURE_2D, m_currentTextures[0].id);
+
+    if (! m_texturesEnabled[0])
+        glDisable(GL_TEXTURE_2D);
+}
+
 void CGLDevice::DestroyTexture(const Texture &texture)
 {
     // Unbind the texture if in use anywhere
@@ -927,6 +967,254 @@ void CGLDevice::DrawPrimitive(PrimitiveType type, const VertexCol *vertices, int
     glDisableClientState(GL_COLOR_ARRAY);
 }
 
+void CGLDevice::DrawPrimitive(PrimitiveType type, const VertexTexCol *vertices, int vertexCount)
+{
+    VertexTexCol* vs = const_cast<VertexTexCol*>(vertices);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(VertexTexCol), reinterpret_cast<GLfloat*>(&vs[0].coord));
+
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(4, GL_FLOAT, sizeof(VertexTexCol), reinterpret_cast<GLfloat*>(&vs[0].color));
+
+    glClientActiveTexture(GL_TEXTURE0);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(VertexTexCol), reinterpret_cast<GLfloat*>(&vs[0].texCoord));
+
+    glDrawArrays(TranslateGfxPrimitive(type), 0, vertexCount);
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY); // GL_TEXTURE0
+}
+
+//! Returns the offset of vertex member as pointer, as needed by gl*Pointer() calls with bound VBO
+static const GLvoid* BufferOffset(std::size_t offset)
+{
+    return reinterpret_cast<const GLvoid*>(offset);
+}
+
+bool CGLDevice::DetectVboSupport()
+{
+#if defined(USE_GLEW)
+    // The core glGenBuffers() etc. are used, which the ARB extension alone does not provide
+    return GLEW_VERSION_1_5;
+#else
+    // VBOs are core functionality since OpenGL 1.5
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    if (version == nullptr)
+        return false;
+
+    int major = 0, minor = 0;
+    if (sscanf(version, "%d.%d", &major, &minor) != 2)
+        return false;
+
+    return (major > 1) || (major == 1 && minor >= 5);
+#endif
+}
+
+template<typename T>
+unsigned int CGLDevice::CreateStaticBufferImpl(PrimitiveType primitiveType, VertexType vertexType,
+                                               const T* vertices, int vertexCount)
+{
+    StaticBufferInfo info;
+    info.primitiveType = primitiveType;
+    info.vertexType = vertexType;
+    info.vertexCount = vertexCount;
+    info.glName = 0;
+
+    if (m_useVbo)
+    {
+        glGenBuffers(1, &info.glName);
+        glBindBuffer(GL_ARRAY_BUFFER, info.glName);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(T), vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    else
+    {
+        info.glName = glGenLists(1);
+        if (info.glName == 0)
+        {
+            GetLogger()->Error("Could not create display list for static buffer\n");
+            return 0;
+        }
+
+        glNewList(info.glName, GL_COMPILE);
+        DrawPrimitive(primitiveType, vertices, vertexCount);
+        glEndList();
+    }
+
+    unsigned int id = ++m_lastStaticBufferId;
+    m_staticBuffers[id] = info;
+    return id;
+}
+
+template<typename T>
+void CGLDevice::UpdateStaticBufferImpl(unsigned int bufferId, PrimitiveType primitiveType, VertexType vertexType,
+                                       const T* vertices, int vertexCount)
+{
+    auto it = m_staticBuffers.find(bufferId);
+    if (it == m_staticBuffers.end())
+        return;
+
+    StaticBufferInfo& info = (*it).second;
+    info.primitiveType = primitiveType;
+    info.vertexType = vertexType;
+    info.vertexCount = vertexCount;
+
+    if (m_useVbo)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, info.glName);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(T), vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    else
+    {
+        glNewList(info.glName, GL_COMPILE);
+        DrawPrimitive(primitiveType, vertices, vertexCount);
+        glEndList();
+    }
+}
+
+unsigned int CGLDevice::CreateStaticBuffer(PrimitiveType primitiveType, const Vertex* vertices, int vertexCount)
+{
+    return CreateStaticBufferImpl(primitiveType, VERTEX_TYPE_NORMAL, vertices, vertexCount);
+}
+
+unsigned int CGLDevice::CreateStaticBuffer(PrimitiveType primitiveType, const VertexTex2* vertices, int vertexCount)
+{
+    return CreateStaticBufferImpl(primitiveType, VERTEX_TYPE_TEX2, vertices, vertexCount);
+}
+
+unsigned int CGLDevice::CreateStaticBuffer(PrimitiveType primitiveType, const VertexCol* vertices, int vertexCount)
+{
+    return CreateStaticBufferImpl(primitiveType, VERTEX_TYPE_COL, vertices, vertexCount);
+}
+
+void CGLDevice::UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const Vertex* vertices, int vertexCount)
+{
+    UpdateStaticBufferImpl(bufferId, primitiveType, VERTEX_TYPE_NORMAL, vertices, vertexCount);
+}
+
+void CGLDevice::UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const VertexTex2* vertices, int vertexCount)
+{
+    UpdateStaticBufferImpl(bufferId, primitiveType, VERTEX_TYPE_TEX2, vertices, vertexCount);
+}
+
+void CGLDevice::UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const VertexCol* vertices, int vertexCount)
+{
+    UpdateStaticBufferImpl(bufferId, primitiveType, VERTEX_TYPE_COL, vertices, vertexCount);
+}
+
+void CGLDevice::DrawStaticBuffer(unsigned int bufferId)
+{
+    auto it = m_staticBuffers.find(bufferId);
+    if (it == m_staticBuffers.end())
+        return;
+
+    const StaticBufferInfo& info = (*it).second;
+
+    if (! m_useVbo)
+    {
+        glCallList(info.glName);
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, info.glName);
+
+    if (info.vertexType == VERTEX_TYPE_NORMAL)
+    {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(3, GL_FLOAT, sizeof(Vertex), BufferOffset(offsetof(Vertex, coord)));
+
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, sizeof(Vertex), BufferOffset(offsetof(Vertex, normal)));
+
+        glClientActiveTexture(GL_TEXTURE0);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), BufferOffset(offsetof(Vertex, texCoord)));
+
+        glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    }
+    else if (info.vertexType == VERTEX_TYPE_TEX2)
+    {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(3, GL_FLOAT, sizeof(VertexTex2), BufferOffset(offsetof(VertexTex2, coord)));
+
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, sizeof(VertexTex2), BufferOffset(offsetof(VertexTex2, normal)));
+
+        glClientActiveTexture(GL_TEXTURE0);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(VertexTex2), BufferOffset(offsetof(VertexTex2, texCoord)));
+
+        glClientActiveTexture(GL_TEXTURE1);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(VertexTex2), BufferOffset(offsetof(VertexTex2, texCoord2)));
+
+        glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    }
+    else if (info.vertexType == VERTEX_TYPE_COL)
+    {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(3, GL_FLOAT, sizeof(VertexCol), BufferOffset(offsetof(VertexCol, coord)));
+
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(4, GL_FLOAT, sizeof(VertexCol), BufferOffset(offsetof(VertexCol, color)));
+    }
+
+    glDrawArrays(TranslateGfxPrimitive(info.primitiveType), 0, info.vertexCount);
+
+    if (info.vertexType == VERTEX_TYPE_NORMAL)
+    {
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY); // GL_TEXTURE0
+    }
+    else if (info.vertexType == VERTEX_TYPE_TEX2)
+    {
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY); // GL_TEXTURE1
+        glClientActiveTexture(GL_TEXTURE0);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    }
+    else if (info.vertexType == VERTEX_TYPE_COL)
+    {
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glDisableClientState(GL_COLOR_ARRAY);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void CGLDevice::DestroyStaticBuffer(unsigned int bufferId)
+{
+    auto it = m_staticBuffers.find(bufferId);
+    if (it == m_staticBuffers.end())
+        return;
+
+    if (m_useVbo)
+        glDeleteBuffers(1, &(*it).second.glName);
+    else
+        glDeleteLists((*it).second.glName, 1);
+
+    m_staticBuffers.erase(it);
+}
+
+void CGLDevice::DestroyAllStaticBuffers()
+{
+    for (auto it = m_staticBuffers.begin(); it != m_staticBuffers.end(); ++it)
+    {
+        if (m_useVbo)
+            glDeleteBuffers(1, &(*it).second.glName);
+        else
+            glDeleteLists((*it).second.glName, 1);
+    }
+
+    m_staticBuffers.clear();
+}
+
 bool InPlane(Math::Vector normal, float originPlane, Math::Vector center, float radius)
 {
     float distance = (originPlane + Math::DotProduct(normal, center)) / normal.Length();
@@ -24,6 +24,7 @@
 
 #include "graphics/core/device.h"
 
+#include <map>
 #include <string>
 #include <vector>
 #include <set>
@@ -104,6 +105,7 @@ public:
 
     virtual Texture CreateTexture(CImage *image, const TextureCreateParams &params);
     virtual Texture CreateTexture(ImageData *data, const TextureCreateParams &params);
+    virtual void UpdateTexture(const Texture &texture, Math::IntPoint offset, ImageData *data, TexImgFormat format);
     virtual void DestroyTexture(const Texture &texture);
     virtual void DestroyAllTextures();
 
@@ -126,6 +128,16 @@ public:
     virtual void DrawPrimitive(PrimitiveType type, const VertexTex2 *vertices, int vertexCount,
                                Color color = Color(1.0f, 1.0f, 1.0f, 1.0f));
     virtual void DrawPrimitive(PrimitiveType type, const VertexCol *vertices , int vertexCount);
+    virtual void DrawPrimitive(PrimitiveType type, const VertexTexCol *vertices, int vertexCount);
+
+    virtual unsigned int CreateStaticBuffer(PrimitiveType primitiveType, const Vertex* vertices, int vertexCount);
+    virtual unsigned int CreateStaticBuffer(PrimitiveType primitiveType, const VertexTex2* vertices, int vertexCount);
+    virtual unsigned int CreateStaticBuffer(PrimitiveType primitiveType, const VertexCol* vertices, int vertexCount);
+    virtual void UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const Vertex* vertices, int vertexCount);
+    virtual void UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const VertexTex2* vertices, int vertexCount);
+    virtual void UpdateStaticBuffer(unsigned int bufferId, PrimitiveType primitiveType, const VertexCol* vertices, int vertexCount);
+    virtual void DrawStaticBuffer(unsigned int bufferId);
+    virtual void DestroyStaticBuffer(unsigned int bufferId);
 
     virtual int ComputeSphereVisibility(const Math::Vector &center, float radius);
 
@@ -168,6 +180,48 @@ private:
     //! Updates position for given light based on transformation matrices
     void UpdateLightPosition(int index);
 
+    //! Checks whether vertex buffer objects are supported by the current context
+    bool DetectVboSupport();
+    //! Releases all static buffers
+    void DestroyAllStaticBuffers();
+
+private:
+    /**
+     * \enum VertexType
+     * \brief Type of vertex stored in static buffer
+     */
+    enum VertexType
+    {
+        VERTEX_TYPE_NORMAL,
+        VERTEX_TYPE_TEX2,
+        VERTEX_TYPE_COL
+    };
+
+    /**
+     * \struct StaticBufferInfo
+     * \brief Info about a static buffer (VBO or display list)
+     */
+    struct StaticBufferInfo
+    {
+        //! Type of primitives stored in buffer
+        PrimitiveType primitiveType;
+        //! Type of vertices stored in buffer
+        VertexType vertexType;
+        //! Number of vertices
+        int vertexCount;
+        //! OpenGL name of VBO or display list
+        unsigned int glName;
+    };
+
+    //! Creates a static buffer with given data
+    template<typename T>
+    unsigned int CreateStaticBufferImpl(PrimitiveType primitiveType, VertexType vertexType,
+                                        const T* vertices, int vertexCount);
+    //! Updates a static buffer with given data
+    template<typename T>
+    void UpdateStaticBufferImpl(unsigned int bufferId, PrimitiveType primitiveType, VertexType vertexType,
+                                const T* vertices, int vertexCount);
+
 private:
     //! Current config
     GLDeviceConfig m_config;
@@ -200,6 +254,13 @@ private:
 
     //! Set of all created textures
     std::set<Texture> m_allTextures;
+
+    //! Whether to use VBOs for static buffers (display lists are used otherwise)
+    bool m_useVbo;
+    //! Map of created static buffers (by ID)
+    std::map<unsigned int, StaticBufferInfo> m_staticBuffers;
+    //! Last ID given to static buffer
+    unsigned int m_lastStaticBufferId;
 };
 
 
@@ -21,6 +21,7 @@
 #include "common/iman.h"
 #include "graphics/engine/terrain.h"
 #include "math/geometry.h"
+#include "object/objectgrid.h"
 #include "script/cmdtoken.h"
 #include "ui/interface.h"
 #include "ui/gauge.h"
@@ -29,6 +30,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 
 
 const float ENERGY_POWER    =  0.4f;    // Necessary energy for a battery
@@ -401,10 +403,12 @@ bool CAutoEnergy::SearchVehicle()
 
     cPos = m_object->GetPosition(0);
 
-    for ( i=0 ; i<1000000 ; i++ )
+    std::vector<CObject*> objects;
+    CObjectGrid::GetInstancePointer()->FindCrashCandidates(objects, cPos, 10.0f);
+
+    for ( i=0 ; i<static_cast<int>( objects.size() ) ; i++ )
     {
-        pObj = static_cast< CObject* >(m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if ( pObj == 0 )  break;
+        pObj = objects[i];
 
         type = pObj->GetType();
         if ( type != OBJECT_HUMAN    &&
@@ -486,10 +490,12 @@ CObject* CAutoEnergy::SearchPower()
 
     cPos = m_object->GetPosition(0);
 
-    for ( i=0 ; i<1000000 ; i++ )
+    std::vector<CObject*> objects;
+    CObjectGrid::GetInstancePointer()->FindInRadius(objects, cPos, 1.0f);
+
+    for ( i=0 ; i<static_cast<int>( objects.size() ) ; i++ )
     {
-        pObj = static_cast< CObject* >(m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if ( pObj == 0 )  break;
+        pObj = objects[i];
 
         if ( !pObj->GetLock() )  continue;
 
@@ -17,6 +17,8 @@
 
 #include "object/brain.h"
 
+#include "app/profiler.h"
+
 #include "common/misc.h"
 #include "common/iman.h"
 
@@ -30,6 +32,7 @@
 
 #include "script/cmdtoken.h"
 #include "script/script.h"
+#include "script/scriptscheduler.h"
 
 #include "sound/sound.h"
 
@@ -759,7 +762,11 @@ bool CBrain::EventFrame(const Event &event)
 
     if ( m_program != -1 )  // current program?
     {
-        if ( m_script[m_program]->Continue(event) )
+        CProfilerScope scope(PROF_SCRIPTS);
+
+        // the scheduler may continue it later in this frame
+        if ( !CScriptScheduler::GetInstancePointer()->AddScript(this, m_script[m_program], event) &&
+             m_script[m_program]->Continue(event) )
         {
             StopProgram();
         }
@@ -774,6 +781,15 @@ bool CBrain::EventFrame(const Event &event)
 }
 
 
+// Called by CScriptScheduler when a program it continued is finished.
+
+void CBrain::ProgramEnded(CScript* script)
+{
+    if ( m_program == -1 || m_script[m_program] != script )  return;
+
+    StopProgram();
+}
+
 // Stops the running program.
 
 void CBrain::StopProgram()
@@ -103,6 +103,7 @@ public:
     int         FreeProgram();
     int         GetProgram();
     void        StopProgram();
+    void        ProgramEnded(CScript* script);
     void        StopTask();
 
     bool        IntroduceVirus();
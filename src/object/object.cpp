@@ -28,6 +28,7 @@
 #include "graphics/engine/lightman.h"
 #include "graphics/engine/lightning.h"
 #include "graphics/engine/modelfile.h"
+#include "graphics/engine/navgrid.h"
 #include "graphics/engine/particle.h"
 #include "graphics/engine/pyro.h"
 #include "graphics/engine/terrain.h"
@@ -70,6 +71,7 @@
 #include "object/motion/motiontoto.h"
 #include "object/motion/motionvehicle.h"
 #include "object/motion/motionworm.h"
+#include "object/objectgrid.h"
 #include "object/robotmain.h"
 
 #include "physics/physics.h"
@@ -340,6 +342,12 @@ CObject::CObject(CInstanceManager* iMan)
     m_botVar = CBotVar::Create("", CBotTypResult(CBotTypClass, "object"));
     m_botVar->SetUserPtr(this);
     m_botVar->SetIdent(m_id);
+
+    if ( CObjectGrid::IsCreated() )
+        CObjectGrid::GetInstancePointer()->AddObject(this);
+
+    if ( m_terrain != nullptr )
+        m_terrain->GetNavGrid()->AddObject(this);
 }
 
 // Object's destructor.
@@ -364,6 +372,12 @@ CObject::~CObject()
 
     m_iMan->DeleteInstance(CLASS_OBJECT, this);
 
+    if ( CObjectGrid::IsCreated() )
+        CObjectGrid::GetInstancePointer()->DeleteObject(this);
+
+    if ( m_terrain != nullptr )
+        m_terrain->GetNavGrid()->DeleteObject(this);
+
     m_app = nullptr;
 }
 
@@ -456,7 +470,7 @@ void CObject::DeleteObject(bool bAll)
         }
     }
 
-    m_type = OBJECT_NULL;  // invalid object until complete destruction
+    ChangeType(OBJECT_NULL);  // invalid object until complete destruction
 
     if ( m_partiReactor != -1 )
     {
@@ -912,7 +926,7 @@ void CObject::SetObjectParent(int part, int parent)
 
 void CObject::SetType(ObjectType type)
 {
-    m_type = type;
+    ChangeType(type);
     strcpy(m_name, GetObjectName(m_type));
 
     if ( m_type == OBJECT_MOBILErs )
@@ -948,6 +962,28 @@ ObjectType CObject::GetType()
     return m_type;
 }
 
+// Changes the type and keeps the object index up to date.
+
+void CObject::ChangeType(ObjectType type)
+{
+    ObjectType oldType = m_type;
+    m_type = type;
+
+    if ( CObjectGrid::IsCreated() )
+        CObjectGrid::GetInstancePointer()->UpdateType(this, oldType);
+
+    UpdateNavGrid(0);
+}
+
+// Tells the navigation grid that the crash spheres may have moved.
+
+void CObject::UpdateNavGrid(int part)
+{
+    if ( part != 0 || m_terrain == nullptr )  return;
+
+    m_terrain->GetNavGrid()->UpdateObject(this);
+}
+
 char* CObject::GetName()
 {
     return m_name;
@@ -1279,6 +1315,8 @@ int CObject::SearchDescendant(int parent, int n)
 void CObject::FlushCrashShere()
 {
     m_crashSphereUsed = 0;
+    m_crashSphereExtent = -1.0f;
+    m_crashSphereExtentZoom = 1.0f;
 }
 
 // Adds a new sphere.
@@ -1295,6 +1333,16 @@ int CObject::CreateCrashSphere(Math::Vector pos, float radius, Sound sound,
     m_crashSphereRadius[m_crashSphereUsed] = radius*zoom;
     m_crashSphereHardness[m_crashSphereUsed] = hardness;
     m_crashSphereSound[m_crashSphereUsed] = sound;
+    m_crashSphereExtent = -1.0f;
+
+    // Objects often grow up to full size after creating their spheres
+    if ( CObjectGrid::IsCreated() )
+    {
+        zoom = Math::Max(zoom, 1.0f);
+        CObjectGrid::GetInstancePointer()->UpdateCrashExtent((pos.Length()+radius)*zoom);
+    }
+
+    UpdateNavGrid(0);
     return m_crashSphereUsed++;
 }
 
@@ -1369,6 +1417,35 @@ void CObject::DeleteCrashSphere(int rank)
         m_crashSphereRadius[i-1] = m_crashSphereRadius[i];
     }
     m_crashSphereUsed --;
+    m_crashSphereExtent = -1.0f;
+
+    UpdateNavGrid(0);
+}
+
+// Returns the radius of a sphere around the position of the object,
+// holding all spheres for collisions.
+
+float CObject::GetCrashSphereExtent()
+{
+    float   zoom;
+    int     i;
+
+    // The spheres follow the zoom of the object, but never shrink
+    // in the special case of GetCrashSphere.
+    zoom = Math::Max(GetZoomX(0), GetZoomY(0), GetZoomZ(0), 1.0f);
+
+    if ( m_crashSphereExtent < 0.0f || m_crashSphereExtentZoom != zoom )
+    {
+        m_crashSphereExtent = 0.0f;
+        m_crashSphereExtentZoom = zoom;
+        for ( i=0 ; i<m_crashSphereUsed ; i++ )
+        {
+            m_crashSphereExtent = Math::Max(m_crashSphereExtent,
+                                            m_crashSpherePos[i].Length()*zoom+m_crashSphereRadius[i]);
+        }
+    }
+
+    return m_crashSphereExtent;
 }
 
 // Specifies the global sphere, relative to the object.
@@ -1397,6 +1474,12 @@ void CObject::SetJotlerSphere(Math::Vector pos, float radius)
 {
     m_jotlerSpherePos    = pos;
     m_jotlerSphereRadius = radius;
+
+    if ( CObjectGrid::IsCreated() )
+    {
+        float zoom = Math::Max(GetZoomX(0), 1.0f);
+        CObjectGrid::GetInstancePointer()->UpdateCrashExtent(pos.Length()*zoom + radius);
+    }
 }
 
 // Specifies the sphere of jostling, in the world.
@@ -1533,6 +1616,11 @@ void CObject::SetPosition(int part, const Math::Vector &pos)
     m_objectPart[part].position = pos;
     m_objectPart[part].bTranslate = true;  // it will recalculate the matrices
 
+    if ( part == 0 && CObjectGrid::IsCreated() )
+        CObjectGrid::GetInstancePointer()->UpdatePosition(this);
+
+    UpdateNavGrid(part);
+
     if ( part == 0 && !m_bFlat )  // main part?
     {
         rank = m_objectPart[0].object;
@@ -1654,6 +1742,7 @@ void CObject::SetAngle(int part, const Math::Vector &angle)
 {
     m_objectPart[part].angle = angle;
     m_objectPart[part].bRotate = true;  // it will recalculate the matrices
+    UpdateNavGrid(part);
 
     if ( part == 0 && !m_bFlat )  // main part?
     {
@@ -1672,6 +1761,7 @@ void CObject::SetAngleY(int part, float angle)
 {
     m_objectPart[part].angle.y = angle;
     m_objectPart[part].bRotate = true;  // it will recalculate the matrices
+    UpdateNavGrid(part);
 
     if ( part == 0 && !m_bFlat )  // main part?
     {
@@ -1685,6 +1775,7 @@ void CObject::SetAngleX(int part, float angle)
 {
     m_objectPart[part].angle.x = angle;
     m_objectPart[part].bRotate = true;  // it will recalculate the matrices
+    UpdateNavGrid(part);
 }
 
 // Getes the rotation about the axis Z.
@@ -1693,6 +1784,7 @@ void CObject::SetAngleZ(int part, float angle)
 {
     m_objectPart[part].angle.z = angle;
     m_objectPart[part].bRotate = true;  //it will recalculate the matrices
+    UpdateNavGrid(part);
 }
 
 float CObject::GetAngleY(int part)
@@ -1716,6 +1808,7 @@ float CObject::GetAngleZ(int part)
 void CObject::SetZoom(int part, float zoom)
 {
     m_objectPart[part].bTranslate = true;  // it will recalculate the matrices
+    UpdateNavGrid(part);
     m_objectPart[part].zoom.x = zoom;
     m_objectPart[part].zoom.y = zoom;
     m_objectPart[part].zoom.z = zoom;
@@ -1728,6 +1821,7 @@ void CObject::SetZoom(int part, float zoom)
 void CObject::SetZoom(int part, Math::Vector zoom)
 {
     m_objectPart[part].bTranslate = true;  // it will recalculate the matrices
+    UpdateNavGrid(part);
     m_objectPart[part].zoom = zoom;
 
     m_objectPart[part].bZoom = ( m_objectPart[part].zoom.x != 1.0f ||
@@ -1743,6 +1837,7 @@ Math::Vector CObject::GetZoom(int part)
 void CObject::SetZoomX(int part, float zoom)
 {
     m_objectPart[part].bTranslate = true;  // it will recalculate the matrices
+    UpdateNavGrid(part);
     m_objectPart[part].zoom.x = zoom;
 
     m_objectPart[part].bZoom = ( m_objectPart[part].zoom.x != 1.0f ||
@@ -1753,6 +1848,7 @@ void CObject::SetZoomX(int part, float zoom)
 void CObject::SetZoomY(int part, float zoom)
 {
     m_objectPart[part].bTranslate = true;  // it will recalculate the matrices
+    UpdateNavGrid(part);
     m_objectPart[part].zoom.y = zoom;
 
     m_objectPart[part].bZoom = ( m_objectPart[part].zoom.x != 1.0f ||
@@ -1763,6 +1859,7 @@ void CObject::SetZoomY(int part, float zoom)
 void CObject::SetZoomZ(int part, float zoom)
 {
     m_objectPart[part].bTranslate = true;  // it will recalculate the matrices
+    UpdateNavGrid(part);
     m_objectPart[part].zoom.z = zoom;
 
     m_objectPart[part].bZoom = ( m_objectPart[part].zoom.x != 1.0f ||
@@ -1925,6 +2022,8 @@ void CObject::SetTruck(CObject* truck)
 
     // Invisible shadow if the object is transported.
     m_engine->SetObjectShadowHide(m_objectPart[0].object, (m_truck != 0));
+
+    UpdateNavGrid(0);
 }
 
 CObject* CObject::GetTruck()
@@ -2087,7 +2186,7 @@ void CObject::SetDrawFront(bool bDraw)
 bool CObject::CreateVehicle(Math::Vector pos, float angle, ObjectType type,
                             float power, bool bTrainer, bool bToy)
 {
-    m_type = type;
+    ChangeType(type);
 
     if ( type == OBJECT_TOTO )
     {
@@ -2179,7 +2278,7 @@ bool CObject::CreateVehicle(Math::Vector pos, float angle, ObjectType type,
 
 bool CObject::CreateInsect(Math::Vector pos, float angle, ObjectType type)
 {
-    m_type = type;
+    ChangeType(type);
 
     m_physics = new CPhysics(m_iMan, this);
     m_brain   = new CBrain(m_iMan, this);
@@ -436,6 +436,7 @@ public:
     float       GetCrashSphereHardness(int rank);
     Sound       GetCrashSphereSound(int rank);
     void        DeleteCrashSphere(int rank);
+    float       GetCrashSphereExtent();
     void        SetGlobalSphere(Math::Vector pos, float radius);
     void        GetGlobalSphere(Math::Vector &pos, float &radius);
     void        SetJotlerSphere(Math::Vector pos, float radius);
@@ -677,6 +678,8 @@ protected:
     bool        UpdateTransformObject(int part, bool bForceUpdate);
     bool        UpdateTransformObject();
     void        UpdateSelectParticle();
+    void        ChangeType(ObjectType type);
+    void        UpdateNavGrid(int part);
 
 protected:
     CInstanceManager*   m_iMan;
@@ -763,6 +766,8 @@ protected:
     float       m_crashSphereRadius[MAXCRASHSPHERE];
     float       m_crashSphereHardness[MAXCRASHSPHERE];
     Sound       m_crashSphereSound[MAXCRASHSPHERE];
+    float       m_crashSphereExtent;  // radius holding all spheres, <0 if to compute
+    float       m_crashSphereExtentZoom;  // zoom used to compute it
     Math::Vector    m_globalSpherePos;
     float       m_globalSphereRadius;
     Math::Vector    m_jotlerSpherePos;
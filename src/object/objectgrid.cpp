@@ -0,0 +1,260 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+
+#include "object/objectgrid.h"
+
+#include "math/func.h"
+#include "math/geometry.h"
+
+#include <algorithm>
+#include <utility>
+
+
+template<> CObjectGrid* CSingleton<CObjectGrid>::mInstance = nullptr;
+
+
+CObjectGrid::CObjectGrid()
+{
+    m_cells.resize(OBJECT_GRID_SIZE*OBJECT_GRID_SIZE);
+    m_types.resize(OBJECT_MAX);
+    m_maxCrashExtent = 0.0f;
+    m_statisticPairTest = 0;
+    m_lastStatisticPairTest = 0;
+}
+
+CObjectGrid::~CObjectGrid()
+{
+}
+
+void CObjectGrid::Flush()
+{
+    for (int i = 0; i < static_cast<int>( m_cells.size() ); i++)
+        m_cells[i].clear();
+
+    for (int i = 0; i < static_cast<int>( m_types.size() ); i++)
+        m_types[i].clear();
+
+    m_objectCells.clear();
+    m_maxCrashExtent = 0.0f;
+}
+
+void CObjectGrid::AddObject(CObject* object)
+{
+    if (m_objectCells.find(object) != m_objectCells.end())
+        return;
+
+    int cell = GetCellIndex(object->GetPosition(0));
+    m_cells[cell].push_back(object);
+    m_objectCells[object] = cell;
+
+    m_types[object->GetType()].push_back(object);
+}
+
+void CObjectGrid::DeleteObject(CObject* object)
+{
+    std::map<CObject*, int>::iterator it = m_objectCells.find(object);
+    if (it == m_objectCells.end())
+        return;
+
+    RemoveFromList(m_cells[(*it).second], object);
+    RemoveFromList(m_types[object->GetType()], object);
+
+    m_objectCells.erase(it);
+}
+
+void CObjectGrid::UpdatePosition(CObject* object)
+{
+    std::map<CObject*, int>::iterator it = m_objectCells.find(object);
+    if (it == m_objectCells.end())
+        return;
+
+    int cell = GetCellIndex(object->GetPosition(0));
+    if (cell == (*it).second)
+        return;
+
+    RemoveFromList(m_cells[(*it).second], object);
+    m_cells[cell].push_back(object);
+    (*it).second = cell;
+}
+
+void CObjectGrid::UpdateType(CObject* object, ObjectType oldType)
+{
+    if (m_objectCells.find(object) == m_objectCells.end())
+        return;
+
+    ObjectType newType = object->GetType();
+    if (newType == oldType)
+        return;
+
+    RemoveFromList(m_types[oldType], object);
+    m_types[newType].push_back(object);
+}
+
+void CObjectGrid::UpdateCrashExtent(float extent)
+{
+    if (extent > m_maxCrashExtent)
+        m_maxCrashExtent = extent;
+}
+
+float CObjectGrid::GetMaxCrashExtent()
+{
+    return m_maxCrashExtent;
+}
+
+void CObjectGrid::FindInRadius(std::vector<CObject*> &result, const Math::Vector &center, float radius)
+{
+    result.clear();
+
+    int minX = 0, minZ = 0, maxX = 0, maxZ = 0;
+    GetCellRange(center.x - radius, center.z - radius, center.x + radius, center.z + radius,
+                 minX, minZ, maxX, maxZ);
+
+    for (int z = minZ; z <= maxZ; z++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            const std::vector<CObject*> &cell = m_cells[z*OBJECT_GRID_SIZE + x];
+            for (int i = 0; i < static_cast<int>( cell.size() ); i++)
+            {
+                if (Math::DistanceProjected(cell[i]->GetPosition(0), center) <= radius)
+                    result.push_back(cell[i]);
+            }
+        }
+    }
+}
+
+void CObjectGrid::FindCrashCandidates(std::vector<CObject*> &result, const Math::Vector &center, float radius)
+{
+    FindInRadius(result, center, radius + m_maxCrashExtent);
+}
+
+void CObjectGrid::FindInBox(std::vector<CObject*> &result, const Math::Vector &min, const Math::Vector &max)
+{
+    result.clear();
+
+    int minX = 0, minZ = 0, maxX = 0, maxZ = 0;
+    GetCellRange(min.x, min.z, max.x, max.z, minX, minZ, maxX, maxZ);
+
+    for (int z = minZ; z <= maxZ; z++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            const std::vector<CObject*> &cell = m_cells[z*OBJECT_GRID_SIZE + x];
+            for (int i = 0; i < static_cast<int>( cell.size() ); i++)
+            {
+                Math::Vector pos = cell[i]->GetPosition(0);
+                if (pos.x >= min.x && pos.x <= max.x &&
+                    pos.z >= min.z && pos.z <= max.z)
+                    result.push_back(cell[i]);
+            }
+        }
+    }
+}
+
+void CObjectGrid::FindNearest(std::vector<CObject*> &result, const Math::Vector &center, int count,
+                              float maxRadius)
+{
+    result.clear();
+    if (count <= 0)
+        return;
+
+    // Grow the searched circle until it holds enough objects;
+    // anything outside the circle is farther than everything inside
+    std::vector<CObject*> found;
+    float radius = OBJECT_GRID_CELL_SIZE;
+    while (true)
+    {
+        if (radius > maxRadius)
+            radius = maxRadius;
+
+        FindInRadius(found, center, radius);
+
+        if (static_cast<int>( found.size() ) >= count || radius >= maxRadius || radius >= OBJECT_GRID_MAX_RADIUS)
+            break;
+
+        radius *= 2.0f;
+    }
+
+    std::vector< std::pair<float, CObject*> > sorted;
+    sorted.reserve(found.size());
+    for (int i = 0; i < static_cast<int>( found.size() ); i++)
+        sorted.push_back(std::make_pair(Math::DistanceProjected(found[i]->GetPosition(0), center), found[i]));
+
+    std::sort(sorted.begin(), sorted.end());
+
+    for (int i = 0; i < static_cast<int>( sorted.size() ) && i < count; i++)
+        result.push_back(sorted[i].second);
+}
+
+const std::vector<CObject*>& CObjectGrid::GetObjectsOfType(ObjectType type)
+{
+    return m_types[type];
+}
+
+int CObjectGrid::GetObjectCount()
+{
+    return static_cast<int>( m_objectCells.size() );
+}
+
+void CObjectGrid::FrameStatistics()
+{
+    m_lastStatisticPairTest = m_statisticPairTest;
+    m_statisticPairTest = 0;
+}
+
+void CObjectGrid::AddStatisticPairTest(int count)
+{
+    m_statisticPairTest += count;
+}
+
+int CObjectGrid::GetStatisticPairTest()
+{
+    return m_lastStatisticPairTest;
+}
+
+int CObjectGrid::GetCellIndex(const Math::Vector &pos)
+{
+    int minX = 0, minZ = 0, maxX = 0, maxZ = 0;
+    GetCellRange(pos.x, pos.z, pos.x, pos.z, minX, minZ, maxX, maxZ);
+    return minZ*OBJECT_GRID_SIZE + minX;
+}
+
+void CObjectGrid::GetCellRange(float minX, float minZ, float maxX, float maxZ,
+                               int &cellMinX, int &cellMinZ, int &cellMaxX, int &cellMaxZ)
+{
+    // The grid is centered on the origin, as is the terrain
+    float half = OBJECT_GRID_CELL_SIZE*OBJECT_GRID_SIZE/2.0f;
+    float last = static_cast<float>(OBJECT_GRID_SIZE-1);
+
+    cellMinX = static_cast<int>(Math::Max(0.0f, Math::Min(last, (minX + half) / OBJECT_GRID_CELL_SIZE)));
+    cellMinZ = static_cast<int>(Math::Max(0.0f, Math::Min(last, (minZ + half) / OBJECT_GRID_CELL_SIZE)));
+    cellMaxX = static_cast<int>(Math::Max(0.0f, Math::Min(last, (maxX + half) / OBJECT_GRID_CELL_SIZE)));
+    cellMaxZ = static_cast<int>(Math::Max(0.0f, Math::Min(last, (maxZ + half) / OBJECT_GRID_CELL_SIZE)));
+}
+
+void CObjectGrid::RemoveFromList(std::vector<CObject*> &list, CObject* object)
+{
+    for (int i = 0; i < static_cast<int>( list.size() ); i++)
+    {
+        if (list[i] == object)
+        {
+            list[i] = list.back();
+            list.pop_back();
+            return;
+        }
+    }
+}
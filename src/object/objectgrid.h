@@ -0,0 +1,130 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+/**
+ * \file object/objectgrid.h
+ * \brief CObjectGrid - spatial index of objects
+ */
+
+#pragma once
+
+
+#include "common/singleton.h"
+
+#include "math/vector.h"
+
+#include "object/object.h"
+
+#include <map>
+#include <vector>
+
+
+//! Size of a single grid cell (in world units)
+const float OBJECT_GRID_CELL_SIZE = 20.0f;
+//! Number of grid cells along one side of the grid
+const int   OBJECT_GRID_SIZE      = 160;
+//! Radius covering the whole grid; larger queries scan all cells
+const float OBJECT_GRID_MAX_RADIUS = OBJECT_GRID_CELL_SIZE*OBJECT_GRID_SIZE*1.5f;
+
+
+/**
+ * \class CObjectGrid
+ * \brief Uniform grid over the XZ plane, indexing all objects by position and type
+ *
+ * Every CObject registers itself on creation and keeps its entry up to date
+ * when its main part is moved or its type changes. Queries then only look at
+ * cells overlapping the searched area, instead of walking all instances
+ * in CInstanceManager.
+ *
+ * Objects outside the grid are clamped to the border cells, so the results
+ * are always exact: the distance test is done on the actual position.
+ *
+ * Collisions of CPhysics use the grid as broad phase (FindCrashCandidates()),
+ * then the extent of crash spheres of each object (CObject::GetCrashSphereExtent()),
+ * before testing pairs of spheres; the number of these tests per frame
+ * is shown with the statistics of CEngine::DrawStats().
+ *
+ * Note that carried objects (see CObject::GetTruck()) have positions relative
+ * to their carrier, so callers should skip them as before.
+ */
+class CObjectGrid : public CSingleton<CObjectGrid>
+{
+public:
+    CObjectGrid();
+    ~CObjectGrid();
+
+    //! Removes all objects from the index
+    void        Flush();
+
+    //! Registers a new object
+    void        AddObject(CObject* object);
+    //! Unregisters an object
+    void        DeleteObject(CObject* object);
+    //! Updates the cell of an object after its main part was moved
+    void        UpdatePosition(CObject* object);
+    //! Updates the type bucket of an object after its type changed
+    void        UpdateType(CObject* object, ObjectType oldType);
+    //! Notifies about extent of crash spheres of an object (see GetMaxCrashExtent())
+    void        UpdateCrashExtent(float extent);
+
+    //! Returns the largest distance between an object position and the edge of its crash spheres
+    float       GetMaxCrashExtent();
+
+    //! Finds all objects whose position is within \a radius (in XZ plane) of \a center
+    void        FindInRadius(std::vector<CObject*> &result, const Math::Vector &center, float radius);
+    //! Finds all objects whose crash spheres may reach a circle of \a radius around \a center
+    void        FindCrashCandidates(std::vector<CObject*> &result, const Math::Vector &center, float radius);
+    //! Finds all objects whose position is within given XZ box
+    void        FindInBox(std::vector<CObject*> &result, const Math::Vector &min, const Math::Vector &max);
+    //! Finds up to \a count objects nearest to \a center (in XZ plane), sorted by distance
+    void        FindNearest(std::vector<CObject*> &result, const Math::Vector &center, int count,
+                            float maxRadius = OBJECT_GRID_MAX_RADIUS);
+    //! Returns all objects of given type
+    const std::vector<CObject*>& GetObjectsOfType(ObjectType type);
+
+    //! Returns the total number of indexed objects
+    int         GetObjectCount();
+
+    //! Starts counting collision tests of a new frame
+    void        FrameStatistics();
+    //! Counts collision tests between pairs of crash spheres
+    void        AddStatisticPairTest(int count);
+    //! Returns the number of collision tests done in the last frame
+    int         GetStatisticPairTest();
+
+protected:
+    //! Returns the cell index for given position
+    int         GetCellIndex(const Math::Vector &pos);
+    //! Returns the range of cells overlapping given XZ box
+    void        GetCellRange(float minX, float minZ, float maxX, float maxZ,
+                             int &cellMinX, int &cellMinZ, int &cellMaxX, int &cellMaxZ);
+    //! Removes object from the vector, not preserving order
+    static void RemoveFromList(std::vector<CObject*> &list, CObject* object);
+
+protected:
+    //! Objects in each cell
+    std::vector< std::vector<CObject*> > m_cells;
+    //! Objects of each type
+    std::vector< std::vector<CObject*> > m_types;
+    //! Current cell of each indexed object
+    std::map<CObject*, int> m_objectCells;
+    //! Largest crash sphere extent seen so far
+    float       m_maxCrashExtent;
+    //! Collision tests in the current frame
+    int         m_statisticPairTest;
+    //! Collision tests in the last frame
+    int         m_lastStatisticPairTest;
+};
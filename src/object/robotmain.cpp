@@ -20,6 +20,7 @@
 #include "CBot/CBotDll.h"
 
 #include "app/app.h"
+#include "app/profiler.h"
 
 #include "common/event.h"
 #include "common/global.h"
@@ -32,6 +33,7 @@
 #include "graphics/engine/camera.h"
 #include "graphics/engine/cloud.h"
 #include "graphics/engine/engine.h"
+#include "graphics/engine/imageloader.h"
 #include "graphics/engine/lightman.h"
 #include "graphics/engine/lightning.h"
 #include "graphics/engine/modelfile.h"
@@ -53,6 +55,8 @@
 #include "object/motion/motionhuman.h"
 #include "object/motion/motiontoto.h"
 #include "object/object.h"
+#include "object/objectgrid.h"
+#include "object/snapshot.h"
 #include "object/task/task.h"
 #include "object/task/taskbuild.h"
 #include "object/task/taskmanip.h"
@@ -62,6 +66,7 @@
 #include "script/cbottoken.h"
 #include "script/cmdtoken.h"
 #include "script/script.h"
+#include "script/scriptscheduler.h"
 
 #include "sound/sound.h"
 
@@ -79,6 +84,9 @@
 #include "ui/slider.h"
 #include "ui/window.h"
 
+#include <sstream>
+#include <vector>
+
 
 template<> CRobotMain* CSingleton<CRobotMain>::mInstance = nullptr;
 
@@ -631,6 +639,8 @@ CRobotMain::CRobotMain(CInstanceManager* iMan, CApplication* app)
     m_dialog      = new Ui::CMainDialog(m_iMan);
     m_short       = new Ui::CMainShort();
     m_map         = new Ui::CMainMap();
+    m_objectGrid  = new CObjectGrid();
+    m_scriptScheduler = new CScriptScheduler(m_iMan);
     m_displayInfo = nullptr;
 
     m_engine->SetTerrain(m_terrain);
@@ -705,6 +715,7 @@ CRobotMain::CRobotMain(CInstanceManager* iMan, CApplication* app)
     // if (GetLocalProfileFloat("Edit", "WindowDim.y", fValue)) m_windowDim.y = fValue;
 
     m_IOPublic = false;
+    m_IOText = false;
     m_IODim = Math::Point(320.0f/640.0f, (121.0f+18.0f*8)/480.0f);
     m_IOPos.x = (1.0f-m_IODim.x)/2.0f;  // in the middle
     m_IOPos.y = (1.0f-m_IODim.y)/2.0f;
@@ -857,6 +868,12 @@ CRobotMain::~CRobotMain()
     delete m_map;
     m_map = nullptr;
 
+    delete m_objectGrid;
+    m_objectGrid = nullptr;
+
+    delete m_scriptScheduler;
+    m_scriptScheduler = nullptr;
+
     m_iMan = nullptr;
     m_app = nullptr;
 }
@@ -1101,6 +1118,7 @@ void CRobotMain::ChangePhase(Phase phase)
         bool loading = (m_dialog->GetSceneRead()[0] != 0);
 
         m_map->CreateMap();
+        Gfx::CImageLoader::GetInstancePointer()->SetProgress(m_app);
         CreateScene(m_dialog->GetSceneSoluce(), false, false);  // interactive scene
         if (m_mapImage)
             m_map->SetFixImage(m_mapFilename);
@@ -1203,6 +1221,19 @@ void CRobotMain::ChangePhase(Phase phase)
         m_app->SetMouseMode(MOUSE_ENGINE);
 
     m_engine->LoadAllTextures();
+
+    // Frees the images preloaded for the scene and not used
+    Gfx::CImageLoader* imageLoader = Gfx::CImageLoader::GetInstancePointer();
+    imageLoader->SetProgress(nullptr);
+    imageLoader->Flush();
+}
+
+//! Starts the simulation of a scene without going through the menus
+void CRobotMain::StartScene(const std::string& base, int rank)
+{
+    m_dialog->SetSceneName(base.c_str());
+    m_dialog->SetSceneRank(rank);
+    ChangePhase(PHASE_SIMUL);
 }
 
 //! Processes an event
@@ -1877,6 +1908,12 @@ void CRobotMain::ExecuteCmd(char *cmd)
         return;
     }
 
+    if (strcmp(cmd, "scriptstat") == 0)
+    {
+        m_scriptScheduler->LogStatistics();
+        return;
+    }
+
     if (strcmp(cmd, "invshadow") == 0)
     {
         m_engine->SetShadow(!m_engine->GetShadow());
@@ -2155,6 +2192,28 @@ float CRobotMain::GetFontSize()
     return m_fontSize;
 }
 
+//! Managing the number of threads running the programs
+void CRobotMain::SetScriptThreads(int count)
+{
+    m_scriptScheduler->SetThreadCount(count);
+}
+
+int CRobotMain::GetScriptThreads()
+{
+    return m_scriptScheduler->GetThreadCount();
+}
+
+//! Managing the frame time kept by limiting the instructions of programs
+void CRobotMain::SetScriptFrameTime(float time)
+{
+    m_scriptScheduler->SetFrameTime(time);
+}
+
+float CRobotMain::GetScriptFrameTime()
+{
+    return m_scriptScheduler->GetFrameTime();
+}
+
 //! Managing the size of the default window
 void CRobotMain::SetWindowPos(Math::Point pos)
 {
@@ -2196,6 +2255,17 @@ bool CRobotMain::GetIOPublic()
     return m_IOPublic;
 }
 
+//! Managing the binary snapshot written next to the text files of saved games
+void CRobotMain::SetIOText(bool mode)
+{
+    m_IOText = mode;
+}
+
+bool CRobotMain::GetIOText()
+{
+    return m_IOText;
+}
+
 void CRobotMain::SetIOPos(Math::Point pos)
 {
     m_IOPos = pos;
@@ -2532,6 +2602,8 @@ void CRobotMain::DeleteAllObjects()
         obj->DeleteObject(true);  // destroys rapidly
         delete obj;
     }
+
+    m_objectGrid->Flush();
 }
 
 //! Selects the human
@@ -2575,24 +2647,36 @@ CObject* CRobotMain::SearchNearest(Math::Vector pos, CObject* exclu)
 {
     float min = 100000.0f;
     CObject* best = 0;
-    for (int i = 0; i < 1000000; i++)
+
+    // Search growing circles; the first hit inside a circle is the nearest overall
+    std::vector<CObject*> objects;
+    float radius = OBJECT_GRID_CELL_SIZE;
+    while (true)
     {
-        CObject* obj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if (obj == nullptr) break;
+        m_objectGrid->FindInRadius(objects, pos, radius);
+        for (int i = 0; i < static_cast<int>( objects.size() ); i++)
+        {
+            CObject* obj = objects[i];
 
-        if (obj == exclu) continue;
-        if (!IsSelectable(obj)) continue;
+            if (obj == exclu) continue;
+            if (!IsSelectable(obj)) continue;
 
-        ObjectType type = obj->GetType();
-        if (type == OBJECT_TOTO) continue;
+            ObjectType type = obj->GetType();
+            if (type == OBJECT_TOTO) continue;
 
-        Math::Vector oPos = obj->GetPosition(0);
-        float dist = Math::DistanceProjected(oPos, pos);
-        if (dist < min)
-        {
-            min = dist;
-            best = obj;
+            Math::Vector oPos = obj->GetPosition(0);
+            float dist = Math::DistanceProjected(oPos, pos);
+            if (dist < min)
+            {
+                min = dist;
+                best = obj;
+            }
         }
+
+        if (best != nullptr || radius >= min) break;
+
+        radius *= 2.0f;
+        if (radius >= OBJECT_GRID_MAX_RADIUS) radius = min;
     }
     return best;
 }
@@ -3234,9 +3318,14 @@ void CRobotMain::InitEye()
 //! Advances the entire scene
 bool CRobotMain::EventFrame(const Event &event)
 {
+    CProfiler* profiler = CProfiler::GetInstancePointer();
+    CProfilerScope scope(PROF_UPDATE);
+
     m_time += event.rTime;
     if (!m_movieLock) m_gameTime += event.rTime;
 
+    m_objectGrid->FrameStatistics();
+
     if (!m_immediatSatCom && !m_beginSatCom &&
          m_gameTime > 0.1f && m_phase == PHASE_SIMUL)
     {
@@ -3264,6 +3353,11 @@ bool CRobotMain::EventFrame(const Event &event)
     CObject* toto = nullptr;
     if (!m_freePhoto)
     {
+        // Shares out the instructions of the programs run in this frame
+        m_scriptScheduler->BeginFrame(GetSelect());
+
+        profiler->StartSection(PROF_OBJECTS);
+
         // Advances all the robots, but not toto.
         for (int i = 0; i < 1000000; i++)
         {
@@ -3286,7 +3380,16 @@ bool CRobotMain::EventFrame(const Event &event)
             obj->EventProcess(event);
         }
 
+        profiler->StopSection(PROF_OBJECTS);
+
+        // Runs the programs queued by the robots; this is the frame barrier
+        // after which their effects are visible to the other objects
+        profiler->StartSection(PROF_SCRIPTS);
+        m_scriptScheduler->Execute();
+        profiler->StopSection(PROF_SCRIPTS);
+
         // Advances pyrotechnic effects.
+        profiler->StartSection(PROF_PYROS);
         for (int i = 0; i < 1000000; i++)
         {
             Gfx::CPyro* pyro = static_cast<Gfx::CPyro*>(m_iMan->SearchInstance(CLASS_PYRO, i));
@@ -3299,10 +3402,12 @@ bool CRobotMain::EventFrame(const Event &event)
                 delete pyro;
             }
         }
+        profiler->StopSection(PROF_PYROS);
     }
 
     // The camera follows the object, because its position
     // may depend on the selected object (Gfx::CAM_TYPE_ONBOARD or Gfx::CAM_TYPE_BACK).
+    profiler->StartSection(PROF_CAMERA);
     if (m_phase == PHASE_SIMUL && !m_editFull)
     {
         m_camera->EventProcess(event);
@@ -3316,6 +3421,7 @@ bool CRobotMain::EventFrame(const Event &event)
     {
         m_camera->EventProcess(event);
     }
+    profiler->StopSection(PROF_CAMERA);
 
     // Advances toto following the camera, because its position depends on the camera.
     if (toto != nullptr)
@@ -3701,6 +3807,98 @@ void CRobotMain::ScenePerso()
     }
 }
 
+//! Queues the terrain maps, then the textures of a scene for decoding while it is created
+void CRobotMain::PreloadScene(const std::string& fileName)
+{
+    FILE* file = fopen(fileName.c_str(), "r");
+    if (file == NULL) return;
+
+    std::vector<std::string> terrainMaps;
+    std::vector<std::string> textures;
+
+    char line[500];
+    char name[200];
+
+    while (fgets(line, 500, file) != NULL)
+    {
+        for (int i = 0; i < 500; i++)
+        {
+            if (line[i] == '\t' ) line[i] = ' ';  // replace tab by space
+            if (line[i] == '/' && line[i+1] == '/')
+            {
+                line[i] = 0;
+                break;
+            }
+        }
+
+        name[0] = 0;
+
+        if (Cmd(line, "TerrainRelief") || Cmd(line, "TerrainResource"))
+        {
+            OpString(line, "image", name);
+            terrainMaps.push_back(name);
+        }
+
+        if (Cmd(line, "Background") || Cmd(line, "Planet") || Cmd(line, "ForegroundName") ||
+            Cmd(line, "TerrainWater") || Cmd(line, "TerrainCloud"))
+        {
+            OpString(line, "image", name);
+            textures.push_back(name);
+        }
+
+        if (Cmd(line, "TerrainMaterial"))
+        {
+            OpString(line, "image", name);
+            AddExt(name, ".png");
+            textures.push_back(name);
+        }
+
+        if (Cmd(line, "TerrainInitTextures"))
+        {
+            OpString(line, "image", name);
+            AddExt(name, ".png");
+
+            // Names as made by CTerrain from the base name and the table
+            std::string baseName = name;
+            std::string ext = ".png";
+            size_t pos = baseName.find('.');
+            if (pos != std::string::npos)
+            {
+                ext = baseName.substr(pos);
+                baseName = baseName.substr(0, pos);
+            }
+
+            int count = OpInt(line, "dx", 1) * OpInt(line, "dy", 1);
+            char* op = SearchOp(line, "table");
+            for (int i = 0; i < count && i < 100; i++)
+            {
+                std::stringstream s;
+                s << baseName;
+                s.width(3);
+                s.fill('0');
+                s << GetInt(op, i, 0);
+                s << ext;
+                textures.push_back(s.str());
+            }
+        }
+    }
+
+    fclose(file);
+
+    // Files of the user are copied to a temporary directory first; they are not preloaded
+    for (int i = 0; i < static_cast<int>( terrainMaps.size() ); i++)
+    {
+        if (terrainMaps[i].find("%user%") == std::string::npos)
+            m_engine->PreloadTexture(terrainMaps[i]);
+    }
+
+    for (int i = 0; i < static_cast<int>( textures.size() ); i++)
+    {
+        if (textures[i].find("%user%") == std::string::npos)
+            m_engine->PreloadTexture(textures[i]);
+    }
+}
+
 //! Creates the whole scene
 void CRobotMain::CreateScene(bool soluce, bool fixScene, bool resetObject)
 {
@@ -3786,6 +3984,10 @@ void CRobotMain::CreateScene(bool soluce, bool fixScene, bool resetObject)
     memset(op, 0, 100);
     std::string tempLine;
     m_dialog->BuildSceneName(tempLine, base, rank);
+
+    if (!resetObject)
+        PreloadScene(tempLine);
+
     strcpy(line, tempLine.c_str());
     FILE* file = fopen(line, "r");
     if (file == NULL) return;
@@ -5814,10 +6016,27 @@ void CRobotMain::IOWriteObject(FILE *file, CObject* obj, const char *cmd)
 }
 
 //! Saves the current game
+//! The snapshot holds the whole scene; the text files then only keep the header, read by the
+//! list of saved games. They are complete with -savetext, or if the snapshot could not be written.
 bool CRobotMain::IOWriteScene(const char *filename, const char *filecbot, char *info)
 {
+    char filesnap[MAX_FNAME];
+    strcpy(filesnap, filename);
+    char* ldir = SearchLastDir(filesnap);
+    if (ldir == 0) return false;
+    strcpy(ldir, "/data.snap");
+
+    bool snapshot = !m_IOText && IOWriteSnapshot(filesnap);
+
+    // The previous snapshot must not be read with the new text files, nor the opposite
+    if (snapshot)
+        remove(filecbot);
+    else
+        remove(filesnap);
+
     FILE* file = fopen(filename, "w");
     if (file == NULL)  return false;
+    setvbuf(file, nullptr, _IOFBF, SNAPSHOT_BUFFER);
 
     char line[500];
 
@@ -5838,17 +6057,20 @@ bool CRobotMain::IOWriteScene(const char *filename, const char *filecbot, char *
     }
     fputs(line, file);
 
-    sprintf(line, "Map zoom=%.2f\n", m_map->GetZoomMap());
-    fputs(line, file);
-
-    sprintf(line, "DoneResearch bits=%d\n", static_cast<int>(g_researchDone));
-    fputs(line, file);
-
-    float sleep, delay, magnetic, progress;
-    if (m_lightning->GetStatus(sleep, delay, magnetic, progress))
+    if (!snapshot)
     {
-        sprintf(line, "BlitzMode sleep=%.2f delay=%.2f magnetic=%.2f progress=%.2f\n", sleep, delay, magnetic/g_unit, progress);
+        sprintf(line, "Map zoom=%.2f\n", m_map->GetZoomMap());
         fputs(line, file);
+
+        sprintf(line, "DoneResearch bits=%d\n", static_cast<int>(g_researchDone));
+        fputs(line, file);
+
+        float sleep, delay, magnetic, progress;
+        if (m_lightning->GetStatus(sleep, delay, magnetic, progress))
+        {
+            sprintf(line, "BlitzMode sleep=%.2f delay=%.2f magnetic=%.2f progress=%.2f\n", sleep, delay, magnetic/g_unit, progress);
+            fputs(line, file);
+        }
     }
 
     int objRank = 0;
@@ -5864,32 +6086,51 @@ bool CRobotMain::IOWriteScene(const char *filename, const char *filecbot, char *
         if (obj->GetDead()) continue;
         if (obj->GetExplo()) continue;
 
-        CObject* power = obj->GetPower();
-        CObject* fret  = obj->GetFret();
+        if (!snapshot)
+        {
+            CObject* power = obj->GetPower();
+            CObject* fret  = obj->GetFret();
 
-        if (fret != nullptr)  // object transported?
-            IOWriteObject(file, fret, "CreateFret");
+            if (fret != nullptr)  // object transported?
+                IOWriteObject(file, fret, "CreateFret");
 
-        if (power != nullptr)  // battery transported?
-            IOWriteObject(file, power, "CreatePower");
+            if (power != nullptr)  // battery transported?
+                IOWriteObject(file, power, "CreatePower");
 
-        IOWriteObject(file, obj, "CreateObject");
+            IOWriteObject(file, obj, "CreateObject");
+        }
 
+        // The programs are in their own files, with both formats
         SaveFileScript(obj, filename, objRank++);
     }
     fclose(file);
 
 #if CBOT_STACK
-    // Writes the file of stacks of execution.
-    file = fOpen(filecbot, "wb");
-    if (file == NULL) return false;
+    if (!snapshot)
+    {
+        // Writes the file of stacks of execution.
+        file = fOpen(filecbot, "wb");
+        if (file == NULL) return false;
+        setvbuf(file, nullptr, _IOFBF, SNAPSHOT_BUFFER);
+
+        long version = 1;
+        fWrite(&version, sizeof(long), 1, file);  // version of COLOBOT
+        version = CBotProgram::GetVersion();
+        fWrite(&version, sizeof(long), 1, file);  // version of CBOT
 
-    long version = 1;
-    fWrite(&version, sizeof(long), 1, file);  // version of COLOBOT
-    version = CBotProgram::GetVersion();
-    fWrite(&version, sizeof(long), 1, file);  // version of CBOT
+        IOWriteStacks(file);
+        fClose(file);
+    }
+#endif
 
-    objRank = 0;
+    m_delayWriteMessage = 4;  // displays message in 3 frames
+    return true;
+}
+
+//! Writes the stacks of the programs in execution, in the order of the objects
+void CRobotMain::IOWriteStacks(FILE *file)
+{
+    int objRank = 0;
     for (int i = 0; i < 1000000; i++)
     {
         CObject* obj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
@@ -5900,15 +6141,162 @@ bool CRobotMain::IOWriteScene(const char *filename, const char *filecbot, char *
         if (obj->GetTruck() != nullptr) continue;
         if (obj->GetBurn()) continue;
         if (obj->GetDead()) continue;
+        if (obj->GetExplo()) continue;
 
         if (!SaveFileStack(obj, file, objRank++))  break;
     }
     CBotClass::SaveStaticState(file);
-    fClose(file);
+}
+
+//! Writes an object into the snapshot
+void CRobotMain::IOWriteSnapshotObject(CSnapshotWriter &writer, CObject* obj, int kind)
+{
+    if (obj->GetType() == OBJECT_FIX) return;
+
+    SnapshotObject record;
+    record.kind    = kind;
+    record.type    = obj->GetType();
+    record.id      = obj->GetID();
+    record.trainer = obj->GetTrainer();
+    record.option  = obj->GetOption();
+    record.select  = (obj == m_infoObject);
+
+    record.run = -1;
+    if (obj->GetType() == OBJECT_BASE)
+    {
+        record.run = 3;  // stops and open (PARAM_FIXSCENE)
+    }
+    else
+    {
+        CBrain* brain = obj->GetBrain();
+        if (brain != nullptr && brain->GetProgram() != -1)
+            record.run = brain->GetProgram()+1;
+    }
+
+    record.pos   = obj->GetPosition(0);
+    record.angle = obj->GetAngle(0);
+    record.zoom  = obj->GetZoom(0);
+
+    for (int i = 1; i < OBJECTMAXPART; i++)
+    {
+        if (obj->GetObjectRank(i) == -1) continue;
+
+        SnapshotPart part;
+        part.rank  = i;
+        part.pos   = obj->GetPosition(i);
+        part.angle = obj->GetAngle(i);
+        part.zoom  = obj->GetZoom(i);
+        if (part.pos.x   == 0.0f && part.pos.y   == 0.0f && part.pos.z   == 0.0f &&
+            part.angle.x == 0.0f && part.angle.y == 0.0f && part.angle.z == 0.0f &&
+            part.zoom.x  == 1.0f && part.zoom.y  == 1.0f && part.zoom.z  == 1.0f) continue;
+
+        record.parts.push_back(part);
+    }
+
+    // Other attributes, specific to each class, keep their text form
+    char line[3000];
+    line[0] = 0;
+    obj->Write(line);
+    record.line = line;
+
+    writer.WriteObject(record);
+}
+
+//! Saves the game as a binary snapshot, with the stacks of the programs
+//! The snapshot is written to a temporary file, which replaces the previous snapshot only when complete.
+bool CRobotMain::IOWriteSnapshot(const char *filesnap)
+{
+    char filetemp[MAX_FNAME];
+    sprintf(filetemp, "%s.tmp", filesnap);
+
+    FILE* file = fOpen(filetemp, "wb");
+    if (file == NULL)
+    {
+        GetLogger()->Error("Could not write snapshot %s\n", filetemp);
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, SNAPSHOT_BUFFER);
+
+    int header[3];
+    header[0] = SNAPSHOT_MAGIC;
+    header[1] = SNAPSHOT_VERSION;
+    header[2] = CBotProgram::GetVersion();
+    fWrite(header, sizeof(int), 3, file);
+
+    CSnapshotWriter writer;
+
+    writer.WriteFloat(m_map->GetZoomMap());
+    writer.WriteInt(static_cast<int>(g_researchDone));
+
+    float sleep, delay, magnetic, progress;
+    bool blitz = m_lightning->GetStatus(sleep, delay, magnetic, progress);
+    writer.WriteInt(blitz);
+    if (blitz)
+    {
+        writer.WriteFloat(sleep);
+        writer.WriteFloat(delay);
+        writer.WriteFloat(magnetic);
+        writer.WriteFloat(progress);
+    }
+
+    const std::vector<Gfx::TerrainChange>& changes = m_terrain->GetChanges();
+    writer.WriteInt(static_cast<int>( changes.size() ));
+    for (int i = 0; i < static_cast<int>( changes.size() ); i++)
+    {
+        writer.WriteVector(changes[i].p1);
+        writer.WriteVector(changes[i].p2);
+        writer.WriteFloat(changes[i].height);
+    }
+
+    for (int i = 0; i < 1000000; i++)
+    {
+        CObject* obj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
+        if (obj == nullptr) break;
+
+        if (obj->GetType() == OBJECT_TOTO) continue;
+        if (obj->GetType() == OBJECT_FIX) continue;
+        if (obj->GetTruck() != nullptr) continue;
+        if (obj->GetBurn()) continue;
+        if (obj->GetDead()) continue;
+        if (obj->GetExplo()) continue;
+
+        CObject* power = obj->GetPower();
+        CObject* fret  = obj->GetFret();
+
+        if (fret != nullptr)  // object transported?
+            IOWriteSnapshotObject(writer, fret, SNAPSHOT_FRET);
+
+        if (power != nullptr)  // battery transported?
+            IOWriteSnapshotObject(writer, power, SNAPSHOT_POWER);
+
+        IOWriteSnapshotObject(writer, obj, SNAPSHOT_OBJECT);
+    }
+    writer.WriteInt(SNAPSHOT_END);
+
+    bool ok = writer.Flush(file);
+
+#if CBOT_STACK
+    // The stacks of execution follow in the same stream
+    if (ok)
+        IOWriteStacks(file);
 #endif
 
-    m_delayWriteMessage = 4;  // displays message in 3 frames
-    return true;
+    if (ferror(file)) ok = false;
+    if (fClose(file) != 0) ok = false;
+
+    if (ok)
+    {
+        remove(filesnap);
+        if (rename(filetemp, filesnap) != 0) ok = false;
+    }
+
+    if (!ok)
+    {
+        // The text files are loaded instead
+        GetLogger()->Error("Could not write snapshot %s\n", filesnap);
+        remove(filetemp);
+    }
+    return ok;
 }
 
 //! Resumes the game
@@ -5996,8 +6384,21 @@ CObject* CRobotMain::IOReadScene(const char *filename, const char *filecbot)
 {
     m_base = false;
 
+    char filesnap[MAX_FNAME];
+    strcpy(filesnap, filename);
+    char* ldir = SearchLastDir(filesnap);
+    if (ldir != 0)
+    {
+        strcpy(ldir, "/data.snap");
+
+        CObject* sel = nullptr;
+        if (IOReadSnapshot(filename, filesnap, sel))
+            return sel;
+    }
+
     FILE* file = fopen(filename, "r");
     if (file == NULL) return 0;
+    setvbuf(file, nullptr, _IOFBF, SNAPSHOT_BUFFER);
 
     CObject* fret   = nullptr;
     CObject* power  = nullptr;
@@ -6065,7 +6466,31 @@ CObject* CRobotMain::IOReadScene(const char *filename, const char *filecbot)
     fclose(file);
 
 #if CBOT_STACK
-    // Compiles scripts.
+    IOCompileScripts(filename);
+
+    // Reads the file of stacks of execution.
+    file = fOpen(filecbot, "rb");
+    if (file != NULL)
+    {
+        setvbuf(file, nullptr, _IOFBF, SNAPSHOT_BUFFER);
+        long version;
+        fRead(&version, sizeof(long), 1, file);  // version of COLOBOT
+        if (version == 1)
+        {
+            fRead(&version, sizeof(long), 1, file);  // version of CBOT
+            if (version == CBotProgram::GetVersion())
+                IOReadStacks(file);
+        }
+        fClose(file);
+    }
+#endif
+
+    return sel;
+}
+
+//! Compiles the programs of the objects read from a saved game
+void CRobotMain::IOCompileScripts(const char* filename)
+{
     int nbError = 0;
     int lastError = 0;
     do
@@ -6078,50 +6503,219 @@ CObject* CRobotMain::IOReadScene(const char *filename, const char *filecbot)
             if (obj == nullptr) break;
             if (obj->GetTruck() != nullptr) continue;
 
-            objRank = obj->GetDefRank();
+            int objRank = obj->GetDefRank();
             if (objRank == -1) continue;
 
             LoadFileScript(obj, filename, objRank, nbError);
         }
     }
     while (nbError > 0 && nbError != lastError);
+}
 
-    // Reads the file of stacks of execution.
-    file = fOpen(filecbot, "rb");
-    if (file != NULL)
+//! Resumes the stacks of the programs in execution, in the order of the objects
+void CRobotMain::IOReadStacks(FILE *file)
+{
+    int objRank = 0;
+    for (int i = 0; i < 1000000; i++)
     {
-        long version;
-        fRead(&version, sizeof(long), 1, file);  // version of COLOBOT
-        if (version == 1)
+        CObject* obj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
+        if (obj == nullptr) break;
+
+        if (obj->GetType() == OBJECT_TOTO) continue;
+        if (obj->GetType() == OBJECT_FIX) continue;
+        if (obj->GetTruck() != nullptr) continue;
+        if (obj->GetBurn()) continue;
+        if (obj->GetDead()) continue;
+
+        if (!ReadFileStack(obj, file, objRank++)) break;
+    }
+    CBotClass::RestoreStaticState(file);
+}
+
+//! Resumes an object from the snapshot
+CObject* CRobotMain::IOReadSnapshotObject(const SnapshotObject &record, int objRank)
+{
+    ObjectType type = static_cast<ObjectType>(record.type);
+    CObject* obj = CreateObject(record.pos, record.angle.y, 1.0f, 0.0f, type, 0.0f, record.trainer, false, record.option);
+    if (obj == nullptr) return nullptr;
+
+    obj->SetDefRank(objRank);
+    obj->SetPosition(0, record.pos);
+    obj->SetAngle(0, record.angle);
+    obj->SetZoom(0, record.zoom);
+    obj->SetID(record.id);
+    if (g_id < record.id) g_id = record.id;
+
+    for (int i = 0; i < static_cast<int>( record.parts.size() ); i++)
+    {
+        const SnapshotPart &part = record.parts[i];
+        if (obj->GetObjectRank(part.rank) == -1) continue;
+
+        obj->SetPosition(part.rank, part.pos);
+        obj->SetAngle(part.rank, part.angle);
+        obj->SetZoom(part.rank, part.zoom);
+    }
+
+    if (type == OBJECT_BASE) m_base = true;
+
+    char line[3000];
+    strcpy(line, record.line.c_str());
+    obj->Read(line);
+
+    if (record.run != -1)
+    {
+#if CBOT_STACK
+#else
+        CBrain* brain = obj->GetBrain();
+        if (brain != nullptr)
+            brain->RunProgram(record.run-1);  // starts the program
+#endif
+
+        CAuto* automat = obj->GetAuto();
+        if (automat != nullptr)
+            automat->Start(record.run);  // starts the film
+    }
+
+    return obj;
+}
+
+//! Resumes the game from a snapshot; returns false, without changing anything, if there is no valid snapshot
+//! The whole block is decoded and checked before the first object is created.
+bool CRobotMain::IOReadSnapshot(const char *filename, const char *filesnap, CObject* &sel)
+{
+    FILE* file = fOpen(filesnap, "rb");
+    if (file == NULL) return false;
+    setvbuf(file, nullptr, _IOFBF, SNAPSHOT_BUFFER);
+
+    int header[3];
+    if (fRead(header, sizeof(int), 3, file) != 3 ||
+        header[0] != SNAPSHOT_MAGIC ||
+        header[1] != SNAPSHOT_VERSION)
+    {
+        GetLogger()->Warn("Snapshot %s has an unknown format, reading the text file\n", filesnap);
+        fClose(file);
+        return false;
+    }
+
+    CSnapshotReader reader;
+    if (!reader.Load(file))
+    {
+        GetLogger()->Error("Snapshot %s is truncated, reading the text file\n", filesnap);
+        fClose(file);
+        return false;
+    }
+
+    float zoomMap = reader.ReadFloat();
+    int researchDone = reader.ReadInt();
+
+    bool blitz = (reader.ReadInt() != 0);
+    float sleep = 0.0f, delay = 0.0f, magnetic = 0.0f, progress = 0.0f;
+    if (blitz)
+    {
+        sleep = reader.ReadFloat();
+        delay = reader.ReadFloat();
+        magnetic = reader.ReadFloat();
+        progress = reader.ReadFloat();
+    }
+
+    std::vector<Gfx::TerrainChange> changes;
+    int count = reader.ReadInt();
+    if (count < 0) reader.SetError();
+    for (int i = 0; i < count && !reader.IsError(); i++)
+    {
+        Gfx::TerrainChange change;
+        change.p1 = reader.ReadVector();
+        change.p2 = reader.ReadVector();
+        change.height = reader.ReadFloat();
+        changes.push_back(change);
+    }
+
+    std::vector<SnapshotObject> records;
+    bool ok = !reader.IsError() && reader.ReadObjects(records);
+
+    for (int i = 0; ok && i < static_cast<int>( records.size() ); i++)
+    {
+        if (records[i].type <= OBJECT_NULL || records[i].type >= OBJECT_MAX) ok = false;
+        if (records[i].line.size() >= 3000) ok = false;
+
+        for (int j = 0; j < static_cast<int>( records[i].parts.size() ); j++)
         {
-            fRead(&version, sizeof(long), 1, file);  // version of CBOT
-            if (version == CBotProgram::GetVersion())
+            if (records[i].parts[j].rank >= OBJECTMAXPART) ok = false;
+        }
+    }
+
+    if (!ok)
+    {
+        GetLogger()->Error("Snapshot %s is damaged, reading the text file\n", filesnap);
+        fClose(file);
+        return false;
+    }
+
+    m_map->ZoomMap(zoomMap);
+    g_researchDone = researchDone;
+
+    if (blitz)
+        m_lightning->SetStatus(sleep, delay, magnetic, progress);
+
+    for (int i = 0; i < static_cast<int>( changes.size() ); i++)
+        m_terrain->Terraform(changes[i].p1, changes[i].p2, changes[i].height);
+
+    CObject* fret   = nullptr;
+    CObject* power  = nullptr;
+    int objRank = 0;
+    for (int i = 0; i < static_cast<int>( records.size() ); i++)
+    {
+        const SnapshotObject &record = records[i];
+
+        if (record.kind == SNAPSHOT_FRET)
+        {
+            fret = IOReadSnapshotObject(record, -1);
+        }
+        else if (record.kind == SNAPSHOT_POWER)
+        {
+            power = IOReadSnapshotObject(record, -1);
+        }
+        else
+        {
+            CObject* obj = IOReadSnapshotObject(record, objRank++);
+
+            if (obj != nullptr)
             {
-                objRank = 0;
-                for (int i = 0; i < 1000000; i++)
-                {
-                    CObject* obj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
-                    if (obj == nullptr) break;
+                if (record.select)
+                    sel = obj;
 
-                    if (obj->GetType() == OBJECT_TOTO) continue;
-                    if (obj->GetType() == OBJECT_FIX) continue;
-                    if (obj->GetTruck() != nullptr) continue;
-                    if (obj->GetBurn()) continue;
-                    if (obj->GetDead()) continue;
+                if (fret != nullptr)
+                {
+                    obj->SetFret(fret);
+                    CTaskManip* task = new CTaskManip(m_iMan, obj);
+                    task->Start(TMO_AUTO, TMA_GRAB);  // holds the object!
+                    delete task;
+                }
 
-                    if (!ReadFileStack(obj, file, objRank++)) break;
+                if (power != nullptr)
+                {
+                    obj->SetPower(power);
+                    power->SetTruck(obj);
                 }
             }
+
+            fret  = nullptr;
+            power = nullptr;
         }
-        CBotClass::RestoreStaticState(file);
-        fClose(file);
     }
+
+#if CBOT_STACK
+    IOCompileScripts(filename);
+
+    // The stacks of execution follow the objects
+    if (header[2] == CBotProgram::GetVersion())
+        IOReadStacks(file);
 #endif
 
-    return sel;
+    fClose(file);
+    return true;
 }
 
-
 //! Writes the global parameters for free play
 void CRobotMain::WriteFreeParam()
 {
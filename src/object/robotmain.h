@@ -31,6 +31,7 @@
 #include "object/mainmovie.h"
 
 #include <stdio.h>
+#include <string>
 
 enum Phase
 {
@@ -74,6 +75,11 @@ enum Phase
 class CInstanceManager;
 class CEventQueue;
 class CSoundInterface;
+class CObjectGrid;
+class CScriptScheduler;
+class CSnapshotWriter;
+class CSnapshotReader;
+struct SnapshotObject;
 
 namespace Gfx
 {
@@ -208,6 +214,8 @@ public:
     void        ResetKeyStates();
 
     void        ChangePhase(Phase phase);
+    //! Starts the simulation of a scene without going through the menus
+    void        StartScene(const std::string& base, int rank);
     bool        EventProcess(Event &event);
 
     bool        CreateShortcuts();
@@ -277,8 +285,15 @@ public:
     void        SetWindowDim(Math::Point dim);
     Math::Point     GetWindowDim();
 
+    void        SetScriptThreads(int count);
+    int         GetScriptThreads();
+    void        SetScriptFrameTime(float time);
+    float       GetScriptFrameTime();
+
     void        SetIOPublic(bool mode);
     bool        GetIOPublic();
+    void        SetIOText(bool mode);
+    bool        GetIOText();
     void        SetIOPos(Math::Point pos);
     Math::Point     GetIOPos();
     void        SetIODim(Math::Point dim);
@@ -347,6 +362,13 @@ public:
     CObject*    IOReadScene(const char *filename, const char *filecbot);
     void        IOWriteObject(FILE *file, CObject* pObj, const char *cmd);
     CObject*    IOReadObject(char *line, const char* filename, int objRank);
+    bool        IOWriteSnapshot(const char *filesnap);
+    bool        IOReadSnapshot(const char *filename, const char *filesnap, CObject* &sel);
+    void        IOWriteSnapshotObject(CSnapshotWriter &writer, CObject* pObj, int kind);
+    CObject*    IOReadSnapshotObject(const SnapshotObject &record, int objRank);
+    void        IOWriteStacks(FILE *file);
+    void        IOReadStacks(FILE *file);
+    void        IOCompileScripts(const char* filename);
 
     int         CreateSpot(Math::Vector pos, Gfx::Color color);
 
@@ -357,6 +379,7 @@ protected:
 
     void        Convert();
     void        CreateScene(bool soluce, bool fixScene, bool resetObject);
+    void        PreloadScene(const std::string& fileName);
 
     void        CreateModel();
     Math::Vector LookatPoint(Math::Vector eye, float angleH, float angleV, float length);
@@ -406,6 +429,8 @@ protected:
     Ui::CMainDialog*    m_dialog;
     Ui::CMainShort*     m_short;
     Ui::CMainMap*       m_map;
+    CObjectGrid*        m_objectGrid;
+    CScriptScheduler*   m_scriptScheduler;
     Ui::CInterface*     m_interface;
     Ui::CDisplayText*   m_displayText;
     Ui::CDisplayInfo*   m_displayInfo;
@@ -486,6 +511,7 @@ protected:
     Math::Point     m_windowDim;
 
     bool            m_IOPublic;
+    bool            m_IOText;
     Math::Point     m_IOPos;
     Math::Point     m_IODim;
 
@@ -0,0 +1,259 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+
+#include "object/snapshot.h"
+
+#include <cstring>
+
+
+CSnapshotWriter::CSnapshotWriter()
+{
+}
+
+CSnapshotWriter::~CSnapshotWriter()
+{
+}
+
+void CSnapshotWriter::Write(const void* data, int size)
+{
+    const char* p = static_cast<const char*>(data);
+    m_data.insert(m_data.end(), p, p + size);
+}
+
+void CSnapshotWriter::WriteInt(int value)
+{
+    Write(&value, sizeof(int));
+}
+
+void CSnapshotWriter::WriteFloat(float value)
+{
+    Write(&value, sizeof(float));
+}
+
+void CSnapshotWriter::WriteVector(const Math::Vector& value)
+{
+    WriteFloat(value.x);
+    WriteFloat(value.y);
+    WriteFloat(value.z);
+}
+
+void CSnapshotWriter::WriteString(const char* text)
+{
+    int len = strlen(text);
+    WriteInt(len);
+    Write(text, len);
+}
+
+void CSnapshotWriter::WriteObject(const SnapshotObject& object)
+{
+    WriteInt(object.kind);
+    WriteInt(object.type);
+    WriteInt(object.id);
+    WriteInt(object.trainer);
+    WriteInt(object.option);
+    WriteInt(object.select);
+    WriteInt(object.run);
+
+    WriteVector(object.pos);
+    WriteVector(object.angle);
+    WriteVector(object.zoom);
+
+    for (int i = 0; i < static_cast<int>( object.parts.size() ); i++)
+    {
+        WriteInt(object.parts[i].rank);
+        WriteVector(object.parts[i].pos);
+        WriteVector(object.parts[i].angle);
+        WriteVector(object.parts[i].zoom);
+    }
+    WriteInt(0);
+
+    WriteString(object.line.c_str());
+}
+
+bool CSnapshotWriter::Flush(FILE* file)
+{
+    int size = static_cast<int>( m_data.size() );
+    if (fwrite(&size, sizeof(int), 1, file) != 1)
+        return false;
+
+    if (size > 0 && fwrite(&m_data[0], 1, size, file) != static_cast<size_t>(size))
+        return false;
+
+    m_data.clear();
+    return true;
+}
+
+
+CSnapshotReader::CSnapshotReader()
+{
+    m_pos = 0;
+    m_error = false;
+}
+
+CSnapshotReader::~CSnapshotReader()
+{
+}
+
+bool CSnapshotReader::Load(FILE* file)
+{
+    m_data.clear();
+    m_pos = 0;
+    m_error = true;
+
+    int size = 0;
+    if (fread(&size, sizeof(int), 1, file) != 1)
+        return false;
+
+    if (size < 0)
+        return false;
+
+    m_data.resize(size);
+    if (size > 0 && fread(&m_data[0], 1, size, file) != static_cast<size_t>(size))
+        return false;
+
+    m_error = false;
+    return true;
+}
+
+bool CSnapshotReader::Read(void* data, int size)
+{
+    if (m_error || size < 0 || m_pos + size > static_cast<int>( m_data.size() ))
+    {
+        m_error = true;
+        memset(data, 0, size > 0 ? size : 0);
+        return false;
+    }
+
+    if (size > 0)
+        memcpy(data, &m_data[m_pos], size);
+
+    m_pos += size;
+    return true;
+}
+
+int CSnapshotReader::ReadInt()
+{
+    int value = 0;
+    Read(&value, sizeof(int));
+    return value;
+}
+
+float CSnapshotReader::ReadFloat()
+{
+    float value = 0.0f;
+    Read(&value, sizeof(float));
+    return value;
+}
+
+Math::Vector CSnapshotReader::ReadVector()
+{
+    Math::Vector value;
+    value.x = ReadFloat();
+    value.y = ReadFloat();
+    value.z = ReadFloat();
+    return value;
+}
+
+void CSnapshotReader::ReadString(char* text, int max)
+{
+    text[0] = 0;
+
+    int len = ReadInt();
+    if (len < 0 || len >= max)
+    {
+        m_error = true;
+        return;
+    }
+
+    if (Read(text, len))
+        text[len] = 0;
+}
+
+bool CSnapshotReader::ReadObjects(std::vector<SnapshotObject>& objects)
+{
+    objects.clear();
+
+    while (!m_error)
+    {
+        SnapshotObject object;
+        object.kind = ReadInt();
+        if (object.kind == SNAPSHOT_END)
+            break;
+
+        if (object.kind != SNAPSHOT_OBJECT &&
+            object.kind != SNAPSHOT_FRET   &&
+            object.kind != SNAPSHOT_POWER)
+        {
+            m_error = true;
+            break;
+        }
+
+        object.type    = ReadInt();
+        object.id      = ReadInt();
+        object.trainer = ReadInt();
+        object.option  = ReadInt();
+        object.select  = (ReadInt() != 0);
+        object.run     = ReadInt();
+
+        object.pos   = ReadVector();
+        object.angle = ReadVector();
+        object.zoom  = ReadVector();
+
+        while (!m_error)
+        {
+            SnapshotPart part;
+            part.rank = ReadInt();
+            if (part.rank == 0)
+                break;
+
+            if (part.rank < 0)
+            {
+                m_error = true;
+                break;
+            }
+
+            part.pos   = ReadVector();
+            part.angle = ReadVector();
+            part.zoom  = ReadVector();
+            object.parts.push_back(part);
+        }
+
+        int len = ReadInt();
+        if (len < 0 || m_pos + len > static_cast<int>( m_data.size() ))
+            m_error = true;
+
+        if (!m_error && len > 0)
+        {
+            object.line.assign(&m_data[m_pos], len);
+            m_pos += len;
+        }
+
+        objects.push_back(object);
+    }
+
+    return !m_error;
+}
+
+bool CSnapshotReader::IsError()
+{
+    return m_error;
+}
+
+void CSnapshotReader::SetError()
+{
+    m_error = true;
+}
@@ -0,0 +1,161 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+/**
+ * \file object/snapshot.h
+ * \brief CSnapshotWriter and CSnapshotReader - binary blocks of saved games
+ */
+
+#pragma once
+
+
+#include "math/vector.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+//! Identifies the snapshot files ("SNAP")
+const int SNAPSHOT_MAGIC   = 0x50414e53;
+//! Version of the snapshot format, incremented on each change of its layout
+const int SNAPSHOT_VERSION = 1;
+//! Size of the stream buffer of snapshot files
+const int SNAPSHOT_BUFFER  = 1 << 20;
+
+/**
+ * \enum SnapshotRecord
+ * \brief Kinds of object records in a snapshot
+ *
+ * An object carried by another one (SNAPSHOT_FRET, SNAPSHOT_POWER)
+ * is written just before its carrier, like in the text format.
+ */
+enum SnapshotRecord
+{
+    //! Ends the list of objects
+    SNAPSHOT_END    = 0,
+    SNAPSHOT_OBJECT = 1,
+    SNAPSHOT_FRET   = 2,
+    SNAPSHOT_POWER  = 3
+};
+
+/**
+ * \struct SnapshotPart
+ * \brief Placement of a part of an object, other than the main part
+ */
+struct SnapshotPart
+{
+    //! Rank of the part, from 1
+    int          rank;
+    Math::Vector pos;
+    Math::Vector angle;
+    Math::Vector zoom;
+};
+
+/**
+ * \struct SnapshotObject
+ * \brief Record of an object in a snapshot
+ */
+struct SnapshotObject
+{
+    //! Kind of record (see SnapshotRecord)
+    int          kind;
+    int          type;
+    int          id;
+    int          trainer;
+    int          option;
+    //! Program or film started when the game is resumed, or -1
+    int          run;
+    bool         select;
+    Math::Vector pos;
+    Math::Vector angle;
+    Math::Vector zoom;
+    //! Parts placed differently from their default
+    std::vector<SnapshotPart> parts;
+    //! Other attributes, in the text form of CObject::Write()
+    std::string  line;
+};
+
+
+/**
+ * \class CSnapshotWriter
+ * \brief Collects binary data in memory, to be written as one block
+ *
+ * Values are stored in native byte order: like the stacks of CBot,
+ * snapshots are meant to be read back by the same build.
+ */
+class CSnapshotWriter
+{
+public:
+    CSnapshotWriter();
+    ~CSnapshotWriter();
+
+    void        WriteInt(int value);
+    void        WriteFloat(float value);
+    void        WriteVector(const Math::Vector& value);
+    //! Writes a string with its length
+    void        WriteString(const char* text);
+    //! Writes the record of an object
+    void        WriteObject(const SnapshotObject& object);
+
+    //! Writes the size of the block, then the block itself, to the file
+    bool        Flush(FILE* file);
+
+protected:
+    void        Write(const void* data, int size);
+
+protected:
+    std::vector<char> m_data;
+};
+
+
+/**
+ * \class CSnapshotReader
+ * \brief Reads a block written by CSnapshotWriter with one read, then decodes it from memory
+ *
+ * Reading past the end of the block gives zero values and sets the error flag.
+ * The whole block can thus be decoded and checked before anything is created from it.
+ */
+class CSnapshotReader
+{
+public:
+    CSnapshotReader();
+    ~CSnapshotReader();
+
+    //! Reads the next block from the file
+    bool        Load(FILE* file);
+
+    int          ReadInt();
+    float        ReadFloat();
+    Math::Vector ReadVector();
+    //! Reads a string of at most \a max characters, including the terminating zero
+    void         ReadString(char* text, int max);
+    //! Reads the records of objects up to SNAPSHOT_END; returns false if a record is damaged
+    bool         ReadObjects(std::vector<SnapshotObject>& objects);
+
+    //! Indicates if the block was truncated or the read values were out of it
+    bool        IsError();
+    //! Marks the block as damaged, when the read values make no sense
+    void        SetError();
+
+protected:
+    bool        Read(void* data, int size);
+
+protected:
+    std::vector<char> m_data;
+    int         m_pos;
+    bool        m_error;
+};
@@ -26,14 +26,15 @@
 #include "graphics/engine/terrain.h"
 #include "graphics/engine/water.h"
 #include "math/geometry.h"
+#include "object/objectgrid.h"
 #include "physics/physics.h"
 
-#include <string.h>
+#include <vector>
 
 
 const float FLY_DIST_GROUND = 80.0f;    // minimum distance to remain on the ground
 const float FLY_DEF_HEIGHT  = 50.0f;    // default flying height
-const float BM_DIM_STEP     = 5.0f;
+const int   BM_SEARCH_CELLS = 20000;  // cells looked at by the path search in one frame
 
 
 
@@ -43,14 +44,13 @@ const float BM_DIM_STEP     = 5.0f;
 CTaskGoto::CTaskGoto(CInstanceManager* iMan, CObject* object)
                      : CTask(iMan, object)
 {
-    m_bmArray = 0;
+    m_navGrid = m_terrain->GetNavGrid();
 }
 
 // Object's destructor.
 
 CTaskGoto::~CTaskGoto()
 {
-    BitmapClose();
 }
 
 
@@ -127,7 +127,8 @@ bool CTaskGoto::EventProcess(const Event &event)
         if ( m_bmStep == 0 )
         {
             // Frees the area around the departure.
-            BitmapClearCircle(m_object->GetPosition(0), BM_DIM_STEP*1.8f);
+            m_navAgent.freePos = m_object->GetPosition(0);
+            m_navAgent.freeRadius = Gfx::NAV_CELL_SIZE*1.8f;
         }
 
         pos = m_object->GetPosition(0);
@@ -602,7 +603,6 @@ Error CTaskGoto::Start(Math::Vector goal, float altitude,
     CObject*    target;
     ObjectType  type;
     float       dist;
-    int         x, y;
 
     type = m_object->GetType();
 
@@ -734,9 +734,7 @@ Error CTaskGoto::Start(Math::Vector goal, float altitude,
 
         if ( m_bmFretObject == 0 )
         {
-            x = static_cast<int>((m_goal.x+1600.0f)/BM_DIM_STEP);
-            y = static_cast<int>((m_goal.z+1600.0f)/BM_DIM_STEP);
-            if ( BitmapTestDot(0, x, y) )  // arrival occupied?
+            if ( m_navGrid->TestPosition(m_navAgent, m_goal) )  // arrival occupied?
             {
                 m_error = ERR_GOTO_BUSY;
                 return m_error;
@@ -1522,10 +1520,12 @@ void CTaskGoto::ComputeRepulse(Math::Point &dir)
         bAlien = true;
     }
 
-    for ( i=0 ; i<1000000 ; i++ )
+    std::vector<CObject*> objects;
+    CObjectGrid::GetInstancePointer()->FindCrashCandidates(objects, iPos, iRadius+Math::Max(add, 2.0f));
+
+    for ( i=0 ; i<static_cast<int>( objects.size() ) ; i++ )
     {
-        pObj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if ( pObj == 0 )  break;
+        pObj = objects[i];
 
         if ( pObj == m_object )  continue;
         if ( pObj->GetTruck() != 0 )  continue;
@@ -1614,10 +1614,12 @@ void CTaskGoto::ComputeFlyingRepulse(float &dir)
     fac = 1.5f;
     dir = 0.0f;
 
-    for ( i=0 ; i<1000000 ; i++ )
+    std::vector<CObject*> objects;
+    CObjectGrid::GetInstancePointer()->FindCrashCandidates(objects, iPos, iRadius+add);
+
+    for ( i=0 ; i<static_cast<int>( objects.size() ) ; i++ )
     {
-        pObj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if ( pObj == 0 )  break;
+        pObj = objects[i];
 
         if ( pObj == m_object )  continue;
         if ( pObj->GetTruck() != 0 )  continue;
@@ -1659,7 +1661,7 @@ int CTaskGoto::BeamShortcut()
 
     for ( i=m_bmTotal ; i>=m_bmIndex+2 ; i-- )  // tries from the last
     {
-        if ( BitmapTestLine(m_bmPoints[m_bmIndex], m_bmPoints[i], 0.0f, false) )
+        if ( m_navGrid->TestLine(m_navAgent, m_bmPoints[m_bmIndex], m_bmPoints[i]) )
         {
             return i;  // bingo, found
         }
@@ -1672,20 +1674,7 @@ int CTaskGoto::BeamShortcut()
 
 void CTaskGoto::BeamStart()
 {
-    Math::Vector    min, max;
-
-    BitmapOpen();
-    BitmapObject();
-
-    min = m_object->GetPosition(0);
-    max = m_goal;
-    if ( min.x > max.x )  Math::Swap(min.x, max.x);
-    if ( min.z > max.z )  Math::Swap(min.z, max.z);
-    min.x -= 10.0f*BM_DIM_STEP;
-    min.z -= 10.0f*BM_DIM_STEP;
-    max.x += 10.0f*BM_DIM_STEP;
-    max.z += 10.0f*BM_DIM_STEP;
-    BitmapTerrain(min, max);
+    BeamAgent();
 
     if ( LeakSearch(m_leakPos, m_leakDelay) )
     {
@@ -1705,308 +1694,30 @@ void CTaskGoto::BeamStart()
 
 void CTaskGoto::BeamInit()
 {
-    int     i;
-
-    for ( i=0 ; i<MAXPOINTS ; i++ )
-    {
-        m_bmIter[i] = -1;
-    }
     m_bmStep = 0;
 }
 
-// Calculates points and passes to go from start to goal.
-// Returns:
-// ERR_OK if it's good
-// ERR_GOTO_IMPOSSIBLE if impossible
-// ERR_GOTO_ITER if aborts because too many recursions
-// ERR_CONTINUE if not done yet
-// goalRadius: distance at which we must approach the goal
-
-Error CTaskGoto::BeamSearch(const Math::Vector &start, const Math::Vector &goal,
-                            float goalRadius)
-{
-    float     step, len;
-    int       nbIter;
-
-    m_bmStep ++;
-
-    len = Math::DistanceProjected(start, goal);
-    step = len/5.0f;
-    if ( step < BM_DIM_STEP*2.1f )  step = BM_DIM_STEP*2.1f;
-    if ( step > 20.0f            )  step = 20.0f;
-    nbIter = 200;  // in order not to lower the framerate
-    m_bmIterCounter = 0;
-    return BeamExplore(start, start, goal, goalRadius, 165.0f*Math::PI/180.0f, 22, step, 0, nbIter);
-}
+// Describes the robot for the navigation grid.
 
-// prevPos: previous position
-// curPos:  current position
-// goalPos: position that seeks to achieve
-// angle:   angle to the goal we explores
-// nbDiv:   number of subdivisions being done with angle
-// step     length of a step
-// i        number of recursions made
-// nbIter   maximum number of iterations you have the right to make before temporarily interrupt
-
-Error CTaskGoto::BeamExplore(const Math::Vector &prevPos, const Math::Vector &curPos,
-                             const Math::Vector &goalPos, float goalRadius,
-                             float angle, int nbDiv, float step,
-                             int i, int nbIter)
+void CTaskGoto::BeamAgent()
 {
-    Math::Vector    newPos;
-    Error       ret;
-    int         iDiv, iClear, iLar;
-
-    iLar = 0;
-    if ( i >= MAXPOINTS )  return ERR_GOTO_ITER;  // too many recursions
-
-    if ( m_bmIter[i] == -1 )
-    {
-        m_bmIter[i] = 0;
-
-        if ( i == 0 )
-        {
-            m_bmPoints[i] = curPos;
-        }
-        else
-        {
-            if ( !BitmapTestLine(prevPos, curPos, angle/nbDiv, true) )  return ERR_GOTO_IMPOSSIBLE;
-
-            m_bmPoints[i] = curPos;
-
-            if ( Math::DistanceProjected(curPos, goalPos)-goalRadius <= step )
-            {
-                if ( goalRadius == 0.0f )
-                {
-                    newPos = goalPos;
-                }
-                else
-                {
-                    newPos = BeamPoint(curPos, goalPos, 0, Math::DistanceProjected(curPos, goalPos)-goalRadius);
-                }
-                if ( BitmapTestLine(curPos, newPos, angle/nbDiv, false) )
-                {
-                    m_bmPoints[i+1] = newPos;
-                    m_bmTotal = i+1;
-                    return ERR_OK;
-                }
-            }
-        }
-    }
-
-    if ( iLar >= m_bmIter[i] )
-    {
-        newPos = BeamPoint(curPos, goalPos, 0, step);
-        ret = BeamExplore(curPos, newPos, goalPos, goalRadius, angle, nbDiv, step, i+1, nbIter);
-        if ( ret != ERR_GOTO_IMPOSSIBLE )  return ret;
-        m_bmIter[i] = iLar+1;
-        for ( iClear=i+1 ; iClear<=MAXPOINTS ; iClear++ )  m_bmIter[iClear] = -1;
-        m_bmIterCounter ++;
-        if ( m_bmIterCounter >= nbIter )  return ERR_CONTINUE;
-    }
-    iLar ++;
-
-    for ( iDiv=1 ; iDiv<=nbDiv ; iDiv++ )
-    {
-        if ( iLar >= m_bmIter[i] )
-        {
-            newPos = BeamPoint(curPos, goalPos, angle*iDiv/nbDiv, step);
-            ret = BeamExplore(curPos, newPos, goalPos, goalRadius, angle, nbDiv, step, i+1, nbIter);
-            if ( ret != ERR_GOTO_IMPOSSIBLE )  return ret;
-            m_bmIter[i] = iLar+1;
-            for ( iClear=i+1 ; iClear<=MAXPOINTS ; iClear++ )  m_bmIter[iClear] = -1;
-            m_bmIterCounter ++;
-            if ( m_bmIterCounter >= nbIter )  return ERR_CONTINUE;
-        }
-        iLar ++;
-
-        if ( iLar >= m_bmIter[i] )
-        {
-            newPos = BeamPoint(curPos, goalPos, -angle*iDiv/nbDiv, step);
-            ret = BeamExplore(curPos, newPos, goalPos, goalRadius, angle, nbDiv, step, i+1, nbIter);
-            if ( ret != ERR_GOTO_IMPOSSIBLE )  return ret;
-            m_bmIter[i] = iLar+1;
-            for ( iClear=i+1 ; iClear<=MAXPOINTS ; iClear++ )  m_bmIter[iClear] = -1;
-            m_bmIterCounter ++;
-            if ( m_bmIterCounter >= nbIter )  return ERR_CONTINUE;
-        }
-        iLar ++;
-    }
-
-    return ERR_GOTO_IMPOSSIBLE;
-}
-
-// Is a right "start-goal". Calculates the point located at the distance "step"
-// from the point "start" and an angle "angle" with the right.
-
-Math::Vector CTaskGoto::BeamPoint(const Math::Vector &startPoint,
-                               const Math::Vector &goalPoint,
-                               float angle, float step)
-{
-    Math::Vector    resPoint;
-    float       goalAngle;
-
-    goalAngle = Math::RotateAngle(goalPoint.x-startPoint.x, goalPoint.z-startPoint.z);
-
-    resPoint.x = startPoint.x + cosf(goalAngle+angle)*step;
-    resPoint.z = startPoint.z + sinf(goalAngle+angle)*step;
-    resPoint.y = 0.0f;
-
-    return resPoint;
-}
-
-// Tests if a path along a straight line is possible.
-
-bool CTaskGoto::BitmapTestLine(const Math::Vector &start, const Math::Vector &goal,
-                               float stepAngle, bool bSecond)
-{
-    Math::Vector    pos, inc;
-    float       dist, step;
-    float       distNoB2;
-    int         i, max, x, y;
-
-    if ( m_bmArray == 0 )  return true;
-
-    dist = Math::DistanceProjected(start, goal);
-    if ( dist == 0.0f )  return true;
-    step = BM_DIM_STEP*0.5f;
-
-    inc.x = (goal.x-start.x)*step/dist;
-    inc.z = (goal.z-start.z)*step/dist;
-
-    pos = start;
-
-    if ( bSecond )
-    {
-        x = static_cast<int>((pos.x+1600.0f)/BM_DIM_STEP);
-        y = static_cast<int>((pos.z+1600.0f)/BM_DIM_STEP);
-        BitmapSetDot(1, x, y);  // puts the flag as the starting point
-    }
-
-    max = static_cast<int>(dist/step);
-    if ( max == 0 )  max = 1;
-    distNoB2 = BM_DIM_STEP*sqrtf(2.0f)/sinf(stepAngle);
-    for ( i=0 ; i<max ; i++ )
-    {
-        if ( i == max-1 )
-        {
-            pos = goal;  // tests the point of arrival
-        }
-        else
-        {
-            pos.x += inc.x;
-            pos.z += inc.z;
-        }
-
-        x = static_cast<int>((pos.x+1600.0f)/BM_DIM_STEP);
-        y = static_cast<int>((pos.z+1600.0f)/BM_DIM_STEP);
-
-        if ( bSecond )
-        {
-            if ( i > 2 && BitmapTestDot(1, x, y) )  return false;
-
-            if ( step*(i+1) > distNoB2 && i < max-2 )
-            {
-                BitmapSetDot(1, x, y);
-            }
-        }
-
-        if ( BitmapTestDot(0, x, y) )  return false;
-    }
-    return true;
-}
-
-// Adds the objects in the bitmap.
-
-void CTaskGoto::BitmapObject()
-{
-    CObject     *pObj;
     ObjectType  type;
-    Math::Vector    iPos, oPos;
-    float       iRadius, oRadius, h;
-    int         i, j;
+    Math::Vector    iPos;
+    float       iRadius;
+
+    m_navAgent = Gfx::NavAgent();
+    m_navAgent.object = m_object;
+    m_navAgent.target = m_bmFretObject;
 
     m_object->GetCrashSphere(0, iPos, iRadius);
+    m_navAgent.radius = iRadius;
 
-    for ( i=0 ; i<1000000 ; i++ )
+    if ( m_physics->GetType() == TYPE_FLYING && m_altitude > 0.0f )
     {
-        pObj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if ( pObj == 0 )  break;
-
-        type = pObj->GetType();
-
-        if ( pObj == m_object )  continue;
-        if ( pObj == m_bmFretObject )  continue;
-        if ( pObj->GetTruck() != 0 )  continue;
-
-        h = m_terrain->GetFloorLevel(pObj->GetPosition(0), false);
-        if ( m_physics->GetType() == TYPE_FLYING && m_altitude > 0.0f )
-        {
-            h += m_altitude;
-        }
-
-        j = 0;
-        while ( pObj->GetCrashSphere(j++, oPos, oRadius) )
-        {
-            if ( m_physics->GetType() == TYPE_FLYING && m_altitude > 0.0f )  // flying?
-            {
-                if ( oPos.y-oRadius > h+8.0f ||
-                     oPos.y+oRadius < h-8.0f )  continue;
-            }
-            else    // crawling?
-            {
-                if ( oPos.y-oRadius > h+8.0f )  continue;
-            }
-
-            if ( type == OBJECT_PARA )  oRadius -= 2.0f;
-            BitmapSetCircle(oPos, oRadius+iRadius+4.0f);
-        }
+        m_navAgent.altitude = m_altitude;
     }
-}
-
-// Adds a section of land in the bitmap.
-
-void CTaskGoto::BitmapTerrain(const Math::Vector &min, const Math::Vector &max)
-{
-    int     minx, miny, maxx, maxy;
-
-    minx = static_cast<int>((min.x+1600.0f)/BM_DIM_STEP);
-    miny = static_cast<int>((min.z+1600.0f)/BM_DIM_STEP);
-    maxx = static_cast<int>((max.x+1600.0f)/BM_DIM_STEP);
-    maxy = static_cast<int>((max.z+1600.0f)/BM_DIM_STEP);
-
-    BitmapTerrain(minx, miny, maxx, maxy);
-}
-
-// Adds a section of land in the bitmap.
 
-void CTaskGoto::BitmapTerrain(int minx, int miny, int maxx, int maxy)
-{
-    ObjectType  type;
-    Math::Vector    p;
-    float       aLimit, angle, h;
-    int         x, y;
-    bool        bAcceptWater, bFly;
-
-    if ( minx > maxx )  Math::Swap(minx, maxx);
-    if ( miny > maxy )  Math::Swap(miny, maxy);
-
-    if ( minx < 0          )  minx = 0;
-    if ( miny < 0          )  miny = 0;
-    if ( maxx > m_bmSize-1 )  maxx = m_bmSize-1;
-    if ( maxy > m_bmSize-1 )  maxy = m_bmSize-1;
-
-    if ( minx > m_bmMinX )  minx = m_bmMinX;
-    if ( miny > m_bmMinY )  miny = m_bmMinY;
-    if ( maxx < m_bmMaxX )  maxx = m_bmMaxX;
-    if ( maxy < m_bmMaxY )  maxy = m_bmMaxY;
-
-    if ( minx >= m_bmMinX && maxx <= m_bmMaxX &&
-         miny >= m_bmMinY && maxy <= m_bmMaxY )  return;
-
-    aLimit = 20.0f*Math::PI/180.0f;
-    bAcceptWater = false;
-    bFly = false;
+    m_navAgent.slopeLimit = 20.0f*Math::PI/180.0f;
 
     type = m_object->GetType();
 
@@ -2017,7 +1728,7 @@ void CTaskGoto::BitmapTerrain(int minx, int miny, int maxx, int maxy)
          type == OBJECT_MOBILEwt ||
          type == OBJECT_MOBILEtg )  // wheels?
     {
-        aLimit = 20.0f*Math::PI/180.0f;
+        m_navAgent.slopeLimit = 20.0f*Math::PI/180.0f;
     }
 
     if ( type == OBJECT_MOBILEta ||
@@ -2025,7 +1736,7 @@ void CTaskGoto::BitmapTerrain(int minx, int miny, int maxx, int maxy)
          type == OBJECT_MOBILEti ||
          type == OBJECT_MOBILEts )  // caterpillars?
     {
-        aLimit = 35.0f*Math::PI/180.0f;
+        m_navAgent.slopeLimit = 35.0f*Math::PI/180.0f;
     }
 
     if ( type == OBJECT_MOBILErt ||
@@ -2033,18 +1744,18 @@ void CTaskGoto::BitmapTerrain(int minx, int miny, int maxx, int maxy)
          type == OBJECT_MOBILErr ||
          type == OBJECT_MOBILErs )  // large caterpillars?
     {
-        aLimit = 35.0f*Math::PI/180.0f;
+        m_navAgent.slopeLimit = 35.0f*Math::PI/180.0f;
     }
 
     if ( type == OBJECT_MOBILEsa )  // submarine caterpillars?
     {
-        aLimit = 35.0f*Math::PI/180.0f;
-        bAcceptWater = true;
+        m_navAgent.slopeLimit = 35.0f*Math::PI/180.0f;
+        m_navAgent.acceptWater = true;
     }
 
     if ( type == OBJECT_MOBILEdr )  // designer caterpillars?
     {
-        aLimit = 35.0f*Math::PI/180.0f;
+        m_navAgent.slopeLimit = 35.0f*Math::PI/180.0f;
     }
 
     if ( type == OBJECT_MOBILEfa ||
@@ -2053,8 +1764,8 @@ void CTaskGoto::BitmapTerrain(int minx, int miny, int maxx, int maxy)
          type == OBJECT_MOBILEfi ||
          type == OBJECT_MOBILEft )  // flying?
     {
-        aLimit = 15.0f*Math::PI/180.0f;
-        bFly = true;
+        m_navAgent.slopeLimit = 15.0f*Math::PI/180.0f;
+        m_navAgent.fly = true;
     }
 
     if ( type == OBJECT_MOBILEia ||
@@ -2062,167 +1773,40 @@ void CTaskGoto::BitmapTerrain(int minx, int miny, int maxx, int maxy)
          type == OBJECT_MOBILEis ||
          type == OBJECT_MOBILEii )  // insect legs?
     {
-        aLimit = 60.0f*Math::PI/180.0f;
+        m_navAgent.slopeLimit = 60.0f*Math::PI/180.0f;
     }
-
-    for ( y=miny ; y<=maxy ; y++ )
-    {
-        for ( x=minx ; x<=maxx ; x++ )
-        {
-            if ( x >= m_bmMinX && x <= m_bmMaxX &&
-                 y >= m_bmMinY && y <= m_bmMaxY )  continue;
-
-            p.x = x*BM_DIM_STEP-1600.0f;
-            p.z = y*BM_DIM_STEP-1600.0f;
-
-            if ( bFly )  // flying robot?
-            {
-                h = m_terrain->GetFloorLevel(p, true);
-                if ( h >= m_terrain->GetFlyingMaxHeight()-5.0f )
-                {
-                    BitmapSetDot(0, x, y);
-                }
-                continue;
-            }
-
-            if ( !bAcceptWater )  // not going underwater?
-            {
-                h = m_terrain->GetFloorLevel(p, true);
-                if ( h < m_water->GetLevel()-2.0f )  // under water (*)?
-                {
-//?                 BitmapSetDot(0, x, y);
-                    BitmapSetCircle(p, BM_DIM_STEP*1.0f);
-                    continue;
-                }
-            }
-
-            angle = m_terrain->GetFineSlope(p);
-            if ( angle > aLimit )
-            {
-                BitmapSetDot(0, x, y);
-            }
-        }
-    }
-
-    m_bmMinX = minx;
-    m_bmMinY = miny;
-    m_bmMaxX = maxx;
-    m_bmMaxY = maxy;  // expanded rectangular area
 }
 
-// (*)  Accepts that a robot is 50cm under water, for example Tropica 3!
-
-// Opens an empty bitmap.
-
-bool CTaskGoto::BitmapOpen()
-{
-    BitmapClose();
-
-    m_bmSize = static_cast<int>(3200.0f/BM_DIM_STEP);
-    m_bmArray = new unsigned char[m_bmSize*m_bmSize/8*2];
-    memset(m_bmArray, 0, m_bmSize*m_bmSize/8*2);
-
-    m_bmOffset = m_bmSize/2;
-    m_bmLine = m_bmSize/8;
-
-    m_bmMinX = m_bmSize;  // non-existent rectangular area
-    m_bmMinY = m_bmSize;
-    m_bmMaxX = 0;
-    m_bmMaxY = 0;
-
-    return true;
-}
-
-// Closes the bitmap.
-
-bool CTaskGoto::BitmapClose()
-{
-    delete[] m_bmArray;
-    m_bmArray = 0;
-    return true;
-}
-
-// Puts a circle in the bitmap.
-
-void CTaskGoto::BitmapSetCircle(const Math::Vector &pos, float radius)
-{
-    float   d, r;
-    int     cx, cy, ix, iy;
-
-    cx = static_cast<int>((pos.x+1600.0f)/BM_DIM_STEP);
-    cy = static_cast<int>((pos.z+1600.0f)/BM_DIM_STEP);
-    r = radius/BM_DIM_STEP;
-
-    for ( iy=cy-static_cast<int>(r) ; iy<=cy+static_cast<int>(r) ; iy++ )
-    {
-        for ( ix=cx-static_cast<int>(r) ; ix<=cx+static_cast<int>(r) ; ix++ )
-        {
-            d = Math::Point(static_cast<float>(ix-cx), static_cast<float>(iy-cy)).Length();
-            if ( d > r )  continue;
-            BitmapSetDot(0, ix, iy);
-        }
-    }
-}
+// Calculates points and passes to go from start to goal.
+// Returns:
+// ERR_OK if it's good
+// ERR_GOTO_IMPOSSIBLE if impossible
+// ERR_GOTO_ITER if the path has too many points
+// ERR_CONTINUE if not done yet
+// goalRadius: distance at which we must approach the goal
 
-// Removes a circle in the bitmap.
-//TODO this method is almost same as above one
-void CTaskGoto::BitmapClearCircle(const Math::Vector &pos, float radius)
+Error CTaskGoto::BeamSearch(const Math::Vector &start, const Math::Vector &goal,
+                            float goalRadius)
 {
-    float   d, r;
-    int     cx, cy, ix, iy;
+    Error       ret;
+    int         i;
 
-    cx = static_cast<int>((pos.x+1600.0f)/BM_DIM_STEP);
-    cy = static_cast<int>((pos.z+1600.0f)/BM_DIM_STEP);
-    r = radius/BM_DIM_STEP;
+    m_bmStep ++;
 
-    for ( iy=cy-static_cast<int>(r) ; iy<=cy+static_cast<int>(r) ; iy++ )
+    if ( m_bmStep == 1 )
     {
-        for ( ix=cx-static_cast<int>(r) ; ix<=cx+static_cast<int>(r) ; ix++ )
-        {
-            d = Math::Point(static_cast<float>(ix-cx), static_cast<float>(iy-cy)).Length();
-            if ( d > r )  continue;
-            BitmapClearDot(0, ix, iy);
-        }
+        m_navSearch.Start(m_navGrid, m_navAgent, start, goal, goalRadius);
     }
-}
-
-// Makes a point in the bitmap.
-// x:y: 0..m_bmSize-1
-
-void CTaskGoto::BitmapSetDot(int rank, int x, int y)
-{
-    if ( x < 0 || x >= m_bmSize ||
-         y < 0 || y >= m_bmSize )  return;
-
-    m_bmArray[rank*m_bmLine*m_bmSize + m_bmLine*y + x/8] |= (1<<x%8);
-}
-
-// Removes a point in the bitmap.
-// x:y: 0..m_bmSize-1
 
-void CTaskGoto::BitmapClearDot(int rank, int x, int y)
-{
-    if ( x < 0 || x >= m_bmSize ||
-         y < 0 || y >= m_bmSize )  return;
-
-    m_bmArray[rank*m_bmLine*m_bmSize + m_bmLine*y + x/8] &= ~(1<<x%8);
-}
+    ret = m_navSearch.Step(BM_SEARCH_CELLS, MAXPOINTS);  // in order not to lower the framerate
+    if ( ret != ERR_OK )  return ret;
 
-// Tests a point in the bitmap.
-// x:y: 0..m_bmSize-1
-
-bool CTaskGoto::BitmapTestDot(int rank, int x, int y)
-{
-    if ( x < 0 || x >= m_bmSize ||
-         y < 0 || y >= m_bmSize )  return false;
-
-    if ( x < m_bmMinX || x > m_bmMaxX ||
-         y < m_bmMinY || y > m_bmMaxY )
+    const std::vector<Math::Vector>& path = m_navSearch.GetPath();
+    for ( i=0 ; i<static_cast<int>( path.size() ) ; i++ )
     {
-        BitmapTerrain(x-10,y-10, x+10,y+10);  // remade a layer
+        m_bmPoints[i] = path[i];
     }
-
-    return m_bmArray[rank*m_bmLine*m_bmSize + m_bmLine*y + x/8] & (1<<x%8);
+    m_bmTotal = static_cast<int>( path.size() )-1;
+    return ERR_OK;
 }
 
-
@@ -20,6 +20,7 @@
 
 
 #include "object/task/task.h"
+#include "graphics/engine/navgrid.h"
 #include "math/vector.h"
 
 
@@ -94,22 +95,8 @@ protected:
     int         BeamShortcut();
     void        BeamStart();
     void        BeamInit();
+    void        BeamAgent();
     Error       BeamSearch(const Math::Vector &start, const Math::Vector &goal, float goalRadius);
-    Error       BeamExplore(const Math::Vector &prevPos, const Math::Vector &curPos, const Math::Vector &goalPos, float goalRadius, float angle, int nbDiv, float step, int i, int nbIter);
-    Math::Vector    BeamPoint(const Math::Vector &startPoint, const Math::Vector &goalPoint, float angle, float step);
-
-    void        BitmapDebug(const Math::Vector &min, const Math::Vector &max, const Math::Vector &start, const Math::Vector &goal);
-    bool        BitmapTestLine(const Math::Vector &start, const Math::Vector &goal, float stepAngle, bool bSecond);
-    void        BitmapObject();
-    void        BitmapTerrain(const Math::Vector &min, const Math::Vector &max);
-    void        BitmapTerrain(int minx, int miny, int maxx, int maxy);
-    bool        BitmapOpen();
-    bool        BitmapClose();
-    void        BitmapSetCircle(const Math::Vector &pos, float radius);
-    void        BitmapClearCircle(const Math::Vector &pos, float radius);
-    void        BitmapSetDot(int rank, int x, int y);
-    void        BitmapClearDot(int rank, int x, int y);
-    bool        BitmapTestDot(int rank, int x, int y);
 
 protected:
     Math::Vector        m_goal;
@@ -130,17 +117,12 @@ protected:
     float           m_wormLastTime;
     float           m_lastDistance;
 
-    int             m_bmSize;       // width or height of the table
-    int             m_bmOffset;     // m_bmSize/2
-    int             m_bmLine;       // increment line m_bmSize/8
-    unsigned char*          m_bmArray;      // bit table
-    int             m_bmMinX, m_bmMinY;
-    int             m_bmMaxX, m_bmMaxY;
+    Gfx::CNavGrid*  m_navGrid;      // shared grid of the terrain
+    Gfx::NavAgent   m_navAgent;     // how this robot reads the grid
+    Gfx::CNavSearch m_navSearch;    // path search in progress
     int             m_bmTotal;      // number of points in m_bmPoints
     int             m_bmIndex;      // index in m_bmPoints
     Math::Vector        m_bmPoints[MAXPOINTS+2];
-    char            m_bmIter[MAXPOINTS+2];
-    int             m_bmIterCounter;
     CObject*        m_bmFretObject;
     float           m_bmFinalMove;  // final advance distance
     float           m_bmFinalDist;  // effective distance to advance
@@ -22,6 +22,7 @@
 #include "graphics/engine/terrain.h"
 #include "graphics/engine/pyro.h"
 #include "math/geometry.h"
+#include "object/objectgrid.h"
 #include "object/robotmain.h"
 #include "physics/physics.h"
 
@@ -730,10 +731,13 @@ CObject* CTaskManip::SearchTakeUnderObject(Math::Vector &pos, float dLimit)
 
     min = 1000000.0f;
     pBest = 0;
-    for ( i=0 ; i<1000000 ; i++ )
+
+    std::vector<CObject*> objects;
+    CObjectGrid::GetInstancePointer()->FindInRadius(objects, iPos, dLimit);
+
+    for ( i=0 ; i<static_cast<int>( objects.size() ) ; i++ )
     {
-        pObj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if ( pObj == 0 )  break;
+        pObj = objects[i];
 
         type = pObj->GetType();
 
@@ -801,10 +805,13 @@ CObject* CTaskManip::SearchTakeFrontObject(bool bAdvance, Math::Vector &pos,
     min = 1000000.0f;
     pBest = 0;
     bAngle = 0.0f;
-    for ( i=0 ; i<1000000 ; i++ )
+
+    std::vector<CObject*> objects;
+    CObjectGrid::GetInstancePointer()->FindInRadius(objects, iPos, TAKE_DIST+dLimit);
+
+    for ( i=0 ; i<static_cast<int>( objects.size() ) ; i++ )
     {
-        pObj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if ( pObj == 0 )  break;
+        pObj = objects[i];
 
         type = pObj->GetType();
 
@@ -892,10 +899,13 @@ CObject* CTaskManip::SearchTakeBackObject(bool bAdvance, Math::Vector &pos,
     min = 1000000.0f;
     pBest = 0;
     bAngle = 0.0f;
-    for ( i=0 ; i<1000000 ; i++ )
+
+    std::vector<CObject*> objects;
+    CObjectGrid::GetInstancePointer()->FindInRadius(objects, iPos, TAKE_DIST+dLimit);
+
+    for ( i=0 ; i<static_cast<int>( objects.size() ) ; i++ )
     {
-        pObj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if ( pObj == 0 )  break;
+        pObj = objects[i];
 
         type = pObj->GetType();
 
@@ -23,6 +23,7 @@
 #include "graphics/engine/water.h"
 #include "math/geometry.h"
 #include "object/motion/motionhuman.h"
+#include "object/objectgrid.h"
 #include "object/robotmain.h"
 #include "physics/physics.h"
 
@@ -308,10 +309,13 @@ CObject* CTaskTake::SearchTakeObject(float &angle,
     min = 1000000.0f;
     pBest = 0;
     bAngle = 0.0f;
-    for ( i=0 ; i<1000000 ; i++ )
+
+    std::vector<CObject*> objects;
+    CObjectGrid::GetInstancePointer()->FindInRadius(objects, iPos, 4.0f+dLimit);
+
+    for ( i=0 ; i<static_cast<int>( objects.size() ) ; i++ )
     {
-        pObj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if ( pObj == 0 )  break;
+        pObj = objects[i];
 
         type = pObj->GetType();
 
@@ -569,10 +573,12 @@ bool CTaskTake::IsFreeDeposeObject(Math::Vector pos)
     mat = m_object->GetWorldMatrix(0);
     iPos = Transform(*mat, pos);
 
-    for ( i=0 ; i<1000000 ; i++ )
+    std::vector<CObject*> objects;
+    CObjectGrid::GetInstancePointer()->FindCrashCandidates(objects, iPos, 2.0f);
+
+    for ( i=0 ; i<static_cast<int>( objects.size() ) ; i++ )
     {
-        pObj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if ( pObj == 0 )  break;
+        pObj = objects[i];
 
         if ( pObj == m_object )  continue;
         if ( !pObj->GetActif() )  continue;  // inactive?
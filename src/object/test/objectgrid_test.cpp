@@ -0,0 +1,225 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+// object/test/objectgrid_test.cpp
+
+/*
+  Unit tests for the queries of CObjectGrid, compared with a linear scan of all objects
+ */
+
+#include "math/geometry.h"
+#include "object/object.h"
+#include "object/objectgrid.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+
+const int OBJECT_COUNT = 500;
+const int QUERY_COUNT = 200;
+
+// Random value in [min, max]
+float Random(float min, float max)
+{
+    return min + (max - min) * static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+}
+
+// Random position, some of them outside the grid
+Math::Vector RandomPosition()
+{
+    float size = OBJECT_GRID_CELL_SIZE*OBJECT_GRID_SIZE/2.0f + 100.0f;
+    return Math::Vector(Random(-size, size), Random(-10.0f, 10.0f), Random(-size, size));
+}
+
+class ObjectGridTest : public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        srand(1234);
+
+        m_grid = new CObjectGrid();
+
+        ObjectType types[3] = { OBJECT_STONE, OBJECT_URANIUM, OBJECT_MOBILEwa };
+        for (int i = 0; i < OBJECT_COUNT; i++)
+        {
+            CObject* object = new CObject(nullptr);
+            object->SetType(types[i % 3]);
+            object->SetPosition(0, RandomPosition());
+            m_objects.push_back(object);
+            m_grid->AddObject(object);
+        }
+    }
+
+    virtual void TearDown()
+    {
+        delete m_grid;
+        for (int i = 0; i < static_cast<int>( m_objects.size() ); i++)
+            delete m_objects[i];
+        m_objects.clear();
+    }
+
+    // Moves some objects and deletes some others, as the game does
+    void Shuffle()
+    {
+        for (int i = 0; i < static_cast<int>( m_objects.size() ); i++)
+        {
+            if (i % 4 == 0)
+            {
+                m_objects[i]->SetPosition(0, m_objects[i]->GetPosition(0) + Math::Vector(Random(-50.0f, 50.0f), 0.0f, Random(-50.0f, 50.0f)));
+                m_grid->UpdatePosition(m_objects[i]);
+            }
+        }
+
+        for (int i = static_cast<int>( m_objects.size() ) - 1; i >= 0; i -= 7)
+        {
+            m_grid->DeleteObject(m_objects[i]);
+            delete m_objects[i];
+            m_objects.erase(m_objects.begin() + i);
+        }
+    }
+
+    static std::vector<CObject*> Sorted(std::vector<CObject*> list)
+    {
+        std::sort(list.begin(), list.end());
+        return list;
+    }
+
+    std::vector<CObject*> LinearInRadius(const Math::Vector &center, float radius)
+    {
+        std::vector<CObject*> result;
+        for (int i = 0; i < static_cast<int>( m_objects.size() ); i++)
+        {
+            if (Math::DistanceProjected(m_objects[i]->GetPosition(0), center) <= radius)
+                result.push_back(m_objects[i]);
+        }
+        return result;
+    }
+
+    std::vector<CObject*> LinearInBox(const Math::Vector &min, const Math::Vector &max)
+    {
+        std::vector<CObject*> result;
+        for (int i = 0; i < static_cast<int>( m_objects.size() ); i++)
+        {
+            Math::Vector pos = m_objects[i]->GetPosition(0);
+            if (pos.x >= min.x && pos.x <= max.x && pos.z >= min.z && pos.z <= max.z)
+                result.push_back(m_objects[i]);
+        }
+        return result;
+    }
+
+    // Distances of the nearest objects, which are the same whatever the order of equal ones
+    std::vector<float> LinearNearest(const Math::Vector &center, int count, float maxRadius)
+    {
+        std::vector<float> dist;
+        for (int i = 0; i < static_cast<int>( m_objects.size() ); i++)
+        {
+            float d = Math::DistanceProjected(m_objects[i]->GetPosition(0), center);
+            if (d <= maxRadius)
+                dist.push_back(d);
+        }
+        std::sort(dist.begin(), dist.end());
+        if (static_cast<int>( dist.size() ) > count)
+            dist.resize(count);
+        return dist;
+    }
+
+    std::vector<float> Distances(const std::vector<CObject*> &list, const Math::Vector &center)
+    {
+        std::vector<float> dist;
+        for (int i = 0; i < static_cast<int>( list.size() ); i++)
+            dist.push_back(Math::DistanceProjected(list[i]->GetPosition(0), center));
+        return dist;
+    }
+
+    void CheckQueries()
+    {
+        std::vector<CObject*> result;
+        for (int q = 0; q < QUERY_COUNT; q++)
+        {
+            Math::Vector center = RandomPosition();
+            float radius = Random(0.0f, 400.0f);
+
+            m_grid->FindInRadius(result, center, radius);
+            EXPECT_EQ(Sorted(LinearInRadius(center, radius)), Sorted(result));
+
+            Math::Vector corner = RandomPosition();
+            Math::Vector min(Math::Min(center.x, corner.x), 0.0f, Math::Min(center.z, corner.z));
+            Math::Vector max(Math::Max(center.x, corner.x), 0.0f, Math::Max(center.z, corner.z));
+            m_grid->FindInBox(result, min, max);
+            EXPECT_EQ(Sorted(LinearInBox(min, max)), Sorted(result));
+
+            int count = 1 + q % 40;
+            m_grid->FindNearest(result, center, count);
+            EXPECT_EQ(LinearNearest(center, count, OBJECT_GRID_MAX_RADIUS), Distances(result, center));
+
+            m_grid->FindNearest(result, center, count, radius);
+            EXPECT_EQ(LinearNearest(center, count, radius), Distances(result, center));
+        }
+    }
+
+    CObjectGrid* m_grid;
+    std::vector<CObject*> m_objects;
+};
+
+
+TEST_F(ObjectGridTest, QueriesMatchLinearScan)
+{
+    CheckQueries();
+}
+
+TEST_F(ObjectGridTest, QueriesMatchLinearScanAfterChanges)
+{
+    Shuffle();
+    CheckQueries();
+}
+
+TEST_F(ObjectGridTest, NearestIncludesAllObjects)
+{
+    std::vector<CObject*> result;
+    m_grid->FindNearest(result, Math::Vector(0.0f, 0.0f, 0.0f), OBJECT_COUNT*2);
+    EXPECT_EQ(Sorted(m_objects), Sorted(result));
+}
+
+TEST_F(ObjectGridTest, ObjectsOfTypeMatchLinearScan)
+{
+    Shuffle();
+
+    m_objects[0]->SetType(OBJECT_TNT);
+    m_grid->UpdateType(m_objects[0], OBJECT_STONE);
+
+    ObjectType types[4] = { OBJECT_STONE, OBJECT_URANIUM, OBJECT_MOBILEwa, OBJECT_TNT };
+    for (int t = 0; t < 4; t++)
+    {
+        std::vector<CObject*> linear;
+        for (int i = 0; i < static_cast<int>( m_objects.size() ); i++)
+        {
+            if (m_objects[i]->GetType() == types[t])
+                linear.push_back(m_objects[i]);
+        }
+        EXPECT_EQ(Sorted(linear), Sorted(m_grid->GetObjectsOfType(types[t])));
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,303 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+// object/test/snapshot_test.cpp
+
+/*
+  Unit tests for the binary blocks of saved games: round trip through
+  CSnapshotWriter and CSnapshotReader, and detection of damaged blocks
+ */
+
+#include "object/snapshot.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <vector>
+
+
+// Flushes the writer to a temporary file, keeping only the first \a keep bytes if given
+FILE* FlushToFile(CSnapshotWriter &writer, int keep = -1)
+{
+    FILE* full = tmpfile();
+    EXPECT_TRUE(writer.Flush(full));
+
+    std::vector<char> data(ftell(full));
+    rewind(full);
+    if (!data.empty())
+    {
+        EXPECT_EQ(data.size(), fread(&data[0], 1, data.size(), full));
+    }
+    fclose(full);
+
+    if (keep >= 0 && keep < static_cast<int>( data.size() ))
+        data.resize(keep);
+
+    FILE* file = tmpfile();
+    if (!data.empty())
+        fwrite(&data[0], 1, data.size(), file);
+    rewind(file);
+    return file;
+}
+
+// Changes the size of the block at the beginning of the file, as if it was cut at \a size
+FILE* CutBlock(CSnapshotWriter &writer, int size)
+{
+    FILE* file = FlushToFile(writer, sizeof(int) + size);
+    fwrite(&size, sizeof(int), 1, file);
+    rewind(file);
+    return file;
+}
+
+SnapshotObject MakeObject(int kind, int type)
+{
+    SnapshotObject object;
+    object.kind    = kind;
+    object.type    = type;
+    object.id      = 42;
+    object.trainer = 1;
+    object.option  = 2;
+    object.run     = 3;
+    object.select  = true;
+    object.pos     = Math::Vector(1.0f, 2.0f, 3.0f);
+    object.angle   = Math::Vector(0.0f, 1.5f, 0.0f);
+    object.zoom    = Math::Vector(1.0f, 1.0f, 1.0f);
+
+    SnapshotPart part;
+    part.rank  = 2;
+    part.pos   = Math::Vector(0.5f, 0.0f, -0.5f);
+    part.angle = Math::Vector(0.1f, 0.2f, 0.3f);
+    part.zoom  = Math::Vector(2.0f, 2.0f, 2.0f);
+    object.parts.push_back(part);
+
+    object.line = " energy=0.50 shield=1.00";
+    return object;
+}
+
+void WriteScene(CSnapshotWriter &writer)
+{
+    writer.WriteFloat(1.25f);
+    writer.WriteInt(7);
+    writer.WriteVector(Math::Vector(4.0f, 5.0f, 6.0f));
+    writer.WriteObject(MakeObject(SNAPSHOT_POWER, 10));
+    writer.WriteObject(MakeObject(SNAPSHOT_OBJECT, 20));
+    writer.WriteInt(SNAPSHOT_END);
+}
+
+void ExpectVector(const Math::Vector &expected, const Math::Vector &actual)
+{
+    EXPECT_FLOAT_EQ(expected.x, actual.x);
+    EXPECT_FLOAT_EQ(expected.y, actual.y);
+    EXPECT_FLOAT_EQ(expected.z, actual.z);
+}
+
+void ExpectObject(const SnapshotObject &expected, const SnapshotObject &actual)
+{
+    EXPECT_EQ(expected.kind, actual.kind);
+    EXPECT_EQ(expected.type, actual.type);
+    EXPECT_EQ(expected.id, actual.id);
+    EXPECT_EQ(expected.trainer, actual.trainer);
+    EXPECT_EQ(expected.option, actual.option);
+    EXPECT_EQ(expected.run, actual.run);
+    EXPECT_EQ(expected.select, actual.select);
+    ExpectVector(expected.pos, actual.pos);
+    ExpectVector(expected.angle, actual.angle);
+    ExpectVector(expected.zoom, actual.zoom);
+
+    ASSERT_EQ(expected.parts.size(), actual.parts.size());
+    for (int i = 0; i < static_cast<int>( expected.parts.size() ); i++)
+    {
+        EXPECT_EQ(expected.parts[i].rank, actual.parts[i].rank);
+        ExpectVector(expected.parts[i].pos, actual.parts[i].pos);
+        ExpectVector(expected.parts[i].angle, actual.parts[i].angle);
+        ExpectVector(expected.parts[i].zoom, actual.parts[i].zoom);
+    }
+
+    EXPECT_EQ(expected.line, actual.line);
+}
+
+
+TEST(SnapshotTest, RoundTrip)
+{
+    CSnapshotWriter writer;
+    WriteScene(writer);
+    FILE* file = FlushToFile(writer);
+
+    CSnapshotReader reader;
+    ASSERT_TRUE(reader.Load(file));
+    fclose(file);
+
+    EXPECT_FLOAT_EQ(1.25f, reader.ReadFloat());
+    EXPECT_EQ(7, reader.ReadInt());
+    ExpectVector(Math::Vector(4.0f, 5.0f, 6.0f), reader.ReadVector());
+
+    std::vector<SnapshotObject> objects;
+    ASSERT_TRUE(reader.ReadObjects(objects));
+    ASSERT_EQ(2u, objects.size());
+    ExpectObject(MakeObject(SNAPSHOT_POWER, 10), objects[0]);
+    ExpectObject(MakeObject(SNAPSHOT_OBJECT, 20), objects[1]);
+    EXPECT_FALSE(reader.IsError());
+
+    // Nothing follows the block
+    reader.ReadInt();
+    EXPECT_TRUE(reader.IsError());
+}
+
+TEST(SnapshotTest, RoundTripString)
+{
+    CSnapshotWriter writer;
+    writer.WriteString("CreateObject type=Me");
+    writer.WriteString("");
+    FILE* file = FlushToFile(writer);
+
+    CSnapshotReader reader;
+    ASSERT_TRUE(reader.Load(file));
+    fclose(file);
+
+    char text[100];
+    reader.ReadString(text, 100);
+    EXPECT_STREQ("CreateObject type=Me", text);
+    reader.ReadString(text, 100);
+    EXPECT_STREQ("", text);
+    EXPECT_FALSE(reader.IsError());
+}
+
+TEST(SnapshotTest, StringTooLong)
+{
+    CSnapshotWriter writer;
+    writer.WriteString("0123456789");
+    FILE* file = FlushToFile(writer);
+
+    CSnapshotReader reader;
+    ASSERT_TRUE(reader.Load(file));
+    fclose(file);
+
+    char text[10];
+    reader.ReadString(text, 10);
+    EXPECT_TRUE(reader.IsError());
+    EXPECT_STREQ("", text);
+}
+
+TEST(SnapshotTest, TruncatedFile)
+{
+    CSnapshotWriter writer;
+    WriteScene(writer);
+    FILE* file = FlushToFile(writer, 50);
+
+    CSnapshotReader reader;
+    EXPECT_FALSE(reader.Load(file));
+    EXPECT_TRUE(reader.IsError());
+    fclose(file);
+
+    // Reading after a failed load gives zero values
+    EXPECT_EQ(0, reader.ReadInt());
+}
+
+TEST(SnapshotTest, EmptyFile)
+{
+    CSnapshotWriter writer;
+    FILE* file = FlushToFile(writer, 0);
+
+    CSnapshotReader reader;
+    EXPECT_FALSE(reader.Load(file));
+    fclose(file);
+}
+
+TEST(SnapshotTest, TruncatedBlock)
+{
+    CSnapshotWriter full;
+    WriteScene(full);
+    FILE* file = FlushToFile(full);
+    fseek(file, 0, SEEK_END);
+    int size = ftell(file) - sizeof(int);
+    fclose(file);
+
+    // Every cut inside the objects must be detected
+    for (int cut = 3*sizeof(float) + sizeof(int) + 1; cut < size; cut += 3)
+    {
+        CSnapshotWriter writer;
+        WriteScene(writer);
+        file = CutBlock(writer, cut);
+
+        CSnapshotReader reader;
+        ASSERT_TRUE(reader.Load(file));
+        fclose(file);
+
+        reader.ReadFloat();
+        reader.ReadInt();
+        reader.ReadVector();
+
+        std::vector<SnapshotObject> objects;
+        EXPECT_FALSE(reader.ReadObjects(objects)) << "cut at " << cut;
+        EXPECT_TRUE(reader.IsError());
+    }
+}
+
+TEST(SnapshotTest, BadRecordKind)
+{
+    CSnapshotWriter writer;
+    writer.WriteObject(MakeObject(SNAPSHOT_OBJECT, 20));
+    writer.WriteObject(MakeObject(7, 20));
+    writer.WriteInt(SNAPSHOT_END);
+    FILE* file = FlushToFile(writer);
+
+    CSnapshotReader reader;
+    ASSERT_TRUE(reader.Load(file));
+    fclose(file);
+
+    std::vector<SnapshotObject> objects;
+    EXPECT_FALSE(reader.ReadObjects(objects));
+    EXPECT_TRUE(reader.IsError());
+}
+
+TEST(SnapshotTest, BadPartRank)
+{
+    SnapshotObject object = MakeObject(SNAPSHOT_OBJECT, 20);
+    object.parts[0].rank = -3;
+
+    CSnapshotWriter writer;
+    writer.WriteObject(object);
+    writer.WriteInt(SNAPSHOT_END);
+    FILE* file = FlushToFile(writer);
+
+    CSnapshotReader reader;
+    ASSERT_TRUE(reader.Load(file));
+    fclose(file);
+
+    std::vector<SnapshotObject> objects;
+    EXPECT_FALSE(reader.ReadObjects(objects));
+}
+
+TEST(SnapshotTest, MissingEnd)
+{
+    CSnapshotWriter writer;
+    writer.WriteObject(MakeObject(SNAPSHOT_OBJECT, 20));
+    FILE* file = FlushToFile(writer);
+
+    CSnapshotReader reader;
+    ASSERT_TRUE(reader.Load(file));
+    fclose(file);
+
+    std::vector<SnapshotObject> objects;
+    EXPECT_FALSE(reader.ReadObjects(objects));
+}
+
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,34 @@
+#include "object/object.h"
+
+// Only the position and type of the object
+
+CObject::CObject(CInstanceManager* iMan)
+{
+    m_iMan = iMan;
+    m_type = OBJECT_NULL;
+    m_objectPart[0].position = Math::Vector(0.0f, 0.0f, 0.0f);
+}
+
+CObject::~CObject()
+{
+}
+
+void CObject::SetType(ObjectType type)
+{
+    m_type = type;
+}
+
+ObjectType CObject::GetType()
+{
+    return m_type;
+}
+
+void CObject::SetPosition(int part, const Math::Vector &pos)
+{
+    m_objectPart[part].position = pos;
+}
+
+Math::Vector CObject::GetPosition(int part)
+{
+    return m_objectPart[part].position;
+}
@@ -17,6 +17,8 @@
 
 #include "physics/physics.h"
 
+#include "app/profiler.h"
+
 #include "common/event.h"
 #include "common/global.h"
 #include "common/iman.h"
@@ -33,12 +35,14 @@
 #include "object/brain.h"
 #include "object/motion/motion.h"
 #include "object/motion/motionhuman.h"
+#include "object/objectgrid.h"
 #include "object/task/task.h"
 
 #include "script/cmdtoken.h"
 
 #include <cstring>
 #include <cstdio>
+#include <vector>
 
 
 
@@ -1471,6 +1475,8 @@ bool CPhysics::EventFrame(const Event &event)
 
     if ( m_engine->GetPause() )  return true;
 
+    CProfilerScope scope(PROF_PHYSICS);
+
     m_time += event.rTime;
     m_timeUnderWater += event.rTime;
     m_soundTimeJostle += event.rTime;
@@ -2510,10 +2516,14 @@ int CPhysics::ObjectAdapt(const Math::Vector &pos, const Math::Vector &angle)
     iPos = iiPos + (pos - m_object->GetPosition(0));
     iType = m_object->GetType();
 
-    for ( i=0 ; i<1000000 ; i++ )
+    // Only objects near enough to be touched (waypoints are checked up to 15m)
+    CObjectGrid* grid = CObjectGrid::GetInstancePointer();
+    std::vector<CObject*> objects;
+    grid->FindCrashCandidates(objects, iPos, iRad+15.0f);
+
+    for ( i=0 ; i<static_cast<int>( objects.size() ) ; i++ )
     {
-        pObj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if ( pObj == 0 )  break;
+        pObj = objects[i];
 
         if ( pObj == m_object )  continue;  // yourself?
         if ( pObj->GetTruck() != 0 )  continue;  // object transported?
@@ -2595,6 +2605,13 @@ int CPhysics::ObjectAdapt(const Math::Vector &pos, const Math::Vector &angle)
             }
         }
 
+        // All crash spheres of the object are within its extent
+        oPos = pObj->GetPosition(0);
+        distance = Math::Distance(oPos, iPos);
+        if ( distance >= iRad+pObj->GetCrashSphereExtent() )  continue;
+
+        grid->AddStatisticPairTest(pObj->GetCrashSphereTotal());
+
         j = 0;
         while ( pObj->GetCrashSphere(j++, oPos, oRad) )
         {
@@ -18,6 +18,7 @@
 #include "script/script.h"
 
 #include "app/app.h"
+#include "app/system.h"
 
 #include "common/global.h"
 #include "common/iman.h"
@@ -31,12 +32,14 @@
 #include "math/vector.h"
 
 #include "object/object.h"
+#include "object/objectgrid.h"
 #include "object/robotmain.h"
 #include "object/task/taskmanager.h"
 
 #include "physics/physics.h"
 
 #include "script/cbottoken.h"
+#include "script/scriptscheduler.h"
 
 #include "ui/interface.h"
 #include "ui/edit.h"
@@ -45,6 +48,7 @@
 
 
 #include <stdio.h>
+#include <vector>
 
 
 
@@ -203,6 +207,135 @@ bool GetPoint(CBotVar* &var, int& exception, Math::Vector& pos)
 }
 
 
+// Gives the type of an object as seen by the search instructions.
+
+int GetSearchType(CObject* pObj)
+{
+    int     oType;
+
+    oType = pObj->GetType();
+
+    if ( oType == OBJECT_RUINmobilew2 ||
+         oType == OBJECT_RUINmobilet1 ||
+         oType == OBJECT_RUINmobilet2 ||
+         oType == OBJECT_RUINmobiler1 ||
+         oType == OBJECT_RUINmobiler2 )
+    {
+        oType = OBJECT_RUINmobilew1;  // any ruin
+    }
+
+    if ( oType == OBJECT_SCRAP2 ||
+         oType == OBJECT_SCRAP3 ||
+         oType == OBJECT_SCRAP4 ||
+         oType == OBJECT_SCRAP5 )  // wastes?
+    {
+        oType = OBJECT_SCRAP1;  // any waste
+    }
+
+    if ( oType == OBJECT_BARRIER2 ||
+         oType == OBJECT_BARRIER3 )  // barriers?
+    {
+        oType = OBJECT_BARRIER1;  // any barrier
+    }
+
+    return oType;
+}
+
+
+// Adds the objects of a searched type, with all their variants.
+
+void AddTypeObjects(int type, std::vector<CObject*> &list)
+{
+    CObjectGrid*    grid = CObjectGrid::GetInstancePointer();
+    int             first, last;
+
+    if ( type < 0 || type >= OBJECT_MAX )  return;
+
+    first = last = type;
+    if ( type == OBJECT_RUINmobilew1 )  last = OBJECT_RUINmobiler2;  // any ruin
+    if ( type == OBJECT_SCRAP1       )  last = OBJECT_SCRAP5;        // any waste
+    if ( type == OBJECT_BARRIER1     )  last = OBJECT_BARRIER3;      // any barrier
+
+    for ( type=first ; type<=last ; type++ )
+    {
+        const std::vector<CObject*> &objects = grid->GetObjectsOfType(static_cast<ObjectType>(type));
+        list.insert(list.end(), objects.begin(), objects.end());
+    }
+}
+
+// Gives the objects which may have the searched types.
+// Returns false if all types are searched.
+
+bool GetTypeObjects(CBotVar* array, bool bArray, int type, std::vector<CObject*> &list)
+{
+    list.clear();
+
+    if ( !bArray )
+    {
+        if ( type == OBJECT_NULL )  return false;
+        AddTypeObjects(type, list);
+        return true;
+    }
+
+    while ( array != 0 )
+    {
+        AddTypeObjects(array->GetValInt(), list);
+        array = array->GetNext();
+    }
+    return true;
+}
+
+// Gives the candidate rank of a search: the objects of the searched types, or
+// if bSorted all objects by increasing distance, taken from the grid as needed.
+
+CObject* GetSearchObject(std::vector<CObject*> &list, bool bSorted, int rank,
+                         const Math::Vector &center, float maxDist)
+{
+    if ( rank < static_cast<int>( list.size() ) )  return list[rank];
+    if ( !bSorted )  return 0;
+
+    // the nearest objects found before stay at the beginning of the list
+    CObjectGrid::GetInstancePointer()->FindNearest(list, center, rank < 4 ? 16 : rank*4, maxDist);
+
+    if ( rank < static_cast<int>( list.size() ) )  return list[rank];
+    return 0;
+}
+
+
+// Gives the box (in XZ plane) around the sector seen by the radar.
+
+void GetSectorBox(const Math::Vector &center, float angle, float focus, float dist,
+                  Math::Vector &min, Math::Vector &max)
+{
+    float       a[6];
+    int         i, total;
+
+    total = 0;
+    a[total++] = angle-focus/2.0f;  // borders of the sector
+    a[total++] = angle+focus/2.0f;
+    for ( i=0 ; i<4 ; i++ )  // axes crossed by the sector
+    {
+        if ( Math::TestAngle(i*Math::PI/2.0f, a[0], a[1]) )  a[total++] = i*Math::PI/2.0f;
+    }
+
+    min = center;
+    max = center;
+    for ( i=0 ; i<total ; i++ )
+    {
+        min.x = Math::Min(min.x, center.x+cosf(a[i])*dist);
+        max.x = Math::Max(max.x, center.x+cosf(a[i])*dist);
+        min.z = Math::Min(min.z, center.z-sinf(a[i])*dist);  // CW !
+        max.z = Math::Max(max.z, center.z-sinf(a[i])*dist);
+    }
+
+    // against rounding errors at the borders
+    min.x -= 1.0f;
+    min.z -= 1.0f;
+    max.x += 1.0f;
+    max.z += 1.0f;
+}
+
+
 // Instruction "sin(degrees)".
 
 bool CScript::rSin(CBotVar* var, CBotVar* result, int& exception, void* user)
@@ -404,41 +537,31 @@ bool CScript::rSearch(CBotVar* var, CBotVar* result, int& exception, void* user)
         bNearest = true;
     }
 
+    // without searched types, any object may do: the first one, or the nearest one
+    std::vector<CObject*> objects;
+    bool bAll = !GetTypeObjects(array, bArray, type, objects);
+    bool bSorted = bAll && bNearest;
+
     min = 100000.0f;
     pBest = 0;
     for ( i=0 ; i<1000000 ; i++ )
     {
-        pObj = static_cast<CObject*>(script->m_iMan->SearchInstance(CLASS_OBJECT, i));
+        if ( bAll && !bNearest )
+        {
+            pObj = static_cast<CObject*>(script->m_iMan->SearchInstance(CLASS_OBJECT, i));
+        }
+        else
+        {
+            pObj = GetSearchObject(objects, bSorted, i, pos, OBJECT_GRID_MAX_RADIUS);
+        }
         if ( pObj == 0 )  break;
 
         if ( pObj->GetTruck() != 0 )  continue;  // object transported?
         if ( !pObj->GetActif() )  continue;
 
-        oType = pObj->GetType();
-        if ( oType == OBJECT_TOTO )  continue;
+        if ( pObj->GetType() == OBJECT_TOTO )  continue;
 
-        if ( oType == OBJECT_RUINmobilew2 ||
-             oType == OBJECT_RUINmobilet1 ||
-             oType == OBJECT_RUINmobilet2 ||
-             oType == OBJECT_RUINmobiler1 ||
-             oType == OBJECT_RUINmobiler2 )
-        {
-            oType = OBJECT_RUINmobilew1;  // any ruin
-        }
-
-        if ( oType == OBJECT_SCRAP2 ||
-             oType == OBJECT_SCRAP3 ||
-             oType == OBJECT_SCRAP4 ||
-             oType == OBJECT_SCRAP5 )  // wastes?
-        {
-            oType = OBJECT_SCRAP1;  // any waste
-        }
-
-        if ( oType == OBJECT_BARRIER2 ||
-             oType == OBJECT_BARRIER3 )  // barriers?
-        {
-            oType = OBJECT_BARRIER1;  // any barrier
-        }
+        oType = GetSearchType(pObj);
 
         if ( bArray )
         {
@@ -458,6 +581,7 @@ bool CScript::rSearch(CBotVar* var, CBotVar* result, int& exception, void* user)
                 min = dist;
                 pBest = pObj;
             }
+            if ( bSorted )  break;  // the first one is the nearest
         }
         else
         {
@@ -519,12 +643,11 @@ CBotTypResult CScript::cRadar(CBotVar* &var, void* user)
 
 bool CScript::rRadar(CBotVar* var, CBotVar* result, int& exception, void* user)
 {
-    CScript*    script = (static_cast<CObject *>(user))->GetRunScript();
     CObject*    pThis = static_cast<CObject *>(user);
     CObject     *pObj, *pBest;
     CPhysics*   physics;
     CBotVar*    array;
-    Math::Vector    iPos, oPos;
+    Math::Vector    iPos, oPos, bMin, bMax;
     RadarFilter filter;
     float       best, minDist, maxDist, sens, iAngle, angle, focus, d, a;
     int         type, oType, i;
@@ -537,6 +660,8 @@ bool CScript::rRadar(CBotVar* var, CBotVar* result, int& exception, void* user)
     maxDist = 1000.0f*g_unit;
     sens    = 1.0f;
     filter  = FILTER_NONE;
+    array   = 0;
+    bArray  = false;
 
     if ( var != 0 )
     {
@@ -595,9 +720,28 @@ bool CScript::rRadar(CBotVar* var, CBotVar* result, int& exception, void* user)
     if ( sens >= 0.0f )  best = 100000.0f;
     else                 best = 0.0f;
     pBest = 0;
+
+    // without searched types, the nearest objects are seen first,
+    // else the farthest one must be searched in the whole sector
+    std::vector<CObject*> objects;
+    bool bAll = !GetTypeObjects(array, bArray, type, objects);
+    bool bSorted = bAll && sens >= 0.0f;
+    if ( bAll && !bSorted )
+    {
+        if ( focus >= Math::PI*2.0f )
+        {
+            CObjectGrid::GetInstancePointer()->FindInRadius(objects, iPos, maxDist);
+        }
+        else
+        {
+            GetSectorBox(iPos, iAngle, focus, maxDist, bMin, bMax);
+            CObjectGrid::GetInstancePointer()->FindInBox(objects, bMin, bMax);
+        }
+    }
+
     for ( i=0 ; i<1000000 ; i++ )
     {
-        pObj = static_cast<CObject*>(script->m_iMan->SearchInstance(CLASS_OBJECT, i));
+        pObj = GetSearchObject(objects, bSorted, i, iPos, maxDist);
         if ( pObj == 0 )  break;
         if ( pObj == pThis )  continue;
 
@@ -605,31 +749,9 @@ bool CScript::rRadar(CBotVar* var, CBotVar* result, int& exception, void* user)
         if ( !pObj->GetActif() )  continue;
         if ( pObj->GetProxyActivate() )  continue;
 
-        oType = pObj->GetType();
-        if ( oType == OBJECT_TOTO )  continue;
-
-        if ( oType == OBJECT_RUINmobilew2 ||
-             oType == OBJECT_RUINmobilet1 ||
-             oType == OBJECT_RUINmobilet2 ||
-             oType == OBJECT_RUINmobiler1 ||
-             oType == OBJECT_RUINmobiler2 )
-        {
-            oType = OBJECT_RUINmobilew1;  // any ruin
-        }
-
-        if ( oType == OBJECT_SCRAP2 ||
-             oType == OBJECT_SCRAP3 ||
-             oType == OBJECT_SCRAP4 ||
-             oType == OBJECT_SCRAP5 )  // wastes?
-        {
-            oType = OBJECT_SCRAP1;  // any waste
-        }
+        if ( pObj->GetType() == OBJECT_TOTO )  continue;
 
-        if ( oType == OBJECT_BARRIER2 ||
-             oType == OBJECT_BARRIER3 )  // barriers?
-        {
-            oType = OBJECT_BARRIER1;  // any barrier
-        }
+        oType = GetSearchType(pObj);
 
         if ( filter == FILTER_ONLYLANDING )
         {
@@ -662,6 +784,7 @@ bool CScript::rRadar(CBotVar* var, CBotVar* result, int& exception, void* user)
             {
                 best = d;
                 pBest = pObj;
+                if ( bSorted )  break;  // the first one is the nearest
             }
             continue;
         }
@@ -675,6 +798,7 @@ bool CScript::rRadar(CBotVar* var, CBotVar* result, int& exception, void* user)
             {
                 best = d;
                 pBest = pObj;
+                if ( bSorted )  break;  // the first one is the nearest
             }
         }
     }
@@ -783,9 +907,14 @@ bool CScript::rDetect(CBotVar* var, CBotVar* result, int& exception, void* user)
         if ( sens >= 0.0f )  best = 100000.0f;
         else                 best = 0.0f;
         pBest = 0;
+
+        // without searched types, the nearest objects are seen first
+        std::vector<CObject*> objects;
+        bool bSorted = !GetTypeObjects(array, bArray, type, objects);
+
         for ( i=0 ; i<1000000 ; i++ )
         {
-            pObj = static_cast<CObject*>(script->m_iMan->SearchInstance(CLASS_OBJECT, i));
+            pObj = GetSearchObject(objects, bSorted, i, iPos, OBJECT_GRID_MAX_RADIUS);
             if ( pObj == 0 )  break;
             if ( pObj == pThis )  continue;
 
@@ -793,31 +922,9 @@ bool CScript::rDetect(CBotVar* var, CBotVar* result, int& exception, void* user)
             if ( !pObj->GetActif() )  continue;
             if ( pObj->GetProxyActivate() )  continue;
 
-            oType = pObj->GetType();
-            if ( oType == OBJECT_TOTO )  continue;
-
-            if ( oType == OBJECT_RUINmobilew2 ||
-                 oType == OBJECT_RUINmobilet1 ||
-                 oType == OBJECT_RUINmobilet2 ||
-                 oType == OBJECT_RUINmobiler1 ||
-                 oType == OBJECT_RUINmobiler2 )
-            {
-                oType = OBJECT_RUINmobilew1;  // any ruin
-            }
+            if ( pObj->GetType() == OBJECT_TOTO )  continue;
 
-            if ( oType == OBJECT_SCRAP2 ||
-                 oType == OBJECT_SCRAP3 ||
-                 oType == OBJECT_SCRAP4 ||
-                 oType == OBJECT_SCRAP5 )  // wastes?
-            {
-                oType = OBJECT_SCRAP1;  // any waste
-            }
-
-            if ( oType == OBJECT_BARRIER2 ||
-                 oType == OBJECT_BARRIER3 )  // barriers?
-            {
-                oType = OBJECT_BARRIER1;  // any barrier
-            }
+            oType = GetSearchType(pObj);
 
             if ( filter == FILTER_ONLYLANDING )
             {
@@ -850,6 +957,9 @@ bool CScript::rDetect(CBotVar* var, CBotVar* result, int& exception, void* user)
                 pGoal = pObj;
             }
 
+            // the following ones are farther
+            if ( bSorted && pGoal != 0 && (pBest != 0 || d > maxDist) )  break;
+
             if ( d < minDist || d > maxDist )  continue;  // too close or too far?
 
             if ( focus >= Math::PI*2.0f )
@@ -1444,11 +1554,19 @@ bool CScript::rFind(CBotVar* var, CBotVar* result, int& exception, void* user)
             bArray = false;
         }
 
+        iPos   = pThis->GetPosition(0);
+        iAngle = pThis->GetAngleY(0);
+
         best = 100000.0f;
         pBest = 0;
+
+        // without searched types, the nearest objects are seen first
+        std::vector<CObject*> objects;
+        bool bSorted = !GetTypeObjects(array, bArray, type, objects);
+
         for ( i=0 ; i<1000000 ; i++ )
         {
-            pObj = static_cast<CObject*>(script->m_iMan->SearchInstance(CLASS_OBJECT, i));
+            pObj = GetSearchObject(objects, bSorted, i, iPos, maxDist);
             if ( pObj == 0 )  break;
             if ( pObj == pThis )  continue;
 
@@ -1456,31 +1574,9 @@ bool CScript::rFind(CBotVar* var, CBotVar* result, int& exception, void* user)
             if ( !pObj->GetActif() )  continue;
             if ( pObj->GetProxyActivate() )  continue;
 
-            oType = pObj->GetType();
-            if ( oType == OBJECT_TOTO )  continue;
+            if ( pObj->GetType() == OBJECT_TOTO )  continue;
 
-            if ( oType == OBJECT_RUINmobilew2 ||
-                 oType == OBJECT_RUINmobilet1 ||
-                 oType == OBJECT_RUINmobilet2 ||
-                 oType == OBJECT_RUINmobiler1 ||
-                 oType == OBJECT_RUINmobiler2 )
-            {
-                oType = OBJECT_RUINmobilew1;  // any ruin
-            }
-
-            if ( oType == OBJECT_SCRAP2 ||
-                 oType == OBJECT_SCRAP3 ||
-                 oType == OBJECT_SCRAP4 ||
-                 oType == OBJECT_SCRAP5 )  // wastes?
-            {
-                oType = OBJECT_SCRAP1;  // any waste
-            }
-
-            if ( oType == OBJECT_BARRIER2 ||
-                 oType == OBJECT_BARRIER3 )  // barriers?
-            {
-                oType = OBJECT_BARRIER1;  // any barrier
-            }
+            oType = GetSearchType(pObj);
 
             if ( bArray )
             {
@@ -1501,6 +1597,7 @@ bool CScript::rFind(CBotVar* var, CBotVar* result, int& exception, void* user)
                 {
                     best = d;
                     pBest = pObj;
+                    if ( bSorted )  break;  // the first one is the nearest
                 }
                 continue;
             }
@@ -1512,6 +1609,7 @@ bool CScript::rFind(CBotVar* var, CBotVar* result, int& exception, void* user)
                 {
                     best = d;
                     pBest = pObj;
+                    if ( bSorted )  break;  // the first one is the nearest
                 }
             }
         }
@@ -1827,12 +1925,15 @@ CObject* CScript::SearchInfo(CScript* script, CObject* object, float power)
 
     iPos = object->GetPosition(0);
 
+    // the distance in XZ plane is never greater
+    std::vector<CObject*> objects;
+    CObjectGrid::GetInstancePointer()->FindInRadius(objects, iPos, power);
+
     min = 100000.0f;
     pBest = 0;
-    for ( i=0 ; i<1000000 ; i++ )
+    for ( i=0 ; i<static_cast<int>( objects.size() ) ; i++ )
     {
-        pObj = static_cast<CObject*>(script->m_iMan->SearchInstance(CLASS_OBJECT, i));
-        if ( pObj == 0 )  break;
+        pObj = objects[i];
 
         type = pObj->GetType();
         if ( type != OBJECT_INFO )  continue;
@@ -2683,36 +2784,48 @@ CScript::CScript(CInstanceManager* iMan, CObject* object, CTaskManager** seconda
     m_script = 0;
     m_bRun = false;
     m_bStepMode = false;
+    m_bEnded = false;
+    m_workerSteps = 0;
+    m_quota = CBOT_IPF;
+    m_bBlocked = false;
+    m_statSteps = 0LL;
+    m_statTime = 0LL;
+    m_statFrames = 0;
+    m_runStart = CreateTimeStamp();
+    m_runEnd = CreateTimeStamp();
     m_bCompile = false;
     m_title[0] = 0;
     m_cursor1 = 0;
     m_cursor2 = 0;
     m_filename[0] = 0;
+    m_colorEdit = 0;
+    m_colorReset = 0;
 }
 
 // Initializes all functions for module CBOT.
 
 void CScript::InitFonctions()
 {
-    CBotProgram::AddFunction("sin",       rSin,       CScript::cOneFloat);
-    CBotProgram::AddFunction("cos",       rCos,       CScript::cOneFloat);
-    CBotProgram::AddFunction("tan",       rTan,       CScript::cOneFloat);
-    CBotProgram::AddFunction("asin",      raSin,      CScript::cOneFloat);
-    CBotProgram::AddFunction("acos",      raCos,      CScript::cOneFloat);
-    CBotProgram::AddFunction("atan",      raTan,      CScript::cOneFloat);
-    CBotProgram::AddFunction("sqrt",      rSqrt,      CScript::cOneFloat);
-    CBotProgram::AddFunction("pow",       rPow,       CScript::cTwoFloat);
+    // Functions marked as thread safe only read the world (see CScriptScheduler)
+    CBotProgram::AddFunction("sin",       rSin,       CScript::cOneFloat, true);
+    CBotProgram::AddFunction("cos",       rCos,       CScript::cOneFloat, true);
+    CBotProgram::AddFunction("tan",       rTan,       CScript::cOneFloat, true);
+    CBotProgram::AddFunction("asin",      raSin,      CScript::cOneFloat, true);
+    CBotProgram::AddFunction("acos",      raCos,      CScript::cOneFloat, true);
+    CBotProgram::AddFunction("atan",      raTan,      CScript::cOneFloat, true);
+    CBotProgram::AddFunction("sqrt",      rSqrt,      CScript::cOneFloat, true);
+    CBotProgram::AddFunction("pow",       rPow,       CScript::cTwoFloat, true);
     CBotProgram::AddFunction("rand",      rRand,      CScript::cNull);
-    CBotProgram::AddFunction("abs",       rAbs,       CScript::cOneFloat);
+    CBotProgram::AddFunction("abs",       rAbs,       CScript::cOneFloat, true);
 
-    CBotProgram::AddFunction("retobject", rGetObject, CScript::cGetObject);
-    CBotProgram::AddFunction("search",    rSearch,    CScript::cSearch);
-    CBotProgram::AddFunction("radar",     rRadar,     CScript::cRadar);
+    CBotProgram::AddFunction("retobject", rGetObject, CScript::cGetObject, true);
+    CBotProgram::AddFunction("search",    rSearch,    CScript::cSearch, true);
+    CBotProgram::AddFunction("radar",     rRadar,     CScript::cRadar, true);
     CBotProgram::AddFunction("detect",    rDetect,    CScript::cDetect);
-    CBotProgram::AddFunction("direction", rDirection, CScript::cDirection);
+    CBotProgram::AddFunction("direction", rDirection, CScript::cDirection, true);
     CBotProgram::AddFunction("produce",   rProduce,   CScript::cProduce);
-    CBotProgram::AddFunction("distance",  rDistance,  CScript::cDistance);
-    CBotProgram::AddFunction("distance2d",rDistance2d,CScript::cDistance);
+    CBotProgram::AddFunction("distance",  rDistance,  CScript::cDistance, true);
+    CBotProgram::AddFunction("distance2d",rDistance2d,CScript::cDistance, true);
     CBotProgram::AddFunction("space",     rSpace,     CScript::cSpace);
     CBotProgram::AddFunction("flatground",rFlatGround,CScript::cFlatGround);
     CBotProgram::AddFunction("wait",      rWait,      CScript::cOneFloat);
@@ -2734,7 +2847,7 @@ void CScript::InitFonctions()
     CBotProgram::AddFunction("aim",       rAim,       CScript::cOneFloat);
     CBotProgram::AddFunction("motor",     rMotor,     CScript::cMotor);
     CBotProgram::AddFunction("jet",       rJet,       CScript::cOneFloat);
-    CBotProgram::AddFunction("topo",      rTopo,      CScript::cTopo);
+    CBotProgram::AddFunction("topo",      rTopo,      CScript::cTopo, true);
     CBotProgram::AddFunction("message",   rMessage,   CScript::cMessage);
     CBotProgram::AddFunction("cmdline",   rCmdline,   CScript::cOneFloat);
     CBotProgram::AddFunction("ismovie",   rIsMovie,   CScript::cNull);
@@ -2752,6 +2865,9 @@ void CScript::InitFonctions()
 
 CScript::~CScript()
 {
+    if (CScriptScheduler::IsCreated())
+        CScriptScheduler::GetInstancePointer()->RemoveScript(this);
+
     delete m_botProg;
     m_botProg = nullptr;
 
@@ -2763,6 +2879,9 @@ CScript::~CScript()
 
     m_len = 0;
 
+    DestroyTimeStamp(m_runStart);
+    DestroyTimeStamp(m_runEnd);
+
     m_iMan->DeleteInstance(CLASS_SCRIPT, this);
 }
 
@@ -3011,6 +3130,10 @@ bool CScript::Run()
     m_bContinue = false;
     m_ipf = CBOT_IPF;
     m_errMode = ERM_STOP;
+    m_quota = m_ipf;
+    m_statSteps = 0LL;
+    m_statTime = 0LL;
+    m_statFrames = 0;
 
     if ( m_bStepMode )  // step by step mode?
     {
@@ -3038,25 +3161,7 @@ bool CScript::Continue(const Event &event)
         {
             if ( m_botProg->Run(m_object, 0) )
             {
-                m_botProg->GetError(m_error, m_cursor1, m_cursor2);
-                if ( m_cursor1 < 0 || m_cursor1 > m_len ||
-                     m_cursor2 < 0 || m_cursor2 > m_len )
-                {
-                    m_cursor1 = 0;
-                    m_cursor2 = 0;
-                }
-                if ( m_error == 0 )
-                {
-                    m_cursor1 = m_cursor2 = 0;
-                }
-                m_bRun = false;
-
-                if ( m_error != 0 && m_errMode == ERM_STOP )
-                {
-                    char    s[100];
-                    GetError(s);
-                    m_displayText->DisplayText(s, m_object, 10.0f, Ui::TT_ERROR);
-                }
+                RunEnded();
                 m_engine->SetPause(true);  // gives pause
                 return true;
             }
@@ -3069,31 +3174,121 @@ bool CScript::Continue(const Event &event)
         return false;
     }
 
-    if ( m_botProg->Run(m_object, m_ipf) )
+    BeginRun();
+    bool ended = m_botProg->Run(m_object, m_quota);
+    EndRun();
+    CountSteps(m_botProg->GetStepsUsed());
+
+    if ( ended )
     {
-        m_botProg->GetError(m_error, m_cursor1, m_cursor2);
-        if ( m_cursor1 < 0 || m_cursor1 > m_len ||
-             m_cursor2 < 0 || m_cursor2 > m_len )
-        {
-            m_cursor1 = 0;
-            m_cursor2 = 0;
-        }
-        if ( m_error == 0 )
-        {
-            m_cursor1 = m_cursor2 = 0;
-        }
-        m_bRun = false;
+        RunEnded();
+        return true;
+    }
 
-        if ( m_error != 0 && m_errMode == ERM_STOP )
+    return false;
+}
+
+// Returns true if the program can be continued by CScriptScheduler.
+
+bool CScript::IsParallel()
+{
+    if ( m_botProg == 0 )  return false;
+    if ( !m_bRun )  return false;
+    return !m_bStepMode;
+}
+
+// Continues the execution of current program, maybe in a worker thread.
+// The program stops on the first function which must be called
+// on the main thread; ContinueMain() resumes it.
+
+void CScript::ContinueWorker(const Event &event)
+{
+    m_event = event;
+    BeginRun();
+    m_bEnded = m_botProg->Run(m_object, m_quota);
+    EndRun();
+    m_workerSteps = m_botProg->GetStepsUsed();
+}
+
+// Completes the execution started by ContinueWorker(), on the main thread.
+// Returns true when execution is finished.
+
+bool CScript::ContinueMain()
+{
+    int     steps = m_workerSteps;
+    m_workerSteps = 0;
+
+    if ( !m_bEnded && m_botProg->IsDeferred() )
+    {
+        // spends the rest of the instructions of this frame
+        int     rest = m_quota-m_botProg->GetStepsUsed();
+        if ( rest > 0 )
         {
-            char    s[100];
-            GetError(s);
-            m_displayText->DisplayText(s, m_object, 10.0f, Ui::TT_ERROR);
+            GetCurrentTimeStamp(m_runStart);
+            m_bEnded = m_botProg->Run(m_object, rest);
+            EndRun();
+            steps += m_botProg->GetStepsUsed();
         }
-        return true;
     }
+    CountSteps(steps);
 
-    return false;
+    if ( !m_bEnded )  return false;
+
+    m_bEnded = false;
+    RunEnded();
+    return true;
+}
+
+// Gives the quota of instructions of the program for this frame
+// and starts timing its execution. Can be called by a worker thread.
+
+void CScript::BeginRun()
+{
+    m_bBlocked = m_bContinue;
+    m_quota = CScriptScheduler::GetInstancePointer()->GetQuota(m_object, m_ipf, m_bBlocked);
+    GetCurrentTimeStamp(m_runStart);
+}
+
+// Ends timing the execution of the program. Can be called by a worker thread.
+
+void CScript::EndRun()
+{
+    GetCurrentTimeStamp(m_runEnd);
+    m_statTime += TimeStampExactDiff(m_runStart, m_runEnd);
+}
+
+// Counts the instructions run in this frame, on the main thread.
+
+void CScript::CountSteps(int steps)
+{
+    m_statSteps += steps;
+    m_statFrames ++;
+    CScriptScheduler::GetInstancePointer()->AddSteps(m_object, m_ipf, m_bBlocked, steps);
+}
+
+// Gets the error of a finished program and shows it.
+
+void CScript::RunEnded()
+{
+    m_botProg->GetError(m_error, m_cursor1, m_cursor2);
+    if ( m_cursor1 < 0 || m_cursor1 > m_len ||
+         m_cursor2 < 0 || m_cursor2 > m_len )
+    {
+        m_cursor1 = 0;
+        m_cursor2 = 0;
+    }
+    if ( m_error == 0 )
+    {
+        m_cursor1 = m_cursor2 = 0;
+    }
+    m_bRun = false;
+
+    if ( m_error != 0 && m_errMode == ERM_STOP )
+    {
+        char    s[100];
+        GetError(s);
+        m_displayText->DisplayText(s, m_object, 10.0f, Ui::TT_ERROR);
+    }
 }
 
 // Continues the execution of current program.
@@ -3177,6 +3372,36 @@ bool CScript::IsContinue()
     return m_bContinue;
 }
 
+// Returns the object running the program.
+
+CObject* CScript::GetOwner()
+{
+    return m_object;
+}
+
+// Returns the instructions the program may run in the current frame.
+
+int CScript::GetQuota()
+{
+    return m_quota;
+}
+
+// Returns the average number of instructions run per frame since the start of the program.
+
+float CScript::GetStepsPerFrame()
+{
+    if ( m_statFrames == 0 )  return 0.0f;
+    return static_cast<float>(m_statSteps)/m_statFrames;
+}
+
+// Returns the number of instructions run per ms since the start of the program.
+
+float CScript::GetStepsPerMs()
+{
+    if ( m_statTime == 0LL )  return 0.0f;
+    return m_statSteps/(m_statTime/1000000.0f);
+}
+
 
 // Gives the position of the cursor during the execution.
 
@@ -3329,23 +3554,123 @@ void CScript::UpdateList(Ui::CList* list)
 
 void CScript::ColorizeScript(Ui::CEdit* edit)
 {
+    std::vector<ScriptLine> lines;
+    ScriptLine  line;
+    const char* text;
+    bool        bFull, bRem;
+    int         i, j, first, last, oldLast, offset;
+
+    // Cuts the text in lines.
+    text = edit->GetText();
+    line.bRemIn = line.bRemOut = false;
+    for ( i=0 ; text[i] != 0 ; i=j )
+    {
+        for ( j=i ; text[j] != 0 && text[j] != '\n' ; j++ );
+        if ( text[j] == '\n' )  j ++;
+        line.text.assign(text+i, j-i);
+        lines.push_back(line);
+    }
+
+    // The formats of an edit whose text was replaced no longer match its characters.
+    bFull = ( edit != m_colorEdit                    ||
+              edit->GetTextReset() != m_colorReset   ||
+              m_colorLines.size() == 0               );
+
+    first = 0;
+    last = oldLast = 0;
+    if ( bFull )
+    {
+        edit->ClearFormat();
+        last = static_cast<int>( lines.size() );
+    }
+    else
+    {
+        // Skips the unchanged lines at the beginning and at the end.
+        while ( first < static_cast<int>( lines.size() )        &&
+                first < static_cast<int>( m_colorLines.size() ) &&
+                lines[first].text == m_colorLines[first].text )
+        {
+            lines[first] = m_colorLines[first];
+            first ++;
+        }
+        last = static_cast<int>( lines.size() );
+        oldLast = static_cast<int>( m_colorLines.size() );
+        while ( last > first && oldLast > first &&
+                lines[last-1].text == m_colorLines[oldLast-1].text )
+        {
+            last --;
+            oldLast --;
+        }
+    }
+
+    offset = 0;
+    for ( i=0 ; i<first ; i++ )
+    {
+        offset += static_cast<int>( lines[i].text.size() );
+    }
+
+    bRem = ( first > 0 ) ? lines[first-1].bRemOut : false;
+    for ( i=first ; i<static_cast<int>( lines.size() ) ; i++ )
+    {
+        // An unchanged line lexed in the same state keeps its colors, like all the following ones.
+        if ( i >= last && m_colorLines[oldLast+(i-last)].bRemIn == bRem )
+        {
+            for ( j=i ; j<static_cast<int>( lines.size() ) ; j++ )
+            {
+                lines[j] = m_colorLines[oldLast+(j-last)];
+            }
+            break;
+        }
+
+        lines[i].bRemIn = bRem;
+        ColorizeLine(edit, offset, lines[i]);
+        bRem = lines[i].bRemOut;
+        offset += static_cast<int>( lines[i].text.size() );
+    }
+
+    m_colorLines.swap(lines);
+    m_colorEdit = edit;
+    m_colorReset = edit->GetTextReset();
+}
+
+// Colorizes a line of the text beginning at the character offset.
+
+void CScript::ColorizeLine(Ui::CEdit* edit, int offset, ScriptLine &line)
+{
+    CBotToken*  base;
     CBotToken*  bt;
     CBotString  bs;
     const char* token;
-    int         error, type, cursor1, cursor2;
+    const char* sep;
+    int         error, type, start, cursor1, cursor2, i;
     Gfx::FontHighlight color;
 
-    edit->ClearFormat();
+    edit->ClearFormat(offset, offset+static_cast<int>( line.text.size() ));
+
+    // Skips the end of a comment begun on a previous line.
+    start = 0;
+    if ( line.bRemIn )
+    {
+        start = static_cast<int>( line.text.find("*/") );
+        if ( start < 0 )
+        {
+            line.bRemOut = true;
+            return;
+        }
+        start += 2;
+    }
+    line.bRemOut = false;
 
-    bt = CBotToken::CompileTokens(edit->GetText(), error);
+    base = CBotToken::CompileTokens(line.text.c_str()+start, error);
+    bt = base;
     while ( bt != 0 )
     {
         bs = bt->GetString();
         token = bs;
         type = bt->GetType();
 
-        cursor1 = bt->GetStart();
-        cursor2 = bt->GetEnd();
+        cursor1 = offset+start+bt->GetStart();
+        cursor2 = offset+start+bt->GetEnd();
 
         color = Gfx::FONT_HIGHLIGHT_NONE;
         if ( type >= TokenKeyWord && type < TokenKeyWord+100 )
@@ -3381,10 +3706,31 @@ void CScript::ColorizeScript(Ui::CEdit* edit)
             edit->SetFormat(cursor1, cursor2, color);
         }
 
+        // Does a comment /* */ remain open at the end of the line?
+        if ( bt->GetNext() != 0 && bt->GetNext()->GetNext() == 0 )
+        {
+            bs = bt->GetSep();
+            sep = bs;
+            for ( i=0 ; sep[i] != 0 ; i++ )
+            {
+                if ( sep[i] == '/' && sep[i+1] == '/' )  break;
+                if ( sep[i] == '/' && sep[i+1] == '*' )
+                {
+                    for ( i++ ; sep[i] != 0 && (sep[i] != '*' || sep[i+1] != '/') ; i++ );
+                    if ( sep[i] == 0 )
+                    {
+                        line.bRemOut = true;
+                        break;
+                    }
+                    i ++;
+                }
+            }
+        }
+
         bt = bt->GetNext();
     }
 
-    CBotToken::Delete(bt);
+    CBotToken::Delete(base);
 }
 
 
@@ -27,8 +27,12 @@
 #include "CBot/CBotDll.h"
 
 #include <stdio.h>
+#include <string>
+#include <vector>
 
 
+struct SystemTimeStamp;
+
 class CInstanceManager;
 class CObject;
 class CTaskManager;
@@ -49,6 +53,15 @@ class CWater;
 
 
 
+// One line of the text colorized by CScript::ColorizeScript().
+struct ScriptLine
+{
+    std::string text;       // characters of the line, with its '\n'
+    bool        bRemIn;     // line begins inside a comment /* */
+    bool        bRemOut;    // line ends inside a comment /* */
+};
+
+
 class CScript
 {
 public:
@@ -66,10 +79,17 @@ public:
     void        SetStepMode(bool bStep);
     bool        Run();
     bool        Continue(const Event &event);
+    bool        IsParallel();
+    void        ContinueWorker(const Event &event);
+    bool        ContinueMain();
     bool        Step(const Event &event);
     void        Stop();
     bool        IsRunning();
     bool        IsContinue();
+    CObject*    GetOwner();
+    int         GetQuota();
+    float       GetStepsPerFrame();
+    float       GetStepsPerMs();
     bool        GetCursor(int &cursor1, int &cursor2);
     void        UpdateList(Ui::CList* list);
     void        ColorizeScript(Ui::CEdit* edit);
@@ -93,6 +113,11 @@ protected:
     bool        IsEmpty();
     bool        CheckToken();
     bool        Compile();
+    void        RunEnded();
+    void        BeginRun();
+    void        EndRun();
+    void        CountSteps(int steps);
+    void        ColorizeLine(Ui::CEdit* edit, int offset, ScriptLine &line);
 
 private:
 
@@ -196,6 +221,15 @@ private:
     bool    m_bRun;         // program during execution?
     bool    m_bStepMode;        // step by step
     bool    m_bContinue;        // external function to continue
+    bool    m_bEnded;       // program ended in ContinueWorker()?
+    int     m_workerSteps;  // instructions run in ContinueWorker()
+    int     m_quota;        // instructions allowed in this frame (see CScriptScheduler)
+    bool    m_bBlocked;     // waiting in "move", "goto", etc. when the frame began?
+    long long m_statSteps;  // instructions run since the start of the program
+    long long m_statTime;   // time spent running them (in ns)
+    int     m_statFrames;   // frames run since the start of the program
+    SystemTimeStamp* m_runStart;
+    SystemTimeStamp* m_runEnd;
     bool    m_bCompile;     // compilation ok?
     char    m_title[50];        // script title
     char    m_filename[50];     // file name
@@ -205,6 +239,9 @@ private:
     int     m_cursor2;
     Event   m_event;
     float   m_returnValue;
+    std::vector<ScriptLine> m_colorLines;   // lines at the last ColorizeScript()
+    Ui::CEdit*  m_colorEdit;        // edit colorized by the last ColorizeScript()
+    int     m_colorReset;       // GetTextReset() of the edit at the last ColorizeScript()
 };
 
 
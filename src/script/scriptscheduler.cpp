@@ -0,0 +1,419 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+
+#include "script/scriptscheduler.h"
+
+#include "app/profiler.h"
+
+#include "common/iman.h"
+#include "common/logger.h"
+
+#include "graphics/engine/terrain.h"
+
+#include "object/brain.h"
+#include "object/object.h"
+
+#include "script/script.h"
+
+#include <SDL/SDL.h>
+
+
+template<> CScriptScheduler* CSingleton<CScriptScheduler>::mInstance = nullptr;
+
+
+/**
+ * \struct ScriptSchedulerPrivate
+ * \brief Private data of CScriptScheduler class
+ */
+struct ScriptSchedulerPrivate
+{
+    //! Worker threads
+    std::vector<SDL_Thread*> threads;
+    //! Guards the members of CScriptScheduler shared with worker threads
+    SDL_mutex*  mutex;
+    //! Signalled when a new frame starts
+    SDL_cond*   startCond;
+    //! Signalled when the last worker thread is done with the frame
+    SDL_cond*   doneCond;
+};
+
+
+CScriptScheduler::CScriptScheduler(CInstanceManager* iMan)
+{
+    m_iMan = iMan;
+
+    m_private = new ScriptSchedulerPrivate();
+    m_private->mutex = SDL_CreateMutex();
+    m_private->startCond = SDL_CreateCond();
+    m_private->doneCond = SDL_CreateCond();
+
+    m_nextSlice = 0;
+    m_busyThreads = 0;
+    m_frame = 0;
+    m_startFrame = 0;
+    m_quit = false;
+    m_statisticSteps = 0LL;
+
+    m_frameTime = SCRIPT_FRAME_TIME;
+    m_selected = nullptr;
+    m_budget = -1;
+    m_scale = 1.0f;
+    m_stepsPerMs = 0.0f;
+    m_frameSteps = 0;
+    m_framePriority = 0;
+    m_frameDemand = 0;
+}
+
+CScriptScheduler::~CScriptScheduler()
+{
+    StopThreads();
+
+    SDL_DestroyCond(m_private->doneCond);
+    SDL_DestroyCond(m_private->startCond);
+    SDL_DestroyMutex(m_private->mutex);
+
+    delete m_private;
+    m_private = nullptr;
+
+    m_iMan = nullptr;
+}
+
+void CScriptScheduler::SetThreadCount(int count)
+{
+    if (count < 0)
+        count = 0;
+
+    if (count == GetThreadCount())
+        return;
+
+    StopThreads();
+    StartThreads(count);
+}
+
+int CScriptScheduler::GetThreadCount()
+{
+    return static_cast<int>( m_private->threads.size() );
+}
+
+bool CScriptScheduler::AddScript(CBrain* brain, CScript* script, const Event &event)
+{
+    if (m_private->threads.empty())
+        return false;
+
+    if (! script->IsParallel())
+        return false;
+
+    ScheduledScript scheduled;
+    scheduled.brain = brain;
+    scheduled.script = script;
+    m_queue.push_back(scheduled);
+
+    m_event = event;
+    return true;
+}
+
+void CScriptScheduler::RemoveScript(CScript* script)
+{
+    for (int i = 0; i < static_cast<int>( m_queue.size() ); i++)
+    {
+        if (m_queue[i].script == script)
+            m_queue[i].script = nullptr;
+    }
+}
+
+void CScriptScheduler::Execute()
+{
+    if (m_queue.empty())
+        return;
+
+    if (CBotClass::HasSharedData())
+    {
+        // Programs could interact, keep them on the main thread
+        m_nextSlice = 0;
+        RunSlices();
+    }
+    else
+    {
+        UpdateObjects();
+
+        // topo() and other ground queries only read the terrain from then on
+        Gfx::CTerrain* terrain = static_cast<Gfx::CTerrain*>(m_iMan->SearchInstance(CLASS_TERRAIN));
+        if (terrain != nullptr)
+            terrain->ValidateHeightField();
+
+        SDL_LockMutex(m_private->mutex);
+        m_nextSlice = 0;
+        m_busyThreads = GetThreadCount();
+        m_frame++;
+        SDL_CondBroadcast(m_private->startCond);
+        SDL_UnlockMutex(m_private->mutex);
+
+        // The main thread takes part too
+        CBotProgram::SetWorkerThread(true);
+        RunSlices();
+        CBotProgram::SetWorkerThread(false);
+
+        SDL_LockMutex(m_private->mutex);
+        while (m_busyThreads > 0)
+            SDL_CondWait(m_private->doneCond, m_private->mutex);
+        SDL_UnlockMutex(m_private->mutex);
+    }
+
+    // Frame barrier: completes the slices in the order of the objects,
+    // including calls which were left for the main thread
+    for (int i = 0; i < static_cast<int>( m_queue.size() ); i++)
+    {
+        CScript* script = m_queue[i].script;
+        if (script == nullptr)
+            continue;
+
+        if (script->ContinueMain())
+            m_queue[i].brain->ProgramEnded(script);
+    }
+
+    // Destructors of instances released in the worker threads
+    CBotProgram::RunDeferred();
+
+    m_queue.clear();
+}
+
+void CScriptScheduler::SetFrameTime(float time)
+{
+    if (time < 0.0f)
+        time = 0.0f;
+
+    m_frameTime = time;
+}
+
+float CScriptScheduler::GetFrameTime()
+{
+    return m_frameTime;
+}
+
+void CScriptScheduler::BeginFrame(CObject* selected)
+{
+    m_selected = selected;
+
+    int steps = m_frameSteps;
+    int priority = m_framePriority;
+    int demand = m_frameDemand;
+    m_frameSteps = 0;
+    m_framePriority = 0;
+    m_frameDemand = 0;
+
+    m_budget = -1;
+    m_scale = 1.0f;
+
+    if (m_frameTime <= 0.0f || !CProfiler::IsCreated())
+        return;
+
+    CProfiler* profiler = CProfiler::GetInstancePointer();
+
+    // Speed of the programs, in instructions per ms spent running them
+    // (on all threads, as seen from the frame)
+    float time = profiler->GetLastTime(PROF_SCRIPTS);
+    if (steps > 0 && time > 0.0f)
+    {
+        float speed = steps / time;
+        if (m_stepsPerMs == 0.0f)
+            m_stepsPerMs = speed;
+        else
+            m_stepsPerMs += (speed - m_stepsPerMs) * SCRIPT_SPEED_SMOOTH;
+    }
+
+    if (m_stepsPerMs == 0.0f || demand == 0)
+        return;
+
+    // Time left to the programs by the rest of the frame
+    float headroom = m_frameTime - (profiler->GetAverageTime(PROF_FRAME) - profiler->GetAverageTime(PROF_SCRIPTS));
+    if (headroom < m_frameTime * SCRIPT_MIN_HEADROOM)
+        headroom = m_frameTime * SCRIPT_MIN_HEADROOM;
+
+    m_budget = static_cast<int>(headroom * m_stepsPerMs);
+
+    // Programs with priority are served first
+    m_scale = static_cast<float>(m_budget - priority) / demand;
+    if (m_scale < 0.0f)
+        m_scale = 0.0f;
+    if (m_scale > 1.0f)
+        m_scale = 1.0f;
+}
+
+bool CScriptScheduler::IsPriority(CObject* object, bool blocked)
+{
+    return blocked || (object != nullptr && object == m_selected);
+}
+
+int CScriptScheduler::GetQuota(CObject* object, int ipf, bool blocked)
+{
+    if (m_scale >= 1.0f || IsPriority(object, blocked))
+        return ipf;
+
+    int quota = static_cast<int>(ipf * m_scale);
+    int minimum = ipf < SCRIPT_MIN_QUOTA ? ipf : SCRIPT_MIN_QUOTA;
+    if (quota < minimum)
+        quota = minimum;
+
+    return quota;
+}
+
+void CScriptScheduler::AddSteps(CObject* object, int ipf, bool blocked, int steps)
+{
+    m_statisticSteps += steps;
+    m_frameSteps += steps;
+
+    if (IsPriority(object, blocked))
+        m_framePriority += steps;
+    else
+        m_frameDemand += ipf;
+}
+
+long long CScriptScheduler::GetStatisticSteps()
+{
+    return m_statisticSteps;
+}
+
+int CScriptScheduler::GetBudget()
+{
+    return m_budget;
+}
+
+void CScriptScheduler::LogStatistics()
+{
+    GetLogger()->Info("Programs: budget %d instructions per frame, %.1f instructions/ms, %.0f%% of quotas\n",
+                      m_budget, m_stepsPerMs, m_scale * 100.0f);
+
+    for (int i = 0; i < 1000000; i++)
+    {
+        CScript* script = static_cast<CScript*>(m_iMan->SearchInstance(CLASS_SCRIPT, i));
+        if (script == nullptr) break;
+
+        if (! script->IsRunning())
+            continue;
+
+        char title[50];
+        script->GetTitle(title);
+
+        CObject* object = script->GetOwner();
+        GetLogger()->Info("  %s (object %d): quota %d, %.1f instructions/frame, %.1f instructions/ms\n",
+                          title, object != nullptr ? object->GetID() : -1, script->GetQuota(),
+                          script->GetStepsPerFrame(), script->GetStepsPerMs());
+    }
+}
+
+int CScriptScheduler::WorkerThread(void* data)
+{
+    CScriptScheduler* scheduler = static_cast<CScriptScheduler*>(data);
+
+    CBotProgram::SetWorkerThread(true);
+    scheduler->WorkerLoop();
+    return 0;
+}
+
+void CScriptScheduler::WorkerLoop()
+{
+    SDL_LockMutex(m_private->mutex);
+
+    int frame = m_startFrame;
+    while (true)
+    {
+        while (! m_quit && m_frame == frame)
+            SDL_CondWait(m_private->startCond, m_private->mutex);
+
+        if (m_quit)
+            break;
+
+        frame = m_frame;
+        SDL_UnlockMutex(m_private->mutex);
+
+        RunSlices();
+
+        SDL_LockMutex(m_private->mutex);
+        m_busyThreads--;
+        if (m_busyThreads == 0)
+            SDL_CondSignal(m_private->doneCond);
+    }
+
+    SDL_UnlockMutex(m_private->mutex);
+}
+
+void CScriptScheduler::RunSlices()
+{
+    int count = static_cast<int>( m_queue.size() );
+
+    while (true)
+    {
+        SDL_LockMutex(m_private->mutex);
+        int i = m_nextSlice++;
+        SDL_UnlockMutex(m_private->mutex);
+
+        if (i >= count)
+            break;
+
+        if (m_queue[i].script != nullptr)
+            m_queue[i].script->ContinueWorker(m_event);
+    }
+}
+
+void CScriptScheduler::UpdateObjects()
+{
+    for (int i = 0; i < 1000000; i++)
+    {
+        CObject* obj = static_cast<CObject*>(m_iMan->SearchInstance(CLASS_OBJECT, i));
+        if (obj == nullptr) break;
+
+        CBotVar* var = obj->GetBotVar();
+        if (var != nullptr)
+            var->Maj(obj, false);
+    }
+}
+
+void CScriptScheduler::StartThreads(int count)
+{
+    m_quit = false;
+    m_startFrame = m_frame;
+
+    for (int i = 0; i < count; i++)
+    {
+        SDL_Thread* thread = SDL_CreateThread(WorkerThread, this);
+        if (thread == nullptr)
+        {
+            GetLogger()->Error("Could not create script worker thread: %s\n", SDL_GetError());
+            break;
+        }
+        m_private->threads.push_back(thread);
+    }
+
+    GetLogger()->Info("Running programs on %d worker threads\n", GetThreadCount());
+}
+
+void CScriptScheduler::StopThreads()
+{
+    if (m_private->threads.empty())
+        return;
+
+    SDL_LockMutex(m_private->mutex);
+    m_quit = true;
+    SDL_CondBroadcast(m_private->startCond);
+    SDL_UnlockMutex(m_private->mutex);
+
+    for (int i = 0; i < static_cast<int>( m_private->threads.size() ); i++)
+        SDL_WaitThread(m_private->threads[i], nullptr);
+
+    m_private->threads.clear();
+}
+
@@ -0,0 +1,184 @@
+// * This file is part of the COLOBOT source code
+// * Copyright (C) 2012, Polish Portal of Colobot (PPC)
+// *
+// * This program is free software: you can redistribute it and/or modify
+// * it under the terms of the GNU General Public License as published by
+// * the Free Software Foundation, either version 3 of the License, or
+// * (at your option) any later version.
+// *
+// * This program is distributed in the hope that it will be useful,
+// * but WITHOUT ANY WARRANTY; without even the implied warranty of
+// * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// * GNU General Public License for more details.
+// *
+// * You should have received a copy of the GNU General Public License
+// * along with this program. If not, see  http://www.gnu.org/licenses/.
+
+/**
+ * \file script/scriptscheduler.h
+ * \brief CScriptScheduler - parallel execution of robot programs
+ */
+
+#pragma once
+
+
+#include "common/event.h"
+#include "common/singleton.h"
+
+#include <vector>
+
+
+class CInstanceManager;
+class CBrain;
+class CObject;
+class CScript;
+
+struct ScriptSchedulerPrivate;
+
+
+//! Default frame time kept by limiting the instructions of programs (in ms)
+const float SCRIPT_FRAME_TIME = 1000.0f / 30.0f;
+//! Part of the frame time always left to programs, however slow the rest of the frame
+const float SCRIPT_MIN_HEADROOM = 0.1f;
+//! Minimum number of instructions of a program per frame
+const int   SCRIPT_MIN_QUOTA = 10;
+//! Weight of the last frame in the measured speed of programs
+const float SCRIPT_SPEED_SMOOTH = 0.1f;
+
+
+/**
+ * \struct ScheduledScript
+ * \brief Program slice queued for the current frame
+ */
+struct ScheduledScript
+{
+    //! Brain running the program
+    CBrain*     brain;
+    //! Running program; \c nullptr if it was destroyed meanwhile
+    CScript*    script;
+};
+
+/**
+ * \class CScriptScheduler
+ * \brief Runs the program slices of all robots on worker threads
+ *
+ * Instead of advancing its program right away, each CBrain queues it here
+ * during EVENT_FRAME. Once all objects are processed, CRobotMain calls Execute(),
+ * which runs the queued slices on the worker threads and on the main thread.
+ * Nothing else happens meanwhile, so the world does not change and functions
+ * which only read it (see CScript::InitFonctions()) are called right there.
+ * Other functions (move, goto, grab, fire...) stop the program in the worker
+ * thread; it is then resumed serially at the frame barrier, in queue order,
+ * with the rest of its instructions for this frame.
+ *
+ * Programs which can share data through static class members
+ * or synchronized methods are all run on the main thread.
+ *
+ * With thread count 0 (the default), brains run their programs
+ * on the main thread as before.
+ *
+ * The scheduler also shares out the CBot instructions of each frame.
+ * BeginFrame() measures how many instructions the programs run per ms
+ * and how much of the frame time (see SetFrameTime()) the rest of the
+ * frame leaves them; this gives the budget of the frame. Programs of the
+ * selected robot and programs waiting in a function such as "move" or
+ * "goto" keep the quota asked with ipf(); all others get the same part
+ * of their quota, so that the budget is kept (but never less than
+ * SCRIPT_MIN_QUOTA instructions). Programs never get more than their quota.
+ */
+class CScriptScheduler : public CSingleton<CScriptScheduler>
+{
+public:
+    CScriptScheduler(CInstanceManager* iMan);
+    ~CScriptScheduler();
+
+    //! Sets the number of worker threads, 0 disables parallel execution
+    void        SetThreadCount(int count);
+    //! Returns the number of worker threads
+    int         GetThreadCount();
+
+    //! Queues the program slice for this frame; returns false if it must be run right away
+    bool        AddScript(CBrain* brain, CScript* script, const Event &event);
+    //! Removes a script being destroyed from the queue
+    void        RemoveScript(CScript* script);
+
+    //! Runs all queued program slices and completes them on the main thread
+    void        Execute();
+
+    //! Sets the frame time to keep (in ms), 0 gives programs their whole quota
+    void        SetFrameTime(float time);
+    //! Returns the frame time to keep (in ms)
+    float       GetFrameTime();
+
+    //! Computes the instruction budget of the frame which begins
+    void        BeginFrame(CObject* selected);
+    //! Returns the instructions a program may run in this frame, out of its quota \a ipf
+    int         GetQuota(CObject* object, int ipf, bool blocked);
+    //! Adds CBot instructions run by a program; only on the main thread
+    void        AddSteps(CObject* object, int ipf, bool blocked, int steps);
+
+    //! Returns the number of CBot instructions run since the scheduler was created
+    long long   GetStatisticSteps();
+    //! Returns the instruction budget of the frame, -1 if unlimited
+    int         GetBudget();
+    //! Writes the budget and the speed of each running program to the log
+    void        LogStatistics();
+
+protected:
+    //! Whether a program keeps its whole quota
+    bool        IsPriority(CObject* object, bool blocked);
+
+    //! Entry point of worker threads
+    static int  WorkerThread(void* data);
+    //! Waits for frames and takes part in them, until the threads are stopped
+    void        WorkerLoop();
+    //! Runs queued slices until none is left
+    void        RunSlices();
+    //! Updates the CBot variables of all objects before the worker threads read them
+    void        UpdateObjects();
+
+    //! Starts given number of worker threads
+    void        StartThreads(int count);
+    //! Stops all worker threads
+    void        StopThreads();
+
+protected:
+    CInstanceManager*   m_iMan;
+    //! SDL threads and synchronization
+    ScriptSchedulerPrivate* m_private;
+
+    //! Slices queued for this frame
+    std::vector<ScheduledScript> m_queue;
+    //! Event of the current frame
+    Event       m_event;
+    //! Index of the next slice to run
+    int         m_nextSlice;
+    //! Number of worker threads still running slices
+    int         m_busyThreads;
+    //! Counter of frames run in parallel, to wake worker threads
+    int         m_frame;
+    //! Value of m_frame when the worker threads were started
+    int         m_startFrame;
+    //! Whether worker threads must exit
+    bool        m_quit;
+    //! Number of CBot instructions run
+    long long   m_statisticSteps;
+
+    //! Frame time to keep (in ms), 0 for no budget
+    float       m_frameTime;
+    //! Selected object of the current frame
+    CObject*    m_selected;
+    //! Instruction budget of the current frame, -1 if unlimited
+    int         m_budget;
+    //! Part of their quota given to programs without priority
+    float       m_scale;
+    //! Measured speed of programs, in instructions per ms (0 = unknown)
+    float       m_stepsPerMs;
+    //! Instructions run in the current frame
+    int         m_frameSteps;
+    //! Instructions run in the current frame by programs with priority
+    int         m_framePriority;
+    //! Sum of the quotas of the other programs run in the current frame
+    int         m_frameDemand;
+};
+
@@ -108,7 +108,7 @@ void CCheck::Draw()
         DrawShadow(m_pos, m_dim);
     }
 
-    m_engine->SetTexture("button1.png");
+    SetTexture("button1.png");
     m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
 
     zoomExt = 1.00f;
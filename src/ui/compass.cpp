@@ -89,7 +89,7 @@ void CCompass::Draw()
 
     device = m_engine->GetDevice();
 
-    m_engine->SetTexture("button2.png");
+    SetTexture("button2.png");
     m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
 
     p1.x = m_pos.x;
@@ -118,6 +118,7 @@ void CCompass::Draw()
     vertex[2] = Gfx::Vertex(Math::Vector(p2.x, p1.y, 0.0f), n, Math::Point(uv2.x, uv2.y));
     vertex[3] = Gfx::Vertex(Math::Vector(p2.x, p2.y, 0.0f), n, Math::Point(uv2.x, uv1.y));
 
+    MapTexCoords(vertex, 4);
     device->DrawPrimitive(Gfx::PRIMITIVE_TRIANGLE_STRIP, vertex, 4);
     m_engine->AddStatisticTriangle(2);
 
@@ -152,6 +153,7 @@ void CCompass::Draw()
         vertex[1] = Gfx::Vertex(Math::Vector(p2.x, p2.y, 0.0f), n, Math::Point(uv1.x, uv2.y));
         vertex[2] = Gfx::Vertex(Math::Vector(p3.x, p3.y, 0.0f), n, Math::Point(uv2.x, uv2.y));
 
+        MapTexCoords(vertex, 3);
         device->DrawPrimitive(Gfx::PRIMITIVE_TRIANGLES, vertex, 3);
         m_engine->AddStatisticTriangle(1);
     }
@@ -426,6 +426,24 @@ void CControl::GlintFrame(const Event &event)
 }
 
 
+// Binds a texture; images of the interface atlas are bound as a region
+// of the atlas, and DrawIcon maps its texture coordinates to it.
+
+void CControl::SetTexture(const std::string& name)
+{
+    m_engine->SetInterfaceTexture(name, m_texRegion);
+}
+
+// Maps texture coordinates given for the whole texture to the region
+// of the last texture bound by SetTexture.
+
+void CControl::MapTexCoords(Gfx::Vertex* vertex, int count)
+{
+    for (int i = 0; i < count; i++)
+        vertex[i].texCoord = m_texRegion.Map(vertex[i].texCoord);
+}
+
+
 // Draw button.
 
 void CControl::Draw()
@@ -436,7 +454,7 @@ void CControl::Draw()
 
     if ( (m_state & STATE_VISIBLE) == 0 )  return;
 
-    m_engine->SetTexture("button1.png");
+    SetTexture("button1.png");
     m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
 
     zoomExt = 1.00f;
@@ -490,7 +508,7 @@ void CControl::Draw()
 
     if ( m_state & STATE_OKAY )
     {
-        m_engine->SetTexture("button3.png");
+        SetTexture("button3.png");
         icon = 3;  // yellow with green point pressed
     }
 
@@ -506,22 +524,22 @@ void CControl::Draw()
         {
             icon -= 192;
 #if _POLISH
-            m_engine->SetTexture("textp.png");
+            SetTexture("textp.png");
 #else
-            m_engine->SetTexture("text.png");
+            SetTexture("text.png");
 #endif
             m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_WHITE);
         }
         else if ( icon >= 128 )
         {
             icon -= 128;
-            m_engine->SetTexture("button3.png");
+            SetTexture("button3.png");
             m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_WHITE);
         }
         else if ( icon >= 64 )
         {
             icon -= 64;
-            m_engine->SetTexture("button2.png");
+            SetTexture("button2.png");
             m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_WHITE);
         }
         else
@@ -635,6 +653,7 @@ void CControl::DrawIcon(Math::Point pos, Math::Point dim, Math::Point uv1, Math:
         vertex[2] = Gfx::Vertex(Math::Vector(p2.x, p1.y, 0.0f), n, Math::Point(uv2.x,uv2.y));
         vertex[3] = Gfx::Vertex(Math::Vector(p2.x, p2.y, 0.0f), n, Math::Point(uv2.x,uv1.y));
 
+        MapTexCoords(vertex, 4);
         device->DrawPrimitive(Gfx::PRIMITIVE_TRIANGLE_STRIP, vertex, 4);
         m_engine->AddStatisticTriangle(2);
     }
@@ -654,6 +673,7 @@ void CControl::DrawIcon(Math::Point pos, Math::Point dim, Math::Point uv1, Math:
             vertex[6] = Gfx::Vertex(Math::Vector(p2.x, p1.y, 0.0f), n, Math::Point(uv2.x,   uv2.y));
             vertex[7] = Gfx::Vertex(Math::Vector(p2.x, p2.y, 0.0f), n, Math::Point(uv2.x,   uv1.y));
 
+            MapTexCoords(vertex, 8);
             device->DrawPrimitive(Gfx::PRIMITIVE_TRIANGLE_STRIP, vertex, 8);
             m_engine->AddStatisticTriangle(6);
         }
@@ -671,6 +691,7 @@ void CControl::DrawIcon(Math::Point pos, Math::Point dim, Math::Point uv1, Math:
             vertex[6] = Gfx::Vertex(Math::Vector(p2.x, p2.y, 0.0f), n, Math::Point(uv2.x, uv1.y     ));
             vertex[7] = Gfx::Vertex(Math::Vector(p1.x, p2.y, 0.0f), n, Math::Point(uv1.x, uv1.y     ));
 
+            MapTexCoords(vertex, 8);
             device->DrawPrimitive(Gfx::PRIMITIVE_TRIANGLE_STRIP, vertex, 8);
             m_engine->AddStatisticTriangle(6);
         }
@@ -717,6 +738,7 @@ void CControl::DrawIcon(Math::Point pos, Math::Point dim, Math::Point uv1, Math:
     vertex[5] = Gfx::Vertex(Math::Vector(p4.x, p3.y, 0.0f), n, Math::Point(uv2.x - ex, uv2.y - ex));
     vertex[6] = Gfx::Vertex(Math::Vector(p2.x, p1.y, 0.0f), n, Math::Point(uv2.x,      uv2.y     ));
     vertex[7] = Gfx::Vertex(Math::Vector(p2.x, p3.y, 0.0f), n, Math::Point(uv2.x,      uv2.y - ex));
+    MapTexCoords(vertex, 8);
     device->DrawPrimitive(Gfx::PRIMITIVE_TRIANGLE_STRIP, vertex, 8);
     m_engine->AddStatisticTriangle(6);
 
@@ -729,6 +751,7 @@ void CControl::DrawIcon(Math::Point pos, Math::Point dim, Math::Point uv1, Math:
     vertex[5] = Gfx::Vertex(Math::Vector(p4.x, p4.y, 0.0f), n, Math::Point(uv2.x - ex, uv1.y + ex));
     vertex[6] = Gfx::Vertex(Math::Vector(p2.x, p3.y, 0.0f), n, Math::Point(uv2.x,      uv2.y - ex));
     vertex[7] = Gfx::Vertex(Math::Vector(p2.x, p4.y, 0.0f), n, Math::Point(uv2.x,      uv1.y + ex));
+    MapTexCoords(vertex, 8);
     device->DrawPrimitive(Gfx::PRIMITIVE_TRIANGLE_STRIP, vertex, 8);
     m_engine->AddStatisticTriangle(6);
 
@@ -741,6 +764,7 @@ void CControl::DrawIcon(Math::Point pos, Math::Point dim, Math::Point uv1, Math:
     vertex[5] = Gfx::Vertex(Math::Vector(p4.x, p2.y, 0.0f), n, Math::Point(uv2.x - ex, uv1.y   ));
     vertex[6] = Gfx::Vertex(Math::Vector(p2.x, p4.y, 0.0f), n, Math::Point(uv2.x,      uv1.y + ex));
     vertex[7] = Gfx::Vertex(Math::Vector(p2.x, p2.y, 0.0f), n, Math::Point(uv2.x,      uv1.y   ));
+    MapTexCoords(vertex, 8);
     device->DrawPrimitive(Gfx::PRIMITIVE_TRIANGLE_STRIP, vertex, 8);
     m_engine->AddStatisticTriangle(6);
 }
@@ -754,7 +778,7 @@ void CControl::DrawWarning(Math::Point pos, Math::Point dim)
 
     dp = 0.5f / 256.0f;
 
-    m_engine->SetTexture("button2.png");
+    SetTexture("button2.png");
     m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
 
     uv1.x =  64.0f / 256.0f;
@@ -798,7 +822,7 @@ void CControl::DrawShadow(Math::Point pos, Math::Point dim, float deep)
 
     dp = 0.5f/256.0f;
 
-    m_engine->SetTexture("button2.png");
+    SetTexture("button2.png");
     m_engine->SetState( Gfx::ENG_RSTATE_TTEXTURE_WHITE);
 
     pos.x += deep * 0.010f * 0.75f;
@@ -106,6 +106,8 @@ namespace Ui {
                 void    GlintDelete();
                 void    GlintCreate(Math::Point ref, bool bLeft=true, bool bUp=true);
                 void    GlintFrame(const Event &event);
+                void    SetTexture(const std::string& name);
+                void    MapTexCoords(Gfx::Vertex* vertex, int count);
                 void    DrawPart(int icon, float zoom, float ex);
                 void    DrawIcon(Math::Point pos, Math::Point dim, Math::Point uv1, Math::Point uv2, float ex=0.0f);
                 void    DrawIcon(Math::Point pos, Math::Point dim, Math::Point uv1, Math::Point uv2, Math::Point corner, float ex);
@@ -136,6 +138,8 @@ namespace Ui {
         bool              m_bFocus;
         bool              m_bCapture;
 
+        Gfx::TextureRegion m_texRegion;   // part of the bound texture used by DrawIcon (see SetTexture)
+
         bool              m_bGlint;
         Math::Point       m_glintCorner1;
         Math::Point       m_glintCorner2;
@@ -21,6 +21,7 @@
 #include "ui/edit.h"
 
 #include <string.h>
+#include <vector>
 
 namespace Ui {
 
@@ -82,6 +83,17 @@ CEdit::CEdit () : CControl ()
     m_len = 0;
 
     memset(m_lineOffset, 0, sizeof(int) * EDITLINEMAX);
+    m_lineTotal = 0;
+
+    m_layoutStart    = 0;  // all the layout to do
+    m_layoutTail     = 0;
+    m_layoutLen      = 0;
+    m_layoutWidth    = 0.0f;
+    m_layoutIndent   = 0.0f;
+    m_layoutFontSize = 0.0f;
+    m_layoutFontType = Gfx::FONT_COURIER;
+    m_bLayoutFormat  = false;
+    m_textReset      = 0;
 
     m_fontType = Gfx::FONT_COURIER;
     m_scroll        = 0;
@@ -687,6 +699,7 @@ void CEdit::MouseMove(Math::Point mouse)
 
 int CEdit::MouseDetect(Math::Point mouse)
 {
+    std::map<unsigned int, Gfx::FontMetaChar> format;
     Math::Point pos;
     float   indentLength, offset, size;
     int     i, len, c;
@@ -723,7 +736,7 @@ int CEdit::MouseDetect(Math::Point mouse)
 //                c = m_engine->GetText()->Detect(m_text+m_lineOffset[i],
 //                                                len, offset, m_fontSize,
 //                                                m_fontStretch, m_fontType);
-                c = m_engine->GetText()->Detect(std::string(m_text+m_lineOffset[i]).substr(0, len), m_fontType, m_fontSize, offset); // TODO check if good
+                c = m_engine->GetText()->Detect(std::string(m_text+m_lineOffset[i], len), m_fontType, m_fontSize, offset);
             }
             else
             {
@@ -734,10 +747,11 @@ int CEdit::MouseDetect(Math::Point mouse)
 //                                                m_format+m_lineOffset[i],
 //                                                len, offset, size,
 //                                                m_fontStretch);
-                c = m_engine->GetText()->Detect(std::string(m_text+m_lineOffset[i]).substr(0, len),
-                                                m_format,
+                GetLineFormat(m_lineOffset[i], len, format);
+                c = m_engine->GetText()->Detect(std::string(m_text+m_lineOffset[i], len),
+                                                format,
                                                 size,
-                                                offset); // TODO check if good
+                                                offset);
             }
             return m_lineOffset[i]+c;
         }
@@ -886,6 +900,7 @@ bool CEdit::HyperGo(EventType event)
 
 void CEdit::Draw()
 {
+    std::map<unsigned int, Gfx::FontMetaChar> format;
     Math::Point     pos, ppos, dim, start, end;
     float       size, indentLength;
     int         i, j, beg, len, c1, c2, o1, o2, eol, iIndex, line;
@@ -1028,16 +1043,18 @@ void CEdit::Draw()
 
             if ( m_format.size() == 0 )
             {
-                start.x = ppos.x+m_engine->GetText()->GetStringWidth(std::string(m_text+beg).substr(0, o1-beg), m_fontType, size);
-                end.x   = m_engine->GetText()->GetStringWidth(std::string(m_text+o1).substr(0, o2-o1), m_fontType, size);
+                start.x = ppos.x+m_engine->GetText()->GetStringWidth(std::string(m_text+beg, o1-beg), m_fontType, size);
+                end.x   = m_engine->GetText()->GetStringWidth(std::string(m_text+o1, o2-o1), m_fontType, size);
             }
             else
             {
-                start.x = ppos.x+m_engine->GetText()->GetStringWidth(std::string(m_text+beg).substr(0, o1-beg),
-                                                                     m_format,
+                GetLineFormat(beg, o1-beg, format);
+                start.x = ppos.x+m_engine->GetText()->GetStringWidth(std::string(m_text+beg, o1-beg),
+                                                                     format,
                                                                      size);
-                end.x   = m_engine->GetText()->GetStringWidth(std::string(m_text+o1).substr(0, o2-o1),
-                                                              m_format,
+                GetLineFormat(o1, o2-o1, format);
+                end.x   = m_engine->GetText()->GetStringWidth(std::string(m_text+o1, o2-o1),
+                                                              format,
                                                               size);
             }
 
@@ -1060,12 +1077,13 @@ void CEdit::Draw()
         if ( !m_bMulti || !m_bDisplaySpec )  eol = 0;
         if ( m_format.size() == 0 )
         {
-            m_engine->GetText()->DrawText(std::string(m_text+beg).substr(0, len), m_fontType, size, ppos, m_dim.x, Gfx::TEXT_ALIGN_LEFT, eol);
+            m_engine->GetText()->DrawText(std::string(m_text+beg, len), m_fontType, size, ppos, m_dim.x, Gfx::TEXT_ALIGN_LEFT, eol);
         }
         else
         {
-            m_engine->GetText()->DrawText(std::string(m_text+beg).substr(0, len),
-                                          m_format,
+            GetLineFormat(beg, len, format);
+            m_engine->GetText()->DrawText(std::string(m_text+beg, len),
+                                          format,
                                           size,
                                           ppos,
                                           m_dim.x,
@@ -1097,17 +1115,19 @@ void CEdit::Draw()
                 }
 
                 len = m_cursor1 - m_lineOffset[i];
+                if ( len < 0 )  len = 0;  // cursor above the first visible line?
 
                 if ( m_format.size() == 0 )
                 {
-                    m_engine->GetText()->SizeText(std::string(m_text+m_lineOffset[i]).substr(0, len), m_fontType,
+                    m_engine->GetText()->SizeText(std::string(m_text+m_lineOffset[i], len), m_fontType,
                                                   size, pos, Gfx::TEXT_ALIGN_LEFT,
                                                   start, end);
                 }
                 else
                 {
-                    m_engine->GetText()->SizeText(std::string(m_text+m_lineOffset[i]).substr(0, len),
-                                                  m_format,
+                    GetLineFormat(m_lineOffset[i], len, format);
+                    m_engine->GetText()->SizeText(std::string(m_text+m_lineOffset[i], len),
+                                                  format,
                                                   size, pos, Gfx::TEXT_ALIGN_LEFT,
                                                   start, end);
                 }
@@ -1142,7 +1162,7 @@ void CEdit::DrawImage(Math::Point pos, const char *name, float width,
     UserDir(filename, name, "diagram");
     strcat(filename, ".png");
 
-    m_engine->SetTexture(filename);
+    SetTexture(filename);
     m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
 
     uv1.x = 0.0f;
@@ -1170,7 +1190,7 @@ void CEdit::DrawBack(Math::Point pos, Math::Point dim)
 
     if ( m_bGeneric )  return;
 
-    m_engine->SetTexture("button2.png");
+    SetTexture("button2.png");
     m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
 
     if ( m_bMulti )
@@ -1221,9 +1241,9 @@ void CEdit::DrawPart(Math::Point pos, Math::Point dim, int icon)
     float       dp;
 
 #if _POLISH
-    m_engine->SetTexture("textp.png");
+    SetTexture("textp.png");
 #else
-    m_engine->SetTexture("text.png");
+    SetTexture("text.png");
 #endif
     m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
 
@@ -1251,6 +1271,9 @@ void CEdit::SetText(const char *text, bool bNew)
     
     if ( !bNew )  UndoMemorize(OPERUNDO_SPEC);
 
+    LayoutChange(0, 0);
+    m_textReset ++;
+
     m_len = strlen(text);
     if ( m_len > m_maxChar )  m_len = m_maxChar;
 
@@ -1478,6 +1501,9 @@ bool CEdit::ReadText(const char *filename, int addSize)
     m_cursor1 = 0;
     m_cursor2 = 0;
 
+    LayoutChange(0, 0);
+    m_textReset ++;
+
     FreeImage();
 
     if (m_text != nullptr)
@@ -1963,6 +1989,8 @@ void CEdit::SetMaxChar(int max)
     m_len = 0;
     m_cursor1 = 0;
     m_cursor2 = 0;
+    LayoutChange(0, 0);
+    m_textReset ++;
     Justif();
     UndoFlush();
 }
@@ -2147,6 +2175,7 @@ bool CEdit::GetDisplaySpec()
 void CEdit::SetMultiFont(bool bMulti)
 {
     m_format.clear();
+    LayoutChange(0, 0);
 }
 
 // TODO check if it works correctly; was checking if variable is null
@@ -2395,8 +2424,9 @@ void CEdit::MoveChar(int move, bool bWord, bool bSelect)
 
 void CEdit::MoveLine(int move, bool bWord, bool bSelect)
 {
+    std::map<unsigned int, Gfx::FontMetaChar> format;
     float   column, indentLength;
-    int     i, line, c;
+    int     i, line, len, c;
 
     if ( move == 0 )  return;
 
@@ -2441,18 +2471,18 @@ void CEdit::MoveLine(int move, bool bWord, bool bSelect)
         column -= indentLength*m_lineIndent[line];
     }
 
+    len = m_lineOffset[line+1]-m_lineOffset[line];
     if ( m_format.size() == 0 )
     {
-        c = m_engine->GetText()->Detect(std::string(m_text+m_lineOffset[line]),
-                                        m_fontType, m_fontSize,
-                                        m_lineOffset[line+1]-m_lineOffset[line]);
+        c = m_engine->GetText()->Detect(std::string(m_text+m_lineOffset[line], len),
+                                        m_fontType, m_fontSize, column);
     }
     else
     {
-        c = m_engine->GetText()->Detect(std::string(m_text+m_lineOffset[line]),
-                                        m_format,
-                                        m_fontSize,
-                                        m_lineOffset[line+1]-m_lineOffset[line]);
+        GetLineFormat(m_lineOffset[line], len, format);
+        c = m_engine->GetText()->Detect(std::string(m_text+m_lineOffset[line], len),
+                                        format,
+                                        m_fontSize, column);
     }
 
     m_cursor1 = m_lineOffset[line]+c;
@@ -2466,22 +2496,25 @@ void CEdit::MoveLine(int move, bool bWord, bool bSelect)
 
 void CEdit::ColumnFix()
 {
+    std::map<unsigned int, Gfx::FontMetaChar> format;
     float   indentLength;
-    int     line;
+    int     line, len;
 
     line = GetCursorLine(m_cursor1);
 
+    len = m_cursor1-m_lineOffset[line];
     if ( m_format.size() == 0 )
     {
         m_column = m_engine->GetText()->GetStringWidth(
-                                std::string(m_text+m_lineOffset[line]),
+                                std::string(m_text+m_lineOffset[line], len),
                                 m_fontType, m_fontSize);
     }
     else
     {
+        GetLineFormat(m_lineOffset[line], len, format);
         m_column = m_engine->GetText()->GetStringWidth(
-                                std::string(m_text+m_lineOffset[line]),
-                                m_format,
+                                std::string(m_text+m_lineOffset[line], len),
+                                format,
                                 m_fontSize
                             );
     }
@@ -2819,24 +2852,25 @@ void CEdit::InsertOne(char character)
 
     if ( m_len >= m_maxChar )  return;
 
-    for ( i=m_len ; i>=m_cursor1 ; i-- )
+    for ( i=m_len ; i>m_cursor1 ; i-- )
     {
         m_text[i] = m_text[i-1];  // shoot
+    }
 
-        //if ( m_format.size() > 0 )
-        //{
+    // Moves the formats, if any: a text without formats keeps none
+    if ( m_format.size() > 0 )
+    {
+        for ( i=m_len ; i>m_cursor1 ; i-- )
+        {
             m_format[i] = m_format[i-1];  // shoot
-        //}
+        }
+        m_format[m_cursor1] = m_fontType;
     }
 
     m_len ++;
 
     m_text[m_cursor1] = character;
-
-    //if ( m_format.size() > 0 )
-    //{
-        m_format[m_cursor1] = 0;
-    //}
+    LayoutChange(m_cursor1, m_len-m_cursor1-1);
 
     m_cursor1++;
     m_cursor2 = m_cursor1;
@@ -2891,6 +2925,7 @@ void CEdit::DeleteOne(int dir)
     }
     m_len -= hole;
     m_cursor2 = m_cursor1;
+    LayoutChange(m_cursor1, m_len-m_cursor1);
 }
 
 
@@ -3036,6 +3071,7 @@ bool CEdit::MinMaj(bool bMaj)
         else         character = GetToLower(character);
         m_text[i] = character;
     }
+    LayoutChange(c1, m_len-c2);
 
     Justif();
     ColumnFix();
@@ -3048,40 +3084,134 @@ bool CEdit::MinMaj(bool bMaj)
 
 void CEdit::Justif()
 {
-    float   width, size, indentLength;
-    int     i, j, line, indent;
-    bool    bDual, bString, bRem;
-
-    indent = 0;
-    m_lineTotal = 0;
-    m_lineOffset[m_lineTotal] = 0;
-    m_lineIndent[m_lineTotal] = indent;
-    m_lineTotal ++;
+    float   width, indentLength;
+    int     line;
 
+    indentLength = 0.0f;
     if ( m_bAutoIndent )
     {
         indentLength = m_engine->GetText()->GetCharWidth(static_cast<Gfx::UTF8Char>(' '), m_fontType, m_fontSize, 0.0f)
                         * m_engine->GetEditIndentValue();
     }
+    width = m_dim.x-(10.0f/640.0f)*2.0f-(m_bMulti?MARGX*2.0f+SCROLL_WIDTH:0.0f);
+
+    // Anything else than the text changed: all lines must be cut again
+    if ( width         != m_layoutWidth    ||
+         indentLength  != m_layoutIndent   ||
+         m_fontSize    != m_layoutFontSize ||
+         m_fontType    != m_layoutFontType ||
+         (m_format.size() > 0) != m_bLayoutFormat )
+    {
+        LayoutChange(0, 0);
+        m_layoutWidth    = width;
+        m_layoutIndent   = indentLength;
+        m_layoutFontSize = m_fontSize;
+        m_layoutFontType = m_fontType;
+        m_bLayoutFormat  = (m_format.size() > 0);
+    }
+
+    if ( m_layoutStart >= 0 )
+    {
+        JustifLines(width, indentLength);
+        m_layoutStart = -1;
+        m_layoutLen = m_len;
+    }
 
+    if ( m_bMulti )
+    {
+        if ( m_bEdit )
+        {
+            line = GetCursorLine(m_cursor1);
+            if ( line < m_lineFirst )
+            {
+                m_lineFirst = line;
+            }
+            if ( line >= m_lineFirst+m_lineVisible )
+            {
+                m_lineFirst = line-m_lineVisible+1;
+            }
+        }
+    }
+    else
+    {
+        m_lineFirst = 0;
+    }
+
+    UpdateScroll();
+
+    m_timeBlink = 0.0f;  // lights the cursor immediately
+}
+
+// Cuts again the lines touched by the changes since the last Justif().
+// The lines before the first changed paragraph are kept, and the cutting
+// stops as soon as it joins a line of the unchanged end of the text.
+
+void CEdit::JustifLines(float width, float indentLength)
+{
+    std::map<unsigned int, Gfx::FontMetaChar> format;
+    std::vector<int>    oldOffset;
+    std::vector<char>   oldIndent, oldLevel;
+    float   lineWidth, size;
+    int     i, j, k, len, indent, first, delta;
+    bool    bDual, bString, bRem;
+
+    // Searches the last unchanged line beginning a paragraph.
+    k = 0;
+    if ( m_layoutStart > 0 )
+    {
+        for ( i=1 ; i<m_lineTotal ; i++ )
+        {
+            if ( m_lineOffset[i] > m_layoutStart   )  break;
+            if ( m_lineOffset[i] >= m_layoutLen    )  break;
+            if ( m_lineOffset[i] >= m_len          )  break;
+            if ( m_lineOffset[i] == m_lineOffset[i-1] )  continue;  // 2nd line of a headline?
+            if ( m_text[m_lineOffset[i]-1] == '\n' )  k = i;
+        }
+    }
+
+    // Keeps the old lines following it, to join them.
+    for ( i=k ; i<m_lineTotal ; i++ )
+    {
+        oldOffset.push_back(m_lineOffset[i]);
+        oldIndent.push_back(m_lineIndent[i]);
+        oldLevel.push_back(m_lineLevel[i]);
+    }
+    delta = m_len-m_layoutLen;
+
+    indent = (k == 0) ? 0 : m_lineLevel[k];
+    i = m_lineOffset[k];
+    m_lineTotal = k;
+    m_lineOffset[m_lineTotal] = i;
+    m_lineIndent[m_lineTotal] = indent;
+    m_lineLevel[m_lineTotal] = indent;
+    m_lineTotal ++;
+
+    first = -1;
     bString = bRem = false;
-    i = 0;
     while ( true )
     {
         bDual = false;
 
-        width = m_dim.x-(10.0f/640.0f)*2.0f-(m_bMulti?MARGX*2.0f+SCROLL_WIDTH:0.0f);
+        lineWidth = width;
         if ( m_bAutoIndent )
         {
-            width -= indentLength*m_lineIndent[m_lineTotal-1];
+            lineWidth -= indentLength*m_lineIndent[m_lineTotal-1];
         }
 
-        if ( m_format.size() == 0 )
+        // A line never goes past the end of its paragraph.
+        for ( len=0 ; i+len<m_len ; len++ )
         {
-            // TODO check if good
+            if ( m_text[i+len] != '\n' )  continue;
+            if ( m_format.size() > 0 && m_format.count(i+len) &&
+                 (m_format[i+len]&Gfx::FONT_MASK_FONT) == Gfx::FONT_BUTTON )  continue;
+            len ++;
+            break;
+        }
 
-            i += m_engine->GetText()->Justify(m_text+i, m_fontType,
-                                              m_fontSize, width);
+        if ( m_format.size() == 0 )
+        {
+            i += m_engine->GetText()->Justify(std::string(m_text+i, len), m_fontType,
+                                              m_fontSize, lineWidth);
         }
         else
         {
@@ -3099,11 +3229,11 @@ void CEdit::Justif()
             }
             else
             {
-                // TODO check if good
-                i += m_engine->GetText()->Justify(std::string(m_text+i),
-                                                  m_format,
+                GetLineFormat(i, len, format);
+                i += m_engine->GetText()->Justify(std::string(m_text+i, len),
+                                                  format,
                                                   size,
-                                                  width);
+                                                  lineWidth);
             }
         }
 
@@ -3124,61 +3254,106 @@ void CEdit::Justif()
             if ( indent < 0 )  indent = 0;
         }
 
+        // Joins the old lines when a paragraph of the unchanged end begins here.
+        if ( !bDual && i > m_len-m_layoutTail && m_text[i-1] == '\n' )
+        {
+            for ( j=1 ; j<static_cast<int>( oldOffset.size() ) ; j++ )
+            {
+                if ( oldOffset[j]+delta < i )  continue;
+                if ( oldOffset[j]+delta == i      &&
+                     oldOffset[j] < m_layoutLen   &&
+                     oldOffset[j] != oldOffset[j-1] &&
+                     oldLevel[j] == indent )
+                {
+                    first = j;
+                }
+                break;
+            }
+        }
+
+        if ( first >= 0 )
+        {
+            j = first;
+            first = m_lineTotal;  // first joined line
+            for ( ; j<static_cast<int>( oldOffset.size() ) ; j++ )
+            {
+                if ( oldOffset[j] >= m_layoutLen )  break;
+                m_lineOffset[m_lineTotal] = oldOffset[j]+delta;
+                m_lineIndent[m_lineTotal] = oldIndent[j];
+                m_lineLevel[m_lineTotal] = oldLevel[j];
+                m_lineTotal ++;
+                if ( m_lineTotal >= EDITLINEMAX-2 )  break;
+            }
+            break;
+        }
+
         m_lineOffset[m_lineTotal] = i;
         m_lineIndent[m_lineTotal] = indent;
+        m_lineLevel[m_lineTotal] = indent;
         m_lineTotal ++;
         if ( bDual )
         {
             m_lineOffset[m_lineTotal] = i;
             m_lineIndent[m_lineTotal] = indent;
+            m_lineLevel[m_lineTotal] = indent;
             m_lineTotal ++;
         }
         if ( m_lineTotal >= EDITLINEMAX-2 )  break;
     }
 
+    if ( m_bAutoIndent )
+    {
+        for ( j=k ; j<m_lineTotal ; j++ )
+        {
+            if ( first >= 0 && j >= first )  break;  // already corrected
+            if ( m_text[m_lineOffset[j]] == '}' )
+            {
+                if ( m_lineIndent[j] > 0 )  m_lineIndent[j] --;
+            }
+        }
+    }
+
     if ( m_len > 0 && m_text[m_len-1] == '\n' )
     {
         m_lineOffset[m_lineTotal] = m_len;
         m_lineIndent[m_lineTotal] = 0;
+        m_lineLevel[m_lineTotal] = 0;
         m_lineTotal ++;
     }
     m_lineOffset[m_lineTotal] = m_len;
     m_lineIndent[m_lineTotal] = 0;
+    m_lineLevel[m_lineTotal] = 0;
+}
 
-    if ( m_bAutoIndent )
-    {
-        for ( i=0 ; i<=m_lineTotal ; i++ )
-        {
-            if ( m_text[m_lineOffset[i]] == '}' )
-            {
-                if ( m_lineIndent[i] > 0 )  m_lineIndent[i] --;
-            }
-        }
-    }
+// Notes a change of the text, to cut again its lines at the next Justif().
+// start is the first changed character, tail the number of unchanged characters at the end.
 
-    if ( m_bMulti )
+void CEdit::LayoutChange(int start, int tail)
+{
+    if ( m_layoutStart < 0 )
     {
-        if ( m_bEdit )
-        {
-            line = GetCursorLine(m_cursor1);
-            if ( line < m_lineFirst )
-            {
-                m_lineFirst = line;
-            }
-            if ( line >= m_lineFirst+m_lineVisible )
-            {
-                m_lineFirst = line-m_lineVisible+1;
-            }
-        }
+        m_layoutStart = start;
+        m_layoutTail  = tail;
     }
     else
     {
-        m_lineFirst = 0;
+        if ( start < m_layoutStart )  m_layoutStart = start;
+        if ( tail  < m_layoutTail  )  m_layoutTail  = tail;
     }
+}
 
-    UpdateScroll();
+// Gives the formats of the characters of a line, indexed from the beginning of the line.
 
-    m_timeBlink = 0.0f;  // lights the cursor immediately
+void CEdit::GetLineFormat(int beg, int len, std::map<unsigned int, Gfx::FontMetaChar> &format)
+{
+    std::map<unsigned int, Gfx::FontMetaChar>::iterator it;
+
+    format.clear();
+    for ( it=m_format.lower_bound(beg) ; it!=m_format.end() ; ++it )
+    {
+        if ( static_cast<int>(it->first) >= beg+len )  break;
+        format.insert(format.end(), std::make_pair(it->first-beg, it->second));
+    }
 }
 
 // Returns the rank of the line where the cursor is located.
@@ -3258,6 +3433,8 @@ bool CEdit::UndoRecall()
 
     m_len = m_undo[0].len;
     memcpy(m_text, m_undo[0].text, m_len);
+    LayoutChange(0, 0);
+    m_textReset ++;  // the formats were not moved with the characters
 
     m_cursor1 = m_undo[0].cursor1;
     m_cursor2 = m_undo[0].cursor2;
@@ -3281,11 +3458,29 @@ bool CEdit::UndoRecall()
 
 bool CEdit::ClearFormat()
 {
-    if ( m_format.size() == 0 )
+    int     i;
+
+    m_format.clear();
+    for ( i=0 ; i<m_len ; i++ )
     {
-        SetMultiFont(true);
+        m_format.insert(m_format.end(), std::make_pair(static_cast<unsigned int>(i), static_cast<Gfx::FontMetaChar>(m_fontType)));
     }
-    m_format.clear();
+    LayoutChange(0, 0);
+
+    return true;
+}
+
+// Clears the format of a sequence of characters.
+
+bool CEdit::ClearFormat(int cursor1, int cursor2)
+{
+    int     i;
+
+    for ( i=cursor1 ; i<cursor2 ; i++ )
+    {
+        m_format[i] = m_fontType;
+    }
+    LayoutChange(cursor1, m_len-cursor2);
 
     return true;
 }
@@ -3296,17 +3491,29 @@ bool CEdit::SetFormat(int cursor1, int cursor2, int format)
 {
     int     i;
 
-    //if ( m_format.size() == 0 )  return false;
-
     for ( i=cursor1 ; i<cursor2 ; i++ )
     {
-        if (m_format.count(i))
-            m_format[i] |= format;
+        if ( !m_format.count(i) )  m_format[i] = m_fontType;
+        m_format[i] |= format;
+    }
+
+    // Colors do not change the width of characters
+    if ( (format & ~Gfx::FONT_MASK_HIGHLIGHT) != 0 )
+    {
+        LayoutChange(cursor1, m_len-cursor2);
     }
 
     return true;
 }
 
+// Returns the number of times the text was replaced as a whole (SetText, ReadText, Undo),
+// without its formats being moved with the characters.
+
+int CEdit::GetTextReset()
+{
+    return m_textReset;
+}
+
 void CEdit::UpdateScroll()
 {
     float value;
@@ -191,7 +191,9 @@ public:
     void        SetFontSize(float size);
 
     bool        ClearFormat();
+    bool        ClearFormat(int cursor1, int cursor2);
     bool        SetFormat(int cursor1, int cursor2, int format);
+    int         GetTextReset();
 
 protected:
     void        SendModifEvent();
@@ -229,6 +231,9 @@ protected:
     bool        Shift(bool bLeft);
     bool        MinMaj(bool bMaj);
     void        Justif();
+    void        JustifLines(float width, float indentLength);
+    void        LayoutChange(int start, int tail);
+    void        GetLineFormat(int beg, int len, std::map<unsigned int, Gfx::FontMetaChar> &format);
     int         GetCursorLine(int cursor);
 
     void        UndoFlush();
@@ -264,6 +269,16 @@ protected:
     int     m_lineTotal;            // number lines used (in m_lineOffset)
     int     m_lineOffset[EDITLINEMAX];
     char        m_lineIndent[EDITLINEMAX];
+    char        m_lineLevel[EDITLINEMAX];   // indentation before the correction of lines beginning with '}'
+    int         m_layoutStart;          // first character changed since the last Justif(), or -1
+    int         m_layoutTail;           // number of characters at the end not changed since the last Justif()
+    int         m_layoutLen;            // length of the text at the last Justif()
+    float       m_layoutWidth;          // width of the lines at the last Justif()
+    float       m_layoutIndent;         // width of an indentation at the last Justif()
+    float       m_layoutFontSize;       // font size at the last Justif()
+    Gfx::FontType m_layoutFontType;     // font at the last Justif()
+    bool        m_bLayoutFormat;        // true -> m_format was used by the last Justif()
+    int         m_textReset;            // number of times the text was replaced as a whole
     int     m_imageTotal;
     ImageLine   m_image[EDITIMAGEMAX];
     HyperLink   m_link[EDITLINKMAX];
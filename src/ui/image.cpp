@@ -117,7 +117,7 @@ void CImage::Draw()
 
     if ( m_icon == 0 )  // hollow frame?
     {
-        m_engine->SetTexture("button2.png");
+        SetTexture("button2.png");
         m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
         uv1.x = 160.0f / 256.0f;
         uv1.y = 192.0f / 256.0f;  // u-v texture
@@ -135,7 +135,7 @@ void CImage::Draw()
     if ( m_filename[0] != 0 )  // displays an image?
     {
         m_engine->LoadTexture(m_filename);
-        m_engine->SetTexture(m_filename);
+        SetTexture(m_filename);
         m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
         pos = m_pos;
         dim = m_dim;
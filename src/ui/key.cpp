@@ -132,7 +132,7 @@ void CKey::Draw()
         DrawShadow(m_pos, m_dim);
 
 
-    m_engine->SetTexture("button1.png");
+    SetTexture("button1.png");
     m_engine->SetState(Gfx::ENG_RSTATE_NORMAL); // was D3DSTATENORMAL
 
     float zoomExt = 1.00f;
@@ -317,7 +317,7 @@ void CMap::Draw()
         m_offset = AdjustOffset(m_map[MAPMAXOBJECT - 1].pos);
 
     if ( m_fixImage[0] == 0 ) { // drawing of the relief?
-        m_engine->SetTexture("map.png");
+        SetTexture("map.png");
         m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
         uv1.x = 0.5f + (m_offset.x - (m_half / m_zoom)) / (m_half * 2.0f);
         uv1.y = 0.5f - (m_offset.y + (m_half / m_zoom)) / (m_half * 2.0f);
@@ -326,7 +326,7 @@ void CMap::Draw()
         DrawVertex(uv1, uv2, 0.97f);  // drawing the map
     } else {   // still image?
         m_engine->LoadTexture(m_fixImage);
-        m_engine->SetTexture(m_fixImage);
+        SetTexture(m_fixImage);
         m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
         uv1.x = 0.0f;
         uv1.y = 0.0f;
@@ -457,7 +457,7 @@ void CMap::DrawFocus(Math::Point pos, float dir, ObjectType type, MapColor color
     uv2.x = 126.0f/256.0f;
     uv2.y = 255.0f/256.0f;
 
-    m_engine->SetTexture("button2.png");
+    SetTexture("button2.png");
     m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_WHITE);
 
     bEnding = false;
@@ -517,7 +517,7 @@ void CMap::DrawObject(Math::Point pos, float dir, ObjectType type, MapColor colo
             return;  // flashes
         }
 
-        m_engine->SetTexture("button2.png");
+        SetTexture("button2.png");
         m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_BLACK);
         if ( bUp )
         {
@@ -660,7 +660,7 @@ void CMap::DrawObject(Math::Point pos, float dir, ObjectType type, MapColor colo
     {
         if ( bSelect )
         {
-            m_engine->SetTexture("button2.png");
+            SetTexture("button2.png");
             m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
             if ( m_bToy )
             {
@@ -686,7 +686,7 @@ void CMap::DrawObject(Math::Point pos, float dir, ObjectType type, MapColor colo
     {
         if ( m_bRadar )
         {
-            m_engine->SetTexture("button2.png");
+            SetTexture("button2.png");
             m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_WHITE);
             uv1.x =  64.5f/256.0f;  // blue triangle
             uv1.y = 240.5f/256.0f;
@@ -706,7 +706,7 @@ void CMap::DrawObject(Math::Point pos, float dir, ObjectType type, MapColor colo
 
     if ( color == MAPCOLOR_WAYPOINTb )
     {
-        m_engine->SetTexture("button2.png");
+        SetTexture("button2.png");
         m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_BLACK);
         uv1.x = 192.5f/256.0f;  // blue cross
         uv1.y = 240.5f/256.0f;
@@ -716,7 +716,7 @@ void CMap::DrawObject(Math::Point pos, float dir, ObjectType type, MapColor colo
     }
     if ( color == MAPCOLOR_WAYPOINTr )
     {
-        m_engine->SetTexture("button2.png");
+        SetTexture("button2.png");
         m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_BLACK);
         uv1.x = 208.5f/256.0f;  // red cross
         uv1.y = 240.5f/256.0f;
@@ -726,7 +726,7 @@ void CMap::DrawObject(Math::Point pos, float dir, ObjectType type, MapColor colo
     }
     if ( color == MAPCOLOR_WAYPOINTg )
     {
-        m_engine->SetTexture("button2.png");
+        SetTexture("button2.png");
         m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_BLACK);
         uv1.x = 224.5f/256.0f;  // green cross
         uv1.y = 240.5f/256.0f;
@@ -736,7 +736,7 @@ void CMap::DrawObject(Math::Point pos, float dir, ObjectType type, MapColor colo
     }
     if ( color == MAPCOLOR_WAYPOINTy )
     {
-        m_engine->SetTexture("button2.png");
+        SetTexture("button2.png");
         m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_BLACK);
         uv1.x = 240.5f/256.0f;  // yellow cross
         uv1.y = 240.5f/256.0f;
@@ -746,7 +746,7 @@ void CMap::DrawObject(Math::Point pos, float dir, ObjectType type, MapColor colo
     }
     if ( color == MAPCOLOR_WAYPOINTv )
     {
-        m_engine->SetTexture("button2.png");
+        SetTexture("button2.png");
         m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_BLACK);
         uv1.x = 192.5f/256.0f;  // violet cross
         uv1.y = 224.5f/256.0f;
@@ -767,7 +767,7 @@ void CMap::DrawObjectIcon(Math::Point pos, Math::Point dim, MapColor color,
 
     dp = 0.5f/256.0f;
 
-    m_engine->SetTexture("button3.png");
+    SetTexture("button3.png");
     m_engine->SetState(Gfx::ENG_RSTATE_NORMAL);
     if ( color == MAPCOLOR_MOVE )
     {
@@ -882,7 +882,7 @@ void CMap::DrawHighlight(Math::Point pos)
     dim.x *= 2.0f+cosf(m_time*8.0f)*0.5f;
     dim.y *= 2.0f+cosf(m_time*8.0f)*0.5f;
 
-    m_engine->SetTexture("button2.png");
+    SetTexture("button2.png");
     m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_BLACK);
     uv1.x = 160.5f/256.0f;  // hilite
     uv1.y = 224.5f/256.0f;
@@ -905,6 +905,9 @@ void CMap::DrawTriangle(Math::Point p1, Math::Point p2, Math::Point p3, Math::Po
 
     n = Math::Vector(0.0f, 0.0f, -1.0f);  // normal
 
+    uv1 = m_texRegion.Map(uv1);
+    uv2 = m_texRegion.Map(uv2);
+
     vertex[0] = Gfx::VertexTex2(Math::Vector(p1.x, p1.y, 0.0f), n, Math::Point(uv1.x,uv1.y));
     vertex[1] = Gfx::VertexTex2(Math::Vector(p2.x, p2.y, 0.0f), n, Math::Point(uv1.x,uv2.y));
     vertex[2] = Gfx::VertexTex2(Math::Vector(p3.x, p3.y, 0.0f), n, Math::Point(uv2.x,uv2.y));
@@ -925,6 +928,9 @@ void CMap::DrawPenta(Math::Point p1, Math::Point p2, Math::Point p3, Math::Point
 
     n = Math::Vector(0.0f, 0.0f, -1.0f);  // normal
 
+    uv1 = m_texRegion.Map(uv1);
+    uv2 = m_texRegion.Map(uv2);
+
 #if 1
     vertex[0] = Gfx::VertexTex2(Math::Vector(p1.x, p1.y, 0.0f), n, Math::Point(uv1.x,uv1.y));
     vertex[1] = Gfx::VertexTex2(Math::Vector(p2.x, p2.y, 0.0f), n, Math::Point(uv1.x,uv2.y));
@@ -974,6 +980,9 @@ void CMap::DrawVertex(Math::Point uv1, Math::Point uv2, float zoom)
 
     n = Math::Vector(0.0f, 0.0f, -1.0f);  // normal
 
+    uv1 = m_texRegion.Map(uv1);
+    uv2 = m_texRegion.Map(uv2);
+
     vertex[0] = Gfx::VertexTex2(Math::Vector(p1.x, p1.y, 0.0f), n, Math::Point(uv1.x,uv2.y));
     vertex[1] = Gfx::VertexTex2(Math::Vector(p1.x, p2.y, 0.0f), n, Math::Point(uv1.x,uv1.y));
     vertex[2] = Gfx::VertexTex2(Math::Vector(p2.x, p1.y, 0.0f), n, Math::Point(uv2.x,uv2.y));
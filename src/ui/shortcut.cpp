@@ -116,7 +116,7 @@ void CShortcut::Draw()
         zoom = 1.0f;
     }
 
-    m_engine->SetTexture("button3.png");
+    SetTexture("button3.png");
 
     if ( icon != -1 )
     {
@@ -132,7 +132,7 @@ void CShortcut::Draw()
         Math::Point p1, p2, c, uv1, uv2;
         float   zoom, dp;
 
-        m_engine->SetTexture("button2.png");
+        SetTexture("button2.png");
         m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_WHITE);
 
         zoom = 0.9f+sinf(m_time*8.0f)*0.1f;
@@ -172,7 +172,7 @@ void CShortcut::Draw()
         Math::Point uv1, uv2;
         float   dp;
 
-        m_engine->SetTexture("button3.png");
+        SetTexture("button3.png");
         m_engine->SetState(Gfx::ENG_RSTATE_TTEXTURE_WHITE);
 
         uv1.x = 160.0f/256.0f;
@@ -234,6 +234,7 @@ void CShortcut::DrawVertex(int icon, float zoom)
     vertex[2] = Gfx::Vertex(Math::Vector(p2.x, p1.y, 0.0f), n, Math::Point(u2, v2));
     vertex[3] = Gfx::Vertex(Math::Vector(p2.x, p2.y, 0.0f), n, Math::Point(u2, v1));
 
+    MapTexCoords(vertex, 4);
     device->DrawPrimitive(Gfx::PRIMITIVE_TRIANGLE_STRIP, vertex, 4);
     m_engine->AddStatisticTriangle(2);
 }
@@ -3,7 +3,9 @@
 #include "mocks/text_mock.h"
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <cstdlib>
 #include <fstream>
+#include <vector>
 
 class CEditTest : public testing::Test
 {
@@ -65,6 +67,234 @@ TEST_F(CEditTest, WriteTest)
     ASSERT_STREQ(expectedScript.c_str(), outputScript.c_str());
 }
 
+// Gives access to the edition and to the line table of CEdit
+class CEditLayout : public Ui::CEdit
+{
+public:
+    CEditLayout()
+    {
+        m_bMulti = true;
+        m_dim = Math::Point(0.5f, 0.5f);
+    }
+
+    void InsertAt(int pos, const std::string &text)
+    {
+        SetCursor(pos, pos);
+        for (unsigned int i = 0; i < text.size(); i++)
+            InsertOne(text[i]);
+        Justif();
+    }
+
+    void DeleteAt(int pos, int len)
+    {
+        SetCursor(pos, pos + len);
+        DeleteOne(0);
+        Justif();
+    }
+
+    // Line table: offset, indentation and brace level of each line
+    std::vector<int> GetLines()
+    {
+        std::vector<int> lines;
+        for (int i = 0; i <= m_lineTotal; i++)
+        {
+            lines.push_back(m_lineOffset[i]);
+            lines.push_back(m_lineIndent[i]);
+            lines.push_back(m_lineLevel[i]);
+        }
+        return lines;
+    }
+
+    // Line table of a relayout of the whole text
+    std::vector<int> GetFullLayoutLines()
+    {
+        LayoutChange(0, 0);
+        Justif();
+        return GetLines();
+    }
+
+    int GetLineTotal()
+    {
+        return m_lineTotal;
+    }
+};
+
+class CEditLayoutTest : public testing::Test
+{
+public:
+    virtual void SetUp()
+    {
+        m_engine = new Gfx::CEngine(&m_iMan, NULL);
+        m_iMan.AddInstance(CLASS_ENGINE, m_engine);
+
+        // Each character is 1/100 wide, so that long lines are cut
+        CTextMock * text = dynamic_cast<CTextMock *>(m_engine->GetText());
+        ON_CALL(*text, GetCharWidth(_, _, _, _)).WillByDefault(Return(0.01f));
+        EXPECT_CALL(*text, GetCharWidth(_, _, _, _)).Times(::testing::AnyNumber());
+        EXPECT_CALL(*text, GetStringWidth(_, _, _)).Times(::testing::AnyNumber());
+
+        m_edit = new CEditLayout;
+        m_edit->SetMaxChar(Ui::EDITSTUDIOMAX);
+        m_edit->SetAutoIndent(true);
+        m_edit->SetText(PROGRAM, true);
+    }
+
+    virtual void TearDown()
+    {
+        delete m_edit;
+        m_edit = NULL;
+        m_iMan.DeleteInstance(CLASS_ENGINE, m_engine);
+        delete m_engine;
+        m_engine = NULL;
+    }
+
+    // Position of a text in the program
+    int Find(const char *text)
+    {
+        std::string program = m_edit->GetText();
+        program.resize(m_edit->GetTextLength());
+        std::size_t pos = program.find(text);
+        EXPECT_NE(std::string::npos, pos) << text;
+        return static_cast<int>(pos);
+    }
+
+    // The incremental layout must give the same lines as a relayout of the whole text
+    void ExpectFullLayout()
+    {
+        std::vector<int> lines = m_edit->GetLines();
+        EXPECT_EQ(m_edit->GetFullLayoutLines(), lines);
+    }
+
+    static const char* PROGRAM;
+
+    CInstanceManager m_iMan;
+    CApplication m_app;
+    Gfx::CEngine * m_engine;
+    CEditLayout * m_edit;
+    CLogger m_logger;
+};
+
+const char* CEditLayoutTest::PROGRAM =
+    "extern void object::Test()\n"
+    "{\n"
+    "int a = 1;  // counter {\n"
+    "/* a long comment, cut into a few lines of the editor\n"
+    "with a brace { inside it */\n"
+    "while ( a < 10 )\n"
+    "{\n"
+    "a = a + 1; message(\"a long string, longer than a line of the editor\");\n"
+    "if ( a == 5 ) { wait(1); }\n"
+    "}\n"
+    "message(\"end\");\n"
+    "}\n";
+
+TEST_F(CEditLayoutTest, CutsLongLines)
+{
+    // The program has 12 paragraphs, some of them cut
+    EXPECT_GT(m_edit->GetLineTotal(), 13);
+    ExpectFullLayout();
+}
+
+TEST_F(CEditLayoutTest, InsertInsideParagraph)
+{
+    int pos = Find("longer than");
+    for (int i = 0; i < 30; i++)
+    {
+        m_edit->InsertAt(pos + i, "x");
+        ExpectFullLayout();
+    }
+
+    m_edit->InsertAt(Find("counter"), "loop ");
+    ExpectFullLayout();
+}
+
+TEST_F(CEditLayoutTest, DeleteInsideParagraph)
+{
+    int pos = Find("a long string");
+    for (int i = 0; i < 20; i++)
+    {
+        m_edit->DeleteAt(pos, 1);
+        ExpectFullLayout();
+    }
+
+    // Joins two paragraphs, then splits them again
+    pos = Find("\nwhile");
+    m_edit->DeleteAt(pos, 1);
+    ExpectFullLayout();
+    m_edit->InsertAt(pos, "\n");
+    ExpectFullLayout();
+}
+
+TEST_F(CEditLayoutTest, InsertAcrossBraceLevel)
+{
+    // Opening a brace moves all following lines to the next level
+    int pos = Find("while");
+    m_edit->InsertAt(pos, "{");
+    ExpectFullLayout();
+    m_edit->InsertAt(pos + 1, "\n");
+    ExpectFullLayout();
+
+    m_edit->InsertAt(Find("message(\"end"), "}\n");
+    ExpectFullLayout();
+
+    // Closing a brace inside a line
+    m_edit->InsertAt(Find("wait"), "}");
+    ExpectFullLayout();
+}
+
+TEST_F(CEditLayoutTest, DeleteAcrossBraceLevel)
+{
+    m_edit->DeleteAt(Find("{ wait"), 1);
+    ExpectFullLayout();
+
+    // Removes a whole block, braces included
+    int begin = Find("{\na = a");
+    int end = Find("}\nmessage(\"end");
+    m_edit->DeleteAt(begin, end - begin + 2);
+    ExpectFullLayout();
+}
+
+TEST_F(CEditLayoutTest, EditInsideComment)
+{
+    int pos = Find("cut into");
+    m_edit->InsertAt(pos, "and a brace { ");
+    ExpectFullLayout();
+
+    m_edit->InsertAt(Find("inside it"), "\n}\n");
+    ExpectFullLayout();
+
+    m_edit->DeleteAt(Find("and a brace"), 14);
+    ExpectFullLayout();
+
+    // Ends the comment earlier
+    m_edit->InsertAt(Find("with a"), "*/ ");
+    ExpectFullLayout();
+    m_edit->DeleteAt(Find("*/ with"), 3);
+    ExpectFullLayout();
+}
+
+TEST_F(CEditLayoutTest, RandomEdits)
+{
+    const char* chars = "{}\n /*\"ab";
+    srand(1234);
+    for (int i = 0; i < 500; i++)
+    {
+        int len = m_edit->GetTextLength();
+        int pos = rand() % (len + 1);
+        if (rand() % 3 == 0 && pos < len)
+        {
+            m_edit->DeleteAt(pos, 1 + rand() % 5);
+        }
+        else
+        {
+            m_edit->InsertAt(pos, std::string(1, chars[rand() % 10]));
+        }
+
+        std::vector<int> lines = m_edit->GetLines();
+        ASSERT_EQ(m_edit->GetFullLayoutLines(), lines) << "edit " << i;
+    }
+}
+
 int main(int argc, char *argv[])
 {
     ::testing::InitGoogleTest(&argc, argv);
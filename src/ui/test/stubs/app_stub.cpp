@@ -23,4 +23,8 @@ std::string CApplication::GetDataFilePath(DataDir /* dataDir */, const std::stri
     return subpath;
 }
 
+void CApplication::LoadingProgress(int /* done */, int /* total */)
+{
+}
+
 
@@ -51,6 +51,12 @@ bool CEngine::SetTexture(const std::string& /* name */, int /* stage */)
     return true;
 }
 
+bool CEngine::SetInterfaceTexture(const std::string& /* name */, TextureRegion& region)
+{
+    region = TextureRegion();
+    return true;
+}
+
 CText* CEngine::GetText()
 {
     return m_text;
@@ -75,5 +81,13 @@ Texture CEngine::LoadTexture(const std::string& /* name */)
     return texture;
 }
 
+CTextureAtlas::CTextureAtlas()
+{
+}
+
+CTextureAtlas::~CTextureAtlas()
+{
+}
+
 } /* Gfx */
 